@@ -6,6 +6,8 @@
 #
 
 ## Enable Thread Prio
+## Thread priority and cpu affinity are configured per thread role in viewer.conf,
+## below system wide settings are only needed if SCHED_FIFO is still refused.
 #sysctl -w kernel.sched_rt_runtime_us=-1
 #echo 4 > /sys/devices/system/cpu/cpu0/core_ctl/min_cpus
 #echo 4 > /sys/devices/system/cpu/cpu4/core_ctl/min_cpus
@@ -0,0 +1,71 @@
+//******************************************************************************
+//! \file         apl_arena.h
+//! \brief        huge page backed arena of frame buffers and stage workspaces.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_ARENA
+#define H_APL_ARENA
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_ARENA_ALIGN		(64)	// alignment of every block (cache line)
+
+// Backing Pages Of Arena
+typedef enum {
+	 APL_ARENA_PAGE_4K = 0	// normal pages
+	,APL_ARENA_PAGE_THP		// transparent huge pages (madvise), falls back to normal pages
+	,APL_ARENA_PAGE_HUGETLB	// explicit huge pages (vm.nr_hugepages), falls back to THP
+} APL_ARENA_PAGE;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Map arena, call once before allocation of frame buffers and workspaces.
+//! \param[in]    size          arena size [byte].
+//! \param[in]    page          requested backing pages.
+//! \return       0             success
+//! \return       -1            failed, apl_arena_alloc() uses heap
+//******************************************************************************
+int apl_arena_init(size_t size, APL_ARENA_PAGE page);
+
+//******************************************************************************
+//! \brief        Unmap arena, blocks of arena must not be used anymore.
+//******************************************************************************
+void apl_arena_term(void);
+
+//******************************************************************************
+//! \brief        Allocate zero filled (prefaulted) block, aligned to APL_ARENA_ALIGN.
+//! \details      Heap is used if arena is not mapped or exhausted.
+//! \param[in]    size          block size [byte].
+//! \return       block, NULL if heap is exhausted too.
+//******************************************************************************
+void *apl_arena_alloc(size_t size);
+
+//******************************************************************************
+//! \brief        Free block, nothing is done for block in arena (released at apl_arena_term()).
+//******************************************************************************
+void apl_arena_free(void *ptr);
+
+//******************************************************************************
+//! \brief        Lock used part of arena in memory (mlock), call after allocation.
+//! \return       0             success
+//! \return       -1            failed (RLIMIT_MEMLOCK or CAP_IPC_LOCK)
+//******************************************************************************
+int apl_arena_lock(void);
+
+//******************************************************************************
+//! \brief        Print footprint of arena.
+//******************************************************************************
+void apl_arena_report(FILE *fp);
+
+#endif	/* H_APL_ARENA */
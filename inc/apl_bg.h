@@ -0,0 +1,115 @@
+//******************************************************************************
+//! \file         apl_bg.h
+//! \brief        background model of depth, foreground mask and blobs.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_BG
+#define H_APL_BG
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include <mutex>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_BG_BLOB_MAX		(32)		// blobs reported every frame, largest first
+#define APL_BG_LABEL_MAX	(16384)		// provisional labels of one frame
+
+// Foreground Blob, 8-Connected
+typedef struct {
+	uint16_t	x;			// left
+	uint16_t	y;			// top
+	uint16_t	w;			// width
+	uint16_t	h;			// height
+	uint32_t	area;		// foreground pixels
+	float		cx;			// centroid x [pixel]
+	float		cy;			// centroid y [pixel]
+	float		mean;		// mean depth [mm]
+} apl_bg_blob;
+
+// Provisional Label Of Connected Components, parent < own label
+typedef struct {
+	uint32_t	parent;		// union-find parent
+	uint32_t	area;		// pixels
+	uint16_t	x0;			// left
+	uint16_t	y0;			// top
+	uint16_t	x1;			// right
+	uint16_t	y1;			// bottom
+	uint64_t	sx;			// sum of x
+	uint64_t	sy;			// sum of y
+	uint64_t	sd;			// sum of depth
+} apl_bg_label;
+
+// Run Of Foreground Pixels In Row
+typedef struct {
+	uint16_t	x0;			// first pixel
+	uint16_t	x1;			// last pixel
+	uint32_t	label;		// provisional label
+} apl_bg_run;
+
+// Background Model Stage
+typedef struct {
+	size_t					w;			// image width
+	size_t					h;			// image height
+	float					alpha;		// learning rate of background pixels
+	float					alpha_fg;	// learning rate of foreground pixels (absorbs stationary objects)
+	float					k2;			// threshold, (k sigma)^2
+	float					var_min;	// variance floor [mm^2], sensor noise
+	uint32_t				min_area;	// smallest blob [pixel]
+	float					*mean;		// mean depth [mm], 0 = not learned yet
+	float					*var;		// variance of depth [mm^2]
+	apl_bg_label			*label;		// provisional labels [APL_BG_LABEL_MAX]
+	apl_bg_run				*run[2];	// runs of previous and current row [w / 2 + 1]
+	std::mutex				mtx;		// mutex for relearn, blob, fg_ratio
+	bool					relearn;	// forget background at next update
+	float					fg_ratio;	// foreground / pixels of last frame
+	size_t					blob_num;	// blobs of last frame
+	apl_bg_blob				blob[APL_BG_BLOB_MAX];	// blobs of last frame
+} apl_bg;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Initialize model, all memory is allocated here (from arena).
+//! \param[out]   bg            model.
+//! \param[in]    w             image width.
+//! \param[in]    h             image height.
+//! \param[in]    alpha         learning rate of background pixels (0 .. 1).
+//! \param[in]    alpha_fg      learning rate of foreground pixels (0 .. alpha).
+//! \param[in]    k             foreground threshold [sigma].
+//! \param[in]    noise         sensor noise floor of sigma [mm].
+//! \param[in]    min_area      smallest blob reported [pixel].
+//******************************************************************************
+void apl_bg_init(apl_bg *bg, size_t w, size_t h, float alpha, float alpha_fg, float k, uint16_t noise, uint32_t min_area);
+
+//******************************************************************************
+//! \brief        Forget background, learned again from next frame.
+//******************************************************************************
+void apl_bg_reset(apl_bg *bg);
+
+//******************************************************************************
+//! \brief        Update model with depth image, make foreground mask and blobs.
+//! \details      Foreground is closer than background by more than k sigma.
+//!               Invalid depth (0) neither updates the model nor is foreground.
+//! \param[in,out] bg           model.
+//! \param[in]    dp            depth image [mm], 0 = invalid.
+//! \param[out]   mask          foreground mask of depth image, 255 = foreground.
+//******************************************************************************
+void apl_bg_update(apl_bg *bg, const uint16_t *dp, uint8_t *mask);
+
+//******************************************************************************
+//! \brief        Get blobs of last frame, callable from any thread.
+//! \param[out]   blob          APL_BG_BLOB_MAX blobs.
+//! \param[out]   fg_ratio      foreground / pixels.
+//! \return       number of blobs.
+//******************************************************************************
+size_t apl_bg_get(apl_bg *bg, apl_bg_blob *blob, float *fg_ratio);
+
+#endif	/* H_APL_BG */
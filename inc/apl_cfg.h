@@ -0,0 +1,76 @@
+//******************************************************************************
+//! \file         apl_cfg.h
+//! \brief        key = value configuration file of viewer application.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_CFG
+#define H_APL_CFG
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_CFG_DEF_FILE		"viewer.conf"			// default configuration file
+#define APL_CFG_ENV_FILE		"CIS_TOF_VIEWER_CONF"	// environment variable to override file
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Load configuration file, '#' starts a comment.
+//! \param[in]    fn            file name.
+//! \return       0             success
+//! \return       -1            file not found
+//******************************************************************************
+int apl_cfg_load(const char *fn);
+
+//******************************************************************************
+//! \brief        Forget every loaded key, next apl_cfg_load() starts from empty configuration.
+//******************************************************************************
+void apl_cfg_clear(void);
+
+//******************************************************************************
+//! \brief        Get string value.
+//! \param[in]    key           key.
+//! \param[in]    def           value returned when key is not configured.
+//******************************************************************************
+const char *apl_cfg_get_str(const char *key, const char *def);
+
+//******************************************************************************
+//! \brief        Get integer value.
+//! \param[in]    key           key.
+//! \param[in]    def           value returned when key is not configured.
+//******************************************************************************
+int apl_cfg_get_int(const char *key, int def);
+
+//******************************************************************************
+//! \brief        Get floating point value.
+//! \param[in]    key           key.
+//! \param[in]    def           value returned when key is not configured.
+//******************************************************************************
+float apl_cfg_get_float(const char *key, float def);
+
+//******************************************************************************
+//! \brief        Get string value of device, "cam<dev>.<key>" overrides "<key>".
+//! \param[in]    dev           device index.
+//! \param[in]    key           key.
+//! \param[in]    def           value returned when key is not configured.
+//******************************************************************************
+const char *apl_cfg_get_dev_str(uint8_t dev, const char *key, const char *def);
+
+//******************************************************************************
+//! \brief        Get integer value of device, "cam<dev>.<key>" overrides "<key>".
+//******************************************************************************
+int apl_cfg_get_dev_int(uint8_t dev, const char *key, int def);
+
+//******************************************************************************
+//! \brief        Get floating point value of device, "cam<dev>.<key>" overrides "<key>".
+//******************************************************************************
+float apl_cfg_get_dev_float(uint8_t dev, const char *key, float def);
+
+#endif	/* H_APL_CFG */
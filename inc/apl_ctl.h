@@ -0,0 +1,117 @@
+//******************************************************************************
+//! \file         apl_ctl.h
+//! \brief        command channel (stdin and unix socket), parsed commands to lock free queues of threads.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_CTL
+#define H_APL_CTL
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <string>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_CTL_QUEUE_LEN	(16)	// commands waiting for consumer, power of 2
+#define APL_CTL_LINE_MAX	(256)	// longest command line
+#define APL_CTL_CLIENT_MAX	(4)		// connections of unix socket
+
+// Commands, "<name> [args]" Per Line
+typedef enum {
+	 APL_CTL_CMD_SAVE = 0	// save <n>, or <n> : save next n frames as raw files
+	,APL_CTL_CMD_START		// start : start capture
+	,APL_CTL_CMD_STOP		// stop : stop capture
+	,APL_CTL_CMD_MODE		// mode <n> : switch ranging mode (from 1)
+	,APL_CTL_CMD_VIEW		// view <confdata|irnrref|autorange|normal> [on|off] : toggle view
+	,APL_CTL_CMD_STATS		// stats : counters and stage latency (Prometheus text format)
+	,APL_CTL_CMD_TRIGGER	// trigger, or t : dump pre-trigger ring
+	,APL_CTL_CMD_QUIT		// quit : exit program
+	,APL_CTL_CMD_HELP		// help : list of commands, answered by channel
+	,APL_CTL_CMD_NUM
+} APL_CTL_CMD;
+
+// Views Of "view" Command
+typedef enum {
+	 APL_CTL_VIEW_CONFDATA = 0
+	,APL_CTL_VIEW_IRNRREF
+	,APL_CTL_VIEW_AUTORANGE
+	,APL_CTL_VIEW_NORMAL
+	,APL_CTL_VIEW_NUM
+} APL_CTL_VIEW;
+
+// Parsed Command
+typedef struct {
+	APL_CTL_CMD	cmd;
+	int32_t		arg;		// save : frames, mode : mode (from 0), view : APL_CTL_VIEW
+	int32_t		arg2;		// view : 1 = on, 0 = off, -1 = toggle
+} apl_ctl_cmd;
+
+// Lock Free Queue, One Producer (Channel Thread) And One Consumer
+typedef struct {
+	std::atomic<uint32_t>	head;		// next to push, written by producer
+	std::atomic<uint32_t>	tail;		// next to pop, written by consumer
+	apl_ctl_cmd				cmd[APL_CTL_QUEUE_LEN];
+} apl_ctl_queue;
+
+// Called On Channel Thread For Each Command, Routes It (Or Answers It), Empty Reply Is "ok"
+typedef void (*apl_ctl_handler)(const apl_ctl_cmd *cmd, std::string *reply);
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Parse command line.
+//! \param[in]    line          command line, without newline.
+//! \param[out]   cmd           command.
+//! \param[out]   err           reason of failure.
+//! \return       0             success
+//! \return       -1            invalid command
+//******************************************************************************
+int apl_ctl_parse(const char *line, apl_ctl_cmd *cmd, std::string *err);
+
+//******************************************************************************
+//! \brief        Push command, producer only.
+//! \return       false         queue is full
+//******************************************************************************
+bool apl_ctl_push(apl_ctl_queue *q, const apl_ctl_cmd *cmd);
+
+//******************************************************************************
+//! \brief        Pop command, consumer only, an atomic load when empty.
+//! \return       false         queue is empty
+//******************************************************************************
+static inline bool apl_ctl_pop(apl_ctl_queue *q, apl_ctl_cmd *cmd)
+{
+	const uint32_t tail = q->tail.load(std::memory_order_relaxed);
+
+	if (tail == q->head.load(std::memory_order_acquire)) {
+		return false;
+	}
+	*cmd = q->cmd[tail & (APL_CTL_QUEUE_LEN - 1)];
+	q->tail.store(tail + 1, std::memory_order_release);
+
+	return true;
+}
+
+//******************************************************************************
+//! \brief        Start channel thread.
+//! \param[in]    listen_addr   "unix:<path>" of command socket, NULL = stdin only.
+//! \param[in]    use_stdin     commands from stdin.
+//! \param[in]    handler       handler of parsed commands.
+//! \return       0             success
+//! \return       -1            failed
+//******************************************************************************
+int apl_ctl_start(const char *listen_addr, bool use_stdin, apl_ctl_handler handler);
+
+//******************************************************************************
+//! \brief        Stop channel thread, wakes it from poll(), nothing is done if it is not started.
+//******************************************************************************
+void apl_ctl_stop(void);
+
+#endif	/* H_APL_CTL */
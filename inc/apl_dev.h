@@ -0,0 +1,15 @@
+//******************************************************************************
+//! \file         apl_dev.h
+//! \brief        index of sensors driven by one process, shared by per-device modules.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_DEV
+#define H_APL_DEV
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_DEV_MAX		(4)		// sensors of one process, device index is 0 .. APL_DEV_MAX - 1
+
+#endif	/* H_APL_DEV */
@@ -0,0 +1,70 @@
+//******************************************************************************
+//! \file         apl_fill.h
+//! \brief        hole filling of depth by push-pull pyramid guided by ir.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_FILL
+#define H_APL_FILL
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_FILL_LEVEL_MAX	(8)		// levels below image, holes up to 2^8 pixels
+
+// Level Of Pyramid, Half Size Of Level Above
+typedef struct {
+	size_t		w;			// width
+	size_t		h;			// height
+	float		*dp;		// depth [mm], weighted mean of valid children
+	float		*wt;		// weight, 0 = no valid depth below, 1 = valid
+	float		*ir;		// mean of ir
+} apl_fill_level;
+
+// Hole Filling Stage
+//   push : level l = mean of valid 2 x 2 children of level l - 1
+//   pull : invalid pixel of level l - 1 = sum(w_b * w_r * depth(q)) / sum(w_b * w_r) over 2 x 2 nearest q of level l
+//          w_b : bilinear weight, w_r = 1 / (1 + ((ir(p) - ir(q)) / sigma_r)^2), so that depth does not bleed across ir edges
+//   holes wider than max_hole pixels stay invalid as a whole (width = 2 x largest chessboard distance to depth),
+//   found only when level_num - 1 has a block without depth, which every such hole contains
+typedef struct {
+	size_t			w;			// image width
+	size_t			h;			// image height
+	uint32_t		level_num;	// levels below image
+	uint32_t		max_hole;	// widest hole filled [pixel], 2^level_num
+	float			inv_r2;		// 1 / sigma_r^2
+	uint16_t		*dist;		// chessboard distance of hole pixel to depth, w x h
+	uint32_t		*stack;		// pixels to visit of over-size hole, w x h
+	apl_fill_level	lv[APL_FILL_LEVEL_MAX + 1];	// lv[0] is image (size only), lv[1 ..] are allocated
+} apl_fill;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Initialize stage, all memory is allocated here (from arena).
+//! \param[out]   fill          stage.
+//! \param[in]    w             image width.
+//! \param[in]    h             image height.
+//! \param[in]    max_hole      widest hole filled [pixel], rounded up to power of 2.
+//! \param[in]    sigma_r       range sigma of guide [ir value].
+//******************************************************************************
+void apl_fill_init(apl_fill *fill, size_t w, size_t h, uint32_t max_hole, float sigma_r);
+
+//******************************************************************************
+//! \brief        Fill holes of depth in place, rows of each level in parallel.
+//! \param[in]    fill          stage.
+//! \param[in,out] depth        depth [mm] of w x h, 0 = invalid.
+//! \param[in]    ir            ir of w x h (guide).
+//! \param[out]   mask          w x h, 1 = depth is filled (inferred), 0 = measured or still invalid (over-size hole).
+//! \return       pixels filled.
+//******************************************************************************
+size_t apl_fill_run(apl_fill *fill, uint16_t *depth, const uint16_t *ir, uint8_t *mask);
+
+#endif	/* H_APL_FILL */
@@ -0,0 +1,72 @@
+//******************************************************************************
+//! \file         apl_fly.h
+//! \brief        flying pixel (mixed pixel at depth edge) filter of depth.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_FLY
+#define H_APL_FLY
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include "apl_lens.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_FLY_TILE	(16)	// rows of tile, tiles run in parallel
+
+// Flying Pixel Filter Stage, Pixels Are Invalidated (0) In Place
+//   jump to neighbor q of 8 : depth(q) != 0 and |depth(p) - depth(q)| > abs + rel * depth(p)
+//   with lens (3D)          : depth(q) != 0 and |depth(p) - depth(q)| > abs and
+//                             angle between ray of p and step P -> Q is less than angle (surface seen edge-on)
+//   line through p (horizontal, vertical, 2 diagonals) is broken when p jumps to both ends, one end is a true edge
+//   p is flying             : broken lines >= jump_min, or any jump and confdata(p) < conf_min
+typedef struct {
+	size_t			w;			// image width
+	size_t			h;			// image height
+	float			abs;		// floor of discontinuity [mm]
+	float			rel;		// discontinuity relative to depth (depth test only)
+	float			cos2;		// cos^2 of angle (3D test only)
+	uint32_t		jump_min;	// broken lines that make a flying pixel
+	uint16_t		conf_min;	// confdata below it needs one jump only, 0 = not used
+	float			*rx;		// ray of columns -1 .. w, NULL = depth test
+	const float		*ry;		// ray of rows (lens)
+	uint16_t		*halo;		// original rows at tile boundaries (row above, first row), 2 x w per tile
+	uint16_t		*ring;		// original rows of tile (above, current, below), 3 x (w + 2) per tile, border is 0
+	uint16_t		*zero;		// row of 0, confdata when it is not used
+	uint32_t		*removed;	// pixels invalidated, per tile
+} apl_fly;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Initialize stage, all memory is allocated here (from arena).
+//! \param[out]   fly           stage.
+//! \param[in]    w             image width.
+//! \param[in]    h             image height.
+//! \param[in]    lens          lens model of image size for 3D test, NULL or angle <= 0 selects depth test.
+//! \param[in]    angle         angle between ray and step to neighbor [degree].
+//! \param[in]    abs           floor of discontinuity [mm].
+//! \param[in]    rel           discontinuity relative to depth (depth test).
+//! \param[in]    jump_min      broken lines through pixel that make a flying pixel (1 .. 4).
+//! \param[in]    conf_min      confdata below it needs one jump only, 0 = not used.
+//******************************************************************************
+void apl_fly_init(apl_fly *fly, size_t w, size_t h, const apl_lens *lens, float angle,
+				  float abs, float rel, uint32_t jump_min, uint16_t conf_min);
+
+//******************************************************************************
+//! \brief        Invalidate flying pixels in place, one pass over depth with row buffers, tiles in parallel.
+//! \param[in]    fly           stage.
+//! \param[in,out] depth        depth [mm] of w x h, 0 = invalid.
+//! \param[in]    conf          confdata of w x h, NULL = not used.
+//! \return       pixels invalidated.
+//******************************************************************************
+size_t apl_fly_run(apl_fly *fly, uint16_t *depth, const uint16_t *conf);
+
+#endif	/* H_APL_FLY */
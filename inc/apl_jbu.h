@@ -0,0 +1,56 @@
+//******************************************************************************
+//! \file         apl_jbu.h
+//! \brief        joint bilateral upsampling of depth guided by ir (QVGA depth -> VGA).
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_JBU
+#define H_APL_JBU
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_JBU_TAP		(3)		// taps of low resolution in x and y
+
+// Upsampling Stage, Low Resolution x 2 = High Resolution
+//   depth(p) = sum(w_s * w_r * depth(q)) / sum(w_s * w_r) over valid q of 3 x 3 around p
+//   w_s : gaussian of distance p - q, w_r = 1 / (1 + ((ir(p) - ir(q)) / sigma_r)^2)
+typedef struct {
+	size_t		lw;				// low resolution width
+	size_t		lh;				// low resolution height
+	float		inv_r2;			// 1 / sigma_r^2
+	float		ws[2][APL_JBU_TAP];	// spatial weight of taps, [phase of high resolution pixel][tap]
+	float		*dp;			// low resolution depth, 1 pixel border of invalid, (lw + 2) x (lh + 2)
+	float		*ir;			// guide at low resolution (2 x 2 mean of ir), same layout as dp
+	float		*vm;			// 1 = valid depth, 0 = invalid, same layout as dp
+} apl_jbu;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Initialize stage, all memory is allocated here (from arena).
+//! \param[out]   jbu           stage.
+//! \param[in]    lw            low resolution width (depth).
+//! \param[in]    lh            low resolution height (depth).
+//! \param[in]    sigma_s       spatial sigma [pixel of low resolution].
+//! \param[in]    sigma_r       range sigma of guide [ir value].
+//******************************************************************************
+void apl_jbu_init(apl_jbu *jbu, size_t lw, size_t lh, float sigma_s, float sigma_r);
+
+//******************************************************************************
+//! \brief        Upsample depth, rows in parallel.
+//! \param[in]    jbu           stage.
+//! \param[in]    dp_lo         depth [mm] of lw x lh, 0 = invalid.
+//! \param[in]    ir_hi         ir of (lw x 2) x (lh x 2).
+//! \param[out]   dp_hi         depth [mm] of (lw x 2) x (lh x 2), 0 = no valid depth around.
+//******************************************************************************
+void apl_jbu_run(apl_jbu *jbu, const uint16_t *dp_lo, const uint16_t *ir_hi, uint16_t *dp_hi);
+
+#endif	/* H_APL_JBU */
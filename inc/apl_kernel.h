@@ -0,0 +1,62 @@
+//******************************************************************************
+//! \file         apl_kernel.h
+//! \brief        per-frame image kernels of viewer application.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_KERNEL
+#define H_APL_KERNEL
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "tl.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+static const uint16_t	RAW12_INVALID_DEPTH = 0x0FFFU;	/*!< invalid depth in RAW12 format */
+static const uint16_t	INVALID_DEPTH = 0xFFFFU;		/*!< invalid depth */
+
+#define APL_DP_CNV_SHIFT		(12)	// fraction bits of apl_dp_cnv::gain
+#define APL_DP_TCC_SLOPE_ONE	(4096)	// default stMPTempCrct::slope meaning 1.0
+
+// Depth Conversion, depth[mm] = ((raw * gain) + bias) >> APL_DP_CNV_SHIFT, raw is RAW12
+//   gain and bias are bounded so that raw * gain + bias fits int32 for every RAW12 value (loop stays vectorized)
+typedef struct {
+	uint16_t	unit;		// depth_unit [mm/digit]
+	bool		tcc_on;		// temperature correction by stMPTempCrct on/off
+	uint16_t	slope_one;	// stMPTempCrct::slope meaning 1.0
+	bool		tcc_valid;	// correction received at least once
+	int32_t		gain;		// unit * slope, fixed point, 0 .. (INT32_MAX - max(bias, 0)) / RAW12_INVALID_DEPTH
+	int32_t		bias;		// unit * offset, fixed point, including rounding
+} apl_dp_cnv;
+
+// Depth Color Table, Same Colors As apl_dpth_to_color_by_opencv()
+typedef struct {
+	uint16_t				range_min;	// minimum depth of table [mm]
+	uint16_t				range_max;	// maximum depth of table [mm]
+	std::vector<cv::Vec3b>	tbl;		// color of depth [0, range_max], last entry for depth > range_max
+} apl_color_lut;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+void apl_dp_cnv_init(apl_dp_cnv *cnv, uint16_t unit, bool tcc_on, uint16_t slope_one);
+void apl_dp_cnv_update(apl_dp_cnv *cnv, const stMPTempCrct *crct);
+void apl_cnv_dp_rows(uint16_t *dp, size_t w, size_t row_begin, size_t row_end, const apl_dp_cnv *cnv);
+void apl_cnv_dp(TL_Resolution reso, TL_Image *stData, const apl_dp_cnv *cnv);
+cv::Mat apl_dpth_to_color_by_opencv(cv::Mat img, uint32_t min_val, uint32_t max_val);
+bool apl_color_lut_build(apl_color_lut *lut, uint16_t min_val, uint16_t max_val);
+cv::Mat apl_dpth_to_color_by_lut(cv::Mat img, const apl_color_lut *lut);
+void apl_gamma_by_opencv(cv::Mat src, cv::Mat dst, float gamma);
+int apl_save_plane(const char *fn, const void *data, size_t size);
+
+#endif	/* H_APL_KERNEL */
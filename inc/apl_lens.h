@@ -0,0 +1,70 @@
+//******************************************************************************
+//! \file         apl_lens.h
+//! \brief        lens model and ray tables of depth image, shared by 3D stages.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_LENS
+#define H_APL_LENS
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include "tl.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+// Pinhole Model Of Depth Image, Depth Is Distance Along Optical Axis (z)
+//   x = z * rx[u], y = z * ry[v]
+typedef struct {
+	uint16_t	w;			// image width
+	uint16_t	h;			// image height
+	float		fx;			// focal length [pixel]
+	float		fy;			// focal length [pixel]
+	float		cx;			// principal point [pixel]
+	float		cy;			// principal point [pixel]
+	float		*rx;		// (u - cx) / fx of each column, w entries
+	float		*ry;		// (v - cy) / fy of each row, h entries
+} apl_lens;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Initialize lens model and ray tables of image size, tables are allocated from arena.
+//! \details      Focal length and pixel pitch are used if available, viewing angle otherwise.
+//!               Sensor pixels (sns_h, sns_v) are scaled to image size (binning).
+//! \param[out]   lens          lens model.
+//! \param[in]    prm           lens parameters (TL_CMD_LENS_INFO).
+//! \param[in]    fov           field of view (TL_CMD_FOV).
+//! \param[in]    w             image width.
+//! \param[in]    h             image height.
+//! \return       0             success
+//! \return       -1            no usable parameter
+//******************************************************************************
+int apl_lens_init(apl_lens *lens, const TL_LensPrm *prm, const TL_Fov *fov, uint16_t w, uint16_t h);
+
+//******************************************************************************
+//! \brief        Write lens parameters as key = value file (next to saved frames, read by viewer_convert).
+//! \param[in]    fn            file name.
+//! \param[in]    prm           lens parameters (TL_CMD_LENS_INFO).
+//! \param[in]    fov           field of view (TL_CMD_FOV).
+//! \return       0             success
+//! \return       -1            fopen failed
+//******************************************************************************
+int apl_lens_save(const char *fn, const TL_LensPrm *prm, const TL_Fov *fov);
+
+//******************************************************************************
+//! \brief        Point of pixel [mm], camera coordinate (x right, y down, z forward).
+//******************************************************************************
+static inline void apl_lens_point(const apl_lens *lens, size_t u, size_t v, float z, float *x, float *y)
+{
+	*x = z * lens->rx[u];
+	*y = z * lens->ry[v];
+}
+
+#endif	/* H_APL_LENS */
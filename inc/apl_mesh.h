@@ -0,0 +1,196 @@
+//******************************************************************************
+//! \file         apl_mesh.h
+//! \brief        triangle mesh of organized depth, textured by ir, written as PLY / OBJ by own thread.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_MESH
+#define H_APL_MESH
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include <string>
+
+#include "apl_lens.h"
+#include "apl_queue.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_MESH_TILE		(16)	// rows of tile, tiles run in parallel
+#define APL_MESH_QUEUE_DEF	(2)		// frames waiting for writer
+
+// Output Format
+typedef enum {
+	 APL_MESH_FMT_PLY = 0	// binary_little_endian PLY, vertex color is ir
+	,APL_MESH_FMT_OBJ		// Wavefront OBJ (text), vertex color extension "v x y z r g b"
+	,APL_MESH_FMT_NUM
+} APL_MESH_FMT;
+
+// Vertex, Layout Of PLY Vertex Element
+typedef struct __attribute__((packed)) {
+	float		x;			// camera coordinate [m], x right, y down, z forward
+	float		y;
+	float		z;
+	uint8_t		r;			// ir as gray
+	uint8_t		g;
+	uint8_t		b;
+} apl_mesh_vtx;
+
+// Triangle, Layout Of PLY Face Element (list uchar uint), Counter-Clockwise Seen From Camera
+typedef struct __attribute__((packed)) {
+	uint8_t		n;			// 3
+	uint32_t	v[3];		// vertices
+} apl_mesh_face;
+
+// Mesh Of Organized Depth
+//   vertex of every valid pixel, quad of 2 x 2 pixels makes 2 triangles (1 if one corner is invalid)
+//   triangle is skipped when its depths spread more than jump * nearest depth (discontinuity)
+//   buffers are sized for full image once, vertices are numbered by prefix sum over tiles
+typedef struct {
+	size_t			w;			// image width
+	size_t			h;			// image height
+	float			jump;		// spread of triangle (relative to depth) that is a discontinuity
+	float			ir_scale;	// ir to 8 bits
+	const float		*rx;		// ray of columns (lens)
+	const float		*ry;		// ray of rows (lens)
+	apl_mesh_vtx	*vtx;		// vertices, w x h at most
+	apl_mesh_face	*face;		// triangles, 2 x (w - 1) x (h - 1) at most
+	uint32_t		*vid;		// vertex of pixel
+	size_t			*tile_vtx;	// vertices of tile, then first vertex of tile
+	size_t			*tile_face;	// triangles of tile, then first triangle of tile
+	size_t			vtx_num;	// vertices of last frame
+	size_t			face_num;	// triangles of last frame
+} apl_mesh;
+
+// Counters Of Writer
+typedef struct {
+	uint64_t	offered;		// frames given to apl_mesh_out_push()
+	uint64_t	decimated;		// frames skipped by decimation
+	uint64_t	dropped;		// frames skipped because queue was full
+	uint64_t	written;		// meshes written
+	uint64_t	failed;			// meshes not written (file error)
+	uint64_t	triangles;		// triangles written
+	uint64_t	bytes;			// bytes written
+	uint64_t	build_ns;		// time of building meshes
+	uint64_t	busy_ns;		// time of building and writing meshes
+} apl_mesh_stat;
+
+// Frame Queued For Writer, Planes Are Copies
+typedef struct {
+	uint16_t	*depth;			// depth [mm] of mesh size
+	uint16_t	*ir;			// ir of ir_w x ir_h
+	bool		ir_on;			// ir is given
+	uint64_t	seq;			// sequence of frame, name of file
+} apl_mesh_in;
+
+// Streaming Writer, Meshes Are Built And Written By Own Thread
+typedef struct {
+	apl_mesh					mesh;		// buffers of writer thread
+	APL_MESH_FMT				fmt;
+	std::string					prefix;		// output <prefix>_mesh<seq>.ply / .obj
+	uint16_t					ir_w;		// ir size of frames
+	uint16_t					ir_h;
+	apl_mesh_in					*slot;		// queue buffers
+	uint32_t					slot_num;
+	apl_queue					que;		// frames waiting for writer (decimation), its mutex guards stat
+	apl_mesh_stat				stat;		// counters of writer (offered, decimated, dropped are in que)
+	bool						started;
+	pthread_t					thr;		// writer thread
+	char						*io;		// stdio buffer of output
+} apl_mesh_out;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Initialize mesh, all memory is allocated here (from arena).
+//! \param[out]   mesh          mesh.
+//! \param[in]    lens          lens model of depth image.
+//! \param[in]    jump          spread of triangle (relative to depth) that is a discontinuity.
+//! \param[in]    ir_max        ir that is white.
+//******************************************************************************
+void apl_mesh_init(apl_mesh *mesh, const apl_lens *lens, float jump, uint16_t ir_max);
+
+//******************************************************************************
+//! \brief        Free buffers of mesh.
+//******************************************************************************
+void apl_mesh_term(apl_mesh *mesh);
+
+//******************************************************************************
+//! \brief        Build mesh of depth, tiles in parallel.
+//! \param[in,out] mesh         mesh.
+//! \param[in]    depth         depth [mm] of w x h, 0 = invalid.
+//! \param[in]    ir            ir of ir_w x ir_h, sampled at pixel of depth, NULL = white.
+//! \param[in]    ir_w          ir width.
+//! \param[in]    ir_h          ir height.
+//! \return       triangles.
+//******************************************************************************
+size_t apl_mesh_build(apl_mesh *mesh, const uint16_t *depth, const uint16_t *ir, uint16_t ir_w, uint16_t ir_h);
+
+//******************************************************************************
+//! \brief        Write mesh to file.
+//! \param[in]    mesh          mesh built.
+//! \param[in]    fn            file name.
+//! \param[in]    fmt           format.
+//! \param[in]    io            stdio buffer, NULL = default.
+//! \param[in]    io_size       size of stdio buffer.
+//! \return       bytes written, 0 = failed.
+//******************************************************************************
+size_t apl_mesh_write(const apl_mesh *mesh, const char *fn, APL_MESH_FMT fmt, char *io, size_t io_size);
+
+//******************************************************************************
+//! \brief        Format of name ("ply" or "obj").
+//! \return       0             success
+//! \return       -1            unknown name
+//******************************************************************************
+int apl_mesh_fmt_of(const char *name, APL_MESH_FMT *fmt);
+
+//******************************************************************************
+//! \brief        File extension of format, e.g. ".ply".
+//******************************************************************************
+const char *apl_mesh_ext(APL_MESH_FMT fmt);
+
+//******************************************************************************
+//! \brief        Allocate mesh and queue (from arena) and start writer thread.
+//! \param[out]   out           writer.
+//! \param[in]    lens          lens model of depth image.
+//! \param[in]    jump          spread of triangle (relative to depth) that is a discontinuity.
+//! \param[in]    ir_max        ir that is white.
+//! \param[in]    ir_w          ir width of frames.
+//! \param[in]    ir_h          ir height of frames.
+//! \param[in]    prefix        output prefix, may contain directory.
+//! \param[in]    fmt           format.
+//! \param[in]    decimate      one frame of every decimate frames is written (>= 1).
+//! \param[in]    queue_max     frames waiting for writer, more are dropped (>= 1).
+//! \return       0             success
+//! \return       -1            failed
+//******************************************************************************
+int apl_mesh_out_init(apl_mesh_out *out, const apl_lens *lens, float jump, uint16_t ir_max, uint16_t ir_w, uint16_t ir_h,
+					  const char *prefix, APL_MESH_FMT fmt, uint32_t decimate, uint32_t queue_max);
+
+//******************************************************************************
+//! \brief        Queue frame for writer, never blocks on writer (frame is dropped when queue is full).
+//! \param[in]    out           writer.
+//! \param[in]    depth         depth [mm] of mesh size.
+//! \param[in]    ir            ir of ir_w x ir_h given at init, NULL = white.
+//! \param[in]    seq           sequence of frame.
+//******************************************************************************
+void apl_mesh_out_push(apl_mesh_out *out, const uint16_t *depth, const uint16_t *ir, uint64_t seq);
+
+//******************************************************************************
+//! \brief        Write queued frames, stop writer thread and free queue.
+//******************************************************************************
+void apl_mesh_out_term(apl_mesh_out *out);
+
+//******************************************************************************
+//! \brief        Get counters, callable from any thread.
+//******************************************************************************
+void apl_mesh_out_get(apl_mesh_out *out, apl_mesh_stat *stat);
+
+#endif	/* H_APL_MESH */
@@ -0,0 +1,80 @@
+//******************************************************************************
+//! \file         apl_metrics.h
+//! \brief        stage latency histograms and local metrics endpoint (Prometheus text format).
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_METRICS
+#define H_APL_METRICS
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_MTR_BUCKET_NUM		(12)	// latency buckets, last one is +Inf
+
+// Measured Stages
+typedef enum {
+	 APL_MTR_STAGE_CAPTURE = 0	// TL_capture (wait for image)
+	,APL_MTR_STAGE_CNV_DP		// apl_cnv_dp
+	,APL_MTR_STAGE_FLY			// apl_fly_run
+	,APL_MTR_STAGE_UPSAMPLE		// apl_jbu_run
+	,APL_MTR_STAGE_STATS		// apl_stats_calc
+	,APL_MTR_STAGE_FILL			// apl_fill_run
+	,APL_MTR_STAGE_RECT			// apl_rect_run
+	,APL_MTR_STAGE_NORMAL		// apl_nrm_run
+	,APL_MTR_STAGE_ROI			// apl_roi_build
+	,APL_MTR_STAGE_SCAN			// apl_scan_calc
+	,APL_MTR_STAGE_BG			// apl_bg_update
+	,APL_MTR_STAGE_PLANE		// apl_plane_fit
+	,APL_MTR_STAGE_SHOW			// apl_show_img
+	,APL_MTR_STAGE_SAVE			// apl_save_file
+	,APL_MTR_STAGE_ENCODE		// video export (encoder thread)
+	,APL_MTR_STAGE_MESH			// mesh export (writer thread, build and write)
+	,APL_MTR_STAGE_LATENCY		// capture timestamp to shown (end to end)
+	,APL_MTR_STAGE_NUM
+} APL_MTR_STAGE;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Monotonic time for apl_mtr_observe(), CLOCK_MONOTONIC as frame timestamps.
+//! \return       time [ns]
+//******************************************************************************
+uint64_t apl_mtr_tick(void);
+
+//******************************************************************************
+//! \brief        Add latency of stage to its histogram, lock free, callable from any thread.
+//! \param[in]    stage         measured stage.
+//! \param[in]    start         apl_mtr_tick() at start of stage.
+//******************************************************************************
+void apl_mtr_observe(APL_MTR_STAGE stage, uint64_t start);
+
+//******************************************************************************
+//! \brief        Serialize telemetry and histograms in Prometheus text format.
+//! \param[out]   out           text.
+//******************************************************************************
+void apl_mtr_format(std::string *out);
+
+//******************************************************************************
+//! \brief        Start endpoint thread.
+//! \param[in]    listen_addr   "unix:<path>" or "[<address>:]<port>", address defaults to 127.0.0.1.
+//! \return       0             success
+//! \return       -1            failed
+//******************************************************************************
+int apl_mtr_start(const char *listen_addr);
+
+//******************************************************************************
+//! \brief        Stop endpoint thread, nothing is done if it is not started.
+//******************************************************************************
+void apl_mtr_stop(void);
+
+#endif	/* H_APL_METRICS */
@@ -0,0 +1,78 @@
+//******************************************************************************
+//! \file         apl_nrm.h
+//! \brief        surface normals of organized depth by lens ray table.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_NRM
+#define H_APL_NRM
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include "apl_lens.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_NRM_TILE		(16)	// rows of tile, tiles run in parallel
+#define APL_NRM_STEP_MAX	(8)		// longest baseline of differences [pixel]
+
+// Surface Normal Stage
+//   P(u, v) = z * (rx[u], ry[v], 1), du = P(u + s, v) - P(u - s, v), dv = P(u, v + s) - P(u, v - s)
+//   n = normalize(dv x du), faces camera (camera coordinate, x right, y down, z forward)
+//   invalid when any of 5 depths is 0 or a neighbor jumps more than jump * depth (discontinuity)
+//   packed normal : byte 0 .. 2 = round(127 * n.x, n.y, n.z) as int8, byte 3 = 0xFF, 0 = invalid
+typedef struct {
+	size_t			w;			// image width
+	size_t			h;			// image height
+	uint32_t		step;		// baseline s [pixel], longer is smoother
+	float			jump;		// neighbor further than jump * depth breaks baseline
+	const float		*rx;		// ray of columns (lens)
+	const float		*ry;		// ray of rows (lens)
+	uint32_t		*valid;		// valid normals, per tile
+} apl_nrm;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Initialize stage, all memory is allocated here (from arena).
+//! \param[out]   nrm           stage.
+//! \param[in]    lens          lens model of depth image.
+//! \param[in]    step          baseline of differences [pixel] (1 .. APL_NRM_STEP_MAX).
+//! \param[in]    jump          relative depth difference of neighbor that is a discontinuity.
+//******************************************************************************
+void apl_nrm_init(apl_nrm *nrm, const apl_lens *lens, uint32_t step, float jump);
+
+//******************************************************************************
+//! \brief        Normals of depth, tiles in parallel.
+//! \param[in]    nrm           stage.
+//! \param[in]    depth         depth [mm] of w x h, 0 = invalid.
+//! \param[out]   map           packed normals of w x h.
+//! \return       valid normals.
+//******************************************************************************
+size_t apl_nrm_run(apl_nrm *nrm, const uint16_t *depth, uint32_t *map);
+
+//******************************************************************************
+//! \brief        Color of packed normals (BGR, r = x, g = y, b = -z), invalid is black.
+//! \param[in]    map           packed normals.
+//! \param[in]    num           pixels.
+//! \param[out]   bgr           3 x num bytes.
+//******************************************************************************
+void apl_nrm_color(const uint32_t *map, size_t num, uint8_t *bgr);
+
+//******************************************************************************
+//! \brief        Normal of packed normal, (0, 0, 0) if invalid.
+//******************************************************************************
+static inline void apl_nrm_unpack(uint32_t packed, float *nx, float *ny, float *nz)
+{
+	*nx = (float)(int8_t)(packed & 0xFFU) * (1.0F / 127.0F);
+	*ny = (float)(int8_t)((packed >> 8) & 0xFFU) * (1.0F / 127.0F);
+	*nz = (float)(int8_t)((packed >> 16) & 0xFFU) * (1.0F / 127.0F);
+}
+
+#endif	/* H_APL_NRM */
@@ -0,0 +1,103 @@
+//******************************************************************************
+//! \file         apl_plane.h
+//! \brief        floor plane estimation, RANSAC on subsampled point cloud of depth.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_PLANE
+#define H_APL_PLANE
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include <mutex>
+
+#include "apl_lens.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_PLANE_BATCH		(16)	// hypotheses scored in parallel between termination checks
+#define APL_PLANE_CONF		(0.99)	// confidence of early termination
+#define APL_PLANE_MIN_RATIO	(0.1F)	// smallest inlier ratio of valid plane
+
+// Plane n.p + d = 0 In Camera Coordinate [mm], |n| = 1, d > 0 (camera is above plane)
+//   height of point p above plane = n.p + d
+typedef struct {
+	uint64_t	seq;			// frame sequence of result
+	bool		valid;			// plane is found
+	bool		warm;			// previous plane was kept as best hypothesis
+	float		n[3];			// unit normal, towards camera
+	float		d;				// distance of camera from plane [mm]
+	float		tilt;			// angle between normal and up [degree]
+	float		rms;			// rms distance of inliers [mm]
+	uint32_t	points;			// valid points of subsampled cloud
+	uint32_t	inliers;		// inliers of subsampled cloud
+	float		inlier_ratio;	// inliers / points
+	uint32_t	hypotheses;		// hypotheses scored
+	uint32_t	mask_inliers;	// inlier pixels of full mask
+} apl_plane_res;
+
+// Plane Estimation Stage
+typedef struct {
+	const apl_lens			*lens;		// lens model of depth image
+	uint16_t				stride;		// subsampling stride in x and y
+	uint32_t				iter_max;	// maximum hypotheses per frame
+	float					thresh;		// inlier distance [mm]
+	float					up[3];		// expected normal of floor in camera coordinate
+	float					cos_tilt;	// cosine of maximum angle between normal and up
+	size_t					pt_num;		// valid points of frame
+	float					*px;		// x of points [mm]
+	float					*py;		// y of points [mm]
+	float					*pz;		// z of points [mm]
+	float					hyp[APL_PLANE_BATCH][4];	// hypotheses of batch (n, d)
+	uint32_t				score[APL_PLANE_BATCH];		// inliers of hypotheses of batch
+	uint64_t				rng;		// state of random number generator
+	apl_plane_res			prev;		// plane of previous frame, warm start
+	std::mutex				mtx;		// mutex for res
+	apl_plane_res			res;		// plane of last frame
+} apl_plane;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Initialize stage, all memory is allocated here (from arena).
+//! \param[out]   pl            stage.
+//! \param[in]    lens          lens model of depth image, kept.
+//! \param[in]    stride        subsampling stride in x and y.
+//! \param[in]    iter_max      maximum hypotheses per frame.
+//! \param[in]    thresh        inlier distance [mm].
+//! \param[in]    up            expected normal of floor in camera coordinate (x right, y down, z forward).
+//! \param[in]    max_tilt      maximum angle between normal and up [degree], hypotheses beyond are rejected.
+//******************************************************************************
+void apl_plane_init(apl_plane *pl, const apl_lens *lens, uint16_t stride, uint32_t iter_max, float thresh,
+					const float up[3], float max_tilt);
+
+//******************************************************************************
+//! \brief        Estimate plane of depth image and make inlier mask.
+//! \details      Previous plane is scored first, hypotheses stop when enough for confidence
+//!               of best inlier ratio. Best plane is refined by least squares of its inliers.
+//! \param[in,out] pl           stage.
+//! \param[in]    dp            depth image [mm], 0 = invalid.
+//! \param[out]   mask          inlier mask of depth image, 255 = inlier, all 0 if no plane is found.
+//******************************************************************************
+void apl_plane_fit(apl_plane *pl, const uint16_t *dp, uint8_t *mask);
+
+//******************************************************************************
+//! \brief        Get plane of last frame, callable from any thread.
+//******************************************************************************
+void apl_plane_get(apl_plane *pl, apl_plane_res *res);
+
+//******************************************************************************
+//! \brief        Height of point above plane [mm].
+//******************************************************************************
+static inline float apl_plane_height(const apl_plane_res *res, float x, float y, float z)
+{
+	return (res->n[0] * x) + (res->n[1] * y) + (res->n[2] * z) + res->d;
+}
+
+#endif	/* H_APL_PLANE */
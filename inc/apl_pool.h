@@ -0,0 +1,77 @@
+//******************************************************************************
+//! \file         apl_pool.h
+//! \brief        persistent worker pool with work-stealing row-band scheduler.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_POOL
+#define H_APL_POOL
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stddef.h>
+
+#include <functional>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+// Cpu Cluster Used By Pool Workers
+typedef enum {
+	 APL_POOL_CLUSTER_ALL = 0	// any core
+	,APL_POOL_CLUSTER_BIG		// big (and prime) cores, highest cpuinfo_max_freq
+	,APL_POOL_CLUSTER_LITTLE	// little cores, lowest cpuinfo_max_freq
+} APL_POOL_CLUSTER;
+
+// Row Band Task, Process Rows [row_begin, row_end)
+typedef std::function<void(size_t row_begin, size_t row_end)> apl_pool_band_fn;
+
+// Independent Task For Fork-Join
+typedef std::function<void(void)> apl_pool_task_fn;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Start worker threads of the pool.
+//! \param[in]    thread_num    number of workers, <= 0 selects (cores in cluster - 1).
+//! \param[in]    cluster       cpu cluster the workers are bound to.
+//! \return       0             success
+//! \return       -1            failed
+//******************************************************************************
+int apl_pool_init(int thread_num, APL_POOL_CLUSTER cluster);
+
+//******************************************************************************
+//! \brief        Stop and join worker threads. Pool falls back to inline execution.
+//******************************************************************************
+void apl_pool_term(void);
+
+//******************************************************************************
+//! \brief        Number of threads executing a fork-join (workers + caller).
+//******************************************************************************
+int apl_pool_thread_num(void);
+
+//******************************************************************************
+//! \brief        Number of cpus belong to the cluster, 0 if unknown.
+//******************************************************************************
+int apl_pool_cluster_cpu_num(APL_POOL_CLUSTER cluster);
+
+//******************************************************************************
+//! \brief        Split rows into bands and run fn on them in parallel, return when all done.
+//! \details      Callable from several threads at once, each caller queues its bands to a deque of its own
+//!               (first 8 caller threads, later ones share them).
+//! \param[in]    rows          number of rows.
+//! \param[in]    grain         rows per band, 0 selects automatically.
+//! \param[in]    fn            band function, called concurrently for disjoint bands.
+//******************************************************************************
+void apl_pool_for(size_t rows, size_t grain, const apl_pool_band_fn &fn);
+
+//******************************************************************************
+//! \brief        Run independent tasks in parallel, return when all done.
+//! \param[in]    tasks         array of tasks.
+//! \param[in]    num           number of tasks.
+//******************************************************************************
+void apl_pool_invoke(const apl_pool_task_fn *tasks, size_t num);
+
+#endif	/* H_APL_POOL */
@@ -0,0 +1,76 @@
+//******************************************************************************
+//! \file         apl_queue.h
+//! \brief        bounded queue of buffers from view thread to a writer thread, frames are dropped when it is full.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_QUEUE
+#define H_APL_QUEUE
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+// Drop Queue Of Buffers Owned By User, Only Pointers Move Between Producer And Consumer
+//   producer : apl_queue_get() -> fill buffer outside of lock -> apl_queue_put()
+//   consumer : apl_queue_pop() -> use buffer -> apl_queue_free()
+typedef struct {
+	std::deque<void *>		free;		// free buffers
+	std::deque<void *>		rdy;		// buffers waiting for consumer
+	std::mutex				mtx;		// mutex for queues, counters, stop (user may guard own counters by it)
+	std::condition_variable	cv;			// signal queued buffer or stop
+	uint32_t				decimate;	// one frame of every decimate frames is queued
+	uint32_t				phase;		// frames until next queued frame
+	uint64_t				offered;	// frames given to apl_queue_get()
+	uint64_t				decimated;	// frames skipped by decimation
+	uint64_t				dropped;	// frames skipped because queue was full
+	bool					stop;		// consumer ends when queue is empty
+} apl_queue;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Empty queue and reset counters, buffers are added by apl_queue_free().
+//! \param[out]   q             queue.
+//! \param[in]    decimate      one frame of every decimate frames is queued (>= 1).
+//******************************************************************************
+void apl_queue_init(apl_queue *q, uint32_t decimate);
+
+//******************************************************************************
+//! \brief        Free buffer for next frame, producer only.
+//! \return       buffer to fill, NULL = frame is decimated or dropped (next frame is tried again, not decimated)
+//******************************************************************************
+void *apl_queue_get(apl_queue *q);
+
+//******************************************************************************
+//! \brief        Hand over filled buffer to consumer, producer only.
+//******************************************************************************
+void apl_queue_put(apl_queue *q, void *buf);
+
+//******************************************************************************
+//! \brief        Wait for next buffer, consumer only.
+//! \return       buffer, NULL = stop is requested and queue is drained
+//******************************************************************************
+void *apl_queue_pop(apl_queue *q);
+
+//******************************************************************************
+//! \brief        Give buffer back (or add buffer at start).
+//******************************************************************************
+void apl_queue_free(apl_queue *q, void *buf);
+
+//******************************************************************************
+//! \brief        Request consumer to end after queued buffers.
+//******************************************************************************
+void apl_queue_stop(apl_queue *q);
+
+#endif	/* H_APL_QUEUE */
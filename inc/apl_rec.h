@@ -0,0 +1,65 @@
+//******************************************************************************
+//! \file         apl_rec.h
+//! \brief        video export of colorized depth and ir windows (MJPEG / AVI), encoded by own thread.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_REC
+#define H_APL_REC
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include <opencv2/opencv.hpp>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_REC_QUEUE_DEF	(4)		// frames waiting for encoder
+
+// Counters Of Recorder
+typedef struct {
+	uint64_t	offered;		// frames given to apl_rec_push()
+	uint64_t	decimated;		// frames skipped by decimation
+	uint64_t	dropped;		// frames skipped because queue was full
+	uint64_t	written;		// frames encoded
+} apl_rec_stat;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Start encoder thread, files are opened at first frame of each stream.
+//! \param[in]    prefix        output "<prefix>_depth.avi" and "<prefix>_ir.avi".
+//! \param[in]    fps           frame rate of camera, files are written at fps / decimate.
+//! \param[in]    decimate      one frame of every decimate frames is recorded (>= 1).
+//! \param[in]    queue_max     frames waiting for encoder, more are dropped (>= 1).
+//! \return       0             success
+//! \return       -1            failed
+//******************************************************************************
+int apl_rec_start(const char *prefix, uint32_t fps, uint32_t decimate, uint32_t queue_max);
+
+//******************************************************************************
+//! \brief        Queue frame for encoder, never blocks on encoder (frame is dropped when queue is full).
+//! \details      Images are copied into buffers owned by recorder, empty image skips its stream.
+//!               Nothing is done if recorder is not started.
+//! \param[in]    depth         colorized depth with overlay, CV_8UC3.
+//! \param[in]    ir            gamma corrected ir with overlay, CV_16UC1.
+//******************************************************************************
+void apl_rec_push(const cv::Mat &depth, const cv::Mat &ir);
+
+//******************************************************************************
+//! \brief        Encode queued frames, stop encoder thread and close files.
+//!               Nothing is done if recorder is not started.
+//******************************************************************************
+void apl_rec_stop(void);
+
+//******************************************************************************
+//! \brief        Get counters, callable from any thread.
+//******************************************************************************
+void apl_rec_get(apl_rec_stat *stat);
+
+#endif	/* H_APL_REC */
@@ -0,0 +1,104 @@
+//******************************************************************************
+//! \file         apl_rect.h
+//! \brief        undistortion (rectification) of depth and ir by fixed point remap table of lens distortion.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_RECT
+#define H_APL_RECT
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include "tl.h"
+#include "apl_lens.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_RECT_TILE		(16)	// rows of tile, tiles run in parallel
+#define APL_RECT_FRAC		(5)		// fractional bits of remap table, 1/32 pixel
+#define APL_RECT_SIZE_MAX	(1023)	// widest image, coordinates are int16 of APL_RECT_FRAC fractional bits
+#define APL_RECT_PRM_FRAC	(16)	// fractional bits of TL_LensPrm::distortion_prm (default)
+
+// Distortion Coefficients (Brown-Conrady) On Normalized Coordinate (x, y) = ((u - cx) / fx, (v - cy) / fy)
+//   xd = x * (1 + k1 r^2 + k2 r^4) + 2 p1 x y + p2 (r^2 + 2 x^2)
+//   yd = y * (1 + k1 r^2 + k2 r^4) + p1 (r^2 + 2 y^2) + 2 p2 x y
+typedef struct {
+	double		k1;			// radial
+	double		k2;
+	double		p1;			// tangential
+	double		p2;
+} apl_rect_coef;
+
+// Rectification Stage Of One Resolution
+//   table is built once : pixel (u, v) of rectified (pinhole) image <- pixel (us, vs) of image as captured
+//   map[2 i], map[2 i + 1] = us, vs in fixed point (APL_RECT_FRAC), -1 = outside of image as captured
+//   depth is sampled at nearest pixel (invalid 0 and edges are never blended), ir bilinearly
+typedef struct {
+	size_t			w;			// image width
+	size_t			h;			// image height
+	int16_t			*map;		// us, vs of each pixel, 2 x w x h
+	uint32_t		outside;	// pixels outside of image as captured (always invalid)
+} apl_rect;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Coefficients of fixed point lens parameters, distortion_prm = k1, k2, p1, p2.
+//! \param[in]    prm           lens parameters (TL_CMD_LENS_INFO).
+//! \param[in]    frac          fractional bits of distortion_prm.
+//! \param[out]   coef          coefficients.
+//! \return       true          lens has distortion
+//! \return       false         all coefficients are 0
+//******************************************************************************
+bool apl_rect_coef_of(const TL_LensPrm *prm, uint32_t frac, apl_rect_coef *coef);
+
+//******************************************************************************
+//! \brief        Append coefficients to lens file of take (apl_lens_save), read back by viewer_convert.
+//! \param[in]    fn            file name.
+//! \param[in]    coef          coefficients.
+//! \param[in]    saved         saved depth and ir are rectified already.
+//! \return       0             success
+//! \return       -1            fopen failed
+//******************************************************************************
+int apl_rect_save(const char *fn, const apl_rect_coef *coef, bool saved);
+
+//******************************************************************************
+//! \brief        Initialize stage and build remap table, all memory is allocated here (from arena).
+//! \param[out]   rect          stage.
+//! \param[in]    lens          pinhole model of rectified image (3D stages use it as it is).
+//! \param[in]    coef          distortion of image as captured.
+//! \return       0             success
+//! \return       -1            image wider than APL_RECT_SIZE_MAX, or no memory
+//******************************************************************************
+int apl_rect_init(apl_rect *rect, const apl_lens *lens, const apl_rect_coef *coef);
+
+//******************************************************************************
+//! \brief        Free remap table.
+//******************************************************************************
+void apl_rect_term(apl_rect *rect);
+
+//******************************************************************************
+//! \brief        Rectify depth and ir of w x h in one pass over table, tiles in parallel.
+//! \param[in]    rect          stage.
+//! \param[in]    depth         depth [mm] as captured, 0 = invalid, NULL = none.
+//! \param[in]    ir            ir as captured, NULL = none.
+//! \param[out]   depth_out     rectified depth, NULL if depth is NULL.
+//! \param[out]   ir_out        rectified ir, NULL if ir is NULL.
+//******************************************************************************
+void apl_rect_run(const apl_rect *rect, const uint16_t *depth, const uint16_t *ir, uint16_t *depth_out, uint16_t *ir_out);
+
+//******************************************************************************
+//! \brief        Rectify mask of depth (e.g. filled depth) at nearest pixel as depth is, tiles in parallel.
+//! \param[in]    rect          stage.
+//! \param[in]    mask          mask as captured.
+//! \param[out]   mask_out      rectified mask, 0 outside of image as captured.
+//******************************************************************************
+void apl_rect_mask(const apl_rect *rect, const uint8_t *mask, uint8_t *mask_out);
+
+#endif	/* H_APL_RECT */
@@ -0,0 +1,96 @@
+//******************************************************************************
+//! \file         apl_roi.h
+//! \brief        summed-area tables of depth, O(1) distance query of rectangles.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_ROI
+#define H_APL_ROI
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include <mutex>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_ROI_MAX		(16)	// regions evaluated every frame
+
+// Rectangle [pixel]
+typedef struct {
+	int		x;		// left
+	int		y;		// top
+	int		w;		// width
+	int		h;		// height
+} apl_roi_rect;
+
+// Distance In Rectangle, Invalid Depth (0) Is Excluded
+typedef struct {
+	uint32_t	area;		// pixels in rectangle (after clipping)
+	uint32_t	valid;		// valid pixels
+	float		coverage;	// valid / area
+	float		mean;		// mean depth [mm]
+	float		var;		// variance of depth [mm^2]
+} apl_roi_res;
+
+// Summed-Area Tables, (w + 1) x (h + 1), Row 0 And Column 0 Are Zero
+typedef struct {
+	size_t					w;			// image width
+	size_t					h;			// image height
+	uint64_t				*sum;		// sum of valid depth
+	uint64_t				*sq;		// sum of squared valid depth
+	uint32_t				*cnt;		// count of valid depth
+	size_t					roi_num;				// configured regions
+	apl_roi_rect			roi[APL_ROI_MAX];		// configured regions
+	std::mutex				mtx;					// mutex for res
+	apl_roi_res				res[APL_ROI_MAX];		// result of configured regions, last frame
+} apl_roi;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Initialize tables, all memory is allocated here (from arena).
+//! \param[out]   roi           tables.
+//! \param[in]    w             image width.
+//! \param[in]    h             image height.
+//******************************************************************************
+void apl_roi_init(apl_roi *roi, size_t w, size_t h);
+
+//******************************************************************************
+//! \brief        Add region evaluated every frame.
+//! \return       0             success
+//! \return       -1            too many regions
+//******************************************************************************
+int apl_roi_add(apl_roi *roi, const apl_roi_rect *rect);
+
+//******************************************************************************
+//! \brief        Build tables from depth image and evaluate configured regions.
+//! \param[in,out] roi          tables.
+//! \param[in]    dp            depth image [mm], 0 = invalid.
+//! \param[in]    skip          pixels counted as invalid (e.g. filled depth), != 0 = skipped, NULL = none.
+//******************************************************************************
+void apl_roi_build(apl_roi *roi, const uint16_t *dp, const uint8_t *skip);
+
+//******************************************************************************
+//! \brief        Query rectangle in O(1), call from the thread building the tables.
+//! \param[in]    roi           tables.
+//! \param[in]    rect          rectangle, clipped to image.
+//! \param[out]   res           result.
+//! \return       0             success
+//! \return       -1            rectangle is outside of image
+//******************************************************************************
+int apl_roi_query(const apl_roi *roi, const apl_roi_rect *rect, apl_roi_res *res);
+
+//******************************************************************************
+//! \brief        Get results of configured regions of last frame, callable from any thread.
+//! \param[out]   res           APL_ROI_MAX results.
+//! \return       number of configured regions.
+//******************************************************************************
+size_t apl_roi_get(apl_roi *roi, apl_roi_rect *rect, apl_roi_res *res);
+
+#endif	/* H_APL_ROI */
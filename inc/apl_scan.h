@@ -0,0 +1,107 @@
+//******************************************************************************
+//! \file         apl_scan.h
+//! \brief        depth to 2D laser scan, minimum range per angle of a band of rows.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_SCAN
+#define H_APL_SCAN
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/socket.h>
+
+#include "apl_lens.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_SCAN_MAGIC		(0x4E435354U)	// "TSCN" in little endian
+#define APL_SCAN_VERSION	(1)
+
+// Scan Message Header, Followed By count float ranges [m], Little Endian
+//   angle of ranges[i] = angle_min + (i * angle_inc), counter-clockwise (left is positive)
+//   range is +inf if there is no return in range_min .. range_max
+typedef struct {
+	uint32_t	magic;		// APL_SCAN_MAGIC
+	uint16_t	version;	// APL_SCAN_VERSION
+	uint16_t	count;		// number of ranges
+	uint64_t	seq;		// scan sequence
+	uint64_t	stamp_ns;	// time of frame, CLOCK_MONOTONIC at capture [ns]
+	float		angle_min;	// angle of first range [rad]
+	float		angle_inc;	// angle between ranges [rad]
+	float		range_min;	// minimum valid range [m]
+	float		range_max;	// maximum valid range [m]
+} __attribute__((packed)) apl_scan_hdr;
+
+// Scan Stage
+typedef struct {
+	uint16_t				w;			// image width
+	uint16_t				row_begin;	// first row of band
+	uint16_t				row_end;	// last row of band + 1
+	uint16_t				range_min;	// minimum valid depth [mm]
+	uint16_t				range_max;	// maximum valid depth [mm]
+	float					*col_fac;	// depth to range in x-z plane of each column, sqrt(1 + rx^2)
+	uint16_t				*col_bin;	// angle bin of each column
+	uint16_t				*col_min;	// minimum depth - max(range_min, 1) of each column (0xFFFF = none)
+	uint8_t					*msg;		// apl_scan_hdr + ranges
+	size_t					msg_size;	// size of msg
+	int						fd;			// socket, -1 = none
+	struct sockaddr_storage	dst;		// destination of socket
+	socklen_t				dst_len;	// size of dst
+	FILE					*fp;		// file, NULL = none
+} apl_scan;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Initialize scan stage, angle tables and buffers are allocated here (from arena).
+//! \param[out]   scan          scan stage.
+//! \param[in]    lens          lens model of depth image.
+//! \param[in]    row_begin     first row of band.
+//! \param[in]    row_end       last row of band + 1.
+//! \param[in]    bins          number of angles, 0 = image width.
+//! \param[in]    range_min     minimum valid depth [mm].
+//! \param[in]    range_max     maximum valid depth [mm].
+//! \return       0             success
+//! \return       -1            bad band or bins
+//******************************************************************************
+int apl_scan_init(apl_scan *scan, const apl_lens *lens, uint16_t row_begin, uint16_t row_end,
+				  uint16_t bins, uint16_t range_min, uint16_t range_max);
+
+//******************************************************************************
+//! \brief        Change valid depth range (ranging mode), call while apl_scan_calc() is not running.
+//! \param[in,out] scan         scan stage.
+//! \param[in]    range_min     minimum valid depth [mm].
+//! \param[in]    range_max     maximum valid depth [mm].
+//******************************************************************************
+void apl_scan_range(apl_scan *scan, uint16_t range_min, uint16_t range_max);
+
+//******************************************************************************
+//! \brief        Open output of scans.
+//! \param[in]    output        "udp:<address>:<port>", "unix:<path>" (datagram) or "file:<path>" (appended).
+//! \return       0             success
+//! \return       -1            failed
+//******************************************************************************
+int apl_scan_open(apl_scan *scan, const char *output);
+
+//******************************************************************************
+//! \brief        Compute scan of depth image and publish it, scan is dropped if socket is busy.
+//! \param[in,out] scan         scan stage.
+//! \param[in]    dp            depth image [mm], 0 = invalid.
+//! \param[in]    stamp_ns      time of frame [ns].
+//! \return       scan message (apl_scan_hdr + ranges).
+//******************************************************************************
+const apl_scan_hdr *apl_scan_calc(apl_scan *scan, const uint16_t *dp, uint64_t stamp_ns);
+
+//******************************************************************************
+//! \brief        Close output of scans.
+//******************************************************************************
+void apl_scan_close(apl_scan *scan);
+
+#endif	/* H_APL_SCAN */
@@ -0,0 +1,119 @@
+//******************************************************************************
+//! \file         apl_stamp.h
+//! \brief        per-frame capture timestamps (CLOCK_MONOTONIC / CLOCK_REALTIME), inter-frame jitter and latency.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_STAMP
+#define H_APL_STAMP
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+
+#include "tl.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_STAMP_BUCKET_NUM	(8)		// buckets of |interval - period|, last one is +Inf
+#define APL_STAMP_LATE			(1.5)	// interval longer than this x period is a late (skipped) frame
+
+// Frame Buffer, TL_Image Is First So That Buffers Are Passed As TL_Image * (TL_capture Fills It)
+typedef struct {
+	TL_Image	img;		// image of libcistof
+	uint64_t	seq;		// sequence of stamped frames
+	uint64_t	mono_ns;	// CLOCK_MONOTONIC right after TL_capture [ns]
+	uint64_t	real_ns;	// CLOCK_REALTIME right after TL_capture [ns], 0 = not stamped
+	TL_E_MODE	mode;		// ranging mode of frame, view thread follows mode switch by it
+	uint8_t		*fill;		// mask of depth, 1 = filled (inferred), NULL = holes are not filled
+	uint32_t	*nrm;		// packed normals of depth (apl_nrm.h), NULL = normals are not computed
+	uint8_t		*plane;		// inlier mask of floor plane (apl_plane.h), 255 = inlier, NULL = plane is not fitted
+	uint8_t		*fg;		// foreground mask of background model (apl_bg.h), 255 = foreground, NULL = no model
+	uint16_t	*rect_dp;	// rectified depth (apl_rect.h), NULL = not rectified
+	uint16_t	*rect_ir;	// rectified ir, NULL = not rectified
+} apl_frm;
+
+// Jitter And Latency Snapshot
+typedef struct {
+	uint64_t	frames;							// stamped frames
+	uint64_t	intervals;						// inter-frame intervals measured
+	double		period_ms;						// nominal interval of ranging mode
+	double		mean_ms;						// mean interval
+	double		jitter_ms;						// standard deviation of interval
+	double		min_ms;							// shortest interval
+	double		max_ms;							// longest interval
+	uint64_t	late;							// intervals longer than APL_STAMP_LATE x period
+	uint64_t	dev[APL_STAMP_BUCKET_NUM];		// |interval - period| histogram, not cumulative
+	double		dev_sum_ms;						// sum of |interval - period|
+	uint64_t	latency_num;					// frames shown
+	double		latency_mean_ms;				// capture to view
+	double		latency_max_ms;
+} apl_stamp_snapshot;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Frame buffer of image.
+//******************************************************************************
+static inline apl_frm *apl_frm_of(TL_Image *img)
+{
+	return reinterpret_cast<apl_frm *>(img);
+}
+
+static inline const apl_frm *apl_frm_of(const TL_Image *img)
+{
+	return reinterpret_cast<const apl_frm *>(img);
+}
+
+//******************************************************************************
+//! \brief        CLOCK_MONOTONIC [ns].
+//******************************************************************************
+uint64_t apl_stamp_mono(void);
+
+//******************************************************************************
+//! \brief        Reset statistics of device, e.g. at start of capture or mode switch.
+//! \param[in]    dev           device index (< APL_DEV_MAX).
+//! \param[in]    fps           nominal frame rate of ranging mode.
+//! \param[in]    realtime      stamp CLOCK_REALTIME as well.
+//! \details      Capture thread of device, or before it starts.
+//******************************************************************************
+void apl_stamp_init(uint8_t dev, uint16_t fps, bool realtime);
+
+//******************************************************************************
+//! \brief        Forget previous frame, capture was stopped and the gap is not an interval.
+//!               Capture thread of device only.
+//******************************************************************************
+void apl_stamp_resume(uint8_t dev);
+
+//******************************************************************************
+//! \brief        Stamp frame right after TL_capture, and measure interval from previous frame.
+//!               Capture thread of device only.
+//******************************************************************************
+void apl_stamp_frame(uint8_t dev, TL_Image *img);
+
+//******************************************************************************
+//! \brief        Measure latency from capture to now (frame is shown). View thread only.
+//******************************************************************************
+void apl_stamp_latency(uint8_t dev, const TL_Image *img);
+
+//******************************************************************************
+//! \brief        Get statistics, callable from any thread, never blocks capture and view thread.
+//******************************************************************************
+void apl_stamp_get(uint8_t dev, apl_stamp_snapshot *snap);
+
+//******************************************************************************
+//! \brief        Print jitter and latency report.
+//******************************************************************************
+void apl_stamp_report(uint8_t dev, FILE *fp);
+
+//******************************************************************************
+//! \brief        Upper bound of deviation bucket [ms], last bucket is +Inf.
+//******************************************************************************
+double apl_stamp_bucket_le(size_t bucket);
+
+#endif	/* H_APL_STAMP */
@@ -0,0 +1,102 @@
+//******************************************************************************
+//! \file         apl_stats.h
+//! \brief        per-frame depth statistics and auto range.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_STATS
+#define H_APL_STATS
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include <mutex>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_STATS_BIN_NUM		(2048)	// histogram bins
+#define APL_STATS_PART_NUM		(8)		// partial histograms, merged after parallel pass
+
+// Percentiles Reported
+typedef enum {
+	 APL_STATS_P01 = 0	// 1%
+	,APL_STATS_P05		// 5%
+	,APL_STATS_P50		// 50% (median)
+	,APL_STATS_P95		// 95%
+	,APL_STATS_P99		// 99%
+	,APL_STATS_PCT_NUM
+} APL_STATS_PCT;
+
+// Depth Statistics Of One Frame, Invalid Depth (0) Is Excluded
+typedef struct {
+	uint64_t	seq;						// frame sequence of statistics
+	uint32_t	sampled;					// sampled pixels
+	uint32_t	valid;						// valid sampled pixels
+	float		valid_ratio;				// valid / sampled
+	uint16_t	min;						// minimum depth [mm]
+	uint16_t	max;						// maximum depth [mm]
+	float		mean;						// mean depth [mm]
+	uint16_t	pct[APL_STATS_PCT_NUM];		// percentiles [mm]
+	uint16_t	range_near;					// smoothed auto range, near [mm]
+	uint16_t	range_far;					// smoothed auto range, far [mm]
+} apl_dp_stats;
+
+// Statistics Stage
+typedef struct {
+	uint16_t				stride;			// sampling stride in x and y
+	uint16_t				bin_shift;		// depth >> bin_shift = bin
+	float					alpha;			// smoothing factor of auto range
+	float					near_s;			// smoothed near
+	float					far_s;			// smoothed far
+	uint32_t				*part;			// partial histograms [APL_STATS_PART_NUM][APL_STATS_BIN_NUM]
+	uint32_t				*work;			// histogram being merged, swapped with hist
+	uint32_t				*hist;			// histogram of last frame
+	std::mutex				mtx;			// mutex for res, hist
+	apl_dp_stats			res;			// statistics of last frame
+} apl_stats;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Initialize statistics stage, all memory is allocated here (from arena).
+//! \param[out]   st            statistics stage.
+//! \param[in]    max_depth     largest depth to resolve [mm], larger depth counts in last bin.
+//! \param[in]    stride        sampling stride in x and y (1 = every pixel).
+//! \param[in]    alpha         smoothing factor of auto range (0 < alpha <= 1).
+//******************************************************************************
+void apl_stats_init(apl_stats *st, uint16_t max_depth, uint16_t stride, float alpha);
+
+//******************************************************************************
+//! \brief        Change depth range (ranging mode), no memory is allocated.
+//! \param[in,out] st           statistics stage, call while apl_stats_calc() is not running.
+//! \param[in]    max_depth     largest depth to resolve [mm].
+//******************************************************************************
+void apl_stats_range(apl_stats *st, uint16_t max_depth);
+
+//******************************************************************************
+//! \brief        Compute statistics of depth image, one pass on worker pool.
+//! \param[in,out] st           statistics stage.
+//! \param[in]    dp            depth image [mm], 0 = invalid.
+//! \param[in]    w             width.
+//! \param[in]    h             height.
+//******************************************************************************
+void apl_stats_calc(apl_stats *st, const uint16_t *dp, size_t w, size_t h);
+
+//******************************************************************************
+//! \brief        Get statistics of last frame, callable from any thread.
+//******************************************************************************
+void apl_stats_get(apl_stats *st, apl_dp_stats *res);
+
+//******************************************************************************
+//! \brief        Copy histogram of last frame, callable from any thread.
+//! \param[out]   hist          APL_STATS_BIN_NUM bins.
+//! \return       bin width [mm]
+//******************************************************************************
+uint32_t apl_stats_get_hist(apl_stats *st, uint32_t *hist);
+
+#endif	/* H_APL_STATS */
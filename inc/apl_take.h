@@ -0,0 +1,228 @@
+//******************************************************************************
+//! \file         apl_take.h
+//! \brief        take file of frames with crc32c and sequence, append-only index for random access.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_TAKE
+#define H_APL_TAKE
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include <vector>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_TAKE_VERSION	(1)
+#define APL_TAKE_PLANE_MAX	(8)				// planes of frame
+#define APL_TAKE_FILE_MAGIC	"TOFTAKE1"		// first 8 bytes of take
+#define APL_TAKE_IDX_MAGIC	"TOFTIDX1"		// first 8 bytes of index
+#define APL_TAKE_FRM_MAGIC	(0x4D524654U)	// "TFRM", first 4 bytes of frame record
+#define APL_TAKE_IDX_SUFFIX	".idx"			// index of <name>.take is <name>.take.idx
+
+// File Header Of Take And Index (Little Endian)
+typedef struct __attribute__((packed)) {
+	char		magic[8];		// APL_TAKE_FILE_MAGIC or APL_TAKE_IDX_MAGIC
+	uint32_t	version;		// APL_TAKE_VERSION
+	uint32_t	crc;			// crc32c of fields before it
+} apl_take_file_hdr;
+
+// Plane Of Frame Record, w x h x bpp Bytes In Payload
+typedef struct __attribute__((packed)) {
+	char		tag[2];			// "dp", "ir", "cf", "rf", "fm" (fill mask), "nm" (normals), "pm" (plane mask), "bm" (foreground mask)
+	uint16_t	bpp;			// bytes per pixel
+	uint16_t	w;
+	uint16_t	h;
+} apl_take_plane;
+
+// Header Of Frame Record, Followed By plane_num Planes Of Table, Then Payload (Planes In Order)
+//   record = header + plane table + payload, records follow each other from end of file header
+typedef struct __attribute__((packed)) {
+	uint32_t	magic;			// APL_TAKE_FRM_MAGIC, records are found again by it after corruption
+	uint16_t	plane_num;		// planes (<= APL_TAKE_PLANE_MAX)
+	uint16_t	reserved;
+	uint32_t	idx;			// frame of take, 0, 1, ...
+	uint32_t	payload;		// bytes of planes
+	uint64_t	seq;			// sequence of capture, gaps are lost frames
+	uint64_t	mono_ns;		// CLOCK_MONOTONIC of capture [ns]
+	uint64_t	real_ns;		// CLOCK_REALTIME of capture [ns], 0 = not stamped
+	uint32_t	payload_crc;	// crc32c of payload
+	uint32_t	hdr_crc;		// crc32c of header before it and plane table
+} apl_take_hdr;
+
+// Entry Of Index, Appended After Its Record Is Written
+typedef struct __attribute__((packed)) {
+	uint64_t	off;			// offset of record in take
+	uint64_t	seq;
+	uint64_t	mono_ns;
+	uint32_t	idx;
+	uint32_t	bytes;			// bytes of record
+	uint32_t	crc;			// crc32c of fields before it
+} apl_take_idx;
+
+// Frame To Write, Or Frame Read (Planes Point Into Buffer Of Reader)
+typedef struct {
+	apl_take_hdr	hdr;
+	apl_take_plane	plane[APL_TAKE_PLANE_MAX];
+	const void		*data[APL_TAKE_PLANE_MAX];
+} apl_take_frame;
+
+// Writer, Record Is Flushed Before Its Index Entry So That Index Never Points Past Data
+typedef struct {
+	FILE			*fp;			// take
+	FILE			*idx;			// index
+	uint64_t		off;			// offset of next record
+	uint32_t		frames;			// frames written
+	uint32_t		sync;			// frames between fdatasync of take, 0 = flushed to kernel only
+	bool			failed;			// write failed, take ends at off and takes no more frames
+} apl_take_writer;
+
+// Index Of Take At Open
+typedef enum {
+	 APL_TAKE_IDX_READ = 0	// consistent entries as written, nothing is scanned or written (verification)
+	,APL_TAKE_IDX_SCAN		// checked against take and completed by scan of record headers, in memory only
+	,APL_TAKE_IDX_REBUILD	// whole take is scanned and index is written again
+} APL_TAKE_IDX_MODE;
+
+// Reader, Index Is Checked Against Take And Completed By Scan
+typedef struct {
+	FILE						*fp;		// take
+	uint64_t					size;		// bytes of take
+	std::vector<apl_take_idx>	idx;		// records of take
+	uint64_t					skipped;	// bytes of take not in any record (corrupt or truncated)
+	bool						idx_ok;		// index file is complete and consistent (or was written again)
+	bool						rebuilt;	// index was written again
+	std::vector<uint8_t>		buf;		// payload of frame read
+} apl_take_reader;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        CRC-32C (Castagnoli), hardware instruction (SSE4.2 / ARMv8 CRC) when available.
+//! \param[in]    crc           crc of preceding data, 0 at first.
+//! \param[in]    data          data.
+//! \param[in]    len           bytes.
+//! \return       crc of preceding data and data.
+//******************************************************************************
+uint32_t apl_crc32c(uint32_t crc, const void *data, size_t len);
+
+//******************************************************************************
+//! \brief        Name of crc32c implementation in use, e.g. "sse4.2".
+//******************************************************************************
+const char *apl_crc32c_impl(void);
+
+//******************************************************************************
+//! \brief        Start frame to write.
+//! \param[out]   frm           frame.
+//! \param[in]    idx           frame of take.
+//! \param[in]    seq           sequence of capture.
+//! \param[in]    mono_ns       CLOCK_MONOTONIC of capture.
+//! \param[in]    real_ns       CLOCK_REALTIME of capture.
+//******************************************************************************
+void apl_take_frame_init(apl_take_frame *frm, uint32_t idx, uint64_t seq, uint64_t mono_ns, uint64_t real_ns);
+
+//******************************************************************************
+//! \brief        Add plane to frame, ignored beyond APL_TAKE_PLANE_MAX or if data is NULL.
+//! \param[in,out] frm          frame.
+//! \param[in]    tag           2 characters, e.g. "dp".
+//! \param[in]    bpp           bytes per pixel.
+//! \param[in]    w             width.
+//! \param[in]    h             height.
+//! \param[in]    data          w x h x bpp bytes, kept until frame is written.
+//******************************************************************************
+void apl_take_frame_add(apl_take_frame *frm, const char *tag, uint16_t bpp, uint16_t w, uint16_t h, const void *data);
+
+//******************************************************************************
+//! \brief        Create take and its index.
+//! \param[out]   wr            writer.
+//! \param[in]    fn            file name of take, index is fn + APL_TAKE_IDX_SUFFIX.
+//! \param[in]    sync          frames between fdatasync, 0 = never.
+//! \return       0             success
+//! \return       -1            fopen failed
+//******************************************************************************
+int apl_take_open(apl_take_writer *wr, const char *fn, uint32_t sync);
+
+//******************************************************************************
+//! \brief        Append frame, then its index entry.
+//! \details      Partial record of failed write is cut off, take stays valid up to last frame written.
+//! \param[in]    wr            writer.
+//! \param[in,out] frm          frame, crc and payload of header are set.
+//! \return       0             success
+//! \return       -1            fwrite failed (now or before), close take
+//******************************************************************************
+int apl_take_write(apl_take_writer *wr, apl_take_frame *frm);
+
+//******************************************************************************
+//! \brief        Close take and index (synced).
+//******************************************************************************
+void apl_take_close(apl_take_writer *wr);
+
+//******************************************************************************
+//! \brief        Check file header of take.
+//! \param[in]    fp            take, positioned after file header on success.
+//! \param[out]   size          bytes of take.
+//! \return       0             take of APL_TAKE_VERSION
+//! \return       -1            not a take
+//******************************************************************************
+int apl_take_check(FILE *fp, uint64_t *size);
+
+//******************************************************************************
+//! \brief        Bytes of record of frame (header, plane table and payload).
+//******************************************************************************
+static inline uint64_t apl_take_rec_bytes(const apl_take_frame *frm)
+{
+	return sizeof(apl_take_hdr) + (frm->hdr.plane_num * sizeof(apl_take_plane)) + frm->hdr.payload;
+}
+
+//******************************************************************************
+//! \brief        Header and plane table of first valid record at or after offset.
+//! \param[in]    fp            take, positioned at payload of record found on success.
+//! \param[in]    size          bytes of take.
+//! \param[in,out] off          offset to look at, offset of record found.
+//! \param[out]   frm           header and planes (data is not read).
+//! \param[out]   skipped       bytes skipped to find record (corruption), NULL = not counted.
+//! \return       0             record found, its payload ends within take
+//! \return       -1            no more record (end of take, or truncated record)
+//******************************************************************************
+int apl_take_next(FILE *fp, uint64_t size, uint64_t *off, apl_take_frame *frm, uint64_t *skipped);
+
+//******************************************************************************
+//! \brief        Open take for random access, index is loaded and, by mode, checked and completed by scan
+//!               of record headers. Index file is written only by APL_TAKE_IDX_REBUILD.
+//! \param[out]   rd            reader.
+//! \param[in]    fn            file name of take.
+//! \param[in]    mode          handling of index.
+//! \return       0             success
+//! \return       -1            not a take
+//******************************************************************************
+int apl_take_ropen(apl_take_reader *rd, const char *fn, APL_TAKE_IDX_MODE mode);
+
+//******************************************************************************
+//! \brief        Read frame of take by index entry, payload crc is checked.
+//! \param[in]    rd            reader.
+//! \param[in]    n             entry of index (record n of take).
+//! \param[out]   frm           frame, planes point into buffer of reader until next read.
+//! \return       0             success
+//! \return       -1            read failed or crc mismatch
+//******************************************************************************
+int apl_take_read(apl_take_reader *rd, size_t n, apl_take_frame *frm);
+
+//******************************************************************************
+//! \brief        Entry of index of frame (idx of header), binary search.
+//! \return       entry, or SIZE_MAX if frame is not in take.
+//******************************************************************************
+size_t apl_take_find(const apl_take_reader *rd, uint32_t idx);
+
+//******************************************************************************
+//! \brief        Close take.
+//******************************************************************************
+void apl_take_rclose(apl_take_reader *rd);
+
+#endif	/* H_APL_TAKE */
@@ -0,0 +1,112 @@
+//******************************************************************************
+//! \file         apl_telemetry.h
+//! \brief        frame loss and sensor-health telemetry.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_TELEMETRY
+#define H_APL_TELEMETRY
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+
+#include "tl.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_TLM_RATE_WINDOW		(10)	// window of rolling rates [s]
+#define APL_TLM_TEMP_WINDOW		(60)	// window of temperature trend [s]
+
+// Counted Notify Flags
+typedef enum {
+	 APL_TLM_NOTIFY_IMAGE = 0	// TL_NOTIFY_IMAGE
+	,APL_TLM_NOTIFY_NO_BUFFER	// TL_NOTIFY_NO_BUFFER
+	,APL_TLM_NOTIFY_DISCONNECT	// TL_NOTIFY_DISCONNECT
+	,APL_TLM_NOTIFY_DEVICE_ERR	// TL_NOTIFY_DEVICE_ERR
+	,APL_TLM_NOTIFY_SYSTEM_ERR	// TL_NOTIFY_SYSTEM_ERR
+	,APL_TLM_NOTIFY_STOPPED		// TL_NOTIFY_STOPPED
+	,APL_TLM_NOTIFY_NUM
+} APL_TLM_NOTIFY;
+
+#define APL_TLM_RESULT_NUM		(TL_E_ERR_OTHER + 1)	// counted TL_E_RESULT values
+
+// Telemetry Snapshot
+typedef struct {
+	uint64_t	capture;						// TL_capture calls
+	uint64_t	frames;							// received images
+	uint64_t	lost;							// images missing in frm_index sequence (sensor/library side)
+	uint64_t	duplicate;						// images of same frm_index as previous one (not lost)
+	uint64_t	frame_error;					// images with stFrmInfo::frame_error
+	uint64_t	pipeline_drop;					// images dropped by viewer pipeline (view behind capture)
+	uint64_t	notify[APL_TLM_NOTIFY_NUM];		// count of each notify flag
+	uint64_t	result[APL_TLM_RESULT_NUM];		// count of each TL_capture result
+	float		fps;							// received images per second, over rate window
+	float		lost_rate;						// lost images per second, over rate window
+	float		drop_rate;						// pipeline drops per second, over rate window
+	float		error_rate;						// failed TL_capture per second, over rate window
+	float		temp;							// latest temperature [degree]
+	float		temp_slope;						// temperature trend [degree/min], over temperature window
+} apl_tlm_snapshot;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Reset telemetry of device.
+//! \param[in]    dev           device index (< APL_DEV_MAX).
+//! \param[in]    fps           nominal frame rate of ranging mode, used to resolve frm_index wraparound.
+//******************************************************************************
+void apl_tlm_init(uint8_t dev, uint16_t fps);
+
+//******************************************************************************
+//! \brief        Ranging mode is changed while capture is stopped, call from capture thread of device only.
+//! \param[in]    dev           device index.
+//! \param[in]    fps           nominal frame rate of new ranging mode.
+//******************************************************************************
+void apl_tlm_mode(uint8_t dev, uint16_t fps);
+
+//******************************************************************************
+//! \brief        Account result of one TL_capture, call from capture thread of device only.
+//! \param[in]    dev           device index.
+//! \param[in]    ret           return value of TL_capture.
+//! \param[in]    notify        notification of TL_capture.
+//! \param[in]    img           image of TL_capture, used if TL_NOTIFY_IMAGE is notified.
+//******************************************************************************
+void apl_tlm_capture(uint8_t dev, TL_E_RESULT ret, uint32_t notify, const TL_Image *img);
+
+//******************************************************************************
+//! \brief        Account an image dropped by viewer pipeline.
+//******************************************************************************
+void apl_tlm_pipeline_drop(uint8_t dev);
+
+//******************************************************************************
+//! \brief        Get snapshot of counters and rates, callable from any thread.
+//******************************************************************************
+void apl_tlm_get(uint8_t dev, apl_tlm_snapshot *snap);
+
+//******************************************************************************
+//! \brief        Print snapshot of device.
+//******************************************************************************
+void apl_tlm_report(uint8_t dev, FILE *fp);
+
+//******************************************************************************
+//! \brief        Number of initialized devices (highest device index + 1).
+//******************************************************************************
+size_t apl_tlm_dev_num(void);
+
+//******************************************************************************
+//! \brief        Name of counted notify flag.
+//******************************************************************************
+const char *apl_tlm_notify_name(size_t notify);
+
+//******************************************************************************
+//! \brief        Name of counted TL_capture result.
+//******************************************************************************
+const char *apl_tlm_result_name(size_t result);
+
+#endif	/* H_APL_TELEMETRY */
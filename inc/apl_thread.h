@@ -0,0 +1,81 @@
+//******************************************************************************
+//! \file         apl_thread.h
+//! \brief        thread creation with scheduling policy, priority and cpu affinity per role.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_THREAD
+#define H_APL_THREAD
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+// Thread Role, Each Role Has Own Scheduling Setting
+typedef enum {
+	 APL_THR_ROLE_CAPTURE = 0	// TL_capture loop
+	,APL_THR_ROLE_PROCESS		// worker pool (per-frame kernels)
+	,APL_THR_ROLE_DISPLAY		// OpenCV HighGUI
+	,APL_THR_ROLE_RECORDER		// file / video output
+	,APL_THR_ROLE_USER_INPUT	// user command
+	,APL_THR_ROLE_SERVICE		// metrics / control endpoints
+	,APL_THR_ROLE_NUM
+} APL_THR_ROLE;
+
+// Scheduling Setting
+typedef struct {
+	int			policy;		// SCHED_OTHER, SCHED_FIFO, SCHED_RR
+	int			priority;	// static priority for SCHED_FIFO/SCHED_RR, nice for SCHED_OTHER
+	uint64_t	cpu_mask;	// bit n = cpu n, 0 = no affinity (any cpu)
+} apl_thr_sched;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Load scheduling setting of all roles from configuration.
+//! \details      key "thread.<role>" = "<other|fifo|rr> <priority> <cpus>",
+//!               e.g. "thread.capture = fifo 80 4-7", cpus "all" for no affinity.
+//******************************************************************************
+void apl_thr_load_cfg(void);
+
+//******************************************************************************
+//! \brief        Get requested scheduling setting of a role.
+//******************************************************************************
+const apl_thr_sched *apl_thr_get_req(APL_THR_ROLE role);
+
+//******************************************************************************
+//! \brief        Create thread with scheduling setting of the role.
+//! \details      If requested setting is refused (e.g. EPERM for SCHED_FIFO), the thread
+//!               is created with default attributes and the result is recorded.
+//! \param[out]   thr           created thread.
+//! \param[in]    role          thread role.
+//! \param[in]    name          thread name (max 15 characters).
+//! \param[in]    fn            thread function.
+//! \param[in]    arg           argument of thread function.
+//! \return       0             success (setting may be partially granted)
+//! \return       -1            failed to create thread
+//******************************************************************************
+int apl_thr_create(pthread_t *thr, APL_THR_ROLE role, const char *name, void *(*fn)(void *), void *arg);
+
+//******************************************************************************
+//! \brief        Create thread with scheduling setting of the role, on given cpus unless cpus of the role are configured.
+//! \details      Same as apl_thr_create(), the cpus are applied at creation and recorded as granted.
+//! \param[in]    cpus          cpus used when role has no cpus configured, NULL = any cpu.
+//! \return       0             success (setting may be partially granted)
+//! \return       -1            failed to create thread
+//******************************************************************************
+int apl_thr_create_on(pthread_t *thr, APL_THR_ROLE role, const char *name, void *(*fn)(void *), void *arg, const cpu_set_t *cpus);
+
+//******************************************************************************
+//! \brief        Print requested and granted scheduling setting of created threads.
+//******************************************************************************
+void apl_thr_report(void);
+
+#endif	/* H_APL_THREAD */
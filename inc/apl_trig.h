@@ -0,0 +1,116 @@
+//******************************************************************************
+//! \file         apl_trig.h
+//! \brief        pre-trigger ring of frames, dumped to raw files or take in background on trigger.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+#ifndef H_APL_TRIG
+#define H_APL_TRIG
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+#include "tl.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+// State Of Ring
+typedef enum {
+	 APL_TRIG_STATE_RECORD = 0	// frames are swapped into ring
+	,APL_TRIG_STATE_POST		// triggered, post-trigger frames are swapped into ring
+	,APL_TRIG_STATE_DUMP		// ring is frozen and written by dump thread
+} APL_TRIG_STATE;
+
+// Pre-Trigger Ring
+//   Ring owns its own frame buffers, a frame is recorded by swapping its buffer with the oldest of ring,
+//   so frame buffers of capture / view never run short and steady state does not copy.
+typedef struct {
+	uint32_t				cap;		// frame buffers of ring, for fastest ranging mode
+	uint32_t				num;		// frames of ring at frame rate of mode (<= cap)
+	uint32_t				post;		// post-trigger frames (pre-trigger = num - post)
+	float					pre_sec;	// pre-trigger length [s]
+	float					post_sec;	// post-trigger length [s]
+	uint32_t				fps_next;	// frame rate of mode switched during trigger, 0 = none
+	TL_Resolution			reso;		// resolution of frames
+	size_t					siz[4];		// bytes of depth, ir, confdata, irnrref plane
+	size_t					bytes;		// memory of ring
+	TL_Image				**slot;		// frame buffers of ring
+	uint32_t				head;		// next slot to be swapped (= oldest frame when ring is full)
+	uint32_t				count;		// frames in ring
+	uint32_t				post_left;	// post-trigger frames until dump
+	uint32_t				fire_at;	// frames in ring at trigger
+	time_t					fire_time;	// wall clock at trigger, name of dump
+	std::atomic<bool>		fire;		// trigger request, async-signal-safe
+	std::mutex				mtx;		// mutex for state, head, count
+	std::condition_variable	cv;			// signal dump or stop
+	APL_TRIG_STATE			state;
+	bool					stop;		// dump thread ends
+	bool					started;
+	pthread_t				thr;		// dump thread
+	std::string				dir;		// output directory
+	bool					take;		// dump is one take (apl_take) instead of raw files
+	uint64_t				fired;		// triggers accepted
+	uint64_t				ignored;	// triggers while previous one is in progress
+} apl_trig;
+
+//******************************************************************************
+// Functions
+//******************************************************************************
+//******************************************************************************
+//! \brief        Allocate ring (from arena) and start dump thread.
+//! \param[out]   trig          ring.
+//! \param[in]    reso          resolution of frames.
+//! \param[in]    fps           frame rate.
+//! \param[in]    fps_max       fastest frame rate of enabled modes, buffers of ring are allocated for it.
+//! \param[in]    pre_sec       pre-trigger length [s].
+//! \param[in]    post_sec      post-trigger length [s].
+//! \param[in]    dir           output directory of dump.
+//! \param[in]    take          dump to trig_<time>.take (crc32c, index) instead of raw files.
+//! \return       0             success
+//! \return       -1            failed
+//******************************************************************************
+int apl_trig_init(apl_trig *trig, TL_Resolution reso, uint32_t fps, uint32_t fps_max, float pre_sec, float post_sec,
+				  const char *dir, bool take);
+
+//******************************************************************************
+//! \brief        Resize ring to frame rate of switched mode, no memory is allocated.
+//! \details      Frames of ring are discarded. While trigger is in progress, ring is resized after its dump.
+//! \param[in,out] trig         ring.
+//! \param[in]    fps           frame rate of mode.
+//******************************************************************************
+void apl_trig_fps(apl_trig *trig, uint32_t fps);
+
+//******************************************************************************
+//! \brief        Stop dump thread (dump in progress is finished) and free ring.
+//******************************************************************************
+void apl_trig_term(apl_trig *trig);
+
+//******************************************************************************
+//! \brief        Request dump, callable from any thread and from signal handler.
+//******************************************************************************
+static inline void apl_trig_fire(apl_trig *trig)
+{
+	trig->fire.store(true);
+}
+
+//******************************************************************************
+//! \brief        Record frame, called once per frame when frame is not used any more.
+//! \details      Buffer of frame is swapped with the oldest buffer of ring, which is returned instead.
+//!               While ring is dumped, frame is returned as it is.
+//! \param[in,out] trig         ring.
+//! \param[in,out] frm          frame buffer, replaced by buffer to be released.
+//******************************************************************************
+void apl_trig_put(apl_trig *trig, TL_Image **frm);
+
+#endif	/* H_APL_TRIG */
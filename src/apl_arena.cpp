@@ -0,0 +1,247 @@
+//******************************************************************************
+//! \file         apl_arena.cpp
+//! \brief        huge page backed arena of frame buffers and stage workspaces.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <malloc.h>
+#include <sys/mman.h>
+
+#include <mutex>
+
+#include "apl_arena.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_ARENA_HUGE_SIZE		((size_t)2 * 1024 * 1024)	// huge page size (arm64 / x86_64 default)
+#define APL_ARENA_THP_ENABLED	"/sys/kernel/mm/transparent_hugepage/enabled"
+
+static const char *PAGE_NAME[] = { "4k", "thp", "hugetlb" };
+
+static std::mutex		sMtx;
+static uint8_t			*sMap = NULL;		// mapping
+static size_t			sMapSize = 0;		// size of mapping
+static uint8_t			*sBase = NULL;		// arena, aligned to huge page
+static size_t			sSize = 0;			// size of arena
+static size_t			sUsed = 0;			// allocated bytes of arena
+static size_t			sHeap = 0;			// allocated bytes of heap (fallback), not yet freed
+static APL_ARENA_PAGE	sPage = APL_ARENA_PAGE_4K;	// granted backing pages
+static bool				sLocked = false;	// mlock succeeded
+
+//******************************************************************************
+//! \brief        Round up to multiple of align (power of 2).
+//******************************************************************************
+static size_t apl_arena_round(size_t size, size_t align)
+{
+	return (size + align - 1) & ~(align - 1);
+}
+
+//******************************************************************************
+//! \brief        Transparent huge pages are not disabled system wide ("always [madvise] never").
+//******************************************************************************
+static bool apl_arena_thp_on(void)
+{
+	char buf[128] = "";
+	FILE *fp;
+
+	fp = fopen(APL_ARENA_THP_ENABLED, "r");
+	if (fp == NULL) {
+		return false;
+	}
+	if (fgets(buf, sizeof(buf), fp) == NULL) {
+		buf[0] = '\0';
+	}
+	(void)fclose(fp);
+
+	return (buf[0] != '\0') && (strstr(buf, "[never]") == NULL);
+}
+
+//******************************************************************************
+//! \brief        Map arena.
+//******************************************************************************
+int apl_arena_init(size_t size, APL_ARENA_PAGE page)
+{
+	void *map = MAP_FAILED;
+
+	std::lock_guard<std::mutex> lock(sMtx);
+
+	if (sMap != NULL) {
+		return 0;
+	}
+
+	size = apl_arena_round(size, APL_ARENA_HUGE_SIZE);
+
+	//! \remark 1. Explicit Huge Pages, Needs Pages Reserved By vm.nr_hugepages.
+	if (page == APL_ARENA_PAGE_HUGETLB) {
+#ifdef MAP_HUGETLB
+		map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+		if (map != MAP_FAILED) {
+			sMap = static_cast<uint8_t *>(map);
+			sMapSize = size;
+			sBase = sMap;
+		}
+		else {
+			printf("arena : no explicit huge pages (%s), try transparent huge pages\n", strerror(errno));
+			page = APL_ARENA_PAGE_THP;
+		}
+	}
+
+	//! \remark 2. Normal Mapping, Aligned To Huge Page So THP Can Back It.
+	if (map == MAP_FAILED) {
+		map = mmap(NULL, size + APL_ARENA_HUGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (map == MAP_FAILED) {
+			printf("arena : mmap %zu bytes failed (%s)\n", size, strerror(errno));
+			return -1;
+		}
+		sMap = static_cast<uint8_t *>(map);
+		sMapSize = size + APL_ARENA_HUGE_SIZE;
+		sBase = reinterpret_cast<uint8_t *>(apl_arena_round(reinterpret_cast<uintptr_t>(sMap), APL_ARENA_HUGE_SIZE));
+
+		if (page == APL_ARENA_PAGE_THP) {
+#ifdef MADV_HUGEPAGE
+			if (madvise(sBase, size, MADV_HUGEPAGE) != 0) {
+				printf("arena : no transparent huge pages (%s), use normal pages\n", strerror(errno));
+				page = APL_ARENA_PAGE_4K;
+			}
+			else
+			if (!apl_arena_thp_on()) {
+				// Advice Is Accepted But Ignored
+				printf("arena : transparent huge pages are disabled (%s), use normal pages\n", APL_ARENA_THP_ENABLED);
+				page = APL_ARENA_PAGE_4K;
+			}
+#else
+			page = APL_ARENA_PAGE_4K;
+#endif
+		}
+	}
+
+	sSize = size;
+	sUsed = 0;
+	sPage = page;
+	sLocked = false;
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Unmap arena.
+//******************************************************************************
+void apl_arena_term(void)
+{
+	std::lock_guard<std::mutex> lock(sMtx);
+
+	if (sMap == NULL) {
+		return;
+	}
+
+	if (sLocked) {
+		(void)munlock(sBase, apl_arena_round(sUsed, APL_ARENA_HUGE_SIZE));
+	}
+	(void)munmap(sMap, sMapSize);
+
+	sMap = NULL;
+	sMapSize = 0;
+	sBase = NULL;
+	sSize = 0;
+	sUsed = 0;
+	sLocked = false;
+}
+
+//******************************************************************************
+//! \brief        Allocate zero filled block.
+//******************************************************************************
+void *apl_arena_alloc(size_t size)
+{
+	void *ptr = NULL;
+
+	size = apl_arena_round((size != 0) ? size : 1, APL_ARENA_ALIGN);
+
+	{
+		std::lock_guard<std::mutex> lock(sMtx);
+
+		if ((sBase != NULL) && (size <= (sSize - sUsed))) {
+			ptr = sBase + sUsed;
+			sUsed += size;
+		}
+		else {
+			if (sBase != NULL) {
+				printf("arena : exhausted, %zu bytes from heap\n", size);
+			}
+			if (posix_memalign(&ptr, APL_ARENA_ALIGN, size) != 0) {
+				return NULL;
+			}
+			sHeap += malloc_usable_size(ptr);
+		}
+	}
+
+	// Touch Every Page Now, No Page Fault In Steady State
+	memset(ptr, 0, size);
+
+	return ptr;
+}
+
+//******************************************************************************
+//! \brief        Free block.
+//******************************************************************************
+void apl_arena_free(void *ptr)
+{
+	std::lock_guard<std::mutex> lock(sMtx);
+	uint8_t *p = static_cast<uint8_t *>(ptr);
+
+	if (ptr == NULL) {
+		return;
+	}
+	if ((sBase != NULL) && (p >= sBase) && (p < (sBase + sSize))) {
+		return;
+	}
+
+	// Same Measure As At Allocation
+	sHeap -= malloc_usable_size(ptr);
+	free(ptr);
+}
+
+//******************************************************************************
+//! \brief        Lock used part of arena in memory.
+//******************************************************************************
+int apl_arena_lock(void)
+{
+	std::lock_guard<std::mutex> lock(sMtx);
+
+	if ((sBase == NULL) || (sUsed == 0)) {
+		return 0;
+	}
+
+	if (mlock(sBase, apl_arena_round(sUsed, APL_ARENA_HUGE_SIZE)) != 0) {
+		printf("arena : mlock failed (%s), need RLIMIT_MEMLOCK or CAP_IPC_LOCK\n", strerror(errno));
+		return -1;
+	}
+	sLocked = true;
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Print footprint of arena.
+//******************************************************************************
+void apl_arena_report(FILE *fp)
+{
+	std::lock_guard<std::mutex> lock(sMtx);
+
+	fprintf(fp, "Arena : %.1f MiB used of %.1f MiB, pages=%s%s, heap fallback %.1f MiB\n",
+		(double)sUsed / (1024 * 1024),
+		(double)sSize / (1024 * 1024),
+		(sBase != NULL) ? PAGE_NAME[sPage] : "none",
+		sLocked ? ", locked" : "",
+		(double)sHeap / (1024 * 1024));
+}
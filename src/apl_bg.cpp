@@ -0,0 +1,298 @@
+//******************************************************************************
+//! \file         apl_bg.cpp
+//! \brief        background model of depth, foreground mask and blobs.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <mutex>
+
+#include "apl_arena.h"
+#include "apl_pool.h"
+#include "apl_bg.h"
+
+//******************************************************************************
+//! \brief        Initialize model.
+//******************************************************************************
+void apl_bg_init(apl_bg *bg, size_t w, size_t h, float alpha, float alpha_fg, float k, uint16_t noise, uint32_t min_area)
+{
+	bg->w = w;
+	bg->h = h;
+	bg->alpha = std::min(std::max(alpha, 0.0F), 1.0F);
+	bg->alpha_fg = std::min(std::max(alpha_fg, 0.0F), bg->alpha);
+	bg->k2 = k * k;
+	bg->var_min = (float)noise * (float)noise;
+	bg->min_area = std::max<uint32_t>(min_area, 1);
+	bg->mean = static_cast<float *>(apl_arena_alloc(w * h * sizeof(float)));
+	bg->var = static_cast<float *>(apl_arena_alloc(w * h * sizeof(float)));
+	bg->label = static_cast<apl_bg_label *>(apl_arena_alloc(APL_BG_LABEL_MAX * sizeof(apl_bg_label)));
+	bg->run[0] = static_cast<apl_bg_run *>(apl_arena_alloc(((w / 2) + 1) * sizeof(apl_bg_run)));
+	bg->run[1] = static_cast<apl_bg_run *>(apl_arena_alloc(((w / 2) + 1) * sizeof(apl_bg_run)));
+	bg->relearn = true;
+	bg->fg_ratio = 0;
+	bg->blob_num = 0;
+}
+
+//******************************************************************************
+//! \brief        Forget background.
+//******************************************************************************
+void apl_bg_reset(apl_bg *bg)
+{
+	std::lock_guard<std::mutex> lock(bg->mtx);
+
+	// Next Update Learns Every Valid Pixel Again (mean == 0)
+	bg->relearn = true;
+}
+
+//******************************************************************************
+//! \brief        Root of provisional label, path halving.
+//******************************************************************************
+static uint32_t apl_bg_find(apl_bg_label *label, uint32_t l)
+{
+	while (label[l].parent != l) {
+		label[l].parent = label[label[l].parent].parent;
+		l = label[l].parent;
+	}
+
+	return l;
+}
+
+//******************************************************************************
+//! \brief        Join provisional labels, smaller label becomes root.
+//******************************************************************************
+static void apl_bg_union(apl_bg_label *label, uint32_t a, uint32_t b)
+{
+	a = apl_bg_find(label, a);
+	b = apl_bg_find(label, b);
+	if (a < b) {
+		label[b].parent = a;
+	}
+	else
+	if (b < a) {
+		label[a].parent = b;
+	}
+}
+
+//******************************************************************************
+//! \brief        Update model of pixels, branch free so that it is vectorized.
+//! \details      Float compares are if-converted only with -fno-trapping-math (CMakeLists.txt).
+//******************************************************************************
+static void apl_bg_model_px(const apl_bg *bg, const uint16_t *dp, float *mean, float *var, uint8_t *mask, size_t num)
+{
+	const float alpha = bg->alpha;
+	const float alpha_fg = bg->alpha_fg;
+	const float k2 = bg->k2;
+	const float var_min = bg->var_min;
+	size_t i;
+
+	for (i = 0; i < num; i++) {
+		float d = (float)dp[i];
+		float m = mean[i];
+		float v = var[i];
+		float diff = d - m;
+		float thr = k2 * std::max(v, var_min);
+		bool valid = (d > 0.0F);
+		bool known = (m > 0.0F);
+		bool fg = valid && known && (diff < 0.0F) && ((diff * diff) > thr);
+		float rate = fg ? alpha_fg : alpha;
+
+		rate = known ? rate : 1.0F;		// First Valid Depth Is Background
+		rate = valid ? rate : 0.0F;		// Invalid Depth Keeps Model
+
+		// Foreground Moves Mean Slowly But Keeps Variance, Or Objects Would Be Absorbed By Growing Variance
+		float rate_v = fg ? 0.0F : rate;
+		float v_new = (1.0F - rate_v) * (v + (rate_v * diff * diff));
+		mean[i] = m + (rate * diff);
+		var[i] = known ? v_new : var_min;
+		mask[i] = fg ? 0xFF : 0x00;
+	}
+}
+
+//******************************************************************************
+//! \brief        Update model with depth image, rows in parallel.
+//******************************************************************************
+static void apl_bg_model(apl_bg *bg, const uint16_t *dp, uint8_t *mask, bool relearn)
+{
+	const size_t w = bg->w;
+
+	apl_pool_for(bg->h, 0, [&](size_t row_begin, size_t row_end) {
+		const size_t begin = row_begin * w;
+		const size_t end = row_end * w;
+
+		if (relearn) {
+			std::fill(bg->mean + begin, bg->mean + end, 0.0F);
+		}
+		apl_bg_model_px(bg, dp + begin, bg->mean + begin, bg->var + begin, mask + begin, end - begin);
+	});
+}
+
+//******************************************************************************
+//! \brief        Label 8-connected runs of foreground, collect blobs.
+//******************************************************************************
+static size_t apl_bg_label_blobs(apl_bg *bg, const uint16_t *dp, const uint8_t *mask, apl_bg_blob *blob, uint32_t *fg_num)
+{
+	const size_t w = bg->w;
+	const size_t h = bg->h;
+	apl_bg_label *label = bg->label;
+	apl_bg_run *prev = bg->run[0];
+	apl_bg_run *cur = bg->run[1];
+	size_t prev_num = 0;
+	size_t blob_num = 0;
+	uint32_t label_num = 1;		// 0 Is Not Used
+	uint32_t fg = 0;
+	uint32_t l;
+
+	//! \remark 1. Runs Of Each Row, Joined With Overlapping Runs Of Previous Row.
+	for (size_t y = 0; y < h; y++) {
+		const uint8_t *m = mask + (y * w);
+		const uint16_t *d = dp + (y * w);
+		size_t cur_num = 0;
+		size_t j = 0;
+		size_t x = 0;
+
+		while (x < w) {
+			if (m[x] == 0) {
+				x++;
+				continue;
+			}
+
+			size_t x0 = x;
+			uint64_t sd = 0;
+			for (; (x < w) && (m[x] != 0); x++) {
+				sd += d[x];
+			}
+			size_t x1 = x - 1;
+			uint32_t n = (uint32_t)(x1 - x0 + 1);
+
+			fg += n;
+			if (label_num >= APL_BG_LABEL_MAX) {
+				continue;	// Too Fragmented, Rest Of Runs Are Not Labeled
+			}
+
+			l = label_num++;
+			label[l].parent = l;
+			label[l].area = n;
+			label[l].x0 = (uint16_t)x0;
+			label[l].x1 = (uint16_t)x1;
+			label[l].y0 = (uint16_t)y;
+			label[l].y1 = (uint16_t)y;
+			label[l].sx = ((uint64_t)(x0 + x1) * n) / 2;
+			label[l].sy = (uint64_t)y * n;
+			label[l].sd = sd;
+
+			// Runs Of Previous Row Touching x0 - 1 .. x1 + 1
+			while ((j < prev_num) && ((prev[j].x1 + 1U) < x0)) {
+				j++;
+			}
+			for (size_t k = j; (k < prev_num) && (prev[k].x0 <= (x1 + 1U)); k++) {
+				apl_bg_union(label, l, prev[k].label);
+			}
+
+			cur[cur_num].x0 = (uint16_t)x0;
+			cur[cur_num].x1 = (uint16_t)x1;
+			cur[cur_num].label = l;
+			cur_num++;
+		}
+
+		std::swap(prev, cur);
+		prev_num = cur_num;
+	}
+
+	//! \remark 2. Merge Labels Into Roots, Children Have Larger Labels Than Parents.
+	for (l = label_num - 1; l > 0; l--) {
+		uint32_t p = label[l].parent;
+
+		if (p == l) {
+			continue;
+		}
+		label[p].area += label[l].area;
+		label[p].x0 = std::min(label[p].x0, label[l].x0);
+		label[p].y0 = std::min(label[p].y0, label[l].y0);
+		label[p].x1 = std::max(label[p].x1, label[l].x1);
+		label[p].y1 = std::max(label[p].y1, label[l].y1);
+		label[p].sx += label[l].sx;
+		label[p].sy += label[l].sy;
+		label[p].sd += label[l].sd;
+	}
+
+	//! \remark 3. Largest Roots Are Blobs.
+	for (l = 1; l < label_num; l++) {
+		const apl_bg_label *r = &label[l];
+		apl_bg_blob b;
+		size_t i;
+
+		if ((r->parent != l) || (r->area < bg->min_area)) {
+			continue;
+		}
+		if ((blob_num == APL_BG_BLOB_MAX) && (r->area <= blob[blob_num - 1].area)) {
+			continue;
+		}
+
+		b.x = r->x0;
+		b.y = r->y0;
+		b.w = (uint16_t)(r->x1 - r->x0 + 1);
+		b.h = (uint16_t)(r->y1 - r->y0 + 1);
+		b.area = r->area;
+		b.cx = (float)r->sx / (float)r->area;
+		b.cy = (float)r->sy / (float)r->area;
+		b.mean = (float)r->sd / (float)r->area;
+
+		// Insert In Descending Order Of Area
+		i = std::min<size_t>(blob_num, APL_BG_BLOB_MAX - 1);
+		for (; (i > 0) && (blob[i - 1].area < b.area); i--) {
+			blob[i] = blob[i - 1];
+		}
+		blob[i] = b;
+		blob_num = std::min<size_t>(blob_num + 1, APL_BG_BLOB_MAX);
+	}
+
+	*fg_num = fg;
+
+	return blob_num;
+}
+
+//******************************************************************************
+//! \brief        Update model with depth image, make foreground mask and blobs.
+//******************************************************************************
+void apl_bg_update(apl_bg *bg, const uint16_t *dp, uint8_t *mask)
+{
+	apl_bg_blob blob[APL_BG_BLOB_MAX];
+	size_t blob_num;
+	uint32_t fg_num;
+	bool relearn;
+
+	{
+		std::lock_guard<std::mutex> lock(bg->mtx);
+		relearn = bg->relearn;
+		bg->relearn = false;
+	}
+
+	apl_bg_model(bg, dp, mask, relearn);
+	blob_num = apl_bg_label_blobs(bg, dp, mask, blob, &fg_num);
+
+	std::lock_guard<std::mutex> lock(bg->mtx);
+	bg->fg_ratio = (float)fg_num / (float)(bg->w * bg->h);
+	bg->blob_num = blob_num;
+	std::copy(blob, blob + blob_num, bg->blob);
+}
+
+//******************************************************************************
+//! \brief        Get blobs of last frame.
+//******************************************************************************
+size_t apl_bg_get(apl_bg *bg, apl_bg_blob *blob, float *fg_ratio)
+{
+	std::lock_guard<std::mutex> lock(bg->mtx);
+
+	std::copy(bg->blob, bg->blob + bg->blob_num, blob);
+	*fg_ratio = bg->fg_ratio;
+
+	return bg->blob_num;
+}
@@ -0,0 +1,143 @@
+//******************************************************************************
+//! \file         apl_cfg.cpp
+//! \brief        key = value configuration file of viewer application.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+
+#include "apl_cfg.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+static std::map<std::string, std::string>	sCfg;	// configured key, value
+
+//******************************************************************************
+//! \brief        Remove leading and trailing white spaces.
+//******************************************************************************
+static std::string apl_cfg_trim(const std::string &str)
+{
+	const char *ws = " \t\r\n";
+	size_t b = str.find_first_not_of(ws);
+	size_t e = str.find_last_not_of(ws);
+
+	if (b == std::string::npos) {
+		return "";
+	}
+
+	return str.substr(b, e - b + 1);
+}
+
+//******************************************************************************
+//! \brief        Load configuration file.
+//******************************************************************************
+int apl_cfg_load(const char *fn)
+{
+	char line[512];
+	FILE *fp;
+
+	fp = fopen(fn, "r");
+	if (fp == NULL) {
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		std::string str(line);
+		size_t pos;
+
+		pos = str.find('#');
+		if (pos != std::string::npos) {
+			str.erase(pos);
+		}
+
+		pos = str.find('=');
+		if (pos == std::string::npos) {
+			continue;
+		}
+
+		sCfg[apl_cfg_trim(str.substr(0, pos))] = apl_cfg_trim(str.substr(pos + 1));
+	}
+
+	(void)fclose(fp);
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Forget every loaded key.
+//******************************************************************************
+void apl_cfg_clear(void)
+{
+	sCfg.clear();
+}
+
+//******************************************************************************
+//! \brief        Get string value.
+//******************************************************************************
+const char *apl_cfg_get_str(const char *key, const char *def)
+{
+	std::map<std::string, std::string>::const_iterator it = sCfg.find(key);
+
+	return (it == sCfg.end()) ? def : it->second.c_str();
+}
+
+//******************************************************************************
+//! \brief        Get integer value.
+//******************************************************************************
+int apl_cfg_get_int(const char *key, int def)
+{
+	const char *str = apl_cfg_get_str(key, NULL);
+
+	return (str == NULL) ? def : (int)strtol(str, NULL, 0);
+}
+
+//******************************************************************************
+//! \brief        Get floating point value.
+//******************************************************************************
+float apl_cfg_get_float(const char *key, float def)
+{
+	const char *str = apl_cfg_get_str(key, NULL);
+
+	return (str == NULL) ? def : strtof(str, NULL);
+}
+
+//******************************************************************************
+//! \brief        Get string value of device.
+//******************************************************************************
+const char *apl_cfg_get_dev_str(uint8_t dev, const char *key, const char *def)
+{
+	char dev_key[128];
+
+	snprintf(dev_key, sizeof(dev_key), "cam%u.%s", dev, key);
+
+	return apl_cfg_get_str(dev_key, apl_cfg_get_str(key, def));
+}
+
+//******************************************************************************
+//! \brief        Get integer value of device.
+//******************************************************************************
+int apl_cfg_get_dev_int(uint8_t dev, const char *key, int def)
+{
+	const char *str = apl_cfg_get_dev_str(dev, key, NULL);
+
+	return (str == NULL) ? def : (int)strtol(str, NULL, 0);
+}
+
+//******************************************************************************
+//! \brief        Get floating point value of device.
+//******************************************************************************
+float apl_cfg_get_dev_float(uint8_t dev, const char *key, float def)
+{
+	const char *str = apl_cfg_get_dev_str(dev, key, NULL);
+
+	return (str == NULL) ? def : strtof(str, NULL);
+}
@@ -0,0 +1,404 @@
+//******************************************************************************
+//! \file         apl_ctl.cpp
+//! \brief        command channel (stdin and unix socket), parsed commands to lock free queues of threads.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <string>
+
+#include "apl_thread.h"
+#include "apl_ctl.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_CTL_FD_EVENT	(0)		// index of eventfd in poll set
+#define APL_CTL_FD_STDIN	(1)		// index of stdin
+#define APL_CTL_FD_LISTEN	(2)		// index of listening socket
+#define APL_CTL_FD_CLIENT	(3)		// index of first connection
+#define APL_CTL_FD_NUM		(APL_CTL_FD_CLIENT + APL_CTL_CLIENT_MAX)
+
+static const char *CMD_NAME[APL_CTL_CMD_NUM] = { "save", "start", "stop", "mode", "view", "stats", "trigger", "quit", "help" };
+static const char *VIEW_NAME[APL_CTL_VIEW_NUM] = { "confdata", "irnrref", "autorange", "normal" };
+
+static const char *HELP_TEXT =
+	"save <n>      save next n frames as raw files (or just <n>)\n"
+	"start | stop  start / stop capture\n"
+	"mode <n>      switch ranging mode\n"
+	"view <confdata|irnrref|autorange|normal> [on|off]\n"
+	"stats         counters and stage latency\n"
+	"trigger | t   dump pre-trigger ring\n"
+	"quit          exit program\n";
+
+static struct pollfd		sPfd[APL_CTL_FD_NUM];
+static std::string			sLine[APL_CTL_FD_NUM];	// partial line of fd
+static apl_ctl_handler		sHandler = NULL;
+static bool					sStarted = false;
+static pthread_t			sThr;
+static std::string			sUnixPath;				// unlinked at stop
+
+//******************************************************************************
+//! \brief        Parse command line.
+//******************************************************************************
+int apl_ctl_parse(const char *line, apl_ctl_cmd *cmd, std::string *err)
+{
+	char name[32] = "";
+	char arg[32] = "";
+	char arg2[32] = "";
+	char *end;
+	int num;
+	int i;
+
+	num = sscanf(line, "%31s %31s %31s", name, arg, arg2);
+	if (num <= 0) {
+		*err = "empty command";
+		return -1;
+	}
+
+	cmd->arg = 0;
+	cmd->arg2 = -1;
+
+	// Bare Number Is Save, As Former Prompt
+	long n = strtol(name, &end, 10);
+	if ((*end == '\0') && (n > 0)) {
+		cmd->cmd = APL_CTL_CMD_SAVE;
+		cmd->arg = (int32_t)n;
+		return 0;
+	}
+	if (strcmp(name, "t") == 0) {
+		cmd->cmd = APL_CTL_CMD_TRIGGER;
+		return 0;
+	}
+
+	for (i = 0; i < APL_CTL_CMD_NUM; i++) {
+		if (strcmp(name, CMD_NAME[i]) == 0) {
+			break;
+		}
+	}
+	if (i == APL_CTL_CMD_NUM) {
+		*err = std::string("unknown command \"") + name + "\", try help";
+		return -1;
+	}
+	cmd->cmd = (APL_CTL_CMD)i;
+
+	switch (cmd->cmd) {
+		case APL_CTL_CMD_SAVE:
+		case APL_CTL_CMD_MODE:
+			n = strtol(arg, &end, 10);
+			if ((num < 2) || (*end != '\0') || (n <= 0) || (n > 0xFFFF)) {
+				*err = std::string(name) + " needs a positive number";
+				return -1;
+			}
+			cmd->arg = (int32_t)((cmd->cmd == APL_CTL_CMD_MODE) ? (n - 1) : n);
+			break;
+		case APL_CTL_CMD_VIEW:
+			for (i = 0; i < APL_CTL_VIEW_NUM; i++) {
+				if (strcmp(arg, VIEW_NAME[i]) == 0) {
+					break;
+				}
+			}
+			if (i == APL_CTL_VIEW_NUM) {
+				*err = "view needs confdata, irnrref, autorange or normal";
+				return -1;
+			}
+			cmd->arg = i;
+			if (num == 3) {
+				if (strcmp(arg2, "on") == 0) {
+					cmd->arg2 = 1;
+				}
+				else
+				if (strcmp(arg2, "off") == 0) {
+					cmd->arg2 = 0;
+				}
+				else {
+					*err = "view state is on or off";
+					return -1;
+				}
+			}
+			break;
+		default:
+			break;
+	}
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Push command.
+//******************************************************************************
+bool apl_ctl_push(apl_ctl_queue *q, const apl_ctl_cmd *cmd)
+{
+	const uint32_t head = q->head.load(std::memory_order_relaxed);
+
+	if ((head - q->tail.load(std::memory_order_acquire)) >= APL_CTL_QUEUE_LEN) {
+		return false;
+	}
+	q->cmd[head & (APL_CTL_QUEUE_LEN - 1)] = *cmd;
+	q->head.store(head + 1, std::memory_order_release);
+
+	return true;
+}
+
+//******************************************************************************
+//! \brief        Execute one line and make reply.
+//******************************************************************************
+static void apl_ctl_exec(const std::string &line, std::string *reply)
+{
+	apl_ctl_cmd cmd;
+	std::string err;
+
+	reply->clear();
+
+	if (apl_ctl_parse(line.c_str(), &cmd, &err) < 0) {
+		*reply = "error: " + err + "\n";
+		return;
+	}
+
+	if (cmd.cmd == APL_CTL_CMD_HELP) {
+		*reply = HELP_TEXT;
+		return;
+	}
+
+	sHandler(&cmd, reply);
+	if (reply->empty()) {
+		*reply = "ok\n";
+	}
+}
+
+//******************************************************************************
+//! \brief        Read fd, execute complete lines.
+//! \return       -1            end of input
+//******************************************************************************
+static int apl_ctl_read(int idx)
+{
+	char buf[APL_CTL_LINE_MAX];
+	std::string reply;
+	std::string line;
+	size_t pos;
+	ssize_t n;
+
+	n = read(sPfd[idx].fd, buf, sizeof(buf));
+	if (n <= 0) {
+		return -1;
+	}
+	sLine[idx].append(buf, (size_t)n);
+
+	while ((pos = sLine[idx].find('\n')) != std::string::npos) {
+		line = sLine[idx].substr(0, pos);
+		sLine[idx].erase(0, pos + 1);
+		if ((!line.empty()) && (line[line.size() - 1] == '\r')) {
+			line.erase(line.size() - 1);
+		}
+		if (line.find_first_not_of(" \t") == std::string::npos) {
+			continue;
+		}
+
+		apl_ctl_exec(line, &reply);
+		if (idx == APL_CTL_FD_STDIN) {
+			fputs(reply.c_str(), stdout);
+			fflush(stdout);
+		}
+		else {
+			(void)send(sPfd[idx].fd, reply.data(), reply.size(), MSG_NOSIGNAL);
+		}
+	}
+
+	// Line Without Newline Is Not A Command
+	if (sLine[idx].size() > APL_CTL_LINE_MAX) {
+		sLine[idx].clear();
+	}
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Accept connection into free slot, refused when all are used.
+//******************************************************************************
+static void apl_ctl_accept(void)
+{
+	int fd = accept4(sPfd[APL_CTL_FD_LISTEN].fd, NULL, NULL, SOCK_CLOEXEC);
+	int i;
+
+	if (fd < 0) {
+		return;
+	}
+	for (i = APL_CTL_FD_CLIENT; i < APL_CTL_FD_NUM; i++) {
+		if (sPfd[i].fd < 0) {
+			sPfd[i].fd = fd;
+			sLine[i].clear();
+			return;
+		}
+	}
+	close(fd);
+}
+
+//******************************************************************************
+//! \brief        Channel thread, sleeps in poll() until input or stop.
+//******************************************************************************
+static void *apl_ctl_thread(void *arg)
+{
+	int i;
+
+	(void)arg;
+
+	for (;;) {
+		if (poll(sPfd, APL_CTL_FD_NUM, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+
+		if (sPfd[APL_CTL_FD_EVENT].revents != 0) {
+			break;
+		}
+
+		// End Of Stdin (e.g. Run In Background) Leaves Socket Only
+		if ((sPfd[APL_CTL_FD_STDIN].revents != 0) && (apl_ctl_read(APL_CTL_FD_STDIN) < 0)) {
+			sPfd[APL_CTL_FD_STDIN].fd = -1;
+		}
+
+		if (sPfd[APL_CTL_FD_LISTEN].revents != 0) {
+			apl_ctl_accept();
+		}
+
+		for (i = APL_CTL_FD_CLIENT; i < APL_CTL_FD_NUM; i++) {
+			if ((sPfd[i].revents != 0) && (apl_ctl_read(i) < 0)) {
+				close(sPfd[i].fd);
+				sPfd[i].fd = -1;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+//******************************************************************************
+//! \brief        Open listening unix socket.
+//******************************************************************************
+static int apl_ctl_listen(const char *listen_addr)
+{
+	struct sockaddr_un sun;
+	int fd;
+
+	if (strncmp(listen_addr, "unix:", 5) != 0) {
+		printf("control : unsupported address %s, use unix:<path>\n", listen_addr);
+		return -1;
+	}
+
+	memset(&sun, 0, sizeof(sun));
+	sun.sun_family = AF_UNIX;
+	if (strlen(listen_addr + 5) >= sizeof(sun.sun_path)) {
+		printf("control : too long path %s\n", listen_addr + 5);
+		return -1;
+	}
+	strcpy(sun.sun_path, listen_addr + 5);
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return -1;
+	}
+	(void)unlink(sun.sun_path);
+	if ((bind(fd, (struct sockaddr *)&sun, sizeof(sun)) < 0) || (listen(fd, APL_CTL_CLIENT_MAX) < 0)) {
+		printf("control : bind %s failed (%s)\n", sun.sun_path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	sUnixPath = sun.sun_path;
+
+	return fd;
+}
+
+//******************************************************************************
+//! \brief        Close descriptors of channel, stdin is left open.
+//******************************************************************************
+static void apl_ctl_close(void)
+{
+	int i;
+
+	for (i = 0; i < APL_CTL_FD_NUM; i++) {
+		if ((i != APL_CTL_FD_STDIN) && (sPfd[i].fd >= 0)) {
+			close(sPfd[i].fd);
+		}
+		sPfd[i].fd = -1;
+	}
+	if (!sUnixPath.empty()) {
+		(void)unlink(sUnixPath.c_str());
+		sUnixPath.clear();
+	}
+}
+
+//******************************************************************************
+//! \brief        Start channel thread.
+//******************************************************************************
+int apl_ctl_start(const char *listen_addr, bool use_stdin, apl_ctl_handler handler)
+{
+	int i;
+
+	if (sStarted) {
+		return 0;
+	}
+
+	for (i = 0; i < APL_CTL_FD_NUM; i++) {
+		sPfd[i].fd = -1;		// Negative fd Is Ignored By poll()
+		sPfd[i].events = POLLIN;
+		sLine[i].clear();
+	}
+
+	sPfd[APL_CTL_FD_EVENT].fd = eventfd(0, EFD_CLOEXEC);
+	if (sPfd[APL_CTL_FD_EVENT].fd < 0) {
+		return -1;
+	}
+	if (use_stdin) {
+		sPfd[APL_CTL_FD_STDIN].fd = STDIN_FILENO;
+	}
+	if (listen_addr != NULL) {
+		sPfd[APL_CTL_FD_LISTEN].fd = apl_ctl_listen(listen_addr);
+		if (sPfd[APL_CTL_FD_LISTEN].fd < 0) {
+			apl_ctl_close();
+			return -1;
+		}
+	}
+
+	sHandler = handler;
+	if (apl_thr_create(&sThr, APL_THR_ROLE_USER_INPUT, "tof_ctl", apl_ctl_thread, NULL) != 0) {
+		apl_ctl_close();
+		return -1;
+	}
+	sStarted = true;
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Stop channel thread.
+//******************************************************************************
+void apl_ctl_stop(void)
+{
+	uint64_t one = 1;
+
+	if (!sStarted) {
+		return;
+	}
+
+	(void)write(sPfd[APL_CTL_FD_EVENT].fd, &one, sizeof(one));
+	pthread_join(sThr, NULL);
+	apl_ctl_close();
+	sStarted = false;
+}
@@ -0,0 +1,336 @@
+//******************************************************************************
+//! \file         apl_fill.cpp
+//! \brief        hole filling of depth by push-pull pyramid guided by ir.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "apl_arena.h"
+#include "apl_pool.h"
+#include "apl_fill.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_FILL_SKIP		(2)		// mask of pixel of over-size hole until image is pulled
+
+//******************************************************************************
+//! \brief        Initialize stage.
+//******************************************************************************
+void apl_fill_init(apl_fill *fill, size_t w, size_t h, uint32_t max_hole, float sigma_r)
+{
+	uint32_t l;
+
+	fill->w = w;
+	fill->h = h;
+	fill->inv_r2 = 1.0F / std::max(sigma_r * sigma_r, 1.0F);
+
+	// Level l Fills Holes Up To 2^l Pixels
+	fill->level_num = 1;
+	while (((1U << fill->level_num) < max_hole) && (fill->level_num < APL_FILL_LEVEL_MAX)) {
+		fill->level_num++;
+	}
+
+	fill->dist = static_cast<uint16_t *>(apl_arena_alloc(w * h * sizeof(uint16_t)));
+	fill->stack = static_cast<uint32_t *>(apl_arena_alloc(w * h * sizeof(uint32_t)));
+
+	fill->lv[0].w = w;
+	fill->lv[0].h = h;
+	fill->lv[0].dp = NULL;
+	fill->lv[0].wt = NULL;
+	fill->lv[0].ir = NULL;
+
+	for (l = 1; l <= fill->level_num; l++) {
+		apl_fill_level *lv = &fill->lv[l];
+
+		if ((fill->lv[l - 1].w == 1) && (fill->lv[l - 1].h == 1)) {
+			fill->level_num = l - 1;
+			break;
+		}
+		lv->w = (fill->lv[l - 1].w + 1) / 2;
+		lv->h = (fill->lv[l - 1].h + 1) / 2;
+		lv->dp = static_cast<float *>(apl_arena_alloc(lv->w * lv->h * sizeof(float)));
+		lv->wt = static_cast<float *>(apl_arena_alloc(lv->w * lv->h * sizeof(float)));
+		lv->ir = static_cast<float *>(apl_arena_alloc(lv->w * lv->h * sizeof(float)));
+	}
+	fill->max_hole = 1U << fill->level_num;
+}
+
+//******************************************************************************
+//! \brief        Push rows of level from 2 x 2 children, children out of level above have no weight.
+//! \param[in]    pdp           depth of level above.
+//! \param[in]    pwt           weight of level above, NULL = depth != 0 (image).
+//! \param[in]    pir           ir of level above.
+//! \param[in]    pw            width of level above.
+//! \param[in]    ph            height of level above.
+//! \param[out]   lv            level.
+//******************************************************************************
+template <typename T>
+static void apl_fill_push(const T *pdp, const float *pwt, const T *pir, size_t pw, size_t ph, apl_fill_level *lv, size_t row_begin, size_t row_end)
+{
+	size_t y;
+	size_t x;
+
+	for (y = row_begin; y < row_end; y++) {
+		const size_t y0 = 2 * y;
+		const size_t y1 = std::min(y0 + 1, ph - 1);
+		const float my = ((y0 + 1) < ph) ? 1.0F : 0.0F;
+
+		for (x = 0; x < lv->w; x++) {
+			const size_t x0 = 2 * x;
+			const size_t x1 = std::min(x0 + 1, pw - 1);
+			const float mx = ((x0 + 1) < pw) ? 1.0F : 0.0F;
+			const size_t c[4] = { (y0 * pw) + x0, (y0 * pw) + x1, (y1 * pw) + x0, (y1 * pw) + x1 };
+			const float m[4] = { 1.0F, mx, my, mx * my };
+			float sw = 0;
+			float sd = 0;
+			float si = 0;
+			int k;
+
+			for (k = 0; k < 4; k++) {
+				const float d = (float)pdp[c[k]];
+				const float v = m[k] * ((pwt != NULL) ? pwt[c[k]] : ((d != 0) ? 1.0F : 0.0F));
+				sw += v;
+				sd += v * d;
+				si += m[k] * (float)pir[c[k]];
+			}
+
+			lv->dp[(y * lv->w) + x] = sd / std::max(sw, 1e-12F);
+			lv->wt[(y * lv->w) + x] = std::min(sw, 1.0F);
+			lv->ir[(y * lv->w) + x] = si / (m[0] + m[1] + m[2] + m[3]);
+		}
+	}
+}
+
+//******************************************************************************
+//! \brief        Interpolate pixel of level above from 2 x 2 nearest pixels of level, weighted by ir.
+//! \param[in]    fill          stage.
+//! \param[in]    lv            level.
+//! \param[in]    x             column of level above.
+//! \param[in]    y             row of level above.
+//! \param[in]    ir            ir of pixel.
+//! \param[out]   dp            depth.
+//! \return       true          interpolated
+//! \return       false         no valid pixel around
+//******************************************************************************
+static inline bool apl_fill_interp(const apl_fill *fill, const apl_fill_level *lv, size_t x, size_t y, float ir, float *dp)
+{
+	// Pixel 2j + phase Is At j - 0.25 + (phase * 0.5) Of Level, Pixels j - 1 + phase .. j + phase
+	const ptrdiff_t qx = (ptrdiff_t)(x >> 1) - 1 + (ptrdiff_t)(x & 1);
+	const ptrdiff_t qy = (ptrdiff_t)(y >> 1) - 1 + (ptrdiff_t)(y & 1);
+	const size_t qx0 = (size_t)std::max<ptrdiff_t>(qx, 0);
+	const size_t qy0 = (size_t)std::max<ptrdiff_t>(qy, 0);
+	const size_t qx1 = std::min<size_t>((size_t)(qx + 1), lv->w - 1);
+	const size_t qy1 = std::min<size_t>((size_t)(qy + 1), lv->h - 1);
+	const float bx0 = ((x & 1) != 0) ? 0.75F : 0.25F;
+	const float by0 = ((y & 1) != 0) ? 0.75F : 0.25F;
+	const size_t q[4] = { (qy0 * lv->w) + qx0, (qy0 * lv->w) + qx1, (qy1 * lv->w) + qx0, (qy1 * lv->w) + qx1 };
+	const float b[4] = { bx0 * by0, (1.0F - bx0) * by0, bx0 * (1.0F - by0), (1.0F - bx0) * (1.0F - by0) };
+	float sk = 0;
+	float sd = 0;
+	int k;
+
+	for (k = 0; k < 4; k++) {
+		const float e = ir - lv->ir[q[k]];
+		const float w = (b[k] * lv->wt[q[k]]) / (1.0F + (e * e * fill->inv_r2));
+		sk += w;
+		sd += w * lv->dp[q[k]];
+	}
+
+	if (sk <= 0) {
+		return false;
+	}
+	*dp = sd / sk;
+
+	return true;
+}
+
+//******************************************************************************
+//! \brief        Pull rows of level above (not image) from level, holes only.
+//******************************************************************************
+static void apl_fill_pull(const apl_fill *fill, uint32_t l, size_t row_begin, size_t row_end)
+{
+	const apl_fill_level *lv = &fill->lv[l];
+	const apl_fill_level *up = &fill->lv[l - 1];
+	size_t y;
+	size_t x;
+
+	for (y = row_begin; y < row_end; y++) {
+		for (x = 0; x < up->w; x++) {
+			const size_t i = (y * up->w) + x;
+
+			// Most Pixels Have Depth, Only Holes Are Interpolated
+			if (up->wt[i] > 0) {
+				continue;
+			}
+			if (apl_fill_interp(fill, lv, x, y, up->ir[i], &up->dp[i])) {
+				up->wt[i] = 1.0F;
+			}
+		}
+	}
+}
+
+//******************************************************************************
+//! \brief        Flag every pixel of holes wider than max_hole as APL_FILL_SKIP in mask.
+//! \details      Two pass chessboard distance to depth (out of image counts as depth), then holes that have a pixel
+//!               farther than max_hole / 2 are flooded (8-connected) from it.
+//******************************************************************************
+static void apl_fill_mark(apl_fill *fill, const uint16_t *depth, uint8_t *mask)
+{
+	const ptrdiff_t w = (ptrdiff_t)fill->w;
+	const ptrdiff_t h = (ptrdiff_t)fill->h;
+	const uint16_t half = (uint16_t)(fill->max_hole / 2);
+	uint16_t *dist = fill->dist;
+	size_t top = 0;
+	ptrdiff_t y;
+	ptrdiff_t x;
+
+	auto at = [&](ptrdiff_t u, ptrdiff_t v) -> uint32_t {
+		return ((u < 0) || (u >= w) || (v < 0) || (v >= h)) ? 0U : dist[(v * w) + u];
+	};
+
+	//! \remark 1. Forward And Backward Pass.
+	for (y = 0; y < h; y++) {
+		for (x = 0; x < w; x++) {
+			const ptrdiff_t i = (y * w) + x;
+			mask[i] = 0;	// Visited Flag Of Flood
+			dist[i] = (depth[i] != 0) ? 0 : (uint16_t)(1U + std::min(std::min(at(x - 1, y - 1), at(x, y - 1)), std::min(at(x + 1, y - 1), at(x - 1, y))));
+		}
+	}
+	for (y = h - 1; y >= 0; y--) {
+		for (x = w - 1; x >= 0; x--) {
+			const ptrdiff_t i = (y * w) + x;
+			if (dist[i] != 0) {
+				dist[i] = (uint16_t)std::min<uint32_t>(dist[i], 1U + std::min(std::min(at(x + 1, y + 1), at(x, y + 1)), std::min(at(x - 1, y + 1), at(x + 1, y))));
+			}
+		}
+	}
+
+	//! \remark 2. Flood Over-Size Holes, Pixel Is Flagged When Pushed.
+	for (y = 0; y < h; y++) {
+		for (x = 0; x < w; x++) {
+			const ptrdiff_t i = (y * w) + x;
+			if ((dist[i] <= half) || (mask[i] == APL_FILL_SKIP)) {
+				continue;
+			}
+			mask[i] = APL_FILL_SKIP;
+			fill->stack[top++] = (uint32_t)i;
+			while (top > 0) {
+				const ptrdiff_t p = fill->stack[--top];
+				const ptrdiff_t px = p % w;
+				const ptrdiff_t py = p / w;
+				ptrdiff_t u;
+				ptrdiff_t v;
+
+				for (v = std::max<ptrdiff_t>(py - 1, 0); v <= std::min<ptrdiff_t>(py + 1, h - 1); v++) {
+					for (u = std::max<ptrdiff_t>(px - 1, 0); u <= std::min<ptrdiff_t>(px + 1, w - 1); u++) {
+						const ptrdiff_t q = (v * w) + u;
+						if ((depth[q] == 0) && (mask[q] != APL_FILL_SKIP)) {
+							mask[q] = APL_FILL_SKIP;
+							fill->stack[top++] = (uint32_t)q;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+//******************************************************************************
+//! \brief        Level has a pixel without depth below it (image: any hole).
+//******************************************************************************
+static bool apl_fill_has_empty(const apl_fill *fill, uint32_t l, const uint16_t *depth)
+{
+	const apl_fill_level *lv = &fill->lv[l];
+
+	if (l == 0) {
+		return std::find(depth, depth + (fill->w * fill->h), 0) != (depth + (fill->w * fill->h));
+	}
+
+	return std::find(lv->wt, lv->wt + (lv->w * lv->h), 0.0F) != (lv->wt + (lv->w * lv->h));
+}
+
+//******************************************************************************
+//! \brief        Pull rows of image from level 1, holes only, filled pixels are flagged.
+//******************************************************************************
+static size_t apl_fill_pull_image(const apl_fill *fill, uint16_t *depth, const uint16_t *ir, uint8_t *mask, bool marked,
+								  size_t row_begin, size_t row_end)
+{
+	const size_t w = fill->w;
+	size_t filled = 0;
+	size_t y;
+	size_t x;
+	float dp;
+
+	for (y = row_begin; y < row_end; y++) {
+		for (x = 0; x < w; x++) {
+			const size_t i = (y * w) + x;
+
+			// Over-Size Hole Stays Invalid
+			if (marked && (mask[i] == APL_FILL_SKIP)) {
+				mask[i] = 0;
+				continue;
+			}
+			mask[i] = 0;
+			if (depth[i] != 0) {
+				continue;
+			}
+			if (apl_fill_interp(fill, &fill->lv[1], x, y, (float)ir[i], &dp)) {
+				depth[i] = (uint16_t)std::min(dp + 0.5F, 65535.0F);
+				mask[i] = (depth[i] != 0) ? 1 : 0;
+				filled += mask[i];
+			}
+		}
+	}
+
+	return filled;
+}
+
+//******************************************************************************
+//! \brief        Fill holes of depth in place.
+//******************************************************************************
+size_t apl_fill_run(apl_fill *fill, uint16_t *depth, const uint16_t *ir, uint8_t *mask)
+{
+	std::atomic<size_t> filled(0);
+	bool marked;
+	uint32_t l;
+
+	//! \remark 1. Push, Image To Level 1, Then Down To Top Of Pyramid.
+	apl_pool_for(fill->lv[1].h, 0, [&](size_t row_begin, size_t row_end) {
+		apl_fill_push<uint16_t>(depth, NULL, ir, fill->w, fill->h, &fill->lv[1], row_begin, row_end);
+	});
+	for (l = 2; l <= fill->level_num; l++) {
+		const apl_fill_level *up = &fill->lv[l - 1];
+		apl_pool_for(fill->lv[l].h, 0, [&](size_t row_begin, size_t row_end) {
+			apl_fill_push<float>(up->dp, up->wt, up->ir, up->w, up->h, &fill->lv[l], row_begin, row_end);
+		});
+	}
+
+	//! \remark 2. Holes Wider Than max_hole, Each Empties A Block Of Level level_num - 1.
+	marked = apl_fill_has_empty(fill, fill->level_num - 1, depth);
+	if (marked) {
+		apl_fill_mark(fill, depth, mask);
+	}
+
+	//! \remark 3. Pull, Holes Of Each Level From Level Below, Up To Level 1.
+	for (l = fill->level_num; l >= 2; l--) {
+		apl_pool_for(fill->lv[l - 1].h, 0, [&](size_t row_begin, size_t row_end) {
+			apl_fill_pull(fill, l, row_begin, row_end);
+		});
+	}
+
+	//! \remark 4. Holes Of Image, Flagged In Mask.
+	apl_pool_for(fill->h, 0, [&](size_t row_begin, size_t row_end) {
+		filled.fetch_add(apl_fill_pull_image(fill, depth, ir, mask, marked, row_begin, row_end), std::memory_order_relaxed);
+	});
+
+	return filled.load();
+}
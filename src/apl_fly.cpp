@@ -0,0 +1,212 @@
+//******************************************************************************
+//! \file         apl_fly.cpp
+//! \brief        flying pixel (mixed pixel at depth edge) filter of depth.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+
+#include "apl_arena.h"
+#include "apl_pool.h"
+#include "apl_fly.h"
+
+//******************************************************************************
+//! \brief        Initialize stage.
+//******************************************************************************
+void apl_fly_init(apl_fly *fly, size_t w, size_t h, const apl_lens *lens, float angle,
+				  float abs, float rel, uint32_t jump_min, uint16_t conf_min)
+{
+	const size_t tiles = (h + APL_FLY_TILE - 1) / APL_FLY_TILE;
+	size_t x;
+
+	fly->w = w;
+	fly->h = h;
+	fly->abs = std::max(abs, 0.0F);
+	fly->rel = std::max(rel, 0.0F);
+	fly->jump_min = std::min<uint32_t>(std::max<uint32_t>(jump_min, 1), 4);
+	fly->conf_min = conf_min;
+	fly->rx = NULL;
+	fly->ry = NULL;
+
+	// 3D Test, Rays Of Columns Padded By One On Both Sides (Neighbors Of Border Are Invalid Anyway)
+	if ((lens != NULL) && (angle > 0) && (lens->w == w) && (lens->h == h)) {
+		const float c = cosf(angle * (float)M_PI / 180.0F);
+		fly->cos2 = c * c;
+		fly->rx = static_cast<float *>(apl_arena_alloc((w + 2) * sizeof(float)));
+		for (x = 0; x < w; x++) {
+			fly->rx[x + 1] = lens->rx[x];
+		}
+		fly->rx[0] = lens->rx[0];
+		fly->rx[w + 1] = lens->rx[w - 1];
+		fly->ry = lens->ry;
+	}
+
+	// Row Buffers, Zero Filled So Border Of Ring Is Invalid
+	fly->halo    = static_cast<uint16_t *>(apl_arena_alloc(tiles * 2 * w * sizeof(uint16_t)));
+	fly->ring    = static_cast<uint16_t *>(apl_arena_alloc(tiles * 3 * (w + 2) * sizeof(uint16_t)));
+	fly->zero    = static_cast<uint16_t *>(apl_arena_alloc(w * sizeof(uint16_t)));
+	fly->removed = static_cast<uint32_t *>(apl_arena_alloc(tiles * sizeof(uint32_t)));
+}
+
+//******************************************************************************
+//! \brief        Filter one row, branch free so that it is vectorized.
+//! \param[in]    row           rows above, current and below, padded by one pixel of 0.
+//! \param[in]    cf            confdata of row.
+//! \param[in]    conf_min      confdata below it needs one jump only.
+//! \param[in]    y             row.
+//! \param[out]   dst           depth of row.
+//! \return       pixels invalidated.
+//******************************************************************************
+template <bool RAY>
+static uint32_t apl_fly_row(const apl_fly *fly, uint16_t *const row[3], const uint16_t *cf, uint16_t conf_min, size_t y, uint16_t *dst)
+{
+	const size_t w = fly->w;
+	const float abs = fly->abs;
+	const float rel = fly->rel;
+	const float cos2 = fly->cos2;
+	const uint32_t jump_min = fly->jump_min;
+	const float *rx = fly->rx;
+	float ry[3] = { 0, 0, 0 };
+	uint32_t removed = 0;
+	size_t x;
+
+	if (RAY) {
+		ry[0] = fly->ry[(y > 0) ? (y - 1) : y];
+		ry[1] = fly->ry[y];
+		ry[2] = fly->ry[(y + 1 < fly->h) ? (y + 1) : y];
+	}
+
+	for (x = 0; x < w; x++) {
+		const float z = (float)row[1][x + 1];
+		const float thr = abs + (rel * z);
+		const float px = RAY ? (z * rx[x + 1]) : 0;
+		const float py = RAY ? (z * ry[1]) : 0;
+		const float p2 = (px * px) + (py * py) + (z * z);
+		bool jump[3][3];
+
+#pragma GCC unroll 3
+		for (int dy = 0; dy < 3; dy++) {
+#pragma GCC unroll 3
+			for (int dx = 0; dx < 3; dx++) {
+				const float zn = (float)row[dy][x + dx];	// Padded, Column x + dx Is Neighbor x + dx - 1
+				const float dz = zn - z;
+
+				if (RAY) {
+					// Step P -> Q Against Ray Of P, cos^2 Without Square Root
+					const float ex = (zn * rx[x + dx]) - px;
+					const float ey = (zn * ry[dy]) - py;
+					const float dot = (ex * px) + (ey * py) + (dz * z);
+					const float e2 = (ex * ex) + (ey * ey) + (dz * dz);
+					jump[dy][dx] = (zn > 0) & (fabsf(dz) > abs) & ((dot * dot) > (cos2 * e2 * p2));
+				}
+				else {
+					jump[dy][dx] = (zn > 0) & (fabsf(dz) > thr);
+				}
+			}
+		}
+
+		// Lines Through p Broken On Both Sides, One Side Only Is A True Edge
+		const uint32_t broken = (uint32_t)(jump[1][0] & jump[1][2]) + (uint32_t)(jump[0][1] & jump[2][1]) +
+								(uint32_t)(jump[0][0] & jump[2][2]) + (uint32_t)(jump[0][2] & jump[2][0]);
+		const bool edge = jump[0][0] | jump[0][1] | jump[0][2] | jump[1][0] | jump[1][2] | jump[2][0] | jump[2][1] | jump[2][2];
+		const bool flying = (broken >= jump_min) | (edge & (cf[x] < conf_min));
+
+		removed += (flying & (z > 0)) ? 1U : 0U;
+		dst[x] = flying ? 0 : row[1][x + 1];
+	}
+
+	return removed;
+}
+
+//******************************************************************************
+//! \brief        Copy row into ring, NULL = row of 0 (out of image).
+//******************************************************************************
+static void apl_fly_load(uint16_t *ring, const uint16_t *src, size_t w)
+{
+	if (src != NULL) {
+		memcpy(ring + 1, src, w * sizeof(uint16_t));
+	}
+	else {
+		memset(ring + 1, 0, w * sizeof(uint16_t));
+	}
+}
+
+//******************************************************************************
+//! \brief        Filter rows of tiles, neighbors are read from ring of original rows.
+//******************************************************************************
+static uint32_t apl_fly_rows(apl_fly *fly, uint16_t *depth, const uint16_t *conf, size_t row_begin, size_t row_end)
+{
+	const size_t w = fly->w;
+	const size_t h = fly->h;
+	const size_t tile = row_begin / APL_FLY_TILE;
+	uint16_t *ring = fly->ring + (tile * 3 * (w + 2));
+	uint16_t *row[3] = { ring, ring + (w + 2), ring + (2 * (w + 2)) };
+	const uint16_t conf_min = (conf != NULL) ? fly->conf_min : 0;
+	uint32_t removed = 0;
+	size_t y;
+
+	// Row Above Belongs To Other Tile, It May Be Filtered Already, Take Its Copy
+	apl_fly_load(row[0], (row_begin > 0) ? (fly->halo + (tile * 2 * w)) : NULL, w);
+	apl_fly_load(row[1], depth + (row_begin * w), w);
+
+	for (y = row_begin; y < row_end; y++) {
+		const uint16_t *below = NULL;
+		if ((y + 1) < row_end) {
+			below = depth + ((y + 1) * w);
+		}
+		else
+		if ((y + 1) < h) {
+			below = fly->halo + ((((y + 1) / APL_FLY_TILE) * 2 * w) + w);
+		}
+		apl_fly_load(row[2], below, w);
+
+		const uint16_t *cf = (conf != NULL) ? (conf + (y * w)) : fly->zero;
+		if (fly->rx != NULL) {
+			removed += apl_fly_row<true>(fly, row, cf, conf_min, y, depth + (y * w));
+		}
+		else {
+			removed += apl_fly_row<false>(fly, row, cf, conf_min, y, depth + (y * w));
+		}
+
+		std::rotate(row, row + 1, row + 3);
+	}
+
+	return removed;
+}
+
+//******************************************************************************
+//! \brief        Invalidate flying pixels in place.
+//******************************************************************************
+size_t apl_fly_run(apl_fly *fly, uint16_t *depth, const uint16_t *conf)
+{
+	const size_t w = fly->w;
+	const size_t tiles = (fly->h + APL_FLY_TILE - 1) / APL_FLY_TILE;
+	size_t removed = 0;
+	size_t t;
+
+	//! \remark 1. Original Rows Around Tile Boundaries, Tiles Filter Their Rows In Place Concurrently.
+	for (t = 1; t < tiles; t++) {
+		const size_t r = t * APL_FLY_TILE;
+		memcpy(fly->halo + (t * 2 * w), depth + ((r - 1) * w), 2 * w * sizeof(uint16_t));
+	}
+
+	//! \remark 2. Tiles In Parallel, Bands Are Whole Tiles.
+	memset(fly->removed, 0, tiles * sizeof(uint32_t));
+	apl_pool_for(fly->h, APL_FLY_TILE, [&](size_t row_begin, size_t row_end) {
+		fly->removed[row_begin / APL_FLY_TILE] = apl_fly_rows(fly, depth, conf, row_begin, row_end);
+	});
+
+	for (t = 0; t < tiles; t++) {
+		removed += fly->removed[t];
+	}
+
+	return removed;
+}
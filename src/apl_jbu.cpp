@@ -0,0 +1,154 @@
+//******************************************************************************
+//! \file         apl_jbu.cpp
+//! \brief        joint bilateral upsampling of depth guided by ir (QVGA depth -> VGA).
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+#include <algorithm>
+
+#include "apl_arena.h"
+#include "apl_pool.h"
+#include "apl_jbu.h"
+
+//******************************************************************************
+//! \brief        Initialize stage.
+//******************************************************************************
+void apl_jbu_init(apl_jbu *jbu, size_t lw, size_t lh, float sigma_s, float sigma_r)
+{
+	size_t n = (lw + 2) * (lh + 2);
+	int phase;
+	int t;
+
+	jbu->lw = lw;
+	jbu->lh = lh;
+	jbu->inv_r2 = 1.0F / std::max(sigma_r * sigma_r, 1.0F);
+
+	// High Resolution Pixel 2j + phase Is At j - 0.25 + (phase * 0.5) Of Low Resolution, Taps j - 1 .. j + 1
+	for (phase = 0; phase < 2; phase++) {
+		for (t = 0; t < APL_JBU_TAP; t++) {
+			float dist = (float)(t - 1) - (-0.25F + (phase * 0.5F));
+			jbu->ws[phase][t] = expf(-(dist * dist) / (2.0F * std::max(sigma_s * sigma_s, 0.01F)));
+		}
+	}
+
+	// Border Stays 0 (Invalid), No Clamping In Inner Loop
+	jbu->dp = static_cast<float *>(apl_arena_alloc(n * sizeof(float)));
+	jbu->ir = static_cast<float *>(apl_arena_alloc(n * sizeof(float)));
+	jbu->vm = static_cast<float *>(apl_arena_alloc(n * sizeof(float)));
+}
+
+//******************************************************************************
+//! \brief        Low resolution planes of rows, depth to float, 2 x 2 mean of ir.
+//******************************************************************************
+static void apl_jbu_prep(apl_jbu *jbu, const uint16_t *dp_lo, const uint16_t *ir_hi, size_t row_begin, size_t row_end)
+{
+	const size_t lw = jbu->lw;
+	const size_t hw = lw * 2;
+	size_t y;
+	size_t x;
+
+	for (y = row_begin; y < row_end; y++) {
+		const uint16_t *src = dp_lo + (y * lw);
+		const uint16_t *ir0 = ir_hi + ((y * 2) * hw);
+		const uint16_t *ir1 = ir0 + hw;
+		float *dp = jbu->dp + ((y + 1) * (lw + 2)) + 1;
+		float *ir = jbu->ir + ((y + 1) * (lw + 2)) + 1;
+		float *vm = jbu->vm + ((y + 1) * (lw + 2)) + 1;
+
+		for (x = 0; x < lw; x++) {
+			dp[x] = (float)src[x];
+			vm[x] = (src[x] != 0) ? 1.0F : 0.0F;
+			ir[x] = (float)(ir0[2 * x] + ir0[(2 * x) + 1] + ir1[2 * x] + ir1[(2 * x) + 1]) * 0.25F;
+		}
+	}
+}
+
+//******************************************************************************
+//! \brief        Upsample rows of high resolution, branch free so that it is vectorized.
+//! \details      Pairs of output pixels (2j, 2j + 1) share taps j - 1 .. j + 1 of low resolution.
+//******************************************************************************
+static void apl_jbu_rows(const apl_jbu *jbu, const uint16_t *ir_hi, uint16_t *dp_hi, size_t row_begin, size_t row_end)
+{
+	const size_t lw = jbu->lw;
+	const size_t hw = lw * 2;
+	const size_t stride = lw + 2;
+	const float inv_r2 = jbu->inv_r2;
+	size_t y;
+	size_t j;
+	int ty;
+
+	for (y = row_begin; y < row_end; y++) {
+		const size_t cy = (y >> 1) + 1;		// Center Row In Padded Plane
+		const float *wy = jbu->ws[y & 1];
+		const uint16_t *guide = ir_hi + (y * hw);
+		uint16_t *dst = dp_hi + (y * hw);
+		const float *dp[APL_JBU_TAP];
+		const float *ir[APL_JBU_TAP];
+		const float *vm[APL_JBU_TAP];
+		float w0[APL_JBU_TAP][APL_JBU_TAP];		// Spatial Weight Of Even Output
+		float w1[APL_JBU_TAP][APL_JBU_TAP];		// Spatial Weight Of Odd Output
+
+		for (ty = 0; ty < APL_JBU_TAP; ty++) {
+			dp[ty] = jbu->dp + ((cy + ty - 1) * stride);
+			ir[ty] = jbu->ir + ((cy + ty - 1) * stride);
+			vm[ty] = jbu->vm + ((cy + ty - 1) * stride);
+			for (int tx = 0; tx < APL_JBU_TAP; tx++) {
+				w0[ty][tx] = wy[ty] * jbu->ws[0][tx];
+				w1[ty][tx] = wy[ty] * jbu->ws[1][tx];
+			}
+		}
+
+		for (j = 0; j < lw; j++) {
+			const float g0 = (float)guide[2 * j];
+			const float g1 = (float)guide[(2 * j) + 1];
+			float sw0 = 0;
+			float sd0 = 0;
+			float sw1 = 0;
+			float sd1 = 0;
+
+#pragma GCC unroll 3
+			for (ty = 0; ty < APL_JBU_TAP; ty++) {
+#pragma GCC unroll 3
+				for (int tx = 0; tx < APL_JBU_TAP; tx++) {
+					const float d = dp[ty][j + tx];			// Padded, Column j + tx Is Tap j + tx - 1
+					const float e0 = g0 - ir[ty][j + tx];
+					const float e1 = g1 - ir[ty][j + tx];
+					const float k0 = (w0[ty][tx] * vm[ty][j + tx]) / (1.0F + (e0 * e0 * inv_r2));
+					const float k1 = (w1[ty][tx] * vm[ty][j + tx]) / (1.0F + (e1 * e1 * inv_r2));
+
+					sw0 += k0;
+					sd0 += k0 * d;
+					sw1 += k1;
+					sd1 += k1 * d;
+				}
+			}
+
+			// No Valid Tap, Weights Are 0
+			dst[2 * j] = (uint16_t)((sd0 / std::max(sw0, 1e-12F)) + 0.5F);
+			dst[(2 * j) + 1] = (uint16_t)((sd1 / std::max(sw1, 1e-12F)) + 0.5F);
+		}
+	}
+}
+
+//******************************************************************************
+//! \brief        Upsample depth.
+//******************************************************************************
+void apl_jbu_run(apl_jbu *jbu, const uint16_t *dp_lo, const uint16_t *ir_hi, uint16_t *dp_hi)
+{
+	//! \remark 1. Low Resolution Planes, Rows In Parallel.
+	apl_pool_for(jbu->lh, 0, [&](size_t row_begin, size_t row_end) {
+		apl_jbu_prep(jbu, dp_lo, ir_hi, row_begin, row_end);
+	});
+
+	//! \remark 2. High Resolution Rows In Parallel.
+	apl_pool_for(jbu->lh * 2, 0, [&](size_t row_begin, size_t row_end) {
+		apl_jbu_rows(jbu, ir_hi, dp_hi, row_begin, row_end);
+	});
+}
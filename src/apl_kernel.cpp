@@ -0,0 +1,328 @@
+//******************************************************************************
+//! \file         apl_kernel.cpp
+//! \brief        per-frame image kernels of viewer application.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include <algorithm>
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "tl.h"
+#include "apl_pool.h"
+#include "apl_kernel.h"
+
+//******************************************************************************
+//! \brief        Set gain and bias, bounded so that raw * gain + bias of RAW12 raw never overflows int32.
+//******************************************************************************
+static void apl_dp_cnv_set(apl_dp_cnv *cnv, int64_t gain, int64_t bias)
+{
+	bias = std::min<int64_t>(std::max<int64_t>(bias, INT32_MIN), INT32_MAX);
+	gain = std::min<int64_t>(std::max<int64_t>(gain, 0), (INT32_MAX - std::max<int64_t>(bias, 0)) / RAW12_INVALID_DEPTH);
+
+	cnv->gain = (int32_t)gain;
+	cnv->bias = (int32_t)bias;
+}
+
+//******************************************************************************
+//! \brief        Initialize depth conversion, without temperature correction.
+//! \n
+//! \param[out]   cnv           Depth conversion.
+//! \param[in]    unit          depth_unit [mm/digit].
+//! \param[in]    tcc_on        Apply stMPTempCrct when it is received.
+//! \param[in]    slope_one     stMPTempCrct::slope meaning 1.0.
+//! \return       None
+//******************************************************************************
+void apl_dp_cnv_init(apl_dp_cnv *cnv, uint16_t unit, bool tcc_on, uint16_t slope_one)
+{
+	cnv->unit = unit;
+	cnv->tcc_on = tcc_on;
+	cnv->slope_one = (slope_one != 0) ? slope_one : APL_DP_TCC_SLOPE_ONE;
+	cnv->tcc_valid = false;
+	apl_dp_cnv_set(cnv, (int64_t)unit << APL_DP_CNV_SHIFT, 0);
+}
+
+//******************************************************************************
+//! \brief        Update temperature correction, coefficients are recomputed only if updated.
+//! \n
+//! \param[in,out] cnv          Depth conversion.
+//! \param[in]    crct          Temperature correction information of the frame.
+//! \return       None
+//******************************************************************************
+void apl_dp_cnv_update(apl_dp_cnv *cnv, const stMPTempCrct *crct)
+{
+	if ((!cnv->tcc_on) || ((!crct->is_updated) && cnv->tcc_valid)) {
+		return;
+	}
+
+	// Slope 0 Is Not Initialized Profile, Keep Unit Conversion Only
+	if (crct->slope == 0) {
+		return;
+	}
+
+	// depth[mm] = ((raw * slope / slope_one) + offset) * unit
+	apl_dp_cnv_set(cnv, ((int64_t)cnv->unit * crct->slope * (1 << APL_DP_CNV_SHIFT)) / cnv->slope_one,
+				   ((int64_t)crct->offset * cnv->unit * (1 << APL_DP_CNV_SHIFT)) + (1 << (APL_DP_CNV_SHIFT - 1)));
+	cnv->tcc_valid = true;
+}
+
+//******************************************************************************
+//! \brief        Preprocess depth rows, convert using depth_unit and temperature correction,
+//!               exclude saturated depth data.
+//! \n
+//! \param[in,out] dp           Depth image.
+//! \param[in]    w             Depth image width.
+//! \param[in]    row_begin     First row.
+//! \param[in]    row_end       Last row + 1.
+//! \param[in]    cnv           Depth conversion.
+//! \return       None
+//******************************************************************************
+void apl_cnv_dp_rows(uint16_t *dp, size_t w, size_t row_begin, size_t row_end, const apl_dp_cnv *cnv)
+{
+	uint16_t* src;
+	const int32_t gain = cnv->gain;
+	const int32_t bias = cnv->bias;
+	size_t n;
+	size_t i;
+
+	src = dp + (w * row_begin);
+	n = w * (row_end - row_begin);
+
+	//! \remark Branch Free, Compiler Vectorizes It (Release Build), 32 Bit Product Never Overflows (Bounded Gain), Saturated On Store.
+	for (i = 0; i < n; i++) {
+		int32_t v = src[i];
+		int32_t d = ((v * gain) + bias) >> APL_DP_CNV_SHIFT;
+
+		d = (d < 0) ? 0 : ((d > 0xFFFF) ? 0xFFFF : d);
+		src[i] = (v == RAW12_INVALID_DEPTH) ? 0 : (uint16_t)d;	//INVALID_DEPTH;
+	}
+}
+
+//******************************************************************************
+//! \brief        Preprocess depth data, convert using depth_unit, exclude saturated depth data.
+//! \n
+//! \param[in]    reso          Depth Image Format.
+//! \param[in]    stData        Image data.
+//! \param[in]    cnv           Depth conversion.
+//! \param[out]   None.
+//! \return       None
+//******************************************************************************
+void apl_cnv_dp(TL_Resolution reso, TL_Image *stData, const apl_dp_cnv *cnv)
+{
+	size_t w;
+	size_t h;
+	uint16_t* dp;
+
+	h = reso.depth.height;
+	w = reso.depth.width;
+	dp = static_cast<uint16_t*>(stData->depth);
+
+	apl_pool_for(h, 0, [dp, w, cnv](size_t row_begin, size_t row_end) {
+		apl_cnv_dp_rows(dp, w, row_begin, row_end, cnv);
+	});
+}
+
+//******************************************************************************
+//! \brief        Utilities Function To Convert Depth Image To Color Map, By Using OpenCV API.
+//! \n
+//! \param[in]    img       Depth Image.
+//! \param[in]    min_val   Minimum Depth Value.
+//! \param[in]    max_val   Depth Value.
+//! \param[out]   None.
+//! \return       cv::Mat of Type CV_8UC3 (8Bits 3 Channels).
+//! \date         2021-02-16, Tue, 02:33 PM
+//******************************************************************************
+cv::Mat apl_dpth_to_color_by_opencv(cv::Mat img, uint32_t min_val, uint32_t max_val)
+{
+	size_t w = img.cols;
+	size_t h = img.rows;
+	double d_min_val = min_val;
+	double d_max_val = max_val;
+	cv::Mat mat_color(h, w, CV_8UC3);
+
+	//! \remark Each Row Band Is Independent, Run Bands On Worker Pool.
+	apl_pool_for(h, 0, [&](size_t row_begin, size_t row_end) {
+		size_t i;
+		size_t j;
+		cv::Mat band_in = img.rowRange((int)row_begin, (int)row_end);
+		cv::Mat band_out = mat_color.rowRange((int)row_begin, (int)row_end);
+		cv::Mat mat_8bit;
+		cv::Mat mat_32bit;
+
+		//! \remark 1. Normalise To 32Bits Float.
+		band_in.convertTo(mat_32bit, CV_32FC1, 1/(d_max_val - d_min_val), -d_min_val/(d_max_val - d_min_val));
+
+		//! \remark 2. Convert To 8Bits, As applyColorMap() Only Accept CV_8U.
+		mat_32bit.convertTo(mat_8bit, CV_8UC1, -255, 255);
+
+		//! \remark 3. Convert To Rainbow Color, Into The Band Of Output Image.
+		cv::applyColorMap(mat_8bit, band_out, cv::COLORMAP_JET);
+
+		//! \remark 4. Mask Off Upper And Lower Range.
+		for (i = 0 ; i < (row_end - row_begin); i++) {
+			const float *y = mat_32bit.ptr<float>(i);
+			cv::Vec3b *dst = band_out.ptr<cv::Vec3b>(i);
+
+			for (j = 0 ; j < w; j++) {
+				if (y[j] > 1) {
+					dst[j] = 0;		// Change To Black, i.e. 0 if (img > 1).
+				}
+				else
+				if (y[j] < 0) {
+					dst[j] = 255;	// Change To White, i.e. 255 if (img < 0).
+				}
+			}
+		}
+	});
+
+	return mat_color;
+}
+
+//******************************************************************************
+//! \brief        Build Color Table Of Depth Range, Nothing Is Done If Range Is Unchanged.
+//! \n
+//! \param[in,out] lut     Color Table.
+//! \param[in]    min_val  Minimum Depth Value.
+//! \param[in]    max_val  Maximum Depth Value.
+//! \return       true     Table Is Rebuilt.
+//******************************************************************************
+bool apl_color_lut_build(apl_color_lut *lut, uint16_t min_val, uint16_t max_val)
+{
+	double d_min_val = min_val;
+	double d_max_val = max_val;
+	cv::Mat mat_ramp(1, 256, CV_8UC1);
+	cv::Mat mat_jet;
+	size_t d;
+
+	if ((!lut->tbl.empty()) && (lut->range_min == min_val) && (lut->range_max == max_val)) {
+		return false;
+	}
+	if (max_val <= min_val) {
+		return false;
+	}
+
+	//! \remark 1. Colors Of COLORMAP_JET.
+	for (d = 0; d < 256; d++) {
+		mat_ramp.at<uint8_t>(0, (int)d) = (uint8_t)d;
+	}
+	cv::applyColorMap(mat_ramp, mat_jet, cv::COLORMAP_JET);
+
+	//! \remark 2. Same Normalisation And Masking As apl_dpth_to_color_by_opencv().
+	lut->range_min = min_val;
+	lut->range_max = max_val;
+	lut->tbl.resize((size_t)max_val + 2);
+	for (d = 0; d < lut->tbl.size(); d++) {
+		float y = (float)((double)d * (1 / (d_max_val - d_min_val)) - (d_min_val / (d_max_val - d_min_val)));
+
+		if (y > 1) {
+			lut->tbl[d] = 0;	// Change To Black, i.e. 0 if (img > 1).
+		}
+		else
+		if (y < 0) {
+			lut->tbl[d] = 255;	// Change To White, i.e. 255 if (img < 0).
+		}
+		else {
+			lut->tbl[d] = mat_jet.at<cv::Vec3b>(0, cv::saturate_cast<uint8_t>((-255 * y) + 255));
+		}
+	}
+
+	return true;
+}
+
+//******************************************************************************
+//! \brief        Convert Depth Image To Color Map By Color Table.
+//! \n
+//! \param[in]    img      Depth Image, CV_16UC1.
+//! \param[in]    lut      Color Table.
+//! \return       cv::Mat of Type CV_8UC3 (8Bits 3 Channels).
+//******************************************************************************
+cv::Mat apl_dpth_to_color_by_lut(cv::Mat img, const apl_color_lut *lut)
+{
+	size_t w = img.cols;
+	size_t h = img.rows;
+	cv::Mat mat_color(h, w, CV_8UC3);
+
+	apl_pool_for(h, 0, [&](size_t row_begin, size_t row_end) {
+		const cv::Vec3b *tbl = lut->tbl.data();
+		const uint16_t last = (uint16_t)(lut->tbl.size() - 1);
+		size_t i;
+		size_t j;
+
+		for (i = row_begin; i < row_end; i++) {
+			const uint16_t *src = img.ptr<uint16_t>((int)i);
+			cv::Vec3b *dst = mat_color.ptr<cv::Vec3b>((int)i);
+
+			for (j = 0; j < w; j++) {
+				dst[j] = tbl[(src[j] < last) ? src[j] : last];
+			}
+		}
+	});
+
+	return mat_color;
+}
+
+//******************************************************************************
+//! \brief        Apply Gamma Correction To 16Bits Image, By Using OpenCV API.
+//! \n
+//! \param[in]    src       Image, CV_16UC1.
+//! \param[out]   dst       Image Of Same Size And Type (May Be src For In Place).
+//! \param[in]    gamma     Gamma Value.
+//! \return       None
+//******************************************************************************
+void apl_gamma_by_opencv(cv::Mat src, cv::Mat dst, float gamma)
+{
+	apl_pool_for(src.rows, 0, [&](size_t row_begin, size_t row_end) {
+		cv::Mat band = src.rowRange((int)row_begin, (int)row_end);
+		cv::Mat band_dst = dst.rowRange((int)row_begin, (int)row_end);
+
+		//! \remark - Convert To Double For "pow()".
+		cv::Mat band_64f;
+		band.convertTo(band_64f, CV_64F);
+
+		//! \remark - Apply Gamma Correction.
+		cv::Mat band_pow;
+		cv::pow(band_64f, gamma, band_pow);
+
+		//! \remark - Convert Back To 16Bits, Into The Band Of Destination.
+		band_pow.convertTo(band_dst, CV_16UC1);
+	});
+}
+
+//******************************************************************************
+//! \brief        Write One Image Plane To Raw File.
+//! \n
+//! \param[in]    fn       File Name.
+//! \param[in]    data     Image Plane.
+//! \param[in]    size     Size Of Image Plane [byte].
+//! \return       0        success
+//! \return       -1       fopen failed
+//******************************************************************************
+int apl_save_plane(const char *fn, const void *data, size_t size)
+{
+	FILE *fp;
+	size_t ret;
+
+	fp = fopen(fn, "wb");
+	if (fp == NULL) {
+		printf("fopen (%s) failed\n", fn);
+		return -1;
+	}
+
+	ret = fwrite(data, size, 1, fp);
+	if ((ret != (size_t)1) || (ferror(fp) != 0)) {
+		printf("fwrite (%s) failed(%d/%d)\n", fn, (int)ret, ferror(fp));
+		clearerr(fp);
+	}
+
+	(void)fclose(fp);
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+//******************************************************************************
+//! \file         apl_lens.cpp
+//! \brief        lens model and ray tables of depth image, shared by 3D stages.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "tl.h"
+#include "apl_arena.h"
+#include "apl_lens.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_LENS_DEG2RAD(a)		((a) * 3.14159265358979 / 180.0)
+
+//******************************************************************************
+//! \brief        Initialize lens model and ray tables of image size.
+//******************************************************************************
+int apl_lens_init(apl_lens *lens, const TL_LensPrm *prm, const TL_Fov *fov, uint16_t w, uint16_t h)
+{
+	double sx = (prm->sns_h != 0) ? ((double)w / prm->sns_h) : 1.0;
+	double sy = (prm->sns_v != 0) ? ((double)h / prm->sns_v) : 1.0;
+	size_t i;
+
+	lens->w = w;
+	lens->h = h;
+
+	//! \remark 1. Focal Length [x100 mm] / Pixel Pitch [x100 um] At Sensor, Scaled To Image.
+	if ((fov->focal_length != 0) && (prm->pixel_pitch != 0)) {
+		double f = ((double)fov->focal_length * 1000.0) / prm->pixel_pitch;
+		lens->fx = (float)(f * sx);
+		lens->fy = (float)(f * sy);
+	}
+	//! \remark 2. Or Viewing Angle [x100 degree] Over Image.
+	else
+	if ((fov->angle_h != 0) && (fov->angle_v != 0)) {
+		lens->fx = (float)((w / 2.0) / tan(APL_LENS_DEG2RAD(fov->angle_h / 200.0)));
+		lens->fy = (float)((h / 2.0) / tan(APL_LENS_DEG2RAD(fov->angle_v / 200.0)));
+	}
+	else {
+		printf("lens : no focal length nor viewing angle\n");
+		return -1;
+	}
+
+	lens->cx = (prm->center_h != 0) ? (float)(prm->center_h * sx) : (float)(w / 2.0);
+	lens->cy = (prm->center_v != 0) ? (float)(prm->center_v * sy) : (float)(h / 2.0);
+
+	lens->rx = static_cast<float *>(apl_arena_alloc(w * sizeof(float)));
+	lens->ry = static_cast<float *>(apl_arena_alloc(h * sizeof(float)));
+	if ((lens->rx == NULL) || (lens->ry == NULL)) {
+		return -1;
+	}
+	for (i = 0; i < w; i++) {
+		lens->rx[i] = ((float)i - lens->cx) / lens->fx;
+	}
+	for (i = 0; i < h; i++) {
+		lens->ry[i] = ((float)i - lens->cy) / lens->fy;
+	}
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Write lens parameters as key = value file.
+//******************************************************************************
+int apl_lens_save(const char *fn, const TL_LensPrm *prm, const TL_Fov *fov)
+{
+	FILE *fp;
+	int i;
+
+	fp = fopen(fn, "w");
+	if (fp == NULL) {
+		printf("fopen (%s) failed\n", fn);
+		return -1;
+	}
+
+	fprintf(fp, "# lens of saved frames, TL_CMD_LENS_INFO and TL_CMD_FOV\n");
+	fprintf(fp, "lens.sns_h        = %u\n", prm->sns_h);
+	fprintf(fp, "lens.sns_v        = %u\n", prm->sns_v);
+	fprintf(fp, "lens.center_h     = %u\n", prm->center_h);
+	fprintf(fp, "lens.center_v     = %u\n", prm->center_v);
+	fprintf(fp, "lens.pixel_pitch  = %u\n", prm->pixel_pitch);
+	for (i = 0; i < 4; i++) {
+		fprintf(fp, "lens.planer_prm%d  = %lld\n", i, (long long)prm->planer_prm[i]);
+	}
+	for (i = 0; i < 4; i++) {
+		fprintf(fp, "lens.distortion_prm%d = %lld\n", i, (long long)prm->distortion_prm[i]);
+	}
+	fprintf(fp, "fov.focal_length  = %u\n", fov->focal_length);
+	fprintf(fp, "fov.angle_h       = %u\n", fov->angle_h);
+	fprintf(fp, "fov.angle_v       = %u\n", fov->angle_v);
+
+	(void)fclose(fp);
+
+	return 0;
+}
@@ -0,0 +1,542 @@
+//******************************************************************************
+//! \file         apl_mesh.cpp
+//! \brief        triangle mesh of organized depth, textured by ir, written as PLY / OBJ by own thread.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+
+#include "apl_arena.h"
+#include "apl_pool.h"
+#include "apl_thread.h"
+#include "apl_metrics.h"
+#include "apl_mesh.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_MESH_MM_TO_M	(0.001F)			// vertices are written in meters
+#define APL_MESH_IO_SIZE	(1024 * 1024)		// stdio buffer of writer
+
+// Triangles Of Quad (p00 = (u, v), p10 = (u + 1, v), p01 = (u, v + 1), p11 = (u + 1, v + 1))
+typedef enum {
+	 APL_MESH_TRI_A = 1		// p00 p01 p10, upper left
+	,APL_MESH_TRI_B = 2		// p10 p01 p11, lower right
+	,APL_MESH_TRI_C = 4		// p00 p01 p11, p10 is invalid
+	,APL_MESH_TRI_D = 8		// p00 p11 p10, p01 is invalid
+} APL_MESH_TRI;
+
+static const char *FMT_NAME[APL_MESH_FMT_NUM] = { "ply", "obj" };
+static const char *FMT_EXT[APL_MESH_FMT_NUM] = { ".ply", ".obj" };
+
+//******************************************************************************
+//! \brief        Initialize mesh.
+//******************************************************************************
+void apl_mesh_init(apl_mesh *mesh, const apl_lens *lens, float jump, uint16_t ir_max)
+{
+	const size_t w = lens->w;
+	const size_t h = lens->h;
+	const size_t tiles = (h + APL_MESH_TILE - 1) / APL_MESH_TILE;
+
+	mesh->w = w;
+	mesh->h = h;
+	mesh->jump = std::max(jump, 0.0F);
+	mesh->ir_scale = 255.0F / (float)std::max<uint16_t>(ir_max, 1);
+	mesh->rx = lens->rx;
+	mesh->ry = lens->ry;
+	mesh->vtx = static_cast<apl_mesh_vtx *>(apl_arena_alloc(w * h * sizeof(apl_mesh_vtx)));
+	mesh->face = static_cast<apl_mesh_face *>(apl_arena_alloc(2 * w * h * sizeof(apl_mesh_face)));
+	mesh->vid = static_cast<uint32_t *>(apl_arena_alloc(w * h * sizeof(uint32_t)));
+	mesh->tile_vtx = static_cast<size_t *>(apl_arena_alloc(tiles * sizeof(size_t)));
+	mesh->tile_face = static_cast<size_t *>(apl_arena_alloc(tiles * sizeof(size_t)));
+	mesh->vtx_num = 0;
+	mesh->face_num = 0;
+}
+
+//******************************************************************************
+//! \brief        Free buffers of mesh.
+//******************************************************************************
+void apl_mesh_term(apl_mesh *mesh)
+{
+	apl_arena_free(mesh->vtx);
+	apl_arena_free(mesh->face);
+	apl_arena_free(mesh->vid);
+	apl_arena_free(mesh->tile_vtx);
+	apl_arena_free(mesh->tile_face);
+	mesh->vtx = NULL;
+	mesh->face = NULL;
+	mesh->vid = NULL;
+	mesh->tile_vtx = NULL;
+	mesh->tile_face = NULL;
+}
+
+//******************************************************************************
+//! \brief        Corners of triangle are valid and do not spread more than jump * nearest.
+//******************************************************************************
+static inline bool apl_mesh_tri_ok(float jump, float za, float zb, float zc)
+{
+	const float lo = std::min(std::min(za, zb), zc);
+	const float hi = std::max(std::max(za, zb), zc);
+
+	return (lo > 0) && ((hi - lo) <= (jump * lo));
+}
+
+//******************************************************************************
+//! \brief        Triangles of quad, APL_MESH_TRI bits.
+//******************************************************************************
+static inline uint32_t apl_mesh_quad(float jump, float z00, float z10, float z01, float z11)
+{
+	uint32_t tri = 0;
+
+	if (apl_mesh_tri_ok(jump, z00, z01, z10)) {
+		tri |= APL_MESH_TRI_A;
+	}
+	if (apl_mesh_tri_ok(jump, z10, z01, z11)) {
+		tri |= APL_MESH_TRI_B;
+	}
+
+	// One Corner Is Invalid, Diagonal Of The Other Three
+	if ((z10 == 0) && apl_mesh_tri_ok(jump, z00, z01, z11)) {
+		tri |= APL_MESH_TRI_C;
+	}
+	if ((z01 == 0) && apl_mesh_tri_ok(jump, z00, z11, z10)) {
+		tri |= APL_MESH_TRI_D;
+	}
+
+	return tri;
+}
+
+//******************************************************************************
+//! \brief        Count vertices and triangles of rows (triangles of quads whose upper row is in rows).
+//******************************************************************************
+static void apl_mesh_count(const apl_mesh *mesh, const uint16_t *depth, size_t row_begin, size_t row_end, size_t *vtx, size_t *face)
+{
+	const size_t w = mesh->w;
+	size_t nv = 0;
+	size_t nf = 0;
+	size_t y;
+	size_t x;
+
+	for (y = row_begin; y < row_end; y++) {
+		const uint16_t *row = depth + (y * w);
+		const uint16_t *dn = row + w;
+
+		for (x = 0; x < w; x++) {
+			nv += (row[x] != 0) ? 1 : 0;
+		}
+		if ((y + 1) >= mesh->h) {
+			continue;
+		}
+		for (x = 0; (x + 1) < w; x++) {
+			nf += (size_t)__builtin_popcount(apl_mesh_quad(mesh->jump, row[x], row[x + 1], dn[x], dn[x + 1]));
+		}
+	}
+
+	*vtx = nv;
+	*face = nf;
+}
+
+//******************************************************************************
+//! \brief        Vertices of rows from first vertex of rows.
+//******************************************************************************
+static void apl_mesh_vertices(apl_mesh *mesh, const uint16_t *depth, const uint16_t *ir, uint16_t ir_w, uint16_t ir_h,
+							  size_t row_begin, size_t row_end, size_t k)
+{
+	const size_t w = mesh->w;
+	const size_t h = mesh->h;
+	size_t y;
+	size_t x;
+
+	for (y = row_begin; y < row_end; y++) {
+		const uint16_t *row = depth + (y * w);
+		const uint16_t *ir_row = (ir != NULL) ? (ir + (((y * ir_h) / h) * ir_w)) : NULL;
+		const float ry = mesh->ry[y];
+
+		for (x = 0; x < w; x++) {
+			apl_mesh_vtx *vtx = &mesh->vtx[k];
+			const float z = (float)row[x] * APL_MESH_MM_TO_M;
+			uint8_t gray = 255;
+
+			if (row[x] == 0) {
+				continue;
+			}
+			if (ir_row != NULL) {
+				gray = (uint8_t)std::min((float)ir_row[(x * ir_w) / w] * mesh->ir_scale, 255.0F);
+			}
+			vtx->x = z * mesh->rx[x];
+			vtx->y = z * ry;
+			vtx->z = z;
+			vtx->r = gray;
+			vtx->g = gray;
+			vtx->b = gray;
+			mesh->vid[(y * w) + x] = (uint32_t)k;
+			k++;
+		}
+	}
+}
+
+//******************************************************************************
+//! \brief        Triangles of rows from first triangle of rows.
+//******************************************************************************
+static void apl_mesh_faces(apl_mesh *mesh, const uint16_t *depth, size_t row_begin, size_t row_end, size_t k)
+{
+	const size_t w = mesh->w;
+	const uint32_t *vid = mesh->vid;
+	size_t y;
+	size_t x;
+
+	for (y = row_begin; (y < row_end) && ((y + 1) < mesh->h); y++) {
+		const uint16_t *row = depth + (y * w);
+		const uint16_t *dn = row + w;
+
+		for (x = 0; (x + 1) < w; x++) {
+			const uint32_t tri = apl_mesh_quad(mesh->jump, row[x], row[x + 1], dn[x], dn[x + 1]);
+			const size_t i00 = (y * w) + x;
+			const size_t i10 = i00 + 1;
+			const size_t i01 = i00 + w;
+			const size_t i11 = i01 + 1;
+
+			if (tri == 0) {
+				continue;
+			}
+			if ((tri & APL_MESH_TRI_A) != 0) {
+				mesh->face[k++] = { 3, { vid[i00], vid[i01], vid[i10] } };
+			}
+			if ((tri & APL_MESH_TRI_B) != 0) {
+				mesh->face[k++] = { 3, { vid[i10], vid[i01], vid[i11] } };
+			}
+			if ((tri & APL_MESH_TRI_C) != 0) {
+				mesh->face[k++] = { 3, { vid[i00], vid[i01], vid[i11] } };
+			}
+			if ((tri & APL_MESH_TRI_D) != 0) {
+				mesh->face[k++] = { 3, { vid[i00], vid[i11], vid[i10] } };
+			}
+		}
+	}
+}
+
+//******************************************************************************
+//! \brief        Build mesh of depth.
+//******************************************************************************
+size_t apl_mesh_build(apl_mesh *mesh, const uint16_t *depth, const uint16_t *ir, uint16_t ir_w, uint16_t ir_h)
+{
+	const size_t tiles = (mesh->h + APL_MESH_TILE - 1) / APL_MESH_TILE;
+	size_t nv = 0;
+	size_t nf = 0;
+	size_t t;
+
+	//! \remark 1. Vertices And Triangles Of Each Tile.
+	memset(mesh->tile_vtx, 0, tiles * sizeof(size_t));
+	memset(mesh->tile_face, 0, tiles * sizeof(size_t));
+	apl_pool_for(mesh->h, APL_MESH_TILE, [&](size_t row_begin, size_t row_end) {
+		const size_t tile = row_begin / APL_MESH_TILE;
+		apl_mesh_count(mesh, depth, row_begin, row_end, &mesh->tile_vtx[tile], &mesh->tile_face[tile]);
+	});
+
+	//! \remark 2. Prefix Sum, First Vertex And Triangle Of Each Tile.
+	for (t = 0; t < tiles; t++) {
+		const size_t v = mesh->tile_vtx[t];
+		const size_t f = mesh->tile_face[t];
+		mesh->tile_vtx[t] = nv;
+		mesh->tile_face[t] = nf;
+		nv += v;
+		nf += f;
+	}
+	mesh->vtx_num = nv;
+	mesh->face_num = nf;
+
+	//! \remark 3. Vertices, Then Triangles (They Refer To Vertices Of Row Below, Maybe Of Next Tile).
+	apl_pool_for(mesh->h, APL_MESH_TILE, [&](size_t row_begin, size_t row_end) {
+		apl_mesh_vertices(mesh, depth, ir, ir_w, ir_h, row_begin, row_end, mesh->tile_vtx[row_begin / APL_MESH_TILE]);
+	});
+	apl_pool_for(mesh->h, APL_MESH_TILE, [&](size_t row_begin, size_t row_end) {
+		apl_mesh_faces(mesh, depth, row_begin, row_end, mesh->tile_face[row_begin / APL_MESH_TILE]);
+	});
+
+	return nf;
+}
+
+//******************************************************************************
+//! \brief        Write vertices and triangles as binary PLY.
+//******************************************************************************
+static bool apl_mesh_write_ply(const apl_mesh *mesh, FILE *fp)
+{
+	char hdr[512];
+	int len;
+
+	len = snprintf(hdr, sizeof(hdr),
+		"ply\n"
+		"format binary_little_endian 1.0\n"
+		"comment camera coordinate [m], x right, y down, z forward, color is ir\n"
+		"element vertex %zu\n"
+		"property float x\n"
+		"property float y\n"
+		"property float z\n"
+		"property uchar red\n"
+		"property uchar green\n"
+		"property uchar blue\n"
+		"element face %zu\n"
+		"property list uchar uint vertex_indices\n"
+		"end_header\n",
+		mesh->vtx_num, mesh->face_num);
+
+	return (fwrite(hdr, 1, (size_t)len, fp) == (size_t)len) &&
+		   (fwrite(mesh->vtx, sizeof(apl_mesh_vtx), mesh->vtx_num, fp) == mesh->vtx_num) &&
+		   (fwrite(mesh->face, sizeof(apl_mesh_face), mesh->face_num, fp) == mesh->face_num);
+}
+
+//******************************************************************************
+//! \brief        Write vertices and triangles as OBJ, vertex color extension, indices from 1.
+//******************************************************************************
+static bool apl_mesh_write_obj(const apl_mesh *mesh, FILE *fp)
+{
+	size_t i;
+
+	if (fprintf(fp, "# camera coordinate [m], x right, y down, z forward, color is ir\n# vertices %zu, triangles %zu\n",
+				mesh->vtx_num, mesh->face_num) < 0) {
+		return false;
+	}
+	for (i = 0; i < mesh->vtx_num; i++) {
+		const apl_mesh_vtx *v = &mesh->vtx[i];
+		if (fprintf(fp, "v %.4f %.4f %.4f %.3f %.3f %.3f\n", v->x, v->y, v->z,
+					v->r / 255.0F, v->g / 255.0F, v->b / 255.0F) < 0) {
+			return false;
+		}
+	}
+	for (i = 0; i < mesh->face_num; i++) {
+		const apl_mesh_face *f = &mesh->face[i];
+		if (fprintf(fp, "f %u %u %u\n", f->v[0] + 1, f->v[1] + 1, f->v[2] + 1) < 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//******************************************************************************
+//! \brief        Write mesh to file.
+//******************************************************************************
+size_t apl_mesh_write(const apl_mesh *mesh, const char *fn, APL_MESH_FMT fmt, char *io, size_t io_size)
+{
+	FILE *fp;
+	long bytes;
+	bool ok;
+
+	fp = fopen(fn, "wb");
+	if (fp == NULL) {
+		printf("fopen (%s) failed\n", fn);
+		return 0;
+	}
+	if (io != NULL) {
+		(void)setvbuf(fp, io, _IOFBF, io_size);
+	}
+
+	ok = (fmt == APL_MESH_FMT_OBJ) ? apl_mesh_write_obj(mesh, fp) : apl_mesh_write_ply(mesh, fp);
+	bytes = ftell(fp);
+	if (!ok) {
+		printf("fwrite (%s) failed\n", fn);
+	}
+	if (fclose(fp) != 0) {
+		printf("fclose (%s) failed\n", fn);
+		ok = false;
+	}
+
+	return (ok && (bytes > 0)) ? (size_t)bytes : 0;
+}
+
+//******************************************************************************
+//! \brief        Format of name.
+//******************************************************************************
+int apl_mesh_fmt_of(const char *name, APL_MESH_FMT *fmt)
+{
+	int i;
+
+	for (i = 0; i < APL_MESH_FMT_NUM; i++) {
+		if (strcmp(name, FMT_NAME[i]) == 0) {
+			*fmt = (APL_MESH_FMT)i;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+//******************************************************************************
+//! \brief        File extension of format.
+//******************************************************************************
+const char *apl_mesh_ext(APL_MESH_FMT fmt)
+{
+	return FMT_EXT[fmt];
+}
+
+//******************************************************************************
+//! \brief        Writer thread, builds and writes queued frames.
+//******************************************************************************
+static void *apl_mesh_thread(void *arg)
+{
+	apl_mesh_out *out = static_cast<apl_mesh_out *>(arg);
+	apl_mesh_in *in;
+	uint64_t tick;
+	uint64_t built;
+	size_t bytes;
+	char fn[512];
+
+	while ((in = static_cast<apl_mesh_in *>(apl_queue_pop(&out->que))) != NULL) {
+		//! \remark 1. Build Into Buffers Of Writer, Reused For Every Frame.
+		tick = apl_mtr_tick();
+		(void)apl_mesh_build(&out->mesh, in->depth, in->ir_on ? in->ir : NULL, out->ir_w, out->ir_h);
+		built = apl_mtr_tick();
+
+		//! \remark 2. Queue Buffer Is Free Once Mesh Is Built.
+		snprintf(fn, sizeof(fn), "%s_mesh%06llu%s", out->prefix.c_str(), (unsigned long long)in->seq, FMT_EXT[out->fmt]);
+		apl_queue_free(&out->que, in);
+
+		//! \remark 3. Stream To Disk.
+		bytes = apl_mesh_write(&out->mesh, fn, out->fmt, out->io, APL_MESH_IO_SIZE);
+		apl_mtr_observe(APL_MTR_STAGE_MESH, tick);
+
+		std::lock_guard<std::mutex> lock(out->que.mtx);
+		if (bytes > 0) {
+			out->stat.written++;
+			out->stat.triangles += out->mesh.face_num;
+			out->stat.bytes += bytes;
+		}
+		else {
+			out->stat.failed++;
+		}
+		out->stat.build_ns += built - tick;
+		out->stat.busy_ns += apl_mtr_tick() - tick;
+	}
+
+	return NULL;
+}
+
+//******************************************************************************
+//! \brief        Allocate mesh and queue and start writer thread.
+//******************************************************************************
+int apl_mesh_out_init(apl_mesh_out *out, const apl_lens *lens, float jump, uint16_t ir_max, uint16_t ir_w, uint16_t ir_h,
+					  const char *prefix, APL_MESH_FMT fmt, uint32_t decimate, uint32_t queue_max)
+{
+	const size_t dp_siz = (size_t)lens->w * lens->h * sizeof(uint16_t);
+	const size_t ir_siz = (size_t)ir_w * ir_h * sizeof(uint16_t);
+	uint32_t i;
+
+	apl_mesh_init(&out->mesh, lens, jump, ir_max);
+	out->fmt = fmt;
+	out->prefix = prefix;
+	out->ir_w = ir_w;
+	out->ir_h = ir_h;
+	out->stat = apl_mesh_stat();
+	out->io = static_cast<char *>(apl_arena_alloc(APL_MESH_IO_SIZE));
+
+	out->slot_num = std::max(queue_max, 1U);
+	out->slot = new apl_mesh_in[out->slot_num];
+	apl_queue_init(&out->que, decimate);
+	for (i = 0; i < out->slot_num; i++) {
+		out->slot[i].depth = static_cast<uint16_t *>(apl_arena_alloc(dp_siz));
+		out->slot[i].ir = static_cast<uint16_t *>(apl_arena_alloc(std::max<size_t>(ir_siz, 1)));
+		out->slot[i].ir_on = false;
+		out->slot[i].seq = 0;
+		apl_queue_free(&out->que, &out->slot[i]);
+	}
+
+	if (apl_thr_create(&out->thr, APL_THR_ROLE_RECORDER, "tof_mesh", apl_mesh_thread, out) != 0) {
+		apl_mesh_out_term(out);
+		return -1;
+	}
+	out->started = true;
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Queue frame for writer.
+//******************************************************************************
+void apl_mesh_out_push(apl_mesh_out *out, const uint16_t *depth, const uint16_t *ir, uint64_t seq)
+{
+	apl_mesh_in *in;
+
+	if (!out->started) {
+		return;
+	}
+
+	//! \remark 1. Decimation, Dropped When Queue Is Full.
+	in = static_cast<apl_mesh_in *>(apl_queue_get(&out->que));
+	if (in == NULL) {
+		return;
+	}
+
+	//! \remark 2. Copy Outside Of Lock, Frame Buffer Goes Back To Caller.
+	memcpy(in->depth, depth, out->mesh.w * out->mesh.h * sizeof(uint16_t));
+	in->ir_on = (ir != NULL);
+	if (ir != NULL) {
+		memcpy(in->ir, ir, (size_t)out->ir_w * out->ir_h * sizeof(uint16_t));
+	}
+	in->seq = seq;
+
+	//! \remark 3. Hand Over To Writer.
+	apl_queue_put(&out->que, in);
+}
+
+//******************************************************************************
+//! \brief        Stop writer thread and free queue.
+//******************************************************************************
+void apl_mesh_out_term(apl_mesh_out *out)
+{
+	apl_mesh_stat stat;
+	uint32_t i;
+
+	if (out->started) {
+		apl_queue_stop(&out->que);
+		pthread_join(out->thr, NULL);
+		out->started = false;
+
+		apl_mesh_out_get(out, &stat);
+		printf("mesh : written=%llu decimated=%llu dropped=%llu failed=%llu triangles=%llu\n",
+			(unsigned long long)stat.written, (unsigned long long)stat.decimated,
+			(unsigned long long)stat.dropped, (unsigned long long)stat.failed, (unsigned long long)stat.triangles);
+		if (stat.busy_ns > 0) {
+			printf("mesh : %.2f M triangles/s built, %.2f M triangles/s written, %.1f MB/s\n",
+				(double)stat.triangles / ((double)std::max<uint64_t>(stat.build_ns, 1) * 1e-9) / 1e6,
+				(double)stat.triangles / ((double)stat.busy_ns * 1e-9) / 1e6,
+				(double)stat.bytes / ((double)stat.busy_ns * 1e-9) / 1e6);
+		}
+	}
+
+	for (i = 0; i < out->slot_num; i++) {
+		apl_arena_free(out->slot[i].depth);
+		apl_arena_free(out->slot[i].ir);
+	}
+	delete[] out->slot;
+	out->slot = NULL;
+	out->slot_num = 0;
+	out->que.free.clear();		// Counters Are Kept For apl_mesh_out_get()
+	out->que.rdy.clear();
+	apl_arena_free(out->io);
+	out->io = NULL;
+	apl_mesh_term(&out->mesh);
+}
+
+//******************************************************************************
+//! \brief        Get counters.
+//******************************************************************************
+void apl_mesh_out_get(apl_mesh_out *out, apl_mesh_stat *stat)
+{
+	std::lock_guard<std::mutex> lock(out->que.mtx);
+
+	*stat = out->stat;
+	stat->offered = out->que.offered;
+	stat->decimated = out->que.decimated;
+	stat->dropped = out->que.dropped;
+}
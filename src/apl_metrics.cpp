@@ -0,0 +1,424 @@
+//******************************************************************************
+//! \file         apl_metrics.cpp
+//! \brief        stage latency histograms and local metrics endpoint (Prometheus text format).
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <string>
+
+#include "apl_thread.h"
+#include "apl_telemetry.h"
+#include "apl_dev.h"
+#include "apl_stamp.h"
+#include "apl_metrics.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_MTR_DEF_ADDR		"127.0.0.1"	// TCP endpoint is local only by default
+#define APL_MTR_POLL_MS			(200)		// stop request is checked at this interval
+#define APL_MTR_REQ_MAX			(2048)		// longest request read
+#define APL_MTR_RECV_TIMEOUT	(1)			// timeout of request [s]
+
+// Upper Bound Of Latency Buckets [s]
+static const double BUCKET_LE[APL_MTR_BUCKET_NUM - 1] = {
+	0.0005, 0.001, 0.002, 0.004, 0.008, 0.016, 0.033, 0.066, 0.133, 0.266, 0.5
+};
+
+static const char *STAGE_NAME[APL_MTR_STAGE_NUM] = { "capture", "cnv_dp", "flying", "upsample", "stats", "fill", "rect", "normal", "roi", "scan", "bg", "plane", "show", "save", "encode", "mesh", "capture_to_view" };
+
+// Latency Histogram, Buckets Are Not Cumulative Here
+typedef struct {
+	std::atomic<uint64_t>	bucket[APL_MTR_BUCKET_NUM];
+	std::atomic<uint64_t>	sum_ns;
+} apl_mtr_hist;
+
+static apl_mtr_hist			sHist[APL_MTR_STAGE_NUM];
+static std::atomic<bool>	sStop(false);
+static bool					sStarted = false;
+static pthread_t			sThr;
+static int					sFd = -1;
+static std::string			sUnixPath;		// unlinked at stop
+
+//******************************************************************************
+//! \brief        Monotonic time for apl_mtr_observe().
+//******************************************************************************
+uint64_t apl_mtr_tick(void)
+{
+	// Same Clock As Frame Stamps, So That apl_mtr_observe() Takes apl_frm::mono_ns
+	return apl_stamp_mono();
+}
+
+//******************************************************************************
+//! \brief        Add latency of stage to its histogram.
+//******************************************************************************
+void apl_mtr_observe(APL_MTR_STAGE stage, uint64_t start)
+{
+	apl_mtr_hist *hist = &sHist[stage];
+	uint64_t ns = apl_mtr_tick() - start;
+	double sec = (double)ns * 1e-9;
+	size_t b;
+
+	for (b = 0; b < (APL_MTR_BUCKET_NUM - 1); b++) {
+		if (sec <= BUCKET_LE[b]) {
+			break;
+		}
+	}
+
+	hist->bucket[b].fetch_add(1, std::memory_order_relaxed);
+	hist->sum_ns.fetch_add(ns, std::memory_order_relaxed);
+}
+
+//******************************************************************************
+//! \brief        Append one sample line.
+//******************************************************************************
+static void apl_mtr_line(std::string *out, const char *name, const char *label, double val)
+{
+	char line[256];
+
+	snprintf(line, sizeof(line), "%s%s %.9g\n", name, label, val);
+	out->append(line);
+}
+
+//******************************************************************************
+//! \brief        Append HELP and TYPE lines.
+//******************************************************************************
+static void apl_mtr_head(std::string *out, const char *name, const char *type, const char *help)
+{
+	char line[256];
+
+	snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+	out->append(line);
+}
+
+//******************************************************************************
+//! \brief        Append HELP and TYPE lines and one sample per device, labeled by device index.
+//******************************************************************************
+static void apl_mtr_dev_series(std::string *out, const char *name, const char *type, const char *help,
+							   size_t dev_num, const std::function<double(size_t)> &value)
+{
+	char label[32];
+	size_t d;
+
+	apl_mtr_head(out, name, type, help);
+	for (d = 0; d < dev_num; d++) {
+		snprintf(label, sizeof(label), "{device=\"%zu\"}", d);
+		apl_mtr_line(out, name, label, value(d));
+	}
+}
+
+//******************************************************************************
+//! \brief        Serialize telemetry and histograms in Prometheus text format.
+//******************************************************************************
+void apl_mtr_format(std::string *out)
+{
+	apl_tlm_snapshot snap[APL_DEV_MAX];
+	apl_stamp_snapshot stamp[APL_DEV_MAX];
+	const size_t dev_num = std::min(apl_tlm_dev_num(), (size_t)APL_DEV_MAX);
+	char label[128];
+	size_t d;
+	size_t i;
+	size_t b;
+
+	out->clear();
+	for (d = 0; d < dev_num; d++) {
+		apl_tlm_get((uint8_t)d, &snap[d]);
+		apl_stamp_get((uint8_t)d, &stamp[d]);
+	}
+
+	apl_mtr_dev_series(out, "tof_capture_calls_total", "counter", "TL_capture calls.", dev_num, [&](size_t n) { return (double)(snap[n].capture); });
+	apl_mtr_dev_series(out, "tof_frames_total", "counter", "Received images.", dev_num, [&](size_t n) { return (double)(snap[n].frames); });
+	apl_mtr_dev_series(out, "tof_frames_lost_total", "counter", "Images missing in frm_index sequence.", dev_num, [&](size_t n) { return (double)(snap[n].lost); });
+	apl_mtr_dev_series(out, "tof_frames_duplicate_total", "counter", "Images repeating previous frm_index.", dev_num, [&](size_t n) { return (double)(snap[n].duplicate); });
+	apl_mtr_dev_series(out, "tof_frame_errors_total", "counter", "Images with frame_error.", dev_num, [&](size_t n) { return (double)(snap[n].frame_error); });
+	apl_mtr_dev_series(out, "tof_pipeline_drops_total", "counter", "Images dropped by viewer pipeline.", dev_num, [&](size_t n) { return (double)(snap[n].pipeline_drop); });
+
+	apl_mtr_head(out, "tof_notify_total", "counter", "TL_capture notifications by flag.");
+	for (d = 0; d < dev_num; d++) {
+		for (i = 0; i < APL_TLM_NOTIFY_NUM; i++) {
+			snprintf(label, sizeof(label), "{device=\"%zu\",flag=\"%s\"}", d, apl_tlm_notify_name(i));
+			apl_mtr_line(out, "tof_notify_total", label, (double)snap[d].notify[i]);
+		}
+	}
+	apl_mtr_head(out, "tof_capture_result_total", "counter", "TL_capture results.");
+	for (d = 0; d < dev_num; d++) {
+		for (i = 0; i < APL_TLM_RESULT_NUM; i++) {
+			snprintf(label, sizeof(label), "{device=\"%zu\",result=\"%s\"}", d, apl_tlm_result_name(i));
+			apl_mtr_line(out, "tof_capture_result_total", label, (double)snap[d].result[i]);
+		}
+	}
+
+	apl_mtr_dev_series(out, "tof_fps", "gauge", "Received images per second.", dev_num, [&](size_t n) { return (double)(snap[n].fps); });
+	apl_mtr_dev_series(out, "tof_lost_rate", "gauge", "Lost images per second.", dev_num, [&](size_t n) { return (double)(snap[n].lost_rate); });
+	apl_mtr_dev_series(out, "tof_drop_rate", "gauge", "Pipeline drops per second.", dev_num, [&](size_t n) { return (double)(snap[n].drop_rate); });
+	apl_mtr_dev_series(out, "tof_error_rate", "gauge", "Failed TL_capture per second.", dev_num, [&](size_t n) { return (double)(snap[n].error_rate); });
+	apl_mtr_dev_series(out, "tof_temperature_celsius", "gauge", "Latest sensor temperature.", dev_num, [&](size_t n) { return (double)(snap[n].temp); });
+	apl_mtr_dev_series(out, "tof_temperature_slope_celsius_per_minute", "gauge", "Sensor temperature trend.", dev_num, [&](size_t n) { return (double)(snap[n].temp_slope); });
+
+	apl_mtr_dev_series(out, "tof_frame_interval_seconds", "gauge", "Mean interval of capture timestamps.", dev_num, [&](size_t n) { return (double)(stamp[n].mean_ms * 1e-3); });
+	apl_mtr_dev_series(out, "tof_frame_jitter_seconds", "gauge", "Standard deviation of interval of capture timestamps.", dev_num, [&](size_t n) { return (double)(stamp[n].jitter_ms * 1e-3); });
+	apl_mtr_dev_series(out, "tof_frame_interval_max_seconds", "gauge", "Longest interval of capture timestamps.", dev_num, [&](size_t n) { return (double)(stamp[n].max_ms * 1e-3); });
+	apl_mtr_dev_series(out, "tof_frames_late_total", "counter", "Intervals longer than 1.5 periods.", dev_num, [&](size_t n) { return (double)(stamp[n].late); });
+
+	apl_mtr_head(out, "tof_frame_deviation_seconds", "histogram", "Deviation of interval from period of mode.");
+	for (d = 0; d < dev_num; d++) {
+		uint64_t cum = 0;
+
+		for (b = 0; b < APL_STAMP_BUCKET_NUM; b++) {
+			cum += stamp[d].dev[b];
+			if (b < (APL_STAMP_BUCKET_NUM - 1)) {
+				snprintf(label, sizeof(label), "{device=\"%zu\",le=\"%g\"}", d, apl_stamp_bucket_le(b) * 1e-3);
+			}
+			else {
+				snprintf(label, sizeof(label), "{device=\"%zu\",le=\"+Inf\"}", d);
+			}
+			apl_mtr_line(out, "tof_frame_deviation_seconds_bucket", label, (double)cum);
+		}
+		snprintf(label, sizeof(label), "{device=\"%zu\"}", d);
+		apl_mtr_line(out, "tof_frame_deviation_seconds_sum", label, stamp[d].dev_sum_ms * 1e-3);
+		apl_mtr_line(out, "tof_frame_deviation_seconds_count", label, (double)cum);
+	}
+
+	// Stages Run On Shared Worker Pool, Histograms Cover All Devices
+	apl_mtr_head(out, "tof_stage_seconds", "histogram", "Latency of pipeline stages.");
+	for (i = 0; i < APL_MTR_STAGE_NUM; i++) {
+		const apl_mtr_hist *hist = &sHist[i];
+		uint64_t cum = 0;
+
+		for (b = 0; b < APL_MTR_BUCKET_NUM; b++) {
+			cum += hist->bucket[b].load(std::memory_order_relaxed);
+			if (b < (APL_MTR_BUCKET_NUM - 1)) {
+				snprintf(label, sizeof(label), "{stage=\"%s\",le=\"%g\"}", STAGE_NAME[i], BUCKET_LE[b]);
+			}
+			else {
+				snprintf(label, sizeof(label), "{stage=\"%s\",le=\"+Inf\"}", STAGE_NAME[i]);
+			}
+			apl_mtr_line(out, "tof_stage_seconds_bucket", label, (double)cum);
+		}
+
+		// Count Is The +Inf Bucket, Consistent Even If Observed Meanwhile
+		snprintf(label, sizeof(label), "{stage=\"%s\"}", STAGE_NAME[i]);
+		apl_mtr_line(out, "tof_stage_seconds_sum", label, (double)hist->sum_ns.load(std::memory_order_relaxed) * 1e-9);
+		apl_mtr_line(out, "tof_stage_seconds_count", label, (double)cum);
+	}
+}
+
+//******************************************************************************
+//! \brief        Answer one HTTP request.
+//******************************************************************************
+static void apl_mtr_serve(int fd)
+{
+	struct timeval tv = { APL_MTR_RECV_TIMEOUT, 0 };
+	char req[APL_MTR_REQ_MAX + 1];
+	char head[256];
+	std::string body;
+	size_t len = 0;
+	ssize_t n;
+	const char *status = "200 OK";
+
+	(void)setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	// Read Request Header, Body Is Not Expected
+	while (len < APL_MTR_REQ_MAX) {
+		n = recv(fd, req + len, APL_MTR_REQ_MAX - len, 0);
+		if (n <= 0) {
+			break;
+		}
+		len += (size_t)n;
+		req[len] = '\0';
+		if (strstr(req, "\r\n\r\n") != NULL) {
+			break;
+		}
+	}
+	req[len] = '\0';
+
+	if ((strncmp(req, "GET /metrics ", 13) == 0) || (strncmp(req, "GET / ", 6) == 0)) {
+		apl_mtr_format(&body);
+	}
+	else {
+		status = "404 Not Found";
+		body = "not found, try /metrics\n";
+	}
+
+	snprintf(head, sizeof(head),
+		"HTTP/1.0 %s\r\n"
+		"Content-Type: text/plain; version=0.0.4\r\n"
+		"Content-Length: %zu\r\n"
+		"Connection: close\r\n\r\n", status, body.size());
+	body.insert(0, head);
+
+	for (len = 0; len < body.size(); len += (size_t)n) {
+		n = send(fd, body.data() + len, body.size() - len, MSG_NOSIGNAL);
+		if (n <= 0) {
+			break;
+		}
+	}
+}
+
+//******************************************************************************
+//! \brief        Endpoint thread.
+//******************************************************************************
+static void *apl_mtr_thread(void *arg)
+{
+	struct pollfd pfd;
+	int fd;
+
+	(void)arg;
+
+	pfd.fd = sFd;
+	pfd.events = POLLIN;
+
+	while (!sStop.load()) {
+		if (poll(&pfd, 1, APL_MTR_POLL_MS) <= 0) {
+			continue;
+		}
+		fd = accept(sFd, NULL, NULL);
+		if (fd < 0) {
+			continue;
+		}
+		apl_mtr_serve(fd);
+		close(fd);
+	}
+
+	return NULL;
+}
+
+//******************************************************************************
+//! \brief        Open listening socket.
+//******************************************************************************
+static int apl_mtr_listen(const char *listen_addr)
+{
+	int fd;
+	int on = 1;
+
+	if (strncmp(listen_addr, "unix:", 5) == 0) {
+		struct sockaddr_un sun;
+
+		memset(&sun, 0, sizeof(sun));
+		sun.sun_family = AF_UNIX;
+		if (strlen(listen_addr + 5) >= sizeof(sun.sun_path)) {
+			printf("metrics : too long path %s\n", listen_addr + 5);
+			return -1;
+		}
+		strcpy(sun.sun_path, listen_addr + 5);
+
+		fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd < 0) {
+			return -1;
+		}
+		(void)unlink(sun.sun_path);
+		if (bind(fd, (struct sockaddr *)&sun, sizeof(sun)) < 0) {
+			printf("metrics : bind %s failed (%s)\n", sun.sun_path, strerror(errno));
+			close(fd);
+			return -1;
+		}
+		sUnixPath = sun.sun_path;
+	}
+	else {
+		struct sockaddr_in sin;
+		char addr[64];
+		const char *colon = strrchr(listen_addr, ':');
+		int port;
+
+		strcpy(addr, APL_MTR_DEF_ADDR);
+		if (colon != NULL) {
+			snprintf(addr, sizeof(addr), "%.*s", (int)(colon - listen_addr), listen_addr);
+			port = atoi(colon + 1);
+		}
+		else {
+			port = atoi(listen_addr);
+		}
+
+		memset(&sin, 0, sizeof(sin));
+		sin.sin_family = AF_INET;
+		sin.sin_port = htons((uint16_t)port);
+		if ((port <= 0) || (port > 0xFFFF) || (inet_pton(AF_INET, addr, &sin.sin_addr) != 1)) {
+			printf("metrics : invalid address %s\n", listen_addr);
+			return -1;
+		}
+
+		fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd < 0) {
+			return -1;
+		}
+		(void)setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+		if (bind(fd, (struct sockaddr *)&sin, sizeof(sin)) < 0) {
+			printf("metrics : bind %s failed (%s)\n", listen_addr, strerror(errno));
+			close(fd);
+			return -1;
+		}
+	}
+
+	if (listen(fd, 4) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+//******************************************************************************
+//! \brief        Start endpoint thread.
+//******************************************************************************
+int apl_mtr_start(const char *listen_addr)
+{
+	if (sStarted) {
+		return 0;
+	}
+
+	sFd = apl_mtr_listen(listen_addr);
+	if (sFd < 0) {
+		return -1;
+	}
+
+	sStop = false;
+	if (apl_thr_create(&sThr, APL_THR_ROLE_SERVICE, "tof_metrics", apl_mtr_thread, NULL) != 0) {
+		close(sFd);
+		sFd = -1;
+		return -1;
+	}
+	sStarted = true;
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Stop endpoint thread.
+//******************************************************************************
+void apl_mtr_stop(void)
+{
+	if (!sStarted) {
+		return;
+	}
+
+	sStop = true;
+	pthread_join(sThr, NULL);
+	close(sFd);
+	sFd = -1;
+	if (!sUnixPath.empty()) {
+		(void)unlink(sUnixPath.c_str());
+		sUnixPath.clear();
+	}
+	sStarted = false;
+}
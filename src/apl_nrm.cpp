@@ -0,0 +1,160 @@
+//******************************************************************************
+//! \file         apl_nrm.cpp
+//! \brief        surface normals of organized depth by lens ray table.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+
+#include "apl_arena.h"
+#include "apl_pool.h"
+#include "apl_nrm.h"
+
+//******************************************************************************
+//! \brief        Initialize stage.
+//******************************************************************************
+void apl_nrm_init(apl_nrm *nrm, const apl_lens *lens, uint32_t step, float jump)
+{
+	const size_t tiles = ((size_t)lens->h + APL_NRM_TILE - 1) / APL_NRM_TILE;
+
+	nrm->w = lens->w;
+	nrm->h = lens->h;
+	nrm->step = std::min<uint32_t>(std::max<uint32_t>(step, 1), APL_NRM_STEP_MAX);
+	nrm->jump = std::max(jump, 0.0F);
+	nrm->rx = lens->rx;
+	nrm->ry = lens->ry;
+	nrm->valid = static_cast<uint32_t *>(apl_arena_alloc(tiles * sizeof(uint32_t)));
+}
+
+//******************************************************************************
+//! \brief        Normals of one row, branch free so that it is vectorized.
+//! \param[in]    nrm           stage.
+//! \param[in]    depth         depth of image.
+//! \param[in]    y             row (step <= y < h - step).
+//! \param[out]   dst           packed normals of row.
+//! \return       valid normals.
+//******************************************************************************
+static uint32_t apl_nrm_row(const apl_nrm *nrm, const uint16_t *depth, size_t y, uint32_t *dst)
+{
+	const size_t w = nrm->w;
+	const size_t s = nrm->step;
+	const float jump = nrm->jump;
+	const float *rx = nrm->rx;
+	const uint16_t *row = depth + (y * w);
+	const uint16_t *up = depth + ((y - s) * w);
+	const uint16_t *dn = depth + ((y + s) * w);
+	const float ry = nrm->ry[y];
+	const float ry_up = nrm->ry[y - s];
+	const float ry_dn = nrm->ry[y + s];
+	uint32_t valid = 0;
+	size_t x;
+
+	for (x = s; x < (w - s); x++) {
+		const float z = (float)row[x];
+		const float zl = (float)row[x - s];
+		const float zr = (float)row[x + s];
+		const float zu = (float)up[x];
+		const float zd = (float)dn[x];
+		const float lim = jump * z;
+		const bool ok = (z > 0) & (zl > 0) & (zr > 0) & (zu > 0) & (zd > 0) &
+						(fabsf(zl - z) <= lim) & (fabsf(zr - z) <= lim) & (fabsf(zu - z) <= lim) & (fabsf(zd - z) <= lim);
+
+		// Tangents Along Row And Column
+		const float dux = (zr * rx[x + s]) - (zl * rx[x - s]);
+		const float duy = (zr - zl) * ry;
+		const float duz = zr - zl;
+		const float dvx = (zd - zu) * rx[x];
+		const float dvy = (zd * ry_dn) - (zu * ry_up);
+		const float dvz = zd - zu;
+
+		// dv x du Faces Camera (z < 0 For Surface Facing It)
+		const float nx = (dvy * duz) - (dvz * duy);
+		const float ny = (dvz * dux) - (dvx * duz);
+		const float nz = (dvx * duy) - (dvy * dux);
+		const float inv = 127.0F / sqrtf(std::max((nx * nx) + (ny * ny) + (nz * nz), 1e-20F));
+
+		// Offset By 128 So That Truncation Rounds, Then Back To int8 By Flipping Bit 7
+		const uint32_t bx = (uint32_t)(int32_t)((nx * inv) + 128.5F) ^ 0x80U;
+		const uint32_t by = (uint32_t)(int32_t)((ny * inv) + 128.5F) ^ 0x80U;
+		const uint32_t bz = (uint32_t)(int32_t)((nz * inv) + 128.5F) ^ 0x80U;
+		const uint32_t packed = (bx & 0xFFU) | ((by & 0xFFU) << 8) | ((bz & 0xFFU) << 16) | 0xFF000000U;
+
+		dst[x] = ok ? packed : 0U;
+		valid += ok ? 1U : 0U;
+	}
+
+	return valid;
+}
+
+//******************************************************************************
+//! \brief        Normals of rows of tile, rows and columns within step of border are invalid.
+//******************************************************************************
+static uint32_t apl_nrm_rows(const apl_nrm *nrm, const uint16_t *depth, uint32_t *map, size_t row_begin, size_t row_end)
+{
+	const size_t w = nrm->w;
+	const size_t s = nrm->step;
+	uint32_t valid = 0;
+	size_t y;
+
+	for (y = row_begin; y < row_end; y++) {
+		uint32_t *dst = map + (y * w);
+
+		if ((y < s) || ((y + s) >= nrm->h) || (w <= (2 * s))) {
+			memset(dst, 0, w * sizeof(uint32_t));
+			continue;
+		}
+		memset(dst, 0, s * sizeof(uint32_t));
+		memset(dst + (w - s), 0, s * sizeof(uint32_t));
+		valid += apl_nrm_row(nrm, depth, y, dst);
+	}
+
+	return valid;
+}
+
+//******************************************************************************
+//! \brief        Normals of depth.
+//******************************************************************************
+size_t apl_nrm_run(apl_nrm *nrm, const uint16_t *depth, uint32_t *map)
+{
+	const size_t tiles = (nrm->h + APL_NRM_TILE - 1) / APL_NRM_TILE;
+	size_t valid = 0;
+	size_t t;
+
+	//! \remark 1. Tiles In Parallel, Depth Is Read Only So Tiles Need No Halo.
+	memset(nrm->valid, 0, tiles * sizeof(uint32_t));
+	apl_pool_for(nrm->h, APL_NRM_TILE, [&](size_t row_begin, size_t row_end) {
+		nrm->valid[row_begin / APL_NRM_TILE] = apl_nrm_rows(nrm, depth, map, row_begin, row_end);
+	});
+
+	//! \remark 2. Sum Of Tiles.
+	for (t = 0; t < tiles; t++) {
+		valid += nrm->valid[t];
+	}
+
+	return valid;
+}
+
+//******************************************************************************
+//! \brief        Color of packed normals.
+//******************************************************************************
+void apl_nrm_color(const uint32_t *map, size_t num, uint8_t *bgr)
+{
+	size_t i;
+
+	for (i = 0; i < num; i++) {
+		const uint32_t p = map[i];
+		const uint32_t on = p >> 24;	// 0xFF Or 0
+
+		bgr[(3 * i) + 0] = (uint8_t)((128 - (int32_t)(int8_t)((p >> 16) & 0xFFU)) & (int32_t)on);
+		bgr[(3 * i) + 1] = (uint8_t)((((p >> 8) & 0xFFU) ^ 0x80U) & on);
+		bgr[(3 * i) + 2] = (uint8_t)(((p & 0xFFU) ^ 0x80U) & on);
+	}
+}
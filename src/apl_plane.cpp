@@ -0,0 +1,418 @@
+//******************************************************************************
+//! \file         apl_plane.cpp
+//! \brief        floor plane estimation, RANSAC on subsampled point cloud of depth.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#include "apl_arena.h"
+#include "apl_pool.h"
+#include "apl_lens.h"
+#include "apl_plane.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_PLANE_RAD2DEG(a)	((a) * 180.0 / 3.14159265358979)
+#define APL_PLANE_JACOBI_SWEEP	(16)	// sweeps of eigen decomposition
+
+//******************************************************************************
+//! \brief        Initialize stage.
+//******************************************************************************
+void apl_plane_init(apl_plane *pl, const apl_lens *lens, uint16_t stride, uint32_t iter_max, float thresh,
+					const float up[3], float max_tilt)
+{
+	size_t cap;
+	float len = sqrtf((up[0] * up[0]) + (up[1] * up[1]) + (up[2] * up[2]));
+
+	pl->lens = lens;
+	pl->stride = std::max<uint16_t>(stride, 1);
+	pl->iter_max = std::max<uint32_t>(iter_max, 1);
+	pl->thresh = thresh;
+	pl->up[0] = (len > 0) ? (up[0] / len) : 0.0F;
+	pl->up[1] = (len > 0) ? (up[1] / len) : -1.0F;		// Camera y Is Down
+	pl->up[2] = (len > 0) ? (up[2] / len) : 0.0F;
+	pl->cos_tilt = cosf(std::min(std::max(max_tilt, 0.0F), 90.0F) * 3.14159265F / 180.0F);
+
+	cap = ((lens->w + pl->stride - 1) / pl->stride) * ((lens->h + pl->stride - 1) / pl->stride);
+	pl->pt_num = 0;
+	pl->px = static_cast<float *>(apl_arena_alloc(cap * sizeof(float)));
+	pl->py = static_cast<float *>(apl_arena_alloc(cap * sizeof(float)));
+	pl->pz = static_cast<float *>(apl_arena_alloc(cap * sizeof(float)));
+	pl->rng = 0x9E3779B97F4A7C15ULL;
+
+	memset(&pl->prev, 0, sizeof(pl->prev));
+	memset(&pl->res, 0, sizeof(pl->res));
+}
+
+//******************************************************************************
+//! \brief        Random number, xorshift64*.
+//******************************************************************************
+static uint32_t apl_plane_rand(apl_plane *pl, uint32_t range)
+{
+	pl->rng ^= pl->rng >> 12;
+	pl->rng ^= pl->rng << 25;
+	pl->rng ^= pl->rng >> 27;
+
+	return (uint32_t)(((pl->rng * 0x2545F4914F6CDD1DULL) >> 32) % range);
+}
+
+//******************************************************************************
+//! \brief        Orient plane towards camera (d > 0) and check angle to up.
+//! \return       true if plane is accepted.
+//******************************************************************************
+static bool apl_plane_orient(const apl_plane *pl, float *h)
+{
+	if (h[3] < 0) {
+		h[0] = -h[0];
+		h[1] = -h[1];
+		h[2] = -h[2];
+		h[3] = -h[3];
+	}
+
+	return ((h[0] * pl->up[0]) + (h[1] * pl->up[1]) + (h[2] * pl->up[2])) >= pl->cos_tilt;
+}
+
+//******************************************************************************
+//! \brief        Plane through 3 random points.
+//! \return       true if plane is accepted (not degenerate, within tilt).
+//******************************************************************************
+static bool apl_plane_sample(apl_plane *pl, float *h)
+{
+	uint32_t n = (uint32_t)pl->pt_num;
+	uint32_t i0 = apl_plane_rand(pl, n);
+	uint32_t i1 = apl_plane_rand(pl, n);
+	uint32_t i2 = apl_plane_rand(pl, n);
+	float ax = pl->px[i1] - pl->px[i0];
+	float ay = pl->py[i1] - pl->py[i0];
+	float az = pl->pz[i1] - pl->pz[i0];
+	float bx = pl->px[i2] - pl->px[i0];
+	float by = pl->py[i2] - pl->py[i0];
+	float bz = pl->pz[i2] - pl->pz[i0];
+	float nx = (ay * bz) - (az * by);
+	float ny = (az * bx) - (ax * bz);
+	float nz = (ax * by) - (ay * bx);
+	float len = sqrtf((nx * nx) + (ny * ny) + (nz * nz));
+
+	// Same Or Collinear Points
+	if (len < 1.0F) {
+		return false;
+	}
+
+	h[0] = nx / len;
+	h[1] = ny / len;
+	h[2] = nz / len;
+	h[3] = -((h[0] * pl->px[i0]) + (h[1] * pl->py[i0]) + (h[2] * pl->pz[i0]));
+
+	return apl_plane_orient(pl, h);
+}
+
+//******************************************************************************
+//! \brief        Count points within thresh of plane, vectorized.
+//******************************************************************************
+static uint32_t apl_plane_score(const apl_plane *pl, const float *h)
+{
+	const float *px = pl->px;
+	const float *py = pl->py;
+	const float *pz = pl->pz;
+	const float nx = h[0];
+	const float ny = h[1];
+	const float nz = h[2];
+	const float d = h[3];
+	const float t = pl->thresh;
+	uint32_t cnt = 0;
+	size_t i;
+
+	for (i = 0; i < pl->pt_num; i++) {
+		float dist = (nx * px[i]) + (ny * py[i]) + (nz * pz[i]) + d;
+		cnt += (fabsf(dist) <= t) ? 1U : 0U;
+	}
+
+	return cnt;
+}
+
+//******************************************************************************
+//! \brief        Eigenvector of smallest eigenvalue of symmetric 3x3, cyclic Jacobi.
+//! \return       smallest eigenvalue.
+//******************************************************************************
+static double apl_plane_eig_min(double a[3][3], double vec[3])
+{
+	double v[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+	int sweep;
+	int p;
+	int q;
+	int k;
+	int m;
+
+	for (sweep = 0; sweep < APL_PLANE_JACOBI_SWEEP; sweep++) {
+		double off = (a[0][1] * a[0][1]) + (a[0][2] * a[0][2]) + (a[1][2] * a[1][2]);
+
+		if (off < 1e-18) {
+			break;
+		}
+		for (p = 0; p < 2; p++) {
+			for (q = p + 1; q < 3; q++) {
+				if (a[p][q] == 0) {
+					continue;
+				}
+				double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+				double t = ((theta >= 0) ? 1.0 : -1.0) / (fabs(theta) + sqrt((theta * theta) + 1.0));
+				double c = 1.0 / sqrt((t * t) + 1.0);
+				double s = t * c;
+
+				// a = J^T a J, v = v J
+				for (k = 0; k < 3; k++) {
+					double akp = a[k][p];
+					double akq = a[k][q];
+					a[k][p] = (c * akp) - (s * akq);
+					a[k][q] = (s * akp) + (c * akq);
+				}
+				for (k = 0; k < 3; k++) {
+					double apk = a[p][k];
+					double aqk = a[q][k];
+					a[p][k] = (c * apk) - (s * aqk);
+					a[q][k] = (s * apk) + (c * aqk);
+				}
+				for (k = 0; k < 3; k++) {
+					double vkp = v[k][p];
+					double vkq = v[k][q];
+					v[k][p] = (c * vkp) - (s * vkq);
+					v[k][q] = (s * vkp) + (c * vkq);
+				}
+			}
+		}
+	}
+
+	m = 0;
+	for (k = 1; k < 3; k++) {
+		m = (a[k][k] < a[m][m]) ? k : m;
+	}
+	for (k = 0; k < 3; k++) {
+		vec[k] = v[k][m];
+	}
+
+	return a[m][m];
+}
+
+//******************************************************************************
+//! \brief        Least squares plane of inliers of h, keeps h if refined plane is rejected.
+//! \return       rms distance of inliers [mm].
+//******************************************************************************
+static float apl_plane_refine(const apl_plane *pl, float *h)
+{
+	double s[3] = { 0, 0, 0 };
+	double c[3][3] = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+	double n[3];
+	double lambda;
+	float r[4];
+	size_t cnt = 0;
+	size_t i;
+
+	for (i = 0; i < pl->pt_num; i++) {
+		float dist = (h[0] * pl->px[i]) + (h[1] * pl->py[i]) + (h[2] * pl->pz[i]) + h[3];
+		double p[3] = { pl->px[i], pl->py[i], pl->pz[i] };
+
+		if (fabsf(dist) > pl->thresh) {
+			continue;
+		}
+		s[0] += p[0];
+		s[1] += p[1];
+		s[2] += p[2];
+		c[0][0] += p[0] * p[0];
+		c[0][1] += p[0] * p[1];
+		c[0][2] += p[0] * p[2];
+		c[1][1] += p[1] * p[1];
+		c[1][2] += p[1] * p[2];
+		c[2][2] += p[2] * p[2];
+		cnt++;
+	}
+	if (cnt < 3) {
+		return pl->thresh;
+	}
+
+	// Covariance About Centroid
+	for (i = 0; i < 3; i++) {
+		s[i] /= (double)cnt;
+	}
+	c[0][0] = (c[0][0] / cnt) - (s[0] * s[0]);
+	c[0][1] = (c[0][1] / cnt) - (s[0] * s[1]);
+	c[0][2] = (c[0][2] / cnt) - (s[0] * s[2]);
+	c[1][1] = (c[1][1] / cnt) - (s[1] * s[1]);
+	c[1][2] = (c[1][2] / cnt) - (s[1] * s[2]);
+	c[2][2] = (c[2][2] / cnt) - (s[2] * s[2]);
+	c[1][0] = c[0][1];
+	c[2][0] = c[0][2];
+	c[2][1] = c[1][2];
+
+	lambda = apl_plane_eig_min(c, n);
+
+	r[0] = (float)n[0];
+	r[1] = (float)n[1];
+	r[2] = (float)n[2];
+	r[3] = (float)-((n[0] * s[0]) + (n[1] * s[1]) + (n[2] * s[2]));
+	if (!apl_plane_orient(pl, r)) {
+		return pl->thresh;
+	}
+	std::copy(r, r + 4, h);
+
+	return (float)sqrt(std::max(lambda, 0.0));
+}
+
+//******************************************************************************
+//! \brief        Inlier mask of full image, rows in parallel.
+//! \return       inlier pixels.
+//******************************************************************************
+static uint32_t apl_plane_mask(apl_plane *pl, const uint16_t *dp, const float *h, uint8_t *mask)
+{
+	const apl_lens *lens = pl->lens;
+	std::atomic<uint32_t> total(0);
+
+	apl_pool_for(lens->h, 0, [&](size_t row_begin, size_t row_end) {
+		// Locals, Stores To uint8_t Mask Could Alias Them
+		const size_t w = lens->w;
+		const float *rx = lens->rx;
+		const float nx = h[0];
+		const float d = h[3];
+		const float t = pl->thresh;
+		uint32_t cnt = 0;
+
+		for (size_t v = row_begin; v < row_end; v++) {
+			const uint16_t *src = dp + (v * w);
+			uint8_t *dst = mask + (v * w);
+			const float cv = (h[1] * lens->ry[v]) + h[2];
+
+			// dist = z * (nx * rx + ny * ry + nz) + d, Invalid z = 0 Is Never Inlier
+			for (size_t u = 0; u < w; u++) {
+				float z = (float)src[u];
+				float dist = (z * ((nx * rx[u]) + cv)) + d;
+				uint32_t in = ((fabsf(dist) <= t) ? 1U : 0U) & ((src[u] != 0) ? 1U : 0U);
+				dst[u] = (uint8_t)(0U - in);
+				cnt += in;
+			}
+		}
+		total += cnt;
+	});
+
+	return total;
+}
+
+//******************************************************************************
+//! \brief        Estimate plane of depth image and make inlier mask.
+//******************************************************************************
+void apl_plane_fit(apl_plane *pl, const uint16_t *dp, uint8_t *mask)
+{
+	const apl_lens *lens = pl->lens;
+	const size_t w = lens->w;
+	const size_t s = pl->stride;
+	apl_plane_res res;
+	float best[4] = { 0, 0, 0, 0 };
+	bool valid[APL_PLANE_BATCH];
+	uint32_t best_score = 0;
+	uint32_t needed = pl->iter_max;
+	uint32_t done = 0;
+	size_t u;
+	size_t v;
+	size_t k;
+
+	memset(&res, 0, sizeof(res));
+	res.seq = pl->prev.seq + 1;
+
+	//! \remark 1. Subsampled Point Cloud, Valid Points Only.
+	pl->pt_num = 0;
+	for (v = 0; v < lens->h; v += s) {
+		const uint16_t *src = dp + (v * w);
+
+		for (u = 0; u < w; u += s) {
+			if (src[u] == 0) {
+				continue;
+			}
+			float z = (float)src[u];
+			apl_lens_point(lens, u, v, z, &pl->px[pl->pt_num], &pl->py[pl->pt_num]);
+			pl->pz[pl->pt_num] = z;
+			pl->pt_num++;
+		}
+	}
+	res.points = (uint32_t)pl->pt_num;
+
+	//! \remark 2. Hypotheses In Batches, Scored In Parallel, Until Enough For Confidence.
+	while ((pl->pt_num >= 3) && (done < needed)) {
+		size_t batch = std::min<size_t>(APL_PLANE_BATCH, needed - done);
+
+		for (k = 0; k < batch; k++) {
+			// Warm Start, Previous Plane Is First Hypothesis
+			if ((done == 0) && (k == 0) && pl->prev.valid) {
+				std::copy(pl->prev.n, pl->prev.n + 3, pl->hyp[0]);
+				pl->hyp[0][3] = pl->prev.d;
+				valid[0] = true;
+				continue;
+			}
+			valid[k] = apl_plane_sample(pl, pl->hyp[k]);
+		}
+
+		apl_pool_for(batch, 1, [&](size_t hyp_begin, size_t hyp_end) {
+			for (size_t i = hyp_begin; i < hyp_end; i++) {
+				pl->score[i] = valid[i] ? apl_plane_score(pl, pl->hyp[i]) : 0U;
+			}
+		});
+
+		for (k = 0; k < batch; k++) {
+			if (pl->score[k] > best_score) {
+				best_score = pl->score[k];
+				std::copy(pl->hyp[k], pl->hyp[k] + 4, best);
+				res.warm = ((done == 0) && (k == 0) && pl->prev.valid);
+			}
+		}
+		done += (uint32_t)batch;
+
+		// Hypotheses For Confidence, 1 - (1 - r^3)^N >= conf
+		if (best_score > 0) {
+			double r = (double)best_score / (double)pl->pt_num;
+			double miss = 1.0 - (r * r * r);
+			double n = (miss <= 0.0) ? 0.0 : (log(1.0 - APL_PLANE_CONF) / log(miss));
+			needed = (uint32_t)std::min<double>(std::max(ceil(n), 1.0), (double)pl->iter_max);
+		}
+	}
+	res.hypotheses = done;
+
+	//! \remark 3. Refine Best, Inlier Mask Of Full Image.
+	if ((pl->pt_num >= 3) && (best_score >= (APL_PLANE_MIN_RATIO * pl->pt_num))) {
+		res.rms = apl_plane_refine(pl, best);
+		res.valid = true;
+		std::copy(best, best + 3, res.n);
+		res.d = best[3];
+		res.tilt = (float)APL_PLANE_RAD2DEG(acos(std::min(1.0F,
+					(best[0] * pl->up[0]) + (best[1] * pl->up[1]) + (best[2] * pl->up[2]))));
+		res.inliers = apl_plane_score(pl, best);
+		res.inlier_ratio = (float)res.inliers / (float)pl->pt_num;
+		res.mask_inliers = apl_plane_mask(pl, dp, best, mask);
+	}
+	else {
+		memset(mask, 0, w * lens->h);
+	}
+
+	pl->prev = res;
+
+	std::lock_guard<std::mutex> lock(pl->mtx);
+	pl->res = res;
+}
+
+//******************************************************************************
+//! \brief        Get plane of last frame.
+//******************************************************************************
+void apl_plane_get(apl_plane *pl, apl_plane_res *res)
+{
+	std::lock_guard<std::mutex> lock(pl->mtx);
+
+	*res = pl->res;
+}
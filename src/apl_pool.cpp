@@ -0,0 +1,368 @@
+//******************************************************************************
+//! \file         apl_pool.cpp
+//! \brief        persistent worker pool with work-stealing row-band scheduler.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "apl_pool.h"
+#include "apl_thread.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_POOL_MAX_CPU		(32)	// maximum cpus scanned in sysfs
+#define APL_POOL_BANDS_PER_THR	(4)		// bands per thread when grain is automatic
+#define APL_POOL_MIN_GRAIN		(8)		// minimum rows per band when grain is automatic
+#define APL_POOL_EXT_SLOT		(8)		// slots of external callers (capture threads, view, writers), more share them
+#define APL_POOL_NO_SLOT		(SIZE_MAX)	// thread has no slot yet
+
+// Fork-Join Job, Shared By Its Bands
+typedef struct {
+	const apl_pool_band_fn	*fn;		// band function
+	std::atomic<size_t>		pending;	// bands not yet finished
+} apl_pool_job;
+
+// Queued Band
+typedef struct {
+	apl_pool_job	*job;		// owner job
+	size_t			begin;		// first row
+	size_t			end;		// last row + 1
+} apl_pool_band;
+
+// Per Thread Deque, Owner Pops Back, Thieves Pop Front
+typedef struct {
+	std::mutex					mtx;	// mutex for deque
+	std::deque<apl_pool_band>	que;	// queued bands
+} apl_pool_slot;
+
+static std::vector<pthread_t>		sWorker;			// worker threads
+static std::vector<apl_pool_slot *>	sSlot;				// 0 .. APL_POOL_EXT_SLOT - 1 = external callers, then workers
+static std::mutex					sWakeMtx;			// mutex for sWakeCv
+static std::condition_variable		sWakeCv;			// wake idle workers
+static std::atomic<size_t>			sQueued(0);			// bands queued in all slots
+static bool							sExit = false;		// true = workers exit
+static std::atomic<size_t>			sExtNext(0);		// next slot of external caller
+static thread_local size_t			tSlotIdx = APL_POOL_NO_SLOT;	// slot of current thread
+
+//******************************************************************************
+//! \brief        Read cpuinfo_max_freq of a cpu.
+//! \param[in]    cpu           cpu number.
+//! \return       frequency [kHz], 0 if cpu does not exist.
+//******************************************************************************
+static long apl_pool_cpu_max_freq(int cpu)
+{
+	char fn[128];
+	FILE *fp;
+	long freq = 0;
+
+	snprintf(fn, sizeof(fn), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+	fp = fopen(fn, "r");
+	if (fp == NULL) {
+		return 0;
+	}
+	if (fscanf(fp, "%ld", &freq) != 1) {
+		freq = 0;
+	}
+	(void)fclose(fp);
+
+	return freq;
+}
+
+//******************************************************************************
+//! \brief        Collect cpus of a cluster.
+//! \param[in]    cluster       cpu cluster.
+//! \param[out]   set           cpus of the cluster.
+//! \return       number of cpus in set.
+//******************************************************************************
+static int apl_pool_cluster_set(APL_POOL_CLUSTER cluster, cpu_set_t *set)
+{
+	long freq[APL_POOL_MAX_CPU];
+	long fmin = 0;
+	long fmax = 0;
+	int ncpu = 0;
+	int i;
+
+	CPU_ZERO(set);
+
+	for (i = 0; i < APL_POOL_MAX_CPU; i++) {
+		freq[i] = apl_pool_cpu_max_freq(i);
+		if (freq[i] == 0) {
+			break;
+		}
+		fmin = ((fmin == 0) || (freq[i] < fmin)) ? freq[i] : fmin;
+		fmax = (freq[i] > fmax) ? freq[i] : fmax;
+	}
+	ncpu = i;
+
+	// No cpufreq (e.g. virtual machine), Treat All Online Cpus As One Cluster
+	if (ncpu == 0) {
+		ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+		ncpu = (ncpu > APL_POOL_MAX_CPU) ? APL_POOL_MAX_CPU : ncpu;
+		for (i = 0; i < ncpu; i++) {
+			CPU_SET(i, set);
+		}
+		return ncpu;
+	}
+
+	for (i = 0; i < ncpu; i++) {
+		if ((cluster == APL_POOL_CLUSTER_ALL) ||
+			(fmin == fmax) ||
+			((cluster == APL_POOL_CLUSTER_BIG)    && (freq[i] != fmin)) ||
+			((cluster == APL_POOL_CLUSTER_LITTLE) && (freq[i] == fmin))) {
+			CPU_SET(i, set);
+		}
+	}
+
+	return CPU_COUNT(set);
+}
+
+//******************************************************************************
+//! \brief        Take a band, own slot first (LIFO), then steal from others (FIFO).
+//! \param[out]   band          taken band.
+//! \return       true          band is taken
+//******************************************************************************
+static bool apl_pool_take(apl_pool_band *band)
+{
+	size_t num = sSlot.size();
+	size_t i;
+
+	if (sQueued.load(std::memory_order_acquire) == 0) {
+		return false;
+	}
+
+	{
+		apl_pool_slot *own = sSlot[tSlotIdx];
+		std::lock_guard<std::mutex> lock(own->mtx);
+		if (!own->que.empty()) {
+			*band = own->que.back();
+			own->que.pop_back();
+			sQueued.fetch_sub(1, std::memory_order_acq_rel);
+			return true;
+		}
+	}
+
+	for (i = 1; i < num; i++) {
+		apl_pool_slot *victim = sSlot[(tSlotIdx + i) % num];
+		std::lock_guard<std::mutex> lock(victim->mtx);
+		if (!victim->que.empty()) {
+			*band = victim->que.front();
+			victim->que.pop_front();
+			sQueued.fetch_sub(1, std::memory_order_acq_rel);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//******************************************************************************
+//! \brief        Execute a band and signal its job.
+//******************************************************************************
+static void apl_pool_exec(const apl_pool_band &band)
+{
+	(*band.job->fn)(band.begin, band.end);
+	band.job->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+//******************************************************************************
+//! \brief        Worker thread.
+//! \param[in]    data          slot index.
+//******************************************************************************
+static void *apl_pool_worker(void *data)
+{
+	apl_pool_band band;
+
+	tSlotIdx = (size_t)(uintptr_t)data;
+
+	while (true) {
+		if (apl_pool_take(&band)) {
+			apl_pool_exec(band);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sWakeMtx);
+		sWakeCv.wait(lock, [] { return sExit || (sQueued.load(std::memory_order_acquire) != 0); });
+		if (sExit) {
+			break;
+		}
+	}
+
+	return nullptr;
+}
+
+//******************************************************************************
+//! \brief        Start worker threads of the pool.
+//******************************************************************************
+int apl_pool_init(int thread_num, APL_POOL_CLUSTER cluster)
+{
+	cpu_set_t set;
+	int ncpu;
+	int i;
+
+	apl_pool_term();
+
+	ncpu = apl_pool_cluster_set(cluster, &set);
+	if (thread_num <= 0) {
+		thread_num = ncpu - 1;	// Caller Of apl_pool_for() Is Also Working
+	}
+
+	// Slots Are Fixed Before Workers Start, Workers Index Them Without Lock
+	for (i = 0; i < (APL_POOL_EXT_SLOT + thread_num); i++) {
+		sSlot.push_back(new apl_pool_slot);
+	}
+	sExit = false;
+
+	for (i = 0; i < thread_num; i++) {
+		pthread_t thr;
+
+		char name[16];
+
+		snprintf(name, sizeof(name), "tof_pool%u", (unsigned)(i & 0xFF));
+		// Cluster Affinity Unless Cpus Of Process Role Are Configured, Applied At Creation So Record Is Right
+		if (apl_thr_create_on(&thr, APL_THR_ROLE_PROCESS, name, apl_pool_worker, (void *)(uintptr_t)(APL_POOL_EXT_SLOT + i),
+							  (ncpu > 0) ? &set : NULL) != 0) {
+			printf("pthread_create failed (pool worker %d)\n", i);
+			break;
+		}
+		sWorker.push_back(thr);
+	}
+
+	return (sWorker.size() == (size_t)thread_num) ? 0 : -1;
+}
+
+//******************************************************************************
+//! \brief        Stop and join worker threads.
+//******************************************************************************
+void apl_pool_term(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(sWakeMtx);
+		sExit = true;
+	}
+	sWakeCv.notify_all();
+
+	for (pthread_t thr : sWorker) {
+		pthread_join(thr, NULL);
+	}
+	sWorker.clear();
+
+	for (apl_pool_slot *slot : sSlot) {
+		delete slot;
+	}
+	sSlot.clear();
+	sQueued.store(0);
+}
+
+//******************************************************************************
+//! \brief        Number of threads executing a fork-join.
+//******************************************************************************
+int apl_pool_thread_num(void)
+{
+	return (int)sWorker.size() + 1;
+}
+
+//******************************************************************************
+//! \brief        Number of cpus belong to the cluster.
+//******************************************************************************
+int apl_pool_cluster_cpu_num(APL_POOL_CLUSTER cluster)
+{
+	cpu_set_t set;
+
+	return apl_pool_cluster_set(cluster, &set);
+}
+
+//******************************************************************************
+//! \brief        Run band function over rows in parallel (fork-join).
+//******************************************************************************
+void apl_pool_for(size_t rows, size_t grain, const apl_pool_band_fn &fn)
+{
+	apl_pool_job job;
+	apl_pool_band band;
+	size_t bands;
+	size_t r;
+
+	if (rows == 0) {
+		return;
+	}
+
+	if (grain == 0) {
+		grain = rows / ((size_t)apl_pool_thread_num() * APL_POOL_BANDS_PER_THR);
+		grain = (grain < APL_POOL_MIN_GRAIN) ? APL_POOL_MIN_GRAIN : grain;
+	}
+	bands = (rows + grain - 1) / grain;
+
+	// No Worker Or Single Band, Run Inline
+	if (sWorker.empty() || (bands == 1)) {
+		fn(0, rows);
+		return;
+	}
+
+	// External Caller (Capture Thread Of Each Device, View, Writers) Gets Own Slot At First Call,
+	// Callers Beyond APL_POOL_EXT_SLOT Share Slots Round Robin (Deques Are Locked, Only Contention Grows)
+	if (tSlotIdx == APL_POOL_NO_SLOT) {
+		tSlotIdx = sExtNext.fetch_add(1, std::memory_order_relaxed) % APL_POOL_EXT_SLOT;
+	}
+
+	job.fn = &fn;
+	job.pending.store(bands);
+
+	// Counted Before Bands Are Published, Thief Never Takes A Band That Is Not Counted (No Wrap Of sQueued)
+	{
+		std::lock_guard<std::mutex> lock(sWakeMtx);
+		sQueued.fetch_add(bands - 1, std::memory_order_acq_rel);
+	}
+
+	// Queue All Bands But The First One To Own Slot, Idle Workers Steal Them
+	{
+		apl_pool_slot *own = sSlot[tSlotIdx];
+		std::lock_guard<std::mutex> lock(own->mtx);
+		for (r = grain; r < rows; r += grain) {
+			own->que.push_back({ &job, r, (r + grain < rows) ? (r + grain) : rows });
+		}
+	}
+	sWakeCv.notify_all();
+
+	// Work On First Band, Then Help Until All Bands Are Done (Join)
+	band = { &job, 0, grain };
+	apl_pool_exec(band);
+
+	while (job.pending.load(std::memory_order_acquire) != 0) {
+		if (apl_pool_take(&band)) {
+			apl_pool_exec(band);
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+//******************************************************************************
+//! \brief        Run independent tasks in parallel (fork-join).
+//******************************************************************************
+void apl_pool_invoke(const apl_pool_task_fn *tasks, size_t num)
+{
+	apl_pool_for(num, 1, [tasks](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			tasks[i]();
+		}
+	});
+}
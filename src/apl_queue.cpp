@@ -0,0 +1,109 @@
+//******************************************************************************
+//! \file         apl_queue.cpp
+//! \brief        bounded queue of buffers from view thread to a writer thread, frames are dropped when it is full.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+
+#include <algorithm>
+
+#include "apl_queue.h"
+
+//******************************************************************************
+//! \brief        Empty queue and reset counters.
+//******************************************************************************
+void apl_queue_init(apl_queue *q, uint32_t decimate)
+{
+	std::lock_guard<std::mutex> lock(q->mtx);
+
+	q->free.clear();
+	q->rdy.clear();
+	q->decimate = std::max(decimate, 1U);
+	q->phase = 0;
+	q->offered = 0;
+	q->decimated = 0;
+	q->dropped = 0;
+	q->stop = false;
+}
+
+//******************************************************************************
+//! \brief        Free buffer for next frame.
+//******************************************************************************
+void *apl_queue_get(apl_queue *q)
+{
+	std::lock_guard<std::mutex> lock(q->mtx);
+	void *buf;
+
+	q->offered++;
+	if (q->phase > 0) {
+		q->phase--;
+		q->decimated++;
+		return NULL;
+	}
+	if (q->free.empty()) {
+		q->dropped++;		// Next Frame Is Tried Again, Not Decimated
+		return NULL;
+	}
+	q->phase = q->decimate - 1;
+	buf = q->free.front();
+	q->free.pop_front();
+
+	return buf;
+}
+
+//******************************************************************************
+//! \brief        Hand over filled buffer to consumer.
+//******************************************************************************
+void apl_queue_put(apl_queue *q, void *buf)
+{
+	{
+		std::lock_guard<std::mutex> lock(q->mtx);
+		q->rdy.push_back(buf);
+	}
+	q->cv.notify_one();
+}
+
+//******************************************************************************
+//! \brief        Wait for next buffer.
+//******************************************************************************
+void *apl_queue_pop(apl_queue *q)
+{
+	std::unique_lock<std::mutex> lock(q->mtx);
+	void *buf;
+
+	q->cv.wait(lock, [q] { return q->stop || !q->rdy.empty(); });
+	if (q->rdy.empty()) {
+		return NULL;		// Stop Requested And Queue Drained
+	}
+	buf = q->rdy.front();
+	q->rdy.pop_front();
+
+	return buf;
+}
+
+//******************************************************************************
+//! \brief        Give buffer back.
+//******************************************************************************
+void apl_queue_free(apl_queue *q, void *buf)
+{
+	std::lock_guard<std::mutex> lock(q->mtx);
+
+	q->free.push_back(buf);
+}
+
+//******************************************************************************
+//! \brief        Request consumer to end after queued buffers.
+//******************************************************************************
+void apl_queue_stop(apl_queue *q)
+{
+	{
+		std::lock_guard<std::mutex> lock(q->mtx);
+		q->stop = true;
+	}
+	q->cv.notify_one();
+}
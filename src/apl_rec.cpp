@@ -0,0 +1,219 @@
+//******************************************************************************
+//! \file         apl_rec.cpp
+//! \brief        video export of colorized depth and ir windows (MJPEG / AVI), encoded by own thread.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "apl_thread.h"
+#include "apl_metrics.h"
+#include "apl_queue.h"
+#include "apl_rec.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+// Queued Frame, Buffers Are Reused So That Steady State Does Not Allocate
+typedef struct {
+	cv::Mat		depth;		// CV_8UC3, empty = not recorded
+	cv::Mat		ir;			// CV_16UC1, empty = not recorded
+} apl_rec_frm;
+
+// Output File Of Stream
+typedef struct {
+	const char		*suffix;	// appended to prefix
+	cv::VideoWriter	writer;		// opened at first frame
+	bool			failed;		// open failed, stream is not recorded any more
+} apl_rec_out;
+
+static apl_queue					sQue;			// frames waiting for encoder, its mutex guards sWritten
+static std::vector<apl_rec_frm>		sFrm;			// buffers of queue
+static uint64_t						sWritten;		// frames encoded
+static bool							sStarted = false;
+static pthread_t					sThr;
+static std::string					sPrefix;
+static double						sFps;			// frame rate of files
+static apl_rec_out					sOut[2] = { { "_depth.avi", cv::VideoWriter(), false }, { "_ir.avi", cv::VideoWriter(), false } };
+
+//******************************************************************************
+//! \brief        Write image to stream, file is opened at first image (size is known then).
+//******************************************************************************
+static void apl_rec_write(apl_rec_out *out, const cv::Mat &img)
+{
+	if (out->failed) {
+		return;
+	}
+
+	if (!out->writer.isOpened()) {
+		std::string fn = sPrefix + out->suffix;
+
+		if (!out->writer.open(fn, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), sFps, img.size(), true)) {
+			printf("rec : open %s failed, stream is not recorded\n", fn.c_str());
+			out->failed = true;
+			return;
+		}
+		printf("rec : %s (%dx%d, %.1f fps)\n", fn.c_str(), img.cols, img.rows, sFps);
+	}
+
+	out->writer.write(img);
+}
+
+//******************************************************************************
+//! \brief        Encoder thread.
+//******************************************************************************
+static void *apl_rec_thread(void *arg)
+{
+	cv::Mat ir_8u;
+	cv::Mat ir_bgr;
+	apl_rec_frm *frm;
+	uint64_t tick;
+
+	(void)arg;
+
+	while ((frm = static_cast<apl_rec_frm *>(apl_queue_pop(&sQue))) != NULL) {
+		tick = apl_mtr_tick();
+
+		//! \remark 1. Depth Is Already BGR.
+		if (!frm->depth.empty()) {
+			apl_rec_write(&sOut[0], frm->depth);
+		}
+
+		//! \remark 2. IR To 8 Bits BGR, Same Scaling As imshow() Of 16 Bits.
+		if (!frm->ir.empty()) {
+			frm->ir.convertTo(ir_8u, CV_8U, 1.0 / 256.0);
+			cv::cvtColor(ir_8u, ir_bgr, cv::COLOR_GRAY2BGR);
+			apl_rec_write(&sOut[1], ir_bgr);
+		}
+
+		apl_mtr_observe(APL_MTR_STAGE_ENCODE, tick);
+
+		{
+			std::lock_guard<std::mutex> lock(sQue.mtx);
+			sWritten++;
+		}
+		apl_queue_free(&sQue, frm);
+	}
+
+	return NULL;
+}
+
+//******************************************************************************
+//! \brief        Start encoder thread.
+//******************************************************************************
+int apl_rec_start(const char *prefix, uint32_t fps, uint32_t decimate, uint32_t queue_max)
+{
+	size_t i;
+
+	if (sStarted) {
+		return 0;
+	}
+
+	sPrefix = prefix;
+	sFps = (double)std::max(fps, 1U) / std::max(decimate, 1U);
+	sWritten = 0;
+
+	apl_queue_init(&sQue, decimate);
+	sFrm.assign(std::max(queue_max, 1U), apl_rec_frm());
+	for (i = 0; i < sFrm.size(); i++) {
+		apl_queue_free(&sQue, &sFrm[i]);
+	}
+
+	for (i = 0; i < 2; i++) {
+		sOut[i].failed = false;
+	}
+
+	if (apl_thr_create(&sThr, APL_THR_ROLE_RECORDER, "tof_rec", apl_rec_thread, NULL) != 0) {
+		return -1;
+	}
+	sStarted = true;
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Queue frame for encoder.
+//******************************************************************************
+void apl_rec_push(const cv::Mat &depth, const cv::Mat &ir)
+{
+	apl_rec_frm *frm;
+
+	if (!sStarted) {
+		return;
+	}
+
+	//! \remark 1. Decimation, Dropped When Queue Is Full.
+	frm = static_cast<apl_rec_frm *>(apl_queue_get(&sQue));
+	if (frm == NULL) {
+		return;
+	}
+
+	//! \remark 2. Copy Outside Of Lock, Buffers Keep Their Size.
+	if (depth.empty()) {
+		frm->depth.release();
+	}
+	else {
+		depth.copyTo(frm->depth);
+	}
+	if (ir.empty()) {
+		frm->ir.release();
+	}
+	else {
+		ir.copyTo(frm->ir);
+	}
+
+	//! \remark 3. Hand Over To Encoder.
+	apl_queue_put(&sQue, frm);
+}
+
+//******************************************************************************
+//! \brief        Stop encoder thread.
+//******************************************************************************
+void apl_rec_stop(void)
+{
+	apl_rec_stat stat;
+	size_t i;
+
+	if (!sStarted) {
+		return;
+	}
+
+	apl_queue_stop(&sQue);
+	pthread_join(sThr, NULL);
+
+	// Release Finalizes AVI Index
+	for (i = 0; i < 2; i++) {
+		sOut[i].writer.release();
+	}
+	sQue.free.clear();		// Counters Are Kept For apl_rec_get()
+	sFrm.clear();
+	sStarted = false;
+
+	apl_rec_get(&stat);
+	printf("rec : written=%llu decimated=%llu dropped=%llu\n",
+		(unsigned long long)stat.written, (unsigned long long)stat.decimated, (unsigned long long)stat.dropped);
+}
+
+//******************************************************************************
+//! \brief        Get counters.
+//******************************************************************************
+void apl_rec_get(apl_rec_stat *stat)
+{
+	std::lock_guard<std::mutex> lock(sQue.mtx);
+
+	stat->offered = sQue.offered;
+	stat->decimated = sQue.decimated;
+	stat->dropped = sQue.dropped;
+	stat->written = sWritten;
+}
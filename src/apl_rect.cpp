@@ -0,0 +1,232 @@
+//******************************************************************************
+//! \file         apl_rect.cpp
+//! \brief        undistortion (rectification) of depth and ir by fixed point remap table of lens distortion.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <algorithm>
+
+#include "apl_arena.h"
+#include "apl_pool.h"
+#include "apl_rect.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_RECT_ONE	(1 << APL_RECT_FRAC)		// 1 pixel in fixed point
+#define APL_RECT_MASK	(APL_RECT_ONE - 1)			// fraction of fixed point
+#define APL_RECT_SHIFT	(2 * APL_RECT_FRAC)			// bilinear weights sum to 1 << APL_RECT_SHIFT
+
+//******************************************************************************
+//! \brief        Coefficients of fixed point lens parameters.
+//******************************************************************************
+bool apl_rect_coef_of(const TL_LensPrm *prm, uint32_t frac, apl_rect_coef *coef)
+{
+	const double scale = ldexp(1.0, -(int)frac);
+
+	coef->k1 = (double)prm->distortion_prm[0] * scale;
+	coef->k2 = (double)prm->distortion_prm[1] * scale;
+	coef->p1 = (double)prm->distortion_prm[2] * scale;
+	coef->p2 = (double)prm->distortion_prm[3] * scale;
+
+	return (coef->k1 != 0) || (coef->k2 != 0) || (coef->p1 != 0) || (coef->p2 != 0);
+}
+
+//******************************************************************************
+//! \brief        Append coefficients to lens file of take.
+//******************************************************************************
+int apl_rect_save(const char *fn, const apl_rect_coef *coef, bool saved)
+{
+	FILE *fp;
+
+	fp = fopen(fn, "a");
+	if (fp == NULL) {
+		printf("fopen (%s) failed\n", fn);
+		return -1;
+	}
+
+	fprintf(fp, "# distortion of depth and ir, saved = 1 : frames are rectified already\n");
+	fprintf(fp, "rect.k1           = %.9g\n", coef->k1);
+	fprintf(fp, "rect.k2           = %.9g\n", coef->k2);
+	fprintf(fp, "rect.p1           = %.9g\n", coef->p1);
+	fprintf(fp, "rect.p2           = %.9g\n", coef->p2);
+	fprintf(fp, "rect.saved        = %d\n", saved ? 1 : 0);
+
+	(void)fclose(fp);
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Initialize stage and build remap table.
+//******************************************************************************
+int apl_rect_init(apl_rect *rect, const apl_lens *lens, const apl_rect_coef *coef)
+{
+	const double us_max = (double)(lens->w - 1);
+	const double vs_max = (double)(lens->h - 1);
+	size_t u;
+	size_t v;
+
+	rect->w = lens->w;
+	rect->h = lens->h;
+	rect->outside = 0;
+	rect->map = NULL;
+
+	if ((rect->w < 2) || (rect->h < 2) || (rect->w > APL_RECT_SIZE_MAX) || (rect->h > APL_RECT_SIZE_MAX)) {
+		printf("rect : %zux%zu is not supported\n", rect->w, rect->h);
+		return -1;
+	}
+
+	rect->map = static_cast<int16_t *>(apl_arena_alloc(2 * rect->w * rect->h * sizeof(int16_t)));
+	if (rect->map == NULL) {
+		return -1;
+	}
+
+	//! \remark 1. Pixel Of Rectified Image Through Distortion To Image As Captured, Once Per Resolution.
+	for (v = 0; v < rect->h; v++) {
+		const double y = lens->ry[v];
+		int16_t *m = rect->map + (2 * v * rect->w);
+
+		for (u = 0; u < rect->w; u++) {
+			const double x = lens->rx[u];
+			const double r2 = (x * x) + (y * y);
+			const double radial = 1.0 + (coef->k1 * r2) + (coef->k2 * r2 * r2);
+			const double xd = (x * radial) + (2.0 * coef->p1 * x * y) + (coef->p2 * (r2 + (2.0 * x * x)));
+			const double yd = (y * radial) + (coef->p1 * (r2 + (2.0 * y * y))) + (2.0 * coef->p2 * x * y);
+			const double us = (xd * lens->fx) + lens->cx;
+			const double vs = (yd * lens->fy) + lens->cy;
+
+			//! \remark 2. Outside Of Image By More Than Half Pixel Is Invalid, Border Is Clamped.
+			if ((us < -0.5) || (us > (us_max + 0.5)) || (vs < -0.5) || (vs > (vs_max + 0.5))) {
+				m[(2 * u) + 0] = -1;
+				m[(2 * u) + 1] = -1;
+				rect->outside++;
+				continue;
+			}
+			m[(2 * u) + 0] = (int16_t)lround(std::min(std::max(us, 0.0), us_max) * APL_RECT_ONE);
+			m[(2 * u) + 1] = (int16_t)lround(std::min(std::max(vs, 0.0), vs_max) * APL_RECT_ONE);
+		}
+	}
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Free remap table.
+//******************************************************************************
+void apl_rect_term(apl_rect *rect)
+{
+	apl_arena_free(rect->map);
+	rect->map = NULL;
+}
+
+//******************************************************************************
+//! \brief        Rectify one row, branch free (selects only) so that it is vectorized.
+//! \param[in]    rect          stage.
+//! \param[in]    y             row.
+//! \param[in]    depth         depth as captured (DP).
+//! \param[in]    ir            ir as captured (IR).
+//! \param[out]   dp_row        row of rectified depth (DP).
+//! \param[out]   ir_row        row of rectified ir (IR).
+//******************************************************************************
+template <bool DP, bool IR>
+static void apl_rect_row(const apl_rect *rect, size_t y, const uint16_t *depth, const uint16_t *ir, uint16_t *dp_row, uint16_t *ir_row)
+{
+	const int32_t w = (int32_t)rect->w;
+	const int32_t h = (int32_t)rect->h;
+	const int16_t *m = rect->map + (2 * y * rect->w);
+	int32_t x;
+
+	for (x = 0; x < w; x++) {
+		const int32_t mx = m[(2 * x) + 0];
+		const int32_t my = m[(2 * x) + 1];
+		const bool in = (mx >= 0);
+		const int32_t sx = in ? mx : 0;
+		const int32_t sy = in ? my : 0;
+
+		// Nearest Pixel, Depth Is Never Blended Across Invalid Pixels Or Edges
+		if (DP) {
+			const int32_t xn = (sx + (APL_RECT_ONE / 2)) >> APL_RECT_FRAC;
+			const int32_t yn = (sy + (APL_RECT_ONE / 2)) >> APL_RECT_FRAC;
+			const uint16_t d = depth[(yn * w) + xn];
+
+			dp_row[x] = in ? d : 0;
+		}
+
+		// Bilinear Of 2 x 2 Pixels, Integer Weights Of APL_RECT_FRAC Bits
+		if (IR) {
+			const int32_t x0 = sx >> APL_RECT_FRAC;
+			const int32_t y0 = sy >> APL_RECT_FRAC;
+			const int32_t x1 = std::min(x0 + 1, w - 1);
+			const int32_t y1 = std::min(y0 + 1, h - 1);
+			const int32_t fx = sx & APL_RECT_MASK;
+			const int32_t fy = sy & APL_RECT_MASK;
+			const int32_t top = ((APL_RECT_ONE - fx) * ir[(y0 * w) + x0]) + (fx * ir[(y0 * w) + x1]);
+			const int32_t bot = ((APL_RECT_ONE - fx) * ir[(y1 * w) + x0]) + (fx * ir[(y1 * w) + x1]);
+			const int32_t v = (((APL_RECT_ONE - fy) * top) + (fy * bot) + (1 << (APL_RECT_SHIFT - 1))) >> APL_RECT_SHIFT;
+
+			ir_row[x] = in ? (uint16_t)v : 0;
+		}
+	}
+}
+
+//******************************************************************************
+//! \brief        Rectify depth and ir.
+//******************************************************************************
+void apl_rect_run(const apl_rect *rect, const uint16_t *depth, const uint16_t *ir, uint16_t *depth_out, uint16_t *ir_out)
+{
+	const size_t w = rect->w;
+
+	//! \remark 1. Tiles In Parallel, Each Row Of Table Is Read Once For Both Planes.
+	apl_pool_for(rect->h, APL_RECT_TILE, [&](size_t row_begin, size_t row_end) {
+		size_t y;
+
+		for (y = row_begin; y < row_end; y++) {
+			if ((depth != NULL) && (ir != NULL)) {
+				apl_rect_row<true, true>(rect, y, depth, ir, depth_out + (y * w), ir_out + (y * w));
+			}
+			else
+			if (depth != NULL) {
+				apl_rect_row<true, false>(rect, y, depth, ir, depth_out + (y * w), NULL);
+			}
+			else
+			if (ir != NULL) {
+				apl_rect_row<false, true>(rect, y, depth, ir, NULL, ir_out + (y * w));
+			}
+		}
+	});
+}
+
+//******************************************************************************
+//! \brief        Rectify mask of depth.
+//******************************************************************************
+void apl_rect_mask(const apl_rect *rect, const uint8_t *mask, uint8_t *mask_out)
+{
+	const size_t w = rect->w;
+
+	apl_pool_for(rect->h, APL_RECT_TILE, [&](size_t row_begin, size_t row_end) {
+		for (size_t y = row_begin; y < row_end; y++) {
+			const int16_t *m = rect->map + (2 * y * w);
+			uint8_t *dst = mask_out + (y * w);
+
+			// Same Nearest Pixel As Depth
+			for (size_t x = 0; x < w; x++) {
+				const int32_t mx = m[(2 * x) + 0];
+				const int32_t my = m[(2 * x) + 1];
+				const bool in = (mx >= 0);
+				const int32_t xn = ((in ? mx : 0) + (APL_RECT_ONE / 2)) >> APL_RECT_FRAC;
+				const int32_t yn = ((in ? my : 0) + (APL_RECT_ONE / 2)) >> APL_RECT_FRAC;
+
+				dst[x] = in ? mask[(yn * w) + xn] : 0;
+			}
+		}
+	});
+}
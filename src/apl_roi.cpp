@@ -0,0 +1,181 @@
+//******************************************************************************
+//! \file         apl_roi.cpp
+//! \brief        summed-area tables of depth, O(1) distance query of rectangles.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+#include <mutex>
+
+#include "apl_arena.h"
+#include "apl_pool.h"
+#include "apl_roi.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_ROI_COL_BLOCK	(64)	// columns per task of vertical pass
+
+//******************************************************************************
+//! \brief        Initialize tables.
+//******************************************************************************
+void apl_roi_init(apl_roi *roi, size_t w, size_t h)
+{
+	size_t n = (w + 1) * (h + 1);
+
+	roi->w = w;
+	roi->h = h;
+	roi->sum = static_cast<uint64_t *>(apl_arena_alloc(n * sizeof(uint64_t)));
+	roi->sq  = static_cast<uint64_t *>(apl_arena_alloc(n * sizeof(uint64_t)));
+	roi->cnt = static_cast<uint32_t *>(apl_arena_alloc(n * sizeof(uint32_t)));
+	roi->roi_num = 0;
+	memset(roi->res, 0, sizeof(roi->res));
+}
+
+//******************************************************************************
+//! \brief        Add region evaluated every frame.
+//******************************************************************************
+int apl_roi_add(apl_roi *roi, const apl_roi_rect *rect)
+{
+	if (roi->roi_num >= APL_ROI_MAX) {
+		return -1;
+	}
+
+	roi->roi[roi->roi_num++] = *rect;
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Build tables from depth image and evaluate configured regions.
+//******************************************************************************
+void apl_roi_build(apl_roi *roi, const uint16_t *dp, const uint8_t *skip)
+{
+	const size_t w = roi->w;
+	const size_t h = roi->h;
+	const size_t stride = w + 1;
+	apl_roi_res res[APL_ROI_MAX];
+	size_t i;
+
+	//! \remark 1. Horizontal Prefix Sums, Rows In Parallel.
+	apl_pool_for(h, 0, [&](size_t row_begin, size_t row_end) {
+		for (size_t y = row_begin; y < row_end; y++) {
+			const uint16_t *src = dp + (y * w);
+			const uint8_t *sk = (skip != NULL) ? (skip + (y * w)) : NULL;
+			uint64_t *ps = &roi->sum[(y + 1) * stride + 1];
+			uint64_t *pq = &roi->sq[(y + 1) * stride + 1];
+			uint32_t *pc = &roi->cnt[(y + 1) * stride + 1];
+			uint64_t s = 0;
+			uint64_t q = 0;
+			uint32_t c = 0;
+
+			for (size_t x = 0; x < w; x++) {
+				uint32_t d = src[x];
+				if (sk != NULL) {
+					d = (sk[x] != 0) ? 0U : d;
+				}
+				s += d;					// Invalid Depth Is 0, Adds Nothing
+				q += (uint64_t)(d * d);
+				c += (d != 0) ? 1U : 0U;
+				ps[x] = s;
+				pq[x] = q;
+				pc[x] = c;
+			}
+		}
+	});
+
+	//! \remark 2. Vertical Accumulation, Column Blocks In Parallel.
+	apl_pool_for((w + APL_ROI_COL_BLOCK - 1) / APL_ROI_COL_BLOCK, 1, [&](size_t blk_begin, size_t blk_end) {
+		const size_t x0 = (blk_begin * APL_ROI_COL_BLOCK) + 1;
+		const size_t x1 = std::min(blk_end * APL_ROI_COL_BLOCK, w) + 1;
+
+		for (size_t y = 2; y <= h; y++) {
+			uint64_t *ps = &roi->sum[y * stride];
+			uint64_t *pq = &roi->sq[y * stride];
+			uint32_t *pc = &roi->cnt[y * stride];
+
+			for (size_t x = x0; x < x1; x++) {
+				ps[x] += ps[x - stride];
+				pq[x] += pq[x - stride];
+				pc[x] += pc[x - stride];
+			}
+		}
+	});
+
+	//! \remark 3. Configured Regions.
+	for (i = 0; i < roi->roi_num; i++) {
+		if (apl_roi_query(roi, &roi->roi[i], &res[i]) < 0) {
+			memset(&res[i], 0, sizeof(res[i]));
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(roi->mtx);
+	std::copy(res, res + roi->roi_num, roi->res);
+}
+
+//******************************************************************************
+//! \brief        Query rectangle in O(1).
+//******************************************************************************
+int apl_roi_query(const apl_roi *roi, const apl_roi_rect *rect, apl_roi_res *res)
+{
+	const size_t stride = roi->w + 1;
+	int x0 = std::max(rect->x, 0);
+	int y0 = std::max(rect->y, 0);
+	int x1 = std::min(rect->x + rect->w, (int)roi->w);
+	int y1 = std::min(rect->y + rect->h, (int)roi->h);
+	size_t a;
+	size_t b;
+	size_t c;
+	size_t d;
+	uint64_t s;
+	uint64_t q;
+	double mean;
+
+	if ((x0 >= x1) || (y0 >= y1)) {
+		return -1;
+	}
+
+	// Corners, sum = D - B - C + A
+	a = ((size_t)y0 * stride) + (size_t)x0;
+	b = ((size_t)y0 * stride) + (size_t)x1;
+	c = ((size_t)y1 * stride) + (size_t)x0;
+	d = ((size_t)y1 * stride) + (size_t)x1;
+
+	s = roi->sum[d] - roi->sum[b] - roi->sum[c] + roi->sum[a];
+	q = roi->sq[d]  - roi->sq[b]  - roi->sq[c]  + roi->sq[a];
+	res->valid = roi->cnt[d] - roi->cnt[b] - roi->cnt[c] + roi->cnt[a];
+	res->area = (uint32_t)((x1 - x0) * (y1 - y0));
+	res->coverage = (float)res->valid / (float)res->area;
+
+	if (res->valid == 0) {
+		res->mean = 0;
+		res->var = 0;
+		return 0;
+	}
+
+	mean = (double)s / res->valid;
+	res->mean = (float)mean;
+	res->var = (float)std::max(((double)q / res->valid) - (mean * mean), 0.0);
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Get results of configured regions of last frame.
+//******************************************************************************
+size_t apl_roi_get(apl_roi *roi, apl_roi_rect *rect, apl_roi_res *res)
+{
+	std::lock_guard<std::mutex> lock(roi->mtx);
+
+	std::copy(roi->roi, roi->roi + roi->roi_num, rect);
+	std::copy(roi->res, roi->res + roi->roi_num, res);
+
+	return roi->roi_num;
+}
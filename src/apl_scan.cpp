@@ -0,0 +1,223 @@
+//******************************************************************************
+//! \file         apl_scan.cpp
+//! \brief        depth to 2D laser scan, minimum range per angle of a band of rows.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <algorithm>
+
+#include "apl_arena.h"
+#include "apl_lens.h"
+#include "apl_scan.h"
+
+//******************************************************************************
+//! \brief        Initialize scan stage.
+//******************************************************************************
+int apl_scan_init(apl_scan *scan, const apl_lens *lens, uint16_t row_begin, uint16_t row_end,
+				  uint16_t bins, uint16_t range_min, uint16_t range_max)
+{
+	apl_scan_hdr *hdr;
+	double a_first;
+	double a_last;
+	double inc;
+	size_t u;
+
+	scan->fd = -1;
+	scan->fp = NULL;
+
+	bins = (bins != 0) ? bins : lens->w;
+	if ((row_begin >= row_end) || (row_end > lens->h) || (bins < 2)) {
+		printf("scan : bad band %u-%u or bins %u\n", row_begin, row_end, bins);
+		return -1;
+	}
+
+	scan->w = lens->w;
+	scan->row_begin = row_begin;
+	scan->row_end = row_end;
+	scan->col_fac = static_cast<float *>(apl_arena_alloc(lens->w * sizeof(float)));
+	scan->col_bin = static_cast<uint16_t *>(apl_arena_alloc(lens->w * sizeof(uint16_t)));
+	scan->col_min = static_cast<uint16_t *>(apl_arena_alloc(lens->w * sizeof(uint16_t)));
+	scan->msg_size = sizeof(apl_scan_hdr) + (bins * sizeof(float));
+	scan->msg = static_cast<uint8_t *>(apl_arena_alloc(scan->msg_size));
+
+	//! \remark Angle Is Counter-Clockwise, Leftmost Column Has Largest Angle.
+	a_first = -atan(lens->rx[lens->w - 1]);
+	a_last  = -atan(lens->rx[0]);
+	inc = (a_last - a_first) / (bins - 1);
+
+	for (u = 0; u < lens->w; u++) {
+		double a = -atan(lens->rx[u]);
+		long b = lround((a - a_first) / inc);
+
+		scan->col_fac[u] = sqrtf(1.0F + (lens->rx[u] * lens->rx[u])) * 0.001F;	// [mm] -> [m]
+		scan->col_bin[u] = (uint16_t)std::min<long>(std::max<long>(b, 0), bins - 1);
+	}
+
+	hdr = reinterpret_cast<apl_scan_hdr *>(scan->msg);
+	hdr->magic = APL_SCAN_MAGIC;
+	hdr->version = APL_SCAN_VERSION;
+	hdr->count = bins;
+	hdr->seq = 0;
+	hdr->stamp_ns = 0;
+	hdr->angle_min = (float)a_first;
+	hdr->angle_inc = (float)inc;
+	apl_scan_range(scan, range_min, range_max);
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Change valid depth range.
+//******************************************************************************
+void apl_scan_range(apl_scan *scan, uint16_t range_min, uint16_t range_max)
+{
+	apl_scan_hdr *hdr = reinterpret_cast<apl_scan_hdr *>(scan->msg);
+
+	scan->range_min = range_min;
+	scan->range_max = range_max;
+	hdr->range_min = range_min * 0.001F;
+	hdr->range_max = range_max * 0.001F;
+}
+
+//******************************************************************************
+//! \brief        Open output of scans.
+//******************************************************************************
+int apl_scan_open(apl_scan *scan, const char *output)
+{
+	memset(&scan->dst, 0, sizeof(scan->dst));
+
+	if (strncmp(output, "file:", 5) == 0) {
+		scan->fp = fopen(output + 5, "ab");
+		if (scan->fp == NULL) {
+			printf("scan : fopen (%s) failed\n", output + 5);
+			return -1;
+		}
+		return 0;
+	}
+
+	if (strncmp(output, "unix:", 5) == 0) {
+		struct sockaddr_un *sun = reinterpret_cast<struct sockaddr_un *>(&scan->dst);
+
+		if (strlen(output + 5) >= sizeof(sun->sun_path)) {
+			return -1;
+		}
+		sun->sun_family = AF_UNIX;
+		strcpy(sun->sun_path, output + 5);
+		scan->dst_len = sizeof(*sun);
+		scan->fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	}
+	else
+	if (strncmp(output, "udp:", 4) == 0) {
+		struct sockaddr_in *sin = reinterpret_cast<struct sockaddr_in *>(&scan->dst);
+		const char *colon = strrchr(output + 4, ':');
+		char addr[64];
+
+		if (colon == NULL) {
+			printf("scan : no port in %s\n", output);
+			return -1;
+		}
+		snprintf(addr, sizeof(addr), "%.*s", (int)(colon - (output + 4)), output + 4);
+		sin->sin_family = AF_INET;
+		sin->sin_port = htons((uint16_t)atoi(colon + 1));
+		if (inet_pton(AF_INET, addr, &sin->sin_addr) != 1) {
+			printf("scan : bad address %s\n", output);
+			return -1;
+		}
+		scan->dst_len = sizeof(*sin);
+		scan->fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	}
+	else {
+		printf("scan : unknown output %s\n", output);
+		return -1;
+	}
+
+	if (scan->fd < 0) {
+		printf("scan : socket failed (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Compute scan of depth image and publish it.
+//******************************************************************************
+const apl_scan_hdr *apl_scan_calc(apl_scan *scan, const uint16_t *dp, uint64_t stamp_ns)
+{
+	apl_scan_hdr *hdr = reinterpret_cast<apl_scan_hdr *>(scan->msg);
+	float *range = reinterpret_cast<float *>(scan->msg + sizeof(apl_scan_hdr));
+	uint16_t *col_min = scan->col_min;
+	const size_t w = scan->w;
+	const uint16_t lo = std::max<uint16_t>(scan->range_min, 1);
+	size_t u;
+	size_t v;
+
+	//! \remark 1. Column Reduction Over Band, Branch Free, Vectorized.
+	//!            Key Is Depth - lo, Invalid 0 And Depth Below range_min Wrap Above Any Depth In Range,
+	//!            So Minimum Is Nearest Depth In Range Whenever Column Has One.
+	std::fill(col_min, col_min + w, 0xFFFF);
+	for (v = scan->row_begin; v < scan->row_end; v++) {
+		const uint16_t *row = dp + (v * w);
+
+		for (u = 0; u < w; u++) {
+			uint16_t key = (uint16_t)(row[u] - lo);
+			col_min[u] = (key < col_min[u]) ? key : col_min[u];
+		}
+	}
+
+	//! \remark 2. Columns To Angle Bins, Minimum Range Of Columns In Bin.
+	std::fill(range, range + hdr->count, INFINITY);
+	for (u = 0; u < w; u++) {
+		uint32_t z = (uint32_t)col_min[u] + lo;
+		float r = (float)z * scan->col_fac[u];
+
+		if ((z <= scan->range_max) && (r < range[scan->col_bin[u]])) {
+			range[scan->col_bin[u]] = r;
+		}
+	}
+
+	hdr->seq++;
+	hdr->stamp_ns = stamp_ns;
+
+	//! \remark 3. Publish, Never Block Capture Thread.
+	if (scan->fd >= 0) {
+		(void)sendto(scan->fd, scan->msg, scan->msg_size, MSG_DONTWAIT | MSG_NOSIGNAL,
+					 reinterpret_cast<struct sockaddr *>(&scan->dst), scan->dst_len);
+	}
+	if (scan->fp != NULL) {
+		(void)fwrite(scan->msg, scan->msg_size, 1, scan->fp);
+	}
+
+	return hdr;
+}
+
+//******************************************************************************
+//! \brief        Close output of scans.
+//******************************************************************************
+void apl_scan_close(apl_scan *scan)
+{
+	if (scan->fd >= 0) {
+		close(scan->fd);
+		scan->fd = -1;
+	}
+	if (scan->fp != NULL) {
+		fclose(scan->fp);
+		scan->fp = NULL;
+	}
+}
@@ -0,0 +1,265 @@
+//******************************************************************************
+//! \file         apl_stamp.cpp
+//! \brief        per-frame capture timestamps (CLOCK_MONOTONIC / CLOCK_REALTIME), inter-frame jitter and latency.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "apl_dev.h"
+#include "apl_stamp.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+// Upper Bound Of Deviation Buckets [ms]
+static const double BUCKET_LE[APL_STAMP_BUCKET_NUM - 1] = { 0.1, 0.25, 0.5, 1.0, 2.0, 5.0, 10.0 };
+
+#define APL_STAMP_WORD_NUM	(sizeof(apl_stamp_snapshot) / sizeof(uint64_t))	// words of published snapshot
+
+static_assert((sizeof(apl_stamp_snapshot) % sizeof(uint64_t)) == 0, "snapshot is published as 64 bit words");
+
+// Timing Of One Device, Each Thread Keeps Own State And Publishes It Without Lock (As apl_tlm_get)
+typedef struct {
+	// State Of Capture Thread (apl_stamp_init, apl_stamp_resume, apl_stamp_frame)
+	bool				realtime;
+	uint64_t			seq;		// sequence of stamped frames
+	uint64_t			prev;		// CLOCK_MONOTONIC of previous frame, 0 = none
+	double				period;		// [ms]
+	double				mean;		// running mean of interval (Welford) [ms]
+	double				m2;			// running sum of squared difference [ms^2]
+	apl_stamp_snapshot	cap;		// interval statistics, latency is not used
+
+	// State Of View Thread (apl_stamp_latency)
+	uint32_t			lat_epoch;	// epoch of latency statistics
+	uint64_t			lat_num;
+	double				lat_mean;	// [ms]
+	double				lat_max;	// [ms]
+
+	// Published, Read By Any Thread
+	std::atomic<uint32_t>	epoch;						// incremented by apl_stamp_init, view thread restarts latency
+	std::atomic<uint32_t>	pub_seq;					// seqlock of pub, odd while capture thread writes
+	std::atomic<uint64_t>	pub[APL_STAMP_WORD_NUM];	// interval statistics as words of apl_stamp_snapshot
+	std::atomic<uint64_t>	latency_num;
+	std::atomic<double>		latency_mean;
+	std::atomic<double>		latency_max;
+} apl_stamp_dev;
+
+static apl_stamp_dev		sDev[APL_DEV_MAX];
+
+//******************************************************************************
+//! \brief        Clock in ns.
+//******************************************************************************
+static uint64_t apl_stamp_clock(clockid_t id)
+{
+	struct timespec ts;
+
+	clock_gettime(id, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+//******************************************************************************
+//! \brief        CLOCK_MONOTONIC [ns].
+//******************************************************************************
+uint64_t apl_stamp_mono(void)
+{
+	return apl_stamp_clock(CLOCK_MONOTONIC);
+}
+
+//******************************************************************************
+//! \brief        Publish interval statistics of capture thread (seqlock writer, single writer).
+//******************************************************************************
+static void apl_stamp_publish(apl_stamp_dev *sd)
+{
+	uint64_t word[APL_STAMP_WORD_NUM];
+	const uint32_t seq = sd->pub_seq.load(std::memory_order_relaxed);
+	size_t i;
+
+	sd->cap.mean_ms = sd->mean;
+	sd->cap.jitter_ms = (sd->cap.intervals > 1) ? sqrt(sd->m2 / (double)(sd->cap.intervals - 1)) : 0;
+	memcpy(word, &sd->cap, sizeof(word));
+
+	sd->pub_seq.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	for (i = 0; i < APL_STAMP_WORD_NUM; i++) {
+		sd->pub[i].store(word[i], std::memory_order_relaxed);
+	}
+	sd->pub_seq.store(seq + 2, std::memory_order_release);
+}
+
+//******************************************************************************
+//! \brief        Reset statistics.
+//******************************************************************************
+void apl_stamp_init(uint8_t dev, uint16_t fps, bool realtime)
+{
+	apl_stamp_dev *sd = &sDev[dev];
+
+	sd->realtime = realtime;
+	sd->prev = 0;
+	sd->period = (fps != 0) ? (1000.0 / fps) : 0;
+	sd->mean = 0;
+	sd->m2 = 0;
+	sd->cap = apl_stamp_snapshot();
+	sd->cap.period_ms = sd->period;
+	apl_stamp_publish(sd);
+
+	// Latency Is Restarted By View Thread At Its Next Frame
+	sd->latency_num.store(0, std::memory_order_relaxed);
+	sd->latency_mean.store(0, std::memory_order_relaxed);
+	sd->latency_max.store(0, std::memory_order_relaxed);
+	sd->epoch.fetch_add(1, std::memory_order_release);
+}
+
+//******************************************************************************
+//! \brief        Forget previous frame.
+//******************************************************************************
+void apl_stamp_resume(uint8_t dev)
+{
+	sDev[dev].prev = 0;
+}
+
+//******************************************************************************
+//! \brief        Stamp frame and measure interval.
+//******************************************************************************
+void apl_stamp_frame(uint8_t dev, TL_Image *img)
+{
+	apl_stamp_dev *sd = &sDev[dev];
+	apl_frm *frm = apl_frm_of(img);
+	double itv;
+	double diff;
+	double delta;
+	size_t b;
+
+	//! \remark 1. Stamp First, Statistics Do Not Delay It.
+	frm->mono_ns = apl_stamp_mono();
+	frm->real_ns = sd->realtime ? apl_stamp_clock(CLOCK_REALTIME) : 0;
+	frm->seq = sd->seq++;
+
+	sd->cap.frames++;
+
+	//! \remark 2. Interval From Previous Frame.
+	if (sd->prev != 0) {
+		itv = (double)(frm->mono_ns - sd->prev) * 1e-6;
+
+		sd->cap.intervals++;
+		delta = itv - sd->mean;
+		sd->mean += delta / (double)sd->cap.intervals;
+		sd->m2 += delta * (itv - sd->mean);
+
+		sd->cap.min_ms = (sd->cap.intervals == 1) ? itv : std::min(sd->cap.min_ms, itv);
+		sd->cap.max_ms = std::max(sd->cap.max_ms, itv);
+		if ((sd->period > 0) && (itv > (APL_STAMP_LATE * sd->period))) {
+			sd->cap.late++;
+		}
+
+		//! \remark 3. Deviation From Period, Late Frames Included.
+		diff = fabs(itv - sd->period);
+		for (b = 0; b < (APL_STAMP_BUCKET_NUM - 1); b++) {
+			if (diff <= BUCKET_LE[b]) {
+				break;
+			}
+		}
+		sd->cap.dev[b]++;
+		sd->cap.dev_sum_ms += diff;
+	}
+	sd->prev = frm->mono_ns;
+
+	//! \remark 4. Publish Without Lock, Readers Never Block Capture Thread.
+	apl_stamp_publish(sd);
+}
+
+//******************************************************************************
+//! \brief        Measure latency from capture to now.
+//******************************************************************************
+void apl_stamp_latency(uint8_t dev, const TL_Image *img)
+{
+	apl_stamp_dev *sd = &sDev[dev];
+	const double lat = (double)(apl_stamp_mono() - apl_frm_of(img)->mono_ns) * 1e-6;
+	const uint32_t epoch = sd->epoch.load(std::memory_order_acquire);
+
+	if (epoch != sd->lat_epoch) {
+		sd->lat_epoch = epoch;
+		sd->lat_num = 0;
+		sd->lat_mean = 0;
+		sd->lat_max = 0;
+	}
+	sd->lat_num++;
+	sd->lat_mean += (lat - sd->lat_mean) / (double)sd->lat_num;
+	sd->lat_max = std::max(sd->lat_max, lat);
+
+	sd->latency_num.store(sd->lat_num, std::memory_order_relaxed);
+	sd->latency_mean.store(sd->lat_mean, std::memory_order_relaxed);
+	sd->latency_max.store(sd->lat_max, std::memory_order_relaxed);
+}
+
+//******************************************************************************
+//! \brief        Get statistics.
+//******************************************************************************
+void apl_stamp_get(uint8_t dev, apl_stamp_snapshot *snap)
+{
+	const apl_stamp_dev *sd = &sDev[dev];
+	uint64_t word[APL_STAMP_WORD_NUM];
+	uint32_t seq;
+	size_t i;
+
+	// Seqlock Reader, Retry While Capture Thread Publishes
+	do {
+		seq = sd->pub_seq.load(std::memory_order_acquire);
+		for (i = 0; i < APL_STAMP_WORD_NUM; i++) {
+			word[i] = sd->pub[i].load(std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while (((seq & 1U) != 0) || (seq != sd->pub_seq.load(std::memory_order_relaxed)));
+
+	memcpy(snap, word, sizeof(word));
+	snap->latency_num     = sd->latency_num.load(std::memory_order_relaxed);
+	snap->latency_mean_ms = sd->latency_mean.load(std::memory_order_relaxed);
+	snap->latency_max_ms  = sd->latency_max.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+//! \brief        Print jitter and latency report.
+//******************************************************************************
+void apl_stamp_report(uint8_t dev, FILE *fp)
+{
+	apl_stamp_snapshot snap;
+	size_t b;
+
+	apl_stamp_get(dev, &snap);
+
+	fprintf(fp, "Frame timing (device %u, CLOCK_MONOTONIC):\n", dev);
+	fprintf(fp, "frames=%llu period=%.3f ms interval mean=%.3f jitter=%.3f min=%.3f max=%.3f ms late=%llu\n",
+		(unsigned long long)snap.frames, snap.period_ms, snap.mean_ms, snap.jitter_ms, snap.min_ms, snap.max_ms,
+		(unsigned long long)snap.late);
+	fprintf(fp, "|interval - period| :");
+	for (b = 0; b < APL_STAMP_BUCKET_NUM; b++) {
+		if (b < (APL_STAMP_BUCKET_NUM - 1)) {
+			fprintf(fp, " <=%gms=%llu", BUCKET_LE[b], (unsigned long long)snap.dev[b]);
+		}
+		else {
+			fprintf(fp, " more=%llu", (unsigned long long)snap.dev[b]);
+		}
+	}
+	fprintf(fp, "\ncapture to view : mean=%.3f max=%.3f ms (%llu frames)\n\n",
+		snap.latency_mean_ms, snap.latency_max_ms, (unsigned long long)snap.latency_num);
+}
+
+//******************************************************************************
+//! \brief        Upper bound of deviation bucket.
+//******************************************************************************
+double apl_stamp_bucket_le(size_t bucket)
+{
+	return (bucket < (APL_STAMP_BUCKET_NUM - 1)) ? BUCKET_LE[bucket] : INFINITY;
+}
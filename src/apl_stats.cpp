@@ -0,0 +1,212 @@
+//******************************************************************************
+//! \file         apl_stats.cpp
+//! \brief        per-frame depth statistics and auto range.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+#include <mutex>
+
+#include "apl_arena.h"
+#include "apl_pool.h"
+#include "apl_stats.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+static const float PCT_VALUE[APL_STATS_PCT_NUM] = { 0.01F, 0.05F, 0.50F, 0.95F, 0.99F };
+
+// Partial Result Of One Part
+typedef struct {
+	uint32_t	sampled;	// sampled pixels
+	uint32_t	valid;		// valid pixels
+	uint16_t	min;		// minimum depth
+	uint16_t	max;		// maximum depth
+	uint64_t	sum;		// sum of depth
+} apl_stats_part;
+
+//******************************************************************************
+//! \brief        Initialize statistics stage.
+//******************************************************************************
+void apl_stats_init(apl_stats *st, uint16_t max_depth, uint16_t stride, float alpha)
+{
+	st->stride = (stride != 0) ? stride : 1;
+	st->alpha = ((alpha > 0) && (alpha <= 1)) ? alpha : 1.0F;
+	st->part = static_cast<uint32_t *>(apl_arena_alloc(APL_STATS_PART_NUM * APL_STATS_BIN_NUM * sizeof(uint32_t)));
+	st->work = static_cast<uint32_t *>(apl_arena_alloc(APL_STATS_BIN_NUM * sizeof(uint32_t)));
+	st->hist = static_cast<uint32_t *>(apl_arena_alloc(APL_STATS_BIN_NUM * sizeof(uint32_t)));
+	apl_stats_range(st, max_depth);
+}
+
+//******************************************************************************
+//! \brief        Change depth range, statistics and auto range restart.
+//******************************************************************************
+void apl_stats_range(apl_stats *st, uint16_t max_depth)
+{
+	std::lock_guard<std::mutex> lock(st->mtx);
+
+	st->near_s = 0;
+	st->far_s = 0;
+
+	// Finest Bin Width That Covers max_depth
+	st->bin_shift = 0;
+	while (((uint32_t)max_depth >> st->bin_shift) >= APL_STATS_BIN_NUM) {
+		st->bin_shift++;
+	}
+
+	std::fill(st->hist, st->hist + APL_STATS_BIN_NUM, 0U);
+	memset(&st->res, 0, sizeof(st->res));
+}
+
+//******************************************************************************
+//! \brief        Compute statistics of depth image.
+//******************************************************************************
+void apl_stats_calc(apl_stats *st, const uint16_t *dp, size_t w, size_t h)
+{
+	apl_stats_part part[APL_STATS_PART_NUM];
+	apl_dp_stats res;
+	const size_t stride = st->stride;
+	const uint16_t shift = st->bin_shift;
+	const size_t rows = (h + stride - 1) / stride;
+	uint32_t *hist = st->work;
+	uint64_t sum = 0;
+	uint64_t cum;
+	uint64_t target;
+	size_t p;
+	size_t b;
+	int k;
+
+	//! \remark 1. One Pass Over Sampled Rows, Each Part Has Own Histogram.
+	apl_pool_for(APL_STATS_PART_NUM, 1, [&](size_t part_begin, size_t part_end) {
+		for (size_t q = part_begin; q < part_end; q++) {
+			uint32_t *ph = &st->part[q * APL_STATS_BIN_NUM];
+			apl_stats_part *pp = &part[q];
+			size_t r;
+			size_t x;
+
+			memset(ph, 0, APL_STATS_BIN_NUM * sizeof(uint32_t));
+			pp->sampled = 0;
+			pp->valid = 0;
+			pp->min = 0xFFFF;
+			pp->max = 0;
+			pp->sum = 0;
+
+			for (r = (q * rows) / APL_STATS_PART_NUM; r < ((q + 1) * rows) / APL_STATS_PART_NUM; r++) {
+				const uint16_t *row = dp + (r * stride * w);
+				uint32_t valid = 0;
+				uint32_t rsum = 0;
+				uint16_t mn = 0xFFFF;
+				uint16_t mx = 0;
+
+				for (x = 0; x < w; x += stride) {
+					uint16_t d = row[x];
+					if (d != 0) {
+						ph[std::min<uint32_t>((uint32_t)d >> shift, APL_STATS_BIN_NUM - 1)]++;
+						mn = (d < mn) ? d : mn;
+						mx = (d > mx) ? d : mx;
+						rsum += d;
+						valid++;
+					}
+				}
+
+				pp->sampled += (uint32_t)((w + stride - 1) / stride);
+				pp->valid += valid;
+				pp->sum += rsum;
+				pp->min = (mn < pp->min) ? mn : pp->min;
+				pp->max = (mx > pp->max) ? mx : pp->max;
+			}
+		}
+	});
+
+	//! \remark 2. Merge Parts.
+	std::fill(hist, hist + APL_STATS_BIN_NUM, 0);
+	memset(&res, 0, sizeof(res));
+	res.min = 0xFFFF;
+	for (p = 0; p < APL_STATS_PART_NUM; p++) {
+		const uint32_t *ph = &st->part[p * APL_STATS_BIN_NUM];
+
+		for (b = 0; b < APL_STATS_BIN_NUM; b++) {
+			hist[b] += ph[b];
+		}
+		res.sampled += part[p].sampled;
+		res.valid += part[p].valid;
+		res.min = (part[p].min < res.min) ? part[p].min : res.min;
+		res.max = (part[p].max > res.max) ? part[p].max : res.max;
+		sum += part[p].sum;
+	}
+
+	//! \remark 3. Percentiles, Interpolated Inside Bin.
+	if (res.valid != 0) {
+		res.valid_ratio = (float)res.valid / (float)res.sampled;
+		res.mean = (float)((double)sum / res.valid);
+
+		for (k = 0; k < APL_STATS_PCT_NUM; k++) {
+			target = (uint64_t)(PCT_VALUE[k] * res.valid);
+			cum = 0;
+			for (b = 0; b < APL_STATS_BIN_NUM; b++) {
+				if ((cum + hist[b]) > target) {
+					float frac = (float)(target - cum) / (float)hist[b];
+					float val = ((float)b + frac) * (float)(1U << shift);
+					val = std::max(val, (float)res.min);
+					val = std::min(val, (float)res.max);
+					res.pct[k] = (uint16_t)val;
+					break;
+				}
+				cum += hist[b];
+			}
+			if (b == APL_STATS_BIN_NUM) {
+				res.pct[k] = res.max;
+			}
+		}
+
+		//! \remark 4. Auto Range, Smoothed 1% - 99% Percentiles.
+		if (st->far_s == 0) {
+			st->near_s = res.pct[APL_STATS_P01];
+			st->far_s  = res.pct[APL_STATS_P99];
+		}
+		else {
+			st->near_s += st->alpha * ((float)res.pct[APL_STATS_P01] - st->near_s);
+			st->far_s  += st->alpha * ((float)res.pct[APL_STATS_P99] - st->far_s);
+		}
+	}
+	else {
+		res.min = 0;
+	}
+	res.range_near = (uint16_t)st->near_s;
+	res.range_far  = (uint16_t)st->far_s;
+
+	std::lock_guard<std::mutex> lock(st->mtx);
+	res.seq = st->res.seq + 1;
+	st->res = res;
+	std::swap(st->hist, st->work);
+}
+
+//******************************************************************************
+//! \brief        Get statistics of last frame.
+//******************************************************************************
+void apl_stats_get(apl_stats *st, apl_dp_stats *res)
+{
+	std::lock_guard<std::mutex> lock(st->mtx);
+
+	*res = st->res;
+}
+
+//******************************************************************************
+//! \brief        Copy histogram of last frame.
+//******************************************************************************
+uint32_t apl_stats_get_hist(apl_stats *st, uint32_t *hist)
+{
+	std::lock_guard<std::mutex> lock(st->mtx);
+
+	std::copy(st->hist, st->hist + APL_STATS_BIN_NUM, hist);
+
+	return 1U << st->bin_shift;
+}
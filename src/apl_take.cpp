@@ -0,0 +1,760 @@
+//******************************************************************************
+//! \file         apl_take.cpp
+//! \brief        take file of frames with crc32c and sequence, append-only index for random access.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdio_ext.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#endif
+
+#include "apl_take.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_CRC32C_POLY		(0x82F63B78U)		// reflected Castagnoli polynomial
+#define APL_TAKE_SCAN_SIZE	(64 * 1024)			// bytes read at once to find magic of record
+
+#if defined(__aarch64__) && !defined(HWCAP_CRC32)
+#define HWCAP_CRC32			(1 << 7)
+#endif
+
+// crc32c Of Reflected Register (No Inversion)
+typedef uint32_t (*apl_crc32c_fn)(uint32_t crc, const uint8_t *p, size_t len);
+
+// Implementation Chosen Once
+typedef struct {
+	apl_crc32c_fn	fn;
+	const char		*name;
+} apl_crc32c_sel;
+
+//******************************************************************************
+// Variables
+//******************************************************************************
+static uint32_t sCrcTbl[8][256];		// slicing-by-8 tables
+
+//******************************************************************************
+//! \brief        Tables of slicing-by-8.
+//******************************************************************************
+static void apl_crc32c_tbl_init(void)
+{
+	uint32_t n;
+	uint32_t k;
+
+	for (n = 0; n < 256; n++) {
+		uint32_t c = n;
+
+		for (k = 0; k < 8; k++) {
+			c = (c >> 1) ^ (APL_CRC32C_POLY & (0U - (c & 1)));
+		}
+		sCrcTbl[0][n] = c;
+	}
+	for (n = 0; n < 256; n++) {
+		for (k = 1; k < 8; k++) {
+			sCrcTbl[k][n] = (sCrcTbl[k - 1][n] >> 8) ^ sCrcTbl[0][sCrcTbl[k - 1][n] & 0xFF];
+		}
+	}
+}
+
+//******************************************************************************
+//! \brief        crc32c by tables, 8 bytes per step (little endian).
+//******************************************************************************
+static uint32_t apl_crc32c_sw(uint32_t crc, const uint8_t *p, size_t len)
+{
+	while ((len > 0) && (((uintptr_t)p & 7) != 0)) {
+		crc = sCrcTbl[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+		len--;
+	}
+	while (len >= 8) {
+		uint64_t v;
+
+		memcpy(&v, p, sizeof(v));
+		v ^= crc;
+		crc = sCrcTbl[7][v & 0xFF] ^ sCrcTbl[6][(v >> 8) & 0xFF] ^ sCrcTbl[5][(v >> 16) & 0xFF] ^ sCrcTbl[4][(v >> 24) & 0xFF]
+			^ sCrcTbl[3][(v >> 32) & 0xFF] ^ sCrcTbl[2][(v >> 40) & 0xFF] ^ sCrcTbl[1][(v >> 48) & 0xFF] ^ sCrcTbl[0][v >> 56];
+		p += 8;
+		len -= 8;
+	}
+	while (len > 0) {
+		crc = sCrcTbl[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+		len--;
+	}
+
+	return crc;
+}
+
+#if defined(__x86_64__)
+//******************************************************************************
+//! \brief        crc32c by SSE4.2 crc32 instruction, 8 bytes per instruction.
+//******************************************************************************
+__attribute__((target("sse4.2")))
+static uint32_t apl_crc32c_hw(uint32_t crc, const uint8_t *p, size_t len)
+{
+	uint64_t c = crc;
+
+	while ((len > 0) && (((uintptr_t)p & 7) != 0)) {
+		c = _mm_crc32_u8((uint32_t)c, *p++);
+		len--;
+	}
+	while (len >= 8) {
+		uint64_t v;
+
+		memcpy(&v, p, sizeof(v));
+		c = _mm_crc32_u64(c, v);
+		p += 8;
+		len -= 8;
+	}
+	while (len > 0) {
+		c = _mm_crc32_u8((uint32_t)c, *p++);
+		len--;
+	}
+
+	return (uint32_t)c;
+}
+
+//******************************************************************************
+//! \brief        Instruction is supported by cpu.
+//******************************************************************************
+static bool apl_crc32c_hw_on(void)
+{
+	return __builtin_cpu_supports("sse4.2") != 0;
+}
+
+#define APL_CRC32C_HW_NAME	"sse4.2"
+
+#elif defined(__aarch64__)
+//******************************************************************************
+//! \brief        crc32c by ARMv8 crc32c instructions, 8 bytes per instruction.
+//******************************************************************************
+__attribute__((target("+crc")))
+static uint32_t apl_crc32c_hw(uint32_t crc, const uint8_t *p, size_t len)
+{
+	while ((len > 0) && (((uintptr_t)p & 7) != 0)) {
+		crc = __crc32cb(crc, *p++);
+		len--;
+	}
+	while (len >= 8) {
+		uint64_t v;
+
+		memcpy(&v, p, sizeof(v));
+		crc = __crc32cd(crc, v);
+		p += 8;
+		len -= 8;
+	}
+	while (len > 0) {
+		crc = __crc32cb(crc, *p++);
+		len--;
+	}
+
+	return crc;
+}
+
+//******************************************************************************
+//! \brief        Instruction is supported by cpu.
+//******************************************************************************
+static bool apl_crc32c_hw_on(void)
+{
+	return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+
+#define APL_CRC32C_HW_NAME	"armv8-crc"
+
+#endif
+
+//******************************************************************************
+//! \brief        Implementation of cpu, chosen at first use.
+//******************************************************************************
+static const apl_crc32c_sel *apl_crc32c_get(void)
+{
+	static const apl_crc32c_sel sel = []() {
+		apl_crc32c_sel s;
+
+#if defined(APL_CRC32C_HW_NAME)
+		if (apl_crc32c_hw_on()) {
+			s.fn = apl_crc32c_hw;
+			s.name = APL_CRC32C_HW_NAME;
+			return s;
+		}
+#endif
+		apl_crc32c_tbl_init();
+		s.fn = apl_crc32c_sw;
+		s.name = "table";
+		return s;
+	}();
+
+	return &sel;
+}
+
+//******************************************************************************
+//! \brief        CRC-32C (Castagnoli).
+//******************************************************************************
+uint32_t apl_crc32c(uint32_t crc, const void *data, size_t len)
+{
+	return ~apl_crc32c_get()->fn(~crc, static_cast<const uint8_t *>(data), len);
+}
+
+//******************************************************************************
+//! \brief        Name of crc32c implementation in use.
+//******************************************************************************
+const char *apl_crc32c_impl(void)
+{
+	return apl_crc32c_get()->name;
+}
+
+//******************************************************************************
+//! \brief        File header of take or index.
+//******************************************************************************
+static void apl_take_file_hdr_make(apl_take_file_hdr *hdr, const char *magic)
+{
+	memcpy(hdr->magic, magic, sizeof(hdr->magic));
+	hdr->version = APL_TAKE_VERSION;
+	hdr->crc = apl_crc32c(0, hdr, offsetof(apl_take_file_hdr, crc));
+}
+
+//******************************************************************************
+//! \brief        File header is of magic and version.
+//******************************************************************************
+static bool apl_take_file_hdr_ok(const apl_take_file_hdr *hdr, const char *magic)
+{
+	return (memcmp(hdr->magic, magic, sizeof(hdr->magic)) == 0) && (hdr->version == APL_TAKE_VERSION)
+		&& (hdr->crc == apl_crc32c(0, hdr, offsetof(apl_take_file_hdr, crc)));
+}
+
+//******************************************************************************
+//! \brief        crc of header and plane table of frame.
+//******************************************************************************
+static uint32_t apl_take_hdr_crc(const apl_take_frame *frm)
+{
+	uint32_t crc;
+
+	crc = apl_crc32c(0, &frm->hdr, offsetof(apl_take_hdr, hdr_crc));
+	crc = apl_crc32c(crc, frm->plane, frm->hdr.plane_num * sizeof(apl_take_plane));
+
+	return crc;
+}
+
+//******************************************************************************
+//! \brief        Bytes of planes in table of frame.
+//******************************************************************************
+static uint64_t apl_take_plane_bytes(const apl_take_frame *frm)
+{
+	uint64_t bytes = 0;
+	uint16_t i;
+
+	for (i = 0; i < frm->hdr.plane_num; i++) {
+		bytes += (uint64_t)frm->plane[i].w * frm->plane[i].h * frm->plane[i].bpp;
+	}
+
+	return bytes;
+}
+
+//******************************************************************************
+//! \brief        Index entry of record.
+//******************************************************************************
+static void apl_take_idx_make(apl_take_idx *ent, const apl_take_frame *frm, uint64_t off)
+{
+	ent->off = off;
+	ent->seq = frm->hdr.seq;
+	ent->mono_ns = frm->hdr.mono_ns;
+	ent->idx = frm->hdr.idx;
+	ent->bytes = (uint32_t)apl_take_rec_bytes(frm);
+	ent->crc = apl_crc32c(0, ent, offsetof(apl_take_idx, crc));
+}
+
+//******************************************************************************
+//! \brief        Start frame to write.
+//******************************************************************************
+void apl_take_frame_init(apl_take_frame *frm, uint32_t idx, uint64_t seq, uint64_t mono_ns, uint64_t real_ns)
+{
+	memset(frm, 0, sizeof(*frm));
+	frm->hdr.magic = APL_TAKE_FRM_MAGIC;
+	frm->hdr.idx = idx;
+	frm->hdr.seq = seq;
+	frm->hdr.mono_ns = mono_ns;
+	frm->hdr.real_ns = real_ns;
+}
+
+//******************************************************************************
+//! \brief        Add plane to frame.
+//******************************************************************************
+void apl_take_frame_add(apl_take_frame *frm, const char *tag, uint16_t bpp, uint16_t w, uint16_t h, const void *data)
+{
+	apl_take_plane *pl;
+
+	if ((frm->hdr.plane_num >= APL_TAKE_PLANE_MAX) || (data == NULL)) {
+		return;
+	}
+
+	pl = &frm->plane[frm->hdr.plane_num];
+	pl->tag[0] = tag[0];
+	pl->tag[1] = tag[1];
+	pl->bpp = bpp;
+	pl->w = w;
+	pl->h = h;
+	frm->data[frm->hdr.plane_num] = data;
+	frm->hdr.plane_num++;
+}
+
+//******************************************************************************
+//! \brief        Create take and its index.
+//******************************************************************************
+int apl_take_open(apl_take_writer *wr, const char *fn, uint32_t sync)
+{
+	const std::string idx_fn = std::string(fn) + APL_TAKE_IDX_SUFFIX;
+	apl_take_file_hdr hdr;
+	apl_take_file_hdr idx_hdr;
+
+	wr->fp = NULL;
+	wr->idx = NULL;
+	wr->off = sizeof(apl_take_file_hdr);
+	wr->frames = 0;
+	wr->sync = sync;
+	wr->failed = false;
+
+	wr->fp = fopen(fn, "wb");
+	if (wr->fp == NULL) {
+		printf("fopen (%s) failed\n", fn);
+		return -1;
+	}
+	wr->idx = fopen(idx_fn.c_str(), "wb");
+	if (wr->idx == NULL) {
+		printf("fopen (%s) failed\n", idx_fn.c_str());
+		(void)fclose(wr->fp);
+		wr->fp = NULL;
+		return -1;
+	}
+
+	apl_take_file_hdr_make(&hdr, APL_TAKE_FILE_MAGIC);
+	apl_take_file_hdr_make(&idx_hdr, APL_TAKE_IDX_MAGIC);
+	(void)fwrite(&hdr, sizeof(hdr), 1, wr->fp);
+	(void)fwrite(&idx_hdr, sizeof(idx_hdr), 1, wr->idx);
+	(void)fflush(wr->fp);
+	(void)fflush(wr->idx);
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Append frame, then its index entry.
+//******************************************************************************
+int apl_take_write(apl_take_writer *wr, apl_take_frame *frm)
+{
+	apl_take_idx ent;
+	uint32_t crc = 0;
+	uint64_t payload = 0;
+	uint16_t i;
+
+	if (wr->failed) {
+		return -1;
+	}
+
+	//! \remark 1. crc Of Payload, Plane By Plane As Written.
+	for (i = 0; i < frm->hdr.plane_num; i++) {
+		const size_t bytes = (size_t)frm->plane[i].w * frm->plane[i].h * frm->plane[i].bpp;
+
+		crc = apl_crc32c(crc, frm->data[i], bytes);
+		payload += bytes;
+	}
+	if (payload > UINT32_MAX) {
+		printf("take : frame of %llu bytes is too large\n", (unsigned long long)payload);
+		return -1;
+	}
+	frm->hdr.payload = (uint32_t)payload;
+	frm->hdr.payload_crc = crc;
+	frm->hdr.hdr_crc = apl_take_hdr_crc(frm);
+
+	//! \remark 2. Record, Flushed To Kernel Before Index Entry Refers To It.
+	(void)fwrite(&frm->hdr, sizeof(frm->hdr), 1, wr->fp);
+	(void)fwrite(frm->plane, sizeof(apl_take_plane), frm->hdr.plane_num, wr->fp);
+	for (i = 0; i < frm->hdr.plane_num; i++) {
+		(void)fwrite(frm->data[i], (size_t)frm->plane[i].w * frm->plane[i].bpp, frm->plane[i].h, wr->fp);
+	}
+	if ((fflush(wr->fp) != 0) || (ferror(wr->fp) != 0)) {
+		// Unwritten Bytes Are Discarded And Partial Record Is Cut Off, So Index Stays Right
+		printf("fwrite (take) failed, take ends at frame %u\n", wr->frames);
+		__fpurge(wr->fp);
+		clearerr(wr->fp);
+		if (ftruncate(fileno(wr->fp), (off_t)wr->off) != 0) {
+			printf("ftruncate (take) failed\n");
+		}
+		wr->failed = true;
+		return -1;
+	}
+	if ((wr->sync > 0) && (((wr->frames + 1) % wr->sync) == 0)) {
+		(void)fdatasync(fileno(wr->fp));
+	}
+
+	//! \remark 3. Index Entry, Lost Entries Are Found Again By Scan Of Take.
+	apl_take_idx_make(&ent, frm, wr->off);
+	(void)fwrite(&ent, sizeof(ent), 1, wr->idx);
+	(void)fflush(wr->idx);
+
+	wr->off += apl_take_rec_bytes(frm);
+	wr->frames++;
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Close take and index.
+//******************************************************************************
+void apl_take_close(apl_take_writer *wr)
+{
+	if (wr->fp != NULL) {
+		(void)fflush(wr->fp);
+		(void)fdatasync(fileno(wr->fp));
+		(void)fclose(wr->fp);
+		wr->fp = NULL;
+	}
+	if (wr->idx != NULL) {
+		(void)fflush(wr->idx);
+		(void)fdatasync(fileno(wr->idx));
+		(void)fclose(wr->idx);
+		wr->idx = NULL;
+	}
+}
+
+//******************************************************************************
+//! \brief        Check file header of take.
+//******************************************************************************
+int apl_take_check(FILE *fp, uint64_t *size)
+{
+	apl_take_file_hdr hdr;
+	struct stat st;
+
+	if (fstat(fileno(fp), &st) != 0) {
+		return -1;
+	}
+	*size = (uint64_t)st.st_size;
+
+	if ((fseeko(fp, 0, SEEK_SET) != 0) || (fread(&hdr, sizeof(hdr), 1, fp) != 1)) {
+		return -1;
+	}
+	if (!apl_take_file_hdr_ok(&hdr, APL_TAKE_FILE_MAGIC)) {
+		return -1;
+	}
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Seek only if stream is elsewhere, so that sequential reads keep buffer of stream.
+//******************************************************************************
+static int apl_take_seek(FILE *fp, uint64_t off)
+{
+	if (ftello(fp) == (off_t)off) {
+		return 0;
+	}
+	return fseeko(fp, (off_t)off, SEEK_SET);
+}
+
+//******************************************************************************
+//! \brief        Offset of next magic of record at or after offset, size if none.
+//******************************************************************************
+static uint64_t apl_take_resync(FILE *fp, uint64_t size, uint64_t off)
+{
+	const uint32_t magic = APL_TAKE_FRM_MAGIC;
+	std::vector<uint8_t> buf(APL_TAKE_SCAN_SIZE);
+
+	while ((off + sizeof(magic)) <= size) {
+		const size_t len = (size_t)std::min<uint64_t>(buf.size(), size - off);
+		const uint8_t *p;
+
+		if ((apl_take_seek(fp, off) != 0) || (fread(buf.data(), 1, len, fp) != len)) {
+			break;
+		}
+		p = static_cast<const uint8_t *>(memmem(buf.data(), len, &magic, sizeof(magic)));
+		if (p != NULL) {
+			return off + (uint64_t)(p - buf.data());
+		}
+
+		// Magic May Straddle Chunks
+		off += len - (sizeof(magic) - 1);
+	}
+
+	return size;
+}
+
+//******************************************************************************
+//! \brief        Header and plane table of first valid record at or after offset.
+//******************************************************************************
+int apl_take_next(FILE *fp, uint64_t size, uint64_t *off, apl_take_frame *frm, uint64_t *skipped)
+{
+	uint64_t pos = *off;
+
+	while ((pos + sizeof(apl_take_hdr)) <= size) {
+		bool ok;
+
+		//! \remark 1. Header, Then Plane Table Of Its Count, crc Over Both.
+		ok = (apl_take_seek(fp, pos) == 0) && (fread(&frm->hdr, sizeof(frm->hdr), 1, fp) == 1)
+			&& (frm->hdr.magic == APL_TAKE_FRM_MAGIC) && (frm->hdr.plane_num <= APL_TAKE_PLANE_MAX);
+		ok = ok && (fread(frm->plane, sizeof(apl_take_plane), frm->hdr.plane_num, fp) == frm->hdr.plane_num);
+		ok = ok && (frm->hdr.hdr_crc == apl_take_hdr_crc(frm)) && (apl_take_plane_bytes(frm) == frm->hdr.payload);
+
+		if (ok) {
+			//! \remark 2. Record Cut By End Of Take (Crash While Writing) Is Not A Record.
+			if ((pos + apl_take_rec_bytes(frm)) > size) {
+				break;
+			}
+			memset(frm->data, 0, sizeof(frm->data));
+			if (skipped != NULL) {
+				*skipped += pos - *off;
+			}
+			*off = pos;
+			return 0;
+		}
+
+		//! \remark 3. Corrupt, Next Magic.
+		pos = apl_take_resync(fp, size, pos + 1);
+	}
+
+	if (skipped != NULL) {
+		*skipped += size - *off;
+	}
+	*off = size;
+
+	return -1;
+}
+
+//******************************************************************************
+//! \brief        Load entries of index that are consistent, stops at first that is not.
+//! \return       true          whole index is consistent
+//******************************************************************************
+static bool apl_take_idx_load(apl_take_reader *rd, const std::string &fn)
+{
+	apl_take_file_hdr hdr;
+	apl_take_idx ent;
+	uint64_t end = sizeof(apl_take_file_hdr);
+	bool ok = true;
+	FILE *fp;
+
+	fp = fopen(fn.c_str(), "rb");
+	if (fp == NULL) {
+		return false;
+	}
+	if ((fread(&hdr, sizeof(hdr), 1, fp) != 1) || !apl_take_file_hdr_ok(&hdr, APL_TAKE_IDX_MAGIC)) {
+		(void)fclose(fp);
+		return false;
+	}
+
+	while (fread(&ent, sizeof(ent), 1, fp) == 1) {
+		// Entry Itself, Records In Order, Within Take
+		if ((ent.crc != apl_crc32c(0, &ent, offsetof(apl_take_idx, crc)))
+		 || (ent.off < end) || ((ent.off + ent.bytes) > rd->size)
+		 || (!rd->idx.empty() && (ent.idx <= rd->idx.back().idx))) {
+			ok = false;
+			break;
+		}
+		rd->idx.push_back(ent);
+		end = ent.off + ent.bytes;
+	}
+	// Partial Entry At End (Crash While Appending)
+	if (ok && !feof(fp)) {
+		ok = false;
+	}
+	if (ok && (ftello(fp) != (off_t)(sizeof(hdr) + (rd->idx.size() * sizeof(ent))))) {
+		ok = false;
+	}
+
+	(void)fclose(fp);
+
+	return ok;
+}
+
+//******************************************************************************
+//! \brief        Write index again, replaced at once by rename.
+//******************************************************************************
+static int apl_take_idx_save(const apl_take_reader *rd, const std::string &fn)
+{
+	const std::string tmp = fn + ".tmp";
+	apl_take_file_hdr hdr;
+	FILE *fp;
+	bool ok;
+
+	fp = fopen(tmp.c_str(), "wb");
+	if (fp == NULL) {
+		printf("fopen (%s) failed\n", tmp.c_str());
+		return -1;
+	}
+
+	apl_take_file_hdr_make(&hdr, APL_TAKE_IDX_MAGIC);
+	(void)fwrite(&hdr, sizeof(hdr), 1, fp);
+	(void)fwrite(rd->idx.data(), sizeof(apl_take_idx), rd->idx.size(), fp);
+	ok = (fflush(fp) == 0) && (ferror(fp) == 0) && (fdatasync(fileno(fp)) == 0);
+	(void)fclose(fp);
+
+	if (!ok || (rename(tmp.c_str(), fn.c_str()) != 0)) {
+		printf("write (%s) failed\n", fn.c_str());
+		(void)unlink(tmp.c_str());
+		return -1;
+	}
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Open take for random access.
+//******************************************************************************
+int apl_take_ropen(apl_take_reader *rd, const char *fn, APL_TAKE_IDX_MODE mode)
+{
+	const std::string idx_fn = std::string(fn) + APL_TAKE_IDX_SUFFIX;
+	apl_take_frame frm;
+	uint64_t off = sizeof(apl_take_file_hdr);
+	size_t i;
+
+	rd->idx.clear();
+	rd->skipped = 0;
+	rd->idx_ok = false;
+	rd->rebuilt = false;
+
+	rd->fp = fopen(fn, "rb");
+	if (rd->fp == NULL) {
+		printf("fopen (%s) failed\n", fn);
+		return -1;
+	}
+	if (apl_take_check(rd->fp, &rd->size) != 0) {
+		printf("%s is not a take (version %d)\n", fn, APL_TAKE_VERSION);
+		(void)fclose(rd->fp);
+		rd->fp = NULL;
+		return -1;
+	}
+
+	//! \remark 1. Entries Of Index, Last One Must Point At Valid Record (Index Of Other Take, Take Cut Short).
+	if (mode != APL_TAKE_IDX_REBUILD) {
+		rd->idx_ok = apl_take_idx_load(rd, idx_fn);
+	}
+	while ((mode != APL_TAKE_IDX_READ) && !rd->idx.empty()) {
+		uint64_t at = rd->idx.back().off;
+
+		if ((apl_take_next(rd->fp, rd->size, &at, &frm, NULL) == 0) && (at == rd->idx.back().off)
+		 && (frm.hdr.idx == rd->idx.back().idx) && (frm.hdr.seq == rd->idx.back().seq)) {
+			break;
+		}
+		rd->idx.pop_back();
+		rd->idx_ok = false;
+	}
+
+	//! \remark 2. Gaps Between Entries Are Bytes Of No Record.
+	for (i = 0; i < rd->idx.size(); i++) {
+		rd->skipped += rd->idx[i].off - off;
+		off = rd->idx[i].off + rd->idx[i].bytes;
+	}
+
+	//! \remark 3. Records After Last Entry By Scan Of Headers Only, Index As Written Is Kept For Verification.
+	if (mode == APL_TAKE_IDX_READ) {
+		return 0;
+	}
+	while (apl_take_next(rd->fp, rd->size, &off, &frm, &rd->skipped) == 0) {
+		apl_take_idx ent;
+
+		apl_take_idx_make(&ent, &frm, off);
+		if (!rd->idx.empty() && (ent.idx <= rd->idx.back().idx)) {
+			// Frame Out Of Order (Stale Data Of Overwritten Take), Skipped
+			rd->skipped += ent.bytes;
+		}
+		else {
+			rd->idx.push_back(ent);
+			rd->idx_ok = false;
+		}
+		off += ent.bytes;
+	}
+
+	//! \remark 4. Index Written Again On Request Only, Reader Never Rewrites It Silently.
+	if (mode == APL_TAKE_IDX_REBUILD) {
+		rd->rebuilt = (apl_take_idx_save(rd, idx_fn) == 0);
+		rd->idx_ok = rd->rebuilt;
+	}
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Read frame of take by index entry.
+//******************************************************************************
+int apl_take_read(apl_take_reader *rd, size_t n, apl_take_frame *frm)
+{
+	const apl_take_idx *ent;
+	uint64_t off;
+	size_t pos = 0;
+	uint16_t i;
+
+	if (n >= rd->idx.size()) {
+		return -1;
+	}
+	ent = &rd->idx[n];
+	off = ent->off;
+
+	//! \remark 1. Header Where Index Points.
+	if ((apl_take_next(rd->fp, rd->size, &off, frm, NULL) != 0) || (off != ent->off) || (frm->hdr.idx != ent->idx)) {
+		printf("take : frame %u is not at %llu\n", ent->idx, (unsigned long long)ent->off);
+		return -1;
+	}
+
+	//! \remark 2. Payload And Its crc.
+	rd->buf.resize(frm->hdr.payload);
+	if (fread(rd->buf.data(), 1, frm->hdr.payload, rd->fp) != frm->hdr.payload) {
+		printf("take : frame %u is cut short\n", ent->idx);
+		return -1;
+	}
+	if (apl_crc32c(0, rd->buf.data(), frm->hdr.payload) != frm->hdr.payload_crc) {
+		printf("take : frame %u crc mismatch\n", ent->idx);
+		return -1;
+	}
+
+	for (i = 0; i < frm->hdr.plane_num; i++) {
+		frm->data[i] = rd->buf.data() + pos;
+		pos += (size_t)frm->plane[i].w * frm->plane[i].h * frm->plane[i].bpp;
+	}
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Entry of index of frame.
+//******************************************************************************
+size_t apl_take_find(const apl_take_reader *rd, uint32_t idx)
+{
+	std::vector<apl_take_idx>::const_iterator it;
+
+	it = std::lower_bound(rd->idx.begin(), rd->idx.end(), idx, [](const apl_take_idx &ent, uint32_t v) {
+		return ent.idx < v;
+	});
+	if ((it == rd->idx.end()) || (it->idx != idx)) {
+		return SIZE_MAX;
+	}
+
+	return (size_t)(it - rd->idx.begin());
+}
+
+//******************************************************************************
+//! \brief        Close take.
+//******************************************************************************
+void apl_take_rclose(apl_take_reader *rd)
+{
+	if (rd->fp != NULL) {
+		(void)fclose(rd->fp);
+		rd->fp = NULL;
+	}
+	rd->idx.clear();
+	std::vector<uint8_t>().swap(rd->buf);
+}
@@ -0,0 +1,375 @@
+//******************************************************************************
+//! \file         apl_telemetry.cpp
+//! \brief        frame loss and sensor-health telemetry.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <atomic>
+#include <chrono>
+
+#include "tl.h"
+#include "apl_dev.h"
+#include "apl_telemetry.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_TLM_SAMPLE_NUM		(APL_TLM_TEMP_WINDOW + 1)	// per second samples kept
+#define APL_TLM_IDX_MOD			(256)						// stFrmInfo::frm_index wraps at 256
+
+// Per Second Sample, Owned By Capture Thread
+typedef struct {
+	std::chrono::steady_clock::time_point	t;		// sampled time
+	uint64_t	frames;		// received images
+	uint64_t	lost;		// lost images
+	uint64_t	drop;		// pipeline drops
+	uint64_t	error;		// failed TL_capture
+	float		temp;		// temperature [degree]
+} apl_tlm_sample;
+
+static const uint32_t NOTIFY_FLAG[APL_TLM_NOTIFY_NUM] = {
+	 TL_NOTIFY_IMAGE
+	,TL_NOTIFY_NO_BUFFER
+	,TL_NOTIFY_DISCONNECT
+	,TL_NOTIFY_DEVICE_ERR
+	,TL_NOTIFY_SYSTEM_ERR
+	,TL_NOTIFY_STOPPED
+};
+
+static const char *NOTIFY_NAME[APL_TLM_NOTIFY_NUM] = { "image", "no_buffer", "disconnect", "device_err", "system_err", "stopped" };
+static const char *RESULT_NAME[APL_TLM_RESULT_NUM] = { "success", "param", "system", "state", "timeout", "empty", "not_support", "canceled", "other" };
+
+// Telemetry Of One Device
+typedef struct {
+	// Counters, Written By Capture Thread, Read By Any Thread
+	std::atomic<uint64_t>	capture;
+	std::atomic<uint64_t>	frames;
+	std::atomic<uint64_t>	lost;
+	std::atomic<uint64_t>	dup;
+	std::atomic<uint64_t>	frm_err;
+	std::atomic<uint64_t>	drop;
+	std::atomic<uint64_t>	error;
+	std::atomic<uint64_t>	notify[APL_TLM_NOTIFY_NUM];
+	std::atomic<uint64_t>	result[APL_TLM_RESULT_NUM];
+	std::atomic<float>		fps;
+	std::atomic<float>		lost_rate;
+	std::atomic<float>		drop_rate;
+	std::atomic<float>		err_rate;
+	std::atomic<float>		temp;
+	std::atomic<float>		temp_slope;
+
+	// State Of Capture Thread
+	uint16_t								mode_fps;		// nominal frame rate
+	bool									has_last;		// last_idx is valid
+	uint8_t									last_idx;		// last frm_index
+	std::chrono::steady_clock::time_point	last_tick;		// time of last image
+	apl_tlm_sample							sample[APL_TLM_SAMPLE_NUM];
+	size_t									sample_num;		// valid samples
+	size_t									sample_head;	// next sample to write
+} apl_tlm_dev;
+
+static apl_tlm_dev				sDev[APL_DEV_MAX];
+static std::atomic<size_t>		sDevNum(0);		// initialized devices (highest index + 1)
+
+//******************************************************************************
+//! \brief        Same frm_index as previous image is a duplicate, unless a whole wraparound has elapsed.
+//! \param[in]    td            telemetry of device.
+//! \param[in]    idx           frm_index of current image.
+//! \param[in]    dt            elapsed time from previous image [s].
+//******************************************************************************
+static bool apl_tlm_dup(const apl_tlm_dev *td, uint8_t idx, double dt)
+{
+	if (idx != td->last_idx) {
+		return false;
+	}
+
+	return (td->mode_fps == 0) || ((dt * td->mode_fps) < (APL_TLM_IDX_MOD / 2));
+}
+
+//******************************************************************************
+//! \brief        Images lost between two consecutive frm_index.
+//! \param[in]    td            telemetry of device.
+//! \param[in]    idx           frm_index of current image.
+//! \param[in]    dt            elapsed time from previous image [s].
+//******************************************************************************
+static uint64_t apl_tlm_gap(const apl_tlm_dev *td, uint8_t idx, double dt)
+{
+	uint64_t gap = (uint8_t)(idx - td->last_idx - 1U);
+	double expected;
+	double wraps;
+
+	// More Than One Wraparound Is Invisible In frm_index, Resolve It With Elapsed Time
+	if (td->mode_fps != 0) {
+		expected = (dt * td->mode_fps) - 1.0;
+		if (expected >= APL_TLM_IDX_MOD) {
+			wraps = floor(((expected - (double)gap) / APL_TLM_IDX_MOD) + 0.5);
+			gap += (uint64_t)((wraps > 0) ? wraps : 0) * APL_TLM_IDX_MOD;
+		}
+	}
+
+	return gap;
+}
+
+//******************************************************************************
+//! \brief        Take per second sample and update rolling rates.
+//******************************************************************************
+static void apl_tlm_sample_update(apl_tlm_dev *td, const std::chrono::steady_clock::time_point &now)
+{
+	const apl_tlm_sample *cur;
+	const apl_tlm_sample *old;
+	apl_tlm_sample *smp;
+	double dt;
+	double sx = 0;
+	double sy = 0;
+	double sxx = 0;
+	double sxy = 0;
+	double x;
+	double den;
+	size_t n;
+	size_t i;
+
+	if ((td->sample_num != 0) &&
+		((now - td->sample[(td->sample_head + APL_TLM_SAMPLE_NUM - 1) % APL_TLM_SAMPLE_NUM].t) < std::chrono::seconds(1))) {
+		return;
+	}
+
+	smp = &td->sample[td->sample_head];
+	smp->t      = now;
+	smp->frames = td->frames.load(std::memory_order_relaxed);
+	smp->lost   = td->lost.load(std::memory_order_relaxed);
+	smp->drop   = td->drop.load(std::memory_order_relaxed);
+	smp->error  = td->error.load(std::memory_order_relaxed);
+	smp->temp   = td->temp.load(std::memory_order_relaxed);
+	td->sample_head = (td->sample_head + 1) % APL_TLM_SAMPLE_NUM;
+	td->sample_num  = (td->sample_num < APL_TLM_SAMPLE_NUM) ? (td->sample_num + 1) : td->sample_num;
+
+	if (td->sample_num < 2) {
+		return;
+	}
+
+	// Rates Over Rate Window (Or All Samples While Starting)
+	n = (td->sample_num <= APL_TLM_RATE_WINDOW) ? td->sample_num : (APL_TLM_RATE_WINDOW + 1);
+	cur = smp;
+	old = &td->sample[(td->sample_head + APL_TLM_SAMPLE_NUM - n) % APL_TLM_SAMPLE_NUM];
+	dt = std::chrono::duration<double>(cur->t - old->t).count();
+	td->fps.store((float)((cur->frames - old->frames) / dt), std::memory_order_relaxed);
+	td->lost_rate.store((float)((cur->lost - old->lost) / dt), std::memory_order_relaxed);
+	td->drop_rate.store((float)((cur->drop - old->drop) / dt), std::memory_order_relaxed);
+	td->err_rate.store((float)((cur->error - old->error) / dt), std::memory_order_relaxed);
+
+	// Temperature Trend, Least Squares Slope Over Temperature Window
+	n = td->sample_num;
+	old = &td->sample[(td->sample_head + APL_TLM_SAMPLE_NUM - n) % APL_TLM_SAMPLE_NUM];
+	for (i = 0; i < n; i++) {
+		smp = &td->sample[(td->sample_head + APL_TLM_SAMPLE_NUM - n + i) % APL_TLM_SAMPLE_NUM];
+		x = std::chrono::duration<double>(smp->t - old->t).count() / 60.0;
+		sx  += x;
+		sy  += smp->temp;
+		sxx += x * x;
+		sxy += x * smp->temp;
+	}
+	den = (n * sxx) - (sx * sx);
+	td->temp_slope.store((den > 0) ? (float)(((n * sxy) - (sx * sy)) / den) : 0.0F, std::memory_order_relaxed);
+}
+
+//******************************************************************************
+//! \brief        Reset telemetry.
+//******************************************************************************
+void apl_tlm_init(uint8_t dev, uint16_t fps)
+{
+	apl_tlm_dev *td = &sDev[dev];
+	size_t i;
+
+	td->capture = 0;
+	td->frames = 0;
+	td->lost = 0;
+	td->dup = 0;
+	td->frm_err = 0;
+	td->drop = 0;
+	td->error = 0;
+	for (i = 0; i < APL_TLM_NOTIFY_NUM; i++) {
+		td->notify[i] = 0;
+	}
+	for (i = 0; i < APL_TLM_RESULT_NUM; i++) {
+		td->result[i] = 0;
+	}
+	td->fps = 0;
+	td->lost_rate = 0;
+	td->drop_rate = 0;
+	td->err_rate = 0;
+	td->temp = 0;
+	td->temp_slope = 0;
+
+	td->mode_fps = fps;
+	td->has_last = false;
+	td->sample_num = 0;
+	td->sample_head = 0;
+
+	if (sDevNum.load() <= dev) {
+		sDevNum = (size_t)dev + 1;
+	}
+}
+
+//******************************************************************************
+//! \brief        Ranging mode is changed, counters are kept.
+//******************************************************************************
+void apl_tlm_mode(uint8_t dev, uint16_t fps)
+{
+	apl_tlm_dev *td = &sDev[dev];
+
+	td->mode_fps = fps;
+	td->has_last = false;
+}
+
+//******************************************************************************
+//! \brief        Account result of one TL_capture.
+//******************************************************************************
+void apl_tlm_capture(uint8_t dev, TL_E_RESULT ret, uint32_t notify, const TL_Image *img)
+{
+	apl_tlm_dev *td = &sDev[dev];
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	size_t i;
+
+	td->capture.fetch_add(1, std::memory_order_relaxed);
+	if ((size_t)ret < APL_TLM_RESULT_NUM) {
+		td->result[ret].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (ret != TL_E_SUCCESS) {
+		td->error.fetch_add(1, std::memory_order_relaxed);
+	}
+	else {
+		for (i = 0; i < APL_TLM_NOTIFY_NUM; i++) {
+			if ((notify & NOTIFY_FLAG[i]) != 0U) {
+				td->notify[i].fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		if (((notify & (uint32_t)TL_NOTIFY_IMAGE) != 0U) && (img != NULL)) {
+			td->frames.fetch_add(1, std::memory_order_relaxed);
+			if (img->frm_info.frame_error) {
+				td->frm_err.fetch_add(1, std::memory_order_relaxed);
+			}
+			if (td->has_last) {
+				const double dt = std::chrono::duration<double>(now - td->last_tick).count();
+
+				if (apl_tlm_dup(td, img->frm_info.frm_index, dt)) {
+					td->dup.fetch_add(1, std::memory_order_relaxed);
+				}
+				else {
+					td->lost.fetch_add(apl_tlm_gap(td, img->frm_info.frm_index, dt), std::memory_order_relaxed);
+				}
+			}
+			td->has_last = true;
+			td->last_idx = img->frm_info.frm_index;
+			td->last_tick = now;
+			td->temp.store((float)img->temp / 100.0F, std::memory_order_relaxed);
+		}
+
+		// Sequence Restarts After Stop Or Disconnect
+		if ((notify & (uint32_t)(TL_NOTIFY_STOPPED | TL_NOTIFY_DISCONNECT)) != 0U) {
+			td->has_last = false;
+		}
+	}
+
+	apl_tlm_sample_update(td, now);
+}
+
+//******************************************************************************
+//! \brief        Account an image dropped by viewer pipeline.
+//******************************************************************************
+void apl_tlm_pipeline_drop(uint8_t dev)
+{
+	sDev[dev].drop.fetch_add(1, std::memory_order_relaxed);
+}
+
+//******************************************************************************
+//! \brief        Get snapshot of counters and rates.
+//******************************************************************************
+void apl_tlm_get(uint8_t dev, apl_tlm_snapshot *snap)
+{
+	const apl_tlm_dev *td = &sDev[dev];
+	size_t i;
+
+	snap->capture       = td->capture.load(std::memory_order_relaxed);
+	snap->frames        = td->frames.load(std::memory_order_relaxed);
+	snap->lost          = td->lost.load(std::memory_order_relaxed);
+	snap->duplicate     = td->dup.load(std::memory_order_relaxed);
+	snap->frame_error   = td->frm_err.load(std::memory_order_relaxed);
+	snap->pipeline_drop = td->drop.load(std::memory_order_relaxed);
+	for (i = 0; i < APL_TLM_NOTIFY_NUM; i++) {
+		snap->notify[i] = td->notify[i].load(std::memory_order_relaxed);
+	}
+	for (i = 0; i < APL_TLM_RESULT_NUM; i++) {
+		snap->result[i] = td->result[i].load(std::memory_order_relaxed);
+	}
+	snap->fps        = td->fps.load(std::memory_order_relaxed);
+	snap->lost_rate  = td->lost_rate.load(std::memory_order_relaxed);
+	snap->drop_rate  = td->drop_rate.load(std::memory_order_relaxed);
+	snap->error_rate = td->err_rate.load(std::memory_order_relaxed);
+	snap->temp       = td->temp.load(std::memory_order_relaxed);
+	snap->temp_slope = td->temp_slope.load(std::memory_order_relaxed);
+}
+
+//******************************************************************************
+//! \brief        Print snapshot.
+//******************************************************************************
+void apl_tlm_report(uint8_t dev, FILE *fp)
+{
+	apl_tlm_snapshot snap;
+	size_t i;
+
+	apl_tlm_get(dev, &snap);
+
+	fprintf(fp, "Telemetry (device %u):\n", dev);
+	fprintf(fp, "capture=%llu frames=%llu lost=%llu duplicate=%llu frame_error=%llu pipeline_drop=%llu\n",
+		(unsigned long long)snap.capture,
+		(unsigned long long)snap.frames,
+		(unsigned long long)snap.lost,
+		(unsigned long long)snap.duplicate,
+		(unsigned long long)snap.frame_error,
+		(unsigned long long)snap.pipeline_drop);
+	fprintf(fp, "fps=%.1f lost/s=%.2f drop/s=%.2f error/s=%.2f temp=%.2f C (%+.2f C/min)\n",
+		snap.fps, snap.lost_rate, snap.drop_rate, snap.error_rate, snap.temp, snap.temp_slope);
+	fprintf(fp, "notify :");
+	for (i = 0; i < APL_TLM_NOTIFY_NUM; i++) {
+		fprintf(fp, " %s=%llu", NOTIFY_NAME[i], (unsigned long long)snap.notify[i]);
+	}
+	fprintf(fp, "\nresult :");
+	for (i = 0; i < APL_TLM_RESULT_NUM; i++) {
+		fprintf(fp, " %s=%llu", RESULT_NAME[i], (unsigned long long)snap.result[i]);
+	}
+	fprintf(fp, "\n\n");
+}
+
+//******************************************************************************
+//! \brief        Number of initialized devices.
+//******************************************************************************
+size_t apl_tlm_dev_num(void)
+{
+	return sDevNum.load();
+}
+
+//******************************************************************************
+//! \brief        Name of counted notify flag.
+//******************************************************************************
+const char *apl_tlm_notify_name(size_t notify)
+{
+	return (notify < APL_TLM_NOTIFY_NUM) ? NOTIFY_NAME[notify] : "unknown";
+}
+
+//******************************************************************************
+//! \brief        Name of counted TL_capture result.
+//******************************************************************************
+const char *apl_tlm_result_name(size_t result)
+{
+	return (result < APL_TLM_RESULT_NUM) ? RESULT_NAME[result] : "unknown";
+}
@@ -0,0 +1,342 @@
+//******************************************************************************
+//! \file         apl_thread.cpp
+//! \brief        thread creation with scheduling policy, priority and cpu affinity per role.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "apl_cfg.h"
+#include "apl_thread.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define APL_THR_MAX_CPU		(64)	// cpus representable in cpu_mask
+
+// Created Thread Record
+typedef struct {
+	pthread_t		thr;		// thread
+	APL_THR_ROLE	role;		// role
+	std::string		name;		// thread name
+	apl_thr_sched	granted;	// granted setting
+	int				err;		// error of requested setting, 0 if granted as requested
+} apl_thr_rec;
+
+// Start Argument, Nice Value Is Applied In Thread Context
+typedef struct {
+	void			*(*fn)(void *);	// thread function
+	void			*arg;			// argument of thread function
+	int				nice;			// nice value for SCHED_OTHER
+	std::promise<int>	granted;	// nice value in effect, set by created thread
+} apl_thr_start;
+
+static const char *ROLE_NAME[APL_THR_ROLE_NUM] = { "capture", "process", "display", "recorder", "user_input", "service" };
+
+static apl_thr_sched			sReq[APL_THR_ROLE_NUM];	// requested setting
+static std::mutex				sRecMtx;				// mutex for sRec
+static std::vector<apl_thr_rec>	sRec;					// created threads
+
+//******************************************************************************
+//! \brief        Policy name.
+//******************************************************************************
+static const char *apl_thr_policy_name(int policy)
+{
+	switch (policy) {
+		case SCHED_FIFO:
+			return "fifo";
+		case SCHED_RR:
+			return "rr";
+		default:
+			return "other";
+	}
+}
+
+//******************************************************************************
+//! \brief        Parse cpu list, e.g. "4-7", "0,2,4", "all".
+//! \return       cpu mask, 0 for "all" or invalid list.
+//******************************************************************************
+static uint64_t apl_thr_parse_cpus(const char *str)
+{
+	uint64_t mask = 0;
+	char *end;
+	long first;
+	long last;
+
+	if (strcmp(str, "all") == 0) {
+		return 0;
+	}
+
+	while (*str != '\0') {
+		first = strtol(str, &end, 10);
+		if (end == str) {
+			return 0;
+		}
+		last = first;
+		str = end;
+		if (*str == '-') {
+			str++;
+			last = strtol(str, &end, 10);
+			if (end == str) {
+				return 0;
+			}
+			str = end;
+		}
+		for (; (first <= last) && (first < APL_THR_MAX_CPU); first++) {
+			mask |= (uint64_t)1U << first;
+		}
+		if (*str == ',') {
+			str++;
+		}
+		else
+		if (*str != '\0') {
+			return 0;
+		}
+	}
+
+	return mask;
+}
+
+//******************************************************************************
+//! \brief        Convert cpu mask to cpu_set_t.
+//******************************************************************************
+static void apl_thr_mask_to_set(uint64_t mask, cpu_set_t *set)
+{
+	int i;
+
+	CPU_ZERO(set);
+	for (i = 0; i < APL_THR_MAX_CPU; i++) {
+		if ((mask & ((uint64_t)1U << i)) != 0) {
+			CPU_SET(i, set);
+		}
+	}
+}
+
+//******************************************************************************
+//! \brief        Thread entry, apply nice value, report nice value in effect, then call thread function.
+//******************************************************************************
+static void *apl_thr_entry(void *data)
+{
+	apl_thr_start *start = static_cast<apl_thr_start *>(data);
+	void *(*fn)(void *) = start->fn;
+	void *arg = start->arg;
+	std::promise<int> granted(std::move(start->granted));
+	const id_t tid = (id_t)syscall(SYS_gettid);
+	int nice;
+
+	// Nice Value Is Per Thread On Linux
+	if (start->nice != 0) {
+		if (setpriority(PRIO_PROCESS, tid, start->nice) != 0) {
+			printf("setpriority(%d) failed(%d)\n", start->nice, errno);
+		}
+	}
+	delete start;
+
+	// Refused Or Clamped Nice Value Is Reported As It Is
+	errno = 0;
+	nice = getpriority(PRIO_PROCESS, tid);
+	granted.set_value((errno == 0) ? nice : 0);
+
+	return fn(arg);
+}
+
+//******************************************************************************
+//! \brief        Load scheduling setting of all roles from configuration.
+//******************************************************************************
+void apl_thr_load_cfg(void)
+{
+	char key[64];
+	char policy[16];
+	char cpus[128];
+	int prio;
+	int r;
+
+	for (r = 0; r < APL_THR_ROLE_NUM; r++) {
+		const char *val;
+
+		sReq[r].policy = SCHED_OTHER;
+		sReq[r].priority = 0;
+		sReq[r].cpu_mask = 0;
+
+		snprintf(key, sizeof(key), "thread.%s", ROLE_NAME[r]);
+		val = apl_cfg_get_str(key, NULL);
+		if (val == NULL) {
+			continue;
+		}
+
+		strcpy(cpus, "all");
+		if (sscanf(val, "%15s %d %127s", policy, &prio, cpus) < 2) {
+			printf("invalid %s = %s\n", key, val);
+			continue;
+		}
+
+		if (strcmp(policy, "fifo") == 0) {
+			sReq[r].policy = SCHED_FIFO;
+		}
+		else
+		if (strcmp(policy, "rr") == 0) {
+			sReq[r].policy = SCHED_RR;
+		}
+		sReq[r].priority = prio;
+		sReq[r].cpu_mask = apl_thr_parse_cpus(cpus);
+	}
+}
+
+//******************************************************************************
+//! \brief        Get requested scheduling setting of a role.
+//******************************************************************************
+const apl_thr_sched *apl_thr_get_req(APL_THR_ROLE role)
+{
+	return &sReq[role];
+}
+
+//******************************************************************************
+//! \brief        Create thread with scheduling setting of the role.
+//******************************************************************************
+int apl_thr_create(pthread_t *thr, APL_THR_ROLE role, const char *name, void *(*fn)(void *), void *arg)
+{
+	return apl_thr_create_on(thr, role, name, fn, arg, NULL);
+}
+
+//******************************************************************************
+//! \brief        Create thread with scheduling setting of the role, on given cpus unless cpus of the role are configured.
+//******************************************************************************
+int apl_thr_create_on(pthread_t *thr, APL_THR_ROLE role, const char *name, void *(*fn)(void *), void *arg, const cpu_set_t *cpus)
+{
+	const apl_thr_sched *req = &sReq[role];
+	pthread_attr_t attr;
+	struct sched_param prm;
+	cpu_set_t set;
+	apl_thr_rec rec;
+	apl_thr_start *start;
+	std::future<int> granted;
+	bool pin = false;
+	int nice;
+	int policy;
+	int i;
+	int ret;
+
+	nice = (req->policy == SCHED_OTHER) ? req->priority : 0;
+
+	// Released By Created Thread
+	start = new apl_thr_start;
+	start->fn = fn;
+	start->arg = arg;
+	start->nice = nice;
+	granted = start->granted.get_future();
+
+	rec.role = role;
+	rec.name = name;
+	rec.err = 0;
+
+	pthread_attr_init(&attr);
+	if (req->policy != SCHED_OTHER) {
+		memset(&prm, 0, sizeof(prm));
+		prm.sched_priority = req->priority;
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attr, req->policy);
+		pthread_attr_setschedparam(&attr, &prm);
+	}
+	if (req->cpu_mask != 0) {
+		apl_thr_mask_to_set(req->cpu_mask, &set);
+		pin = true;
+	}
+	else
+	if (cpus != NULL) {
+		set = *cpus;
+		pin = true;
+	}
+	if (pin) {
+		pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+	}
+
+	ret = pthread_create(thr, &attr, apl_thr_entry, start);
+	pthread_attr_destroy(&attr);
+
+	// Fallback, Real-Time Policy Or Cpus Refused (EPERM / EINVAL), Use Default Attributes
+	if ((ret != 0) && ((req->policy != SCHED_OTHER) || pin)) {
+		rec.err = ret;
+		ret = pthread_create(thr, NULL, apl_thr_entry, start);
+		if ((ret == 0) && pin) {
+			// Affinity Alone May Still Be Allowed, Granted Cpus Are Queried Below
+			if (pthread_setaffinity_np(*thr, sizeof(set), &set) != 0) {
+				printf("pthread_setaffinity_np(%s) failed\n", name);
+			}
+		}
+	}
+	if (ret != 0) {
+		delete start;
+		return -1;
+	}
+
+	pthread_setname_np(*thr, name);
+
+	// Query Granted Setting
+	rec.thr = *thr;
+	rec.granted.priority = 0;
+	rec.granted.cpu_mask = 0;
+	if (pthread_getschedparam(*thr, &policy, &prm) == 0) {
+		rec.granted.policy = policy;
+		rec.granted.priority = prm.sched_priority;
+	}
+	else {
+		rec.granted.policy = SCHED_OTHER;
+	}
+	if (rec.granted.policy == SCHED_OTHER) {
+		rec.granted.priority = granted.get();	// Applied In Thread Context, Value In Effect
+	}
+	if (pthread_getaffinity_np(*thr, sizeof(set), &set) == 0) {
+		for (i = 0; i < APL_THR_MAX_CPU; i++) {
+			if (CPU_ISSET(i, &set)) {
+				rec.granted.cpu_mask |= (uint64_t)1U << i;
+			}
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(sRecMtx);
+	sRec.push_back(rec);
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Print requested and granted scheduling setting of created threads.
+//******************************************************************************
+void apl_thr_report(void)
+{
+	std::lock_guard<std::mutex> lock(sRecMtx);
+
+	printf("Thread scheduling (requested -> granted):\n");
+	for (const apl_thr_rec &rec : sRec) {
+		const apl_thr_sched *req = &sReq[rec.role];
+
+		printf("%-15s %-10s : %s/%d cpus=0x%llx -> %s/%d cpus=0x%llx%s\n",
+			rec.name.c_str(),
+			ROLE_NAME[rec.role],
+			apl_thr_policy_name(req->policy), req->priority, (unsigned long long)req->cpu_mask,
+			apl_thr_policy_name(rec.granted.policy), rec.granted.priority, (unsigned long long)rec.granted.cpu_mask,
+			(rec.err != 0) ? " (fallback, need CAP_SYS_NICE or kernel.sched_rt_runtime_us)" :
+			((req->policy == SCHED_OTHER) && (rec.granted.priority != req->priority)) ? " (nice not granted, need CAP_SYS_NICE, -20..19)" : "");
+	}
+	printf("\n");
+}
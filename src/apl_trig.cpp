@@ -0,0 +1,339 @@
+//******************************************************************************
+//! \file         apl_trig.cpp
+//! \brief        pre-trigger ring of frames, dumped to raw files or take in background on trigger.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#include <algorithm>
+
+#include "apl_arena.h"
+#include "apl_thread.h"
+#include "apl_kernel.h"
+#include "apl_stamp.h"
+#include "apl_take.h"
+#include "apl_trig.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+static const char *PLANE_NAME[4] = { "dp", "ir", "cf", "rf" };
+
+//******************************************************************************
+//! \brief        Planes of frame buffer.
+//******************************************************************************
+static void *apl_trig_plane(TL_Image *img, int i)
+{
+	void *plane[4] = { img->depth, img->ir, img->confdata, img->irnrref };
+
+	return plane[i];
+}
+
+//******************************************************************************
+//! \brief        Write frozen ring to one take, oldest frame first.
+//******************************************************************************
+static void apl_trig_dump_take(apl_trig *trig, uint32_t first, const char *stamp)
+{
+	const TL_ImageFormat fmt[4] = { trig->reso.depth, trig->reso.ir, trig->reso.confdata, trig->reso.irnrref };
+	apl_take_writer wr;
+	apl_take_frame tf;
+	char fn[512];
+	uint32_t i;
+	int p;
+
+	snprintf(fn, sizeof(fn), "%s/trig_%s.take", trig->dir.c_str(), stamp);
+	if (apl_take_open(&wr, fn, 0) < 0) {
+		return;
+	}
+
+	for (i = 0; i < trig->count; i++) {
+		TL_Image *img = trig->slot[(first + i) % trig->num];
+		const apl_frm *frm = apl_frm_of(img);
+
+		apl_take_frame_init(&tf, i, frm->seq, frm->mono_ns, frm->real_ns);
+		for (p = 0; p < 4; p++) {
+			if (trig->siz[p] == 0) {
+				continue;
+			}
+			apl_take_frame_add(&tf, PLANE_NAME[p], sizeof(uint16_t), fmt[p].width, fmt[p].height, apl_trig_plane(img, p));
+		}
+		if (apl_take_write(&wr, &tf) < 0) {
+			break;
+		}
+	}
+	apl_take_close(&wr);
+
+	printf("trigger : %u frames %s saved, trigger at %04u\n", i, fn, trig->fire_at);
+}
+
+//******************************************************************************
+//! \brief        Write frozen ring, oldest frame first.
+//******************************************************************************
+static void apl_trig_dump(apl_trig *trig)
+{
+	const uint32_t first = (trig->head + trig->num - trig->count) % trig->num;
+	char stamp[32];
+	char fn[512];
+	uint32_t i;
+	int p;
+
+	FILE *fp;
+
+	strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&trig->fire_time));
+
+	// Take Carries Timestamps In Its Records
+	if (trig->take) {
+		apl_trig_dump_take(trig, first, stamp);
+		return;
+	}
+
+	// Capture Timestamps Of Frames
+	snprintf(fn, sizeof(fn), "%s/trig_%s_ts.csv", trig->dir.c_str(), stamp);
+	fp = fopen(fn, "w");
+	if (fp == NULL) {
+		printf("fopen (%s) failed\n", fn);
+		return;
+	}
+	fprintf(fp, "idx,seq,mono_ns,real_ns\n");
+	for (i = 0; i < trig->count; i++) {
+		const apl_frm *frm = apl_frm_of(trig->slot[(first + i) % trig->num]);
+
+		fprintf(fp, "%u,%llu,%llu,%llu\n", i, (unsigned long long)frm->seq,
+			(unsigned long long)frm->mono_ns, (unsigned long long)frm->real_ns);
+	}
+	fclose(fp);
+
+	for (i = 0; i < trig->count; i++) {
+		TL_Image *img = trig->slot[(first + i) % trig->num];
+
+		for (p = 0; p < 4; p++) {
+			if (trig->siz[p] == 0) {
+				continue;
+			}
+			snprintf(fn, sizeof(fn), "%s/trig_%s_%s%04u.raw", trig->dir.c_str(), stamp, PLANE_NAME[p], i);
+			if (apl_save_plane(fn, apl_trig_plane(img, p), trig->siz[p]) < 0) {
+				return;
+			}
+		}
+	}
+
+	printf("trigger : %u frames %s/trig_%s_{dp|ir|cf|rf}####.raw (+_ts.csv) saved, trigger at %04u\n",
+		trig->count, trig->dir.c_str(), stamp, trig->fire_at);
+}
+
+//******************************************************************************
+//! \brief        Frames of ring at frame rate, call with mtx locked while recording.
+//******************************************************************************
+static void apl_trig_size(apl_trig *trig, uint32_t fps)
+{
+	uint32_t pre;
+
+	// Post-Trigger Frames Include Frame Of Trigger
+	pre = (uint32_t)ceilf(std::max(trig->pre_sec, 0.0F) * fps);
+	trig->post = std::min(std::max((uint32_t)ceilf(std::max(trig->post_sec, 0.0F) * fps), 1U), trig->cap);
+	trig->num = std::min(pre + trig->post, trig->cap);
+	trig->head = 0;
+	trig->count = 0;
+	trig->fps_next = 0;
+}
+
+//******************************************************************************
+//! \brief        Dump thread.
+//******************************************************************************
+static void *apl_trig_thread(void *arg)
+{
+	apl_trig *trig = static_cast<apl_trig *>(arg);
+	std::unique_lock<std::mutex> lock(trig->mtx);
+
+	for (;;) {
+		trig->cv.wait(lock, [trig] { return trig->stop || (trig->state == APL_TRIG_STATE_DUMP); });
+		if (trig->state != APL_TRIG_STATE_DUMP) {
+			break;
+		}
+
+		// Ring Is Not Touched By apl_trig_put() While Dumped
+		lock.unlock();
+		apl_trig_dump(trig);
+		lock.lock();
+
+		trig->count = 0;
+		trig->fire = false;		// Triggers During Dump Are Not Queued
+		trig->state = APL_TRIG_STATE_RECORD;
+		if (trig->fps_next != 0) {
+			apl_trig_size(trig, trig->fps_next);
+		}
+	}
+
+	return NULL;
+}
+
+//******************************************************************************
+//! \brief        Allocate ring and start dump thread.
+//******************************************************************************
+int apl_trig_init(apl_trig *trig, TL_Resolution reso, uint32_t fps, uint32_t fps_max, float pre_sec, float post_sec,
+				  const char *dir, bool take)
+{
+	uint32_t i;
+	int p;
+
+	// Buffers For Fastest Mode, Switched Mode Uses Part Of Them
+	trig->pre_sec = pre_sec;
+	trig->post_sec = post_sec;
+	trig->cap = (uint32_t)ceilf(std::max(pre_sec, 0.0F) * std::max(fps, fps_max))
+			  + std::max((uint32_t)ceilf(std::max(post_sec, 0.0F) * std::max(fps, fps_max)), 1U);
+
+	trig->reso = reso;
+	trig->siz[0] = (size_t)reso.depth.width * reso.depth.height * sizeof(uint16_t);
+	trig->siz[1] = (size_t)reso.ir.width * reso.ir.height * sizeof(uint16_t);
+	trig->siz[2] = (size_t)reso.confdata.width * reso.confdata.height * sizeof(uint16_t);
+	trig->siz[3] = (size_t)reso.irnrref.width * reso.irnrref.height * sizeof(uint16_t);
+	trig->bytes = 0;
+
+	// Same Layout As Frame Buffers, Swapped With Them
+	trig->slot = new TL_Image *[trig->cap];
+	for (i = 0; i < trig->cap; i++) {
+		TL_Image *img = &(new apl_frm())->img;
+
+		img->depth    = apl_arena_alloc(trig->siz[0]);
+		img->ir       = apl_arena_alloc(trig->siz[1]);
+		img->confdata = apl_arena_alloc(trig->siz[2]);
+		img->irnrref  = apl_arena_alloc(trig->siz[3]);
+		trig->slot[i] = img;
+		for (p = 0; p < 4; p++) {
+			trig->bytes += trig->siz[p];
+		}
+	}
+
+	apl_trig_size(trig, fps);
+	trig->post_left = 0;
+	trig->fire_at = 0;
+	trig->fire = false;
+	trig->state = APL_TRIG_STATE_RECORD;
+	trig->stop = false;
+	trig->dir = dir;
+	trig->take = take;
+	trig->fired = 0;
+	trig->ignored = 0;
+
+	if (apl_thr_create(&trig->thr, APL_THR_ROLE_RECORDER, "tof_trig", apl_trig_thread, trig) != 0) {
+		trig->started = false;
+		apl_trig_term(trig);
+		return -1;
+	}
+	trig->started = true;
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Stop dump thread and free ring.
+//******************************************************************************
+void apl_trig_term(apl_trig *trig)
+{
+	uint32_t i;
+
+	if (trig->started) {
+		{
+			std::lock_guard<std::mutex> lock(trig->mtx);
+			trig->stop = true;
+		}
+		trig->cv.notify_one();
+		pthread_join(trig->thr, NULL);
+		trig->started = false;
+		printf("trigger : fired=%llu ignored=%llu\n", (unsigned long long)trig->fired, (unsigned long long)trig->ignored);
+	}
+
+	for (i = 0; i < trig->cap; i++) {
+		apl_arena_free(trig->slot[i]->depth);
+		apl_arena_free(trig->slot[i]->ir);
+		apl_arena_free(trig->slot[i]->confdata);
+		apl_arena_free(trig->slot[i]->irnrref);
+		delete apl_frm_of(trig->slot[i]);
+	}
+	delete[] trig->slot;
+	trig->slot = NULL;
+	trig->cap = 0;
+	trig->num = 0;
+}
+
+//******************************************************************************
+//! \brief        Resize ring to frame rate of switched mode.
+//******************************************************************************
+void apl_trig_fps(apl_trig *trig, uint32_t fps)
+{
+	std::lock_guard<std::mutex> lock(trig->mtx);
+
+	// Frames Of Trigger In Progress Are Kept Until Dumped
+	if (trig->state == APL_TRIG_STATE_RECORD) {
+		apl_trig_size(trig, fps);
+	}
+	else {
+		trig->fps_next = fps;
+	}
+}
+
+//******************************************************************************
+//! \brief        Record frame.
+//******************************************************************************
+void apl_trig_put(apl_trig *trig, TL_Image **frm)
+{
+	bool dump = false;
+
+	{
+		std::lock_guard<std::mutex> lock(trig->mtx);
+
+		//! \remark 1. Frozen While Dumped, Frame Goes Back As It Is.
+		if (trig->state == APL_TRIG_STATE_DUMP) {
+			if (trig->fire.exchange(false)) {
+				trig->ignored++;
+			}
+			return;
+		}
+
+		//! \remark 2. Swap With Oldest Buffer Of Ring.
+		std::swap(trig->slot[trig->head], *frm);
+		std::swap(apl_frm_of(trig->slot[trig->head])->fill, apl_frm_of(*frm)->fill);		// Masks, Normals And Rectified Planes
+		std::swap(apl_frm_of(trig->slot[trig->head])->nrm, apl_frm_of(*frm)->nrm);			// Stay With Frame Buffer,
+		std::swap(apl_frm_of(trig->slot[trig->head])->plane, apl_frm_of(*frm)->plane);
+		std::swap(apl_frm_of(trig->slot[trig->head])->fg, apl_frm_of(*frm)->fg);
+		std::swap(apl_frm_of(trig->slot[trig->head])->rect_dp, apl_frm_of(*frm)->rect_dp);	// Ring Does Not Keep Them
+		std::swap(apl_frm_of(trig->slot[trig->head])->rect_ir, apl_frm_of(*frm)->rect_ir);
+		trig->head = (trig->head + 1 == trig->num) ? 0 : (trig->head + 1);
+		trig->count = std::min(trig->count + 1, trig->num);
+
+		//! \remark 3. Trigger, This Frame Is First Of Post-Trigger.
+		if (trig->fire.exchange(false)) {
+			if (trig->state == APL_TRIG_STATE_RECORD) {
+				trig->state = APL_TRIG_STATE_POST;
+				trig->post_left = trig->post;
+				trig->fire_time = time(NULL);
+				trig->fired++;
+			}
+			else {
+				trig->ignored++;
+			}
+		}
+
+		//! \remark 4. Dump When Post-Trigger Frames Are In Ring.
+		if (trig->state == APL_TRIG_STATE_POST) {
+			trig->post_left--;
+			if (trig->post_left == 0) {
+				trig->fire_at = trig->count - std::min(trig->post, trig->count);
+				trig->state = APL_TRIG_STATE_DUMP;
+				dump = true;
+			}
+		}
+	}
+
+	if (dump) {
+		trig->cv.notify_one();
+	}
+}
@@ -0,0 +1,379 @@
+//******************************************************************************
+//! \file         tl_stub.cpp
+//! \brief        synthetic camera implementing tl.h, for running viewer without device.
+//! \details      Built instead of libcistof.so with -DCISTOF_STUB=ON. Images are a floor plane
+//!               with a moving box, saturated (invalid) pixels and temperature drift.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "tl.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define STUB_INVALID_DEPTH	(0x0FFF)	// saturated raw depth
+#define STUB_BG_PER_MILLE	(20)		// invalid pixels [1/1000]
+
+// Device Handle
+struct stTL_Handle {
+	TL_E_IMAGE_KIND							image_kind;
+	TL_E_MODE								mode;
+	bool									started;
+	bool									canceled;
+	uint64_t								seq;		// images generated
+	uint32_t								rnd;		// noise state
+	std::chrono::steady_clock::time_point	next;		// time of next image
+	std::mutex								mtx;
+	std::condition_variable					cv;
+};
+
+// Ranging Modes : enable, range_near, range_far, depth_unit, fps
+static const TL_ModeInfo MODE_INFO[TL_E_MODE_NUM] = {
+	 { TL_E_TRUE,   150, 1100, 1, 30 }
+	,{ TL_E_TRUE,   500, 4000, 1, 30 }
+	,{ TL_E_TRUE,   150, 1100, 1, 15 }
+	,{ TL_E_TRUE,   500, 4000, 1, 15 }
+	,{ TL_E_FALSE,    0,    0, 0,  0 }
+	,{ TL_E_FALSE,    0,    0, 0,  0 }
+};
+
+//******************************************************************************
+//! \brief        Image format of width x height, 16 bits per pixel.
+//******************************************************************************
+static TL_ImageFormat stub_fmt(uint16_t w, uint16_t h)
+{
+	TL_ImageFormat fmt;
+
+	fmt.width = w;
+	fmt.height = h;
+	fmt.stride = (uint16_t)(w * sizeof(uint16_t));
+	fmt.bit_per_pixel = 16;
+
+	return fmt;
+}
+
+//******************************************************************************
+//! \brief        Resolution of image kind.
+//******************************************************************************
+static TL_Resolution stub_reso(TL_E_IMAGE_KIND kind)
+{
+	TL_Resolution reso;
+	TL_ImageFormat vga = stub_fmt(640, 480);
+	TL_ImageFormat qvga = stub_fmt(320, 240);
+
+	switch (kind) {
+		case TL_E_IMAGE_KIND_VGA_DEPTH_QVGA_IR_BG:
+			reso.depth = vga;
+			reso.ir = qvga;
+			break;
+		case TL_E_IMAGE_KIND_QVGA_DEPTH_IR_BG:
+			reso.depth = qvga;
+			reso.ir = qvga;
+			break;
+		case TL_E_IMAGE_KIND_VGA_IR_QVGA_DEPTH:
+			reso.depth = qvga;
+			reso.ir = vga;
+			break;
+		case TL_E_IMAGE_KIND_VGA_DEPTH_IR:
+		case TL_E_IMAGE_KIND_VGA_IR_BG:
+		default:
+			reso.depth = vga;
+			reso.ir = vga;
+			break;
+	}
+	reso.confdata = reso.depth;
+	reso.irnrref = reso.ir;
+
+	return reso;
+}
+
+//******************************************************************************
+//! \brief        Pseudo random number (xorshift32).
+//******************************************************************************
+static uint32_t stub_rand(uint32_t *state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x;
+}
+
+//******************************************************************************
+//! \brief        Generate one image.
+//******************************************************************************
+static void stub_make_image(TL_Handle *handle, TL_Image *image)
+{
+	const TL_Resolution reso = stub_reso(handle->image_kind);
+	const TL_ModeInfo *info = &MODE_INFO[handle->mode];
+	const double t = (double)handle->seq / (info->fps != 0 ? info->fps : 30);
+	const double near_mm = info->range_near;
+	const double far_mm = info->range_far;
+	uint16_t *dp = static_cast<uint16_t *>(image->depth);
+	uint16_t *ir = static_cast<uint16_t *>(image->ir);
+	size_t w = reso.depth.width;
+	size_t h = reso.depth.height;
+	size_t x;
+	size_t y;
+
+	// Box Moves Left And Right Over The Floor
+	double box_cx = (0.5 + (0.3 * sin(t * 0.8))) * w;
+	double box_half = w / 8.0;
+	double box_mm = near_mm + ((far_mm - near_mm) * 0.35);
+
+	for (y = 0; y < h; y++) {
+		// Floor : Far At Top, Near At Bottom
+		double floor_mm = far_mm - ((far_mm - near_mm) * 0.8 * (double)y / (double)h);
+
+		for (x = 0; x < w; x++) {
+			double d = floor_mm;
+			uint32_t r = stub_rand(&handle->rnd);
+
+			if ((fabs((double)x - box_cx) < box_half) && (y > (h / 4)) && (y < ((3 * h) / 4))) {
+				d = box_mm;
+			}
+			d += (double)(int32_t)(r % 9U) - 4.0;
+
+			dp[(y * w) + x] = ((r >> 16) % 1000U < STUB_BG_PER_MILLE) ? STUB_INVALID_DEPTH :
+							  (uint16_t)(d / (info->depth_unit != 0 ? info->depth_unit : 1));
+		}
+	}
+
+	// IR : Falls With Square Of Distance (Sampled From Depth If Sizes Differ)
+	for (y = 0; y < reso.ir.height; y++) {
+		for (x = 0; x < reso.ir.width; x++) {
+			uint16_t d = dp[((y * h / reso.ir.height) * w) + (x * w / reso.ir.width)];
+			double v = (d == STUB_INVALID_DEPTH) ? 1023.0 : (4.0e7 / ((double)d * d));
+
+			ir[(y * reso.ir.width) + x] = (uint16_t)((v > 1023.0) ? 1023.0 : v);
+		}
+	}
+
+	memset(&image->frm_info, 0, sizeof(image->frm_info));
+	image->frm_info.frm_index = (uint8_t)handle->seq;
+	image->frm_info.pair_idx = (uint8_t)handle->mode;
+	image->frm_info.temp = (float)(40.0 + (5.0 * sin(t / 60.0)));
+	image->frm_info.mp_temp_crct.is_updated = (handle->seq == 0);
+	image->frm_info.mp_temp_crct.slope = 0;		// no profile, see depth.tcc
+	image->temp = (int32_t)(image->frm_info.temp * 100);
+
+	handle->seq++;
+}
+
+//******************************************************************************
+//! \brief        initialize devices
+//******************************************************************************
+TL_E_RESULT TL_init(TL_Handle **handle, const TL_Param *param)
+{
+	if ((handle == NULL) || (param == NULL) || (param->image_kind >= TL_E_IMAGE_KIND_MAX)) {
+		return TL_E_ERR_PARAM;
+	}
+
+	*handle = new TL_Handle;
+	(*handle)->image_kind = param->image_kind;
+	(*handle)->mode = TL_E_MODE_0;
+	(*handle)->started = false;
+	(*handle)->canceled = false;
+	(*handle)->seq = 0;
+	(*handle)->rnd = 2463534242U;
+
+	printf("TL stub : synthetic camera, no device is used\n");
+
+	return TL_E_SUCCESS;
+}
+
+//******************************************************************************
+//! \brief        terminate devices
+//******************************************************************************
+TL_E_RESULT TL_term(TL_Handle **handle)
+{
+	if ((handle == NULL) || (*handle == NULL)) {
+		return TL_E_ERR_PARAM;
+	}
+
+	delete *handle;
+	*handle = NULL;
+
+	return TL_E_SUCCESS;
+}
+
+//******************************************************************************
+//! \brief        start to receive images
+//******************************************************************************
+TL_E_RESULT TL_start(TL_Handle *handle)
+{
+	if (handle == NULL) {
+		return TL_E_ERR_PARAM;
+	}
+
+	std::lock_guard<std::mutex> lock(handle->mtx);
+	handle->started = true;
+	handle->canceled = false;
+	handle->next = std::chrono::steady_clock::now();
+
+	return TL_E_SUCCESS;
+}
+
+//******************************************************************************
+//! \brief        stop to receive images
+//******************************************************************************
+TL_E_RESULT TL_stop(TL_Handle *handle)
+{
+	if (handle == NULL) {
+		return TL_E_ERR_PARAM;
+	}
+
+	std::lock_guard<std::mutex> lock(handle->mtx);
+	handle->started = false;
+	handle->cv.notify_all();
+
+	return TL_E_SUCCESS;
+}
+
+//******************************************************************************
+//! \brief        get property
+//******************************************************************************
+TL_E_RESULT TL_getProperty(TL_Handle *handle, TL_E_CMD command, void* arg)
+{
+	if ((handle == NULL) || (arg == NULL)) {
+		return TL_E_ERR_PARAM;
+	}
+
+	switch (command) {
+		case TL_CMD_DEVICE_INFO: {
+			TL_DeviceInfo *info = static_cast<TL_DeviceInfo *>(arg);
+			memset(info, 0, sizeof(*info));
+			strcpy(info->mod_name, "STUB");
+			strcpy(info->afe_name, "STUB");
+			strcpy(info->sns_name, "STUB");
+			strcpy(info->lns_name, "STUB");
+			info->mod_type2 = 940;
+			break;
+		}
+		case TL_CMD_FOV: {
+			TL_Fov *fov = static_cast<TL_Fov *>(arg);
+			fov->focal_length = 200;	// 2.00 mm
+			fov->angle_h = 7000;		// 70.00 degree
+			fov->angle_v = 5400;		// 54.00 degree
+			break;
+		}
+		case TL_CMD_RESOLUTION:
+			*static_cast<TL_Resolution *>(arg) = stub_reso(handle->image_kind);
+			break;
+		case TL_CMD_MODE:
+			*static_cast<TL_E_MODE *>(arg) = handle->mode;
+			break;
+		case TL_CMD_MODE_INFO: {
+			TL_ModeInfoGroup *grp = static_cast<TL_ModeInfoGroup *>(arg);
+			grp->fbf = TL_E_FALSE;
+			memcpy(grp->mode, MODE_INFO, sizeof(grp->mode));
+			break;
+		}
+		case TL_CMD_LENS_INFO: {
+			TL_LensPrm *lens = static_cast<TL_LensPrm *>(arg);
+			TL_Resolution reso = stub_reso(handle->image_kind);
+			memset(lens, 0, sizeof(*lens));
+			lens->sns_h = reso.depth.width;
+			lens->sns_v = reso.depth.height;
+			lens->center_h = reso.depth.width / 2;
+			lens->center_v = reso.depth.height / 2;
+			lens->pixel_pitch = (reso.depth.width == 640) ? 500 : 1000;	// 5 um at VGA
+			break;
+		}
+		default:
+			return TL_E_ERR_NOT_SUPPORT;
+	}
+
+	return TL_E_SUCCESS;
+}
+
+//******************************************************************************
+//! \brief        set property
+//******************************************************************************
+TL_E_RESULT TL_setProperty(TL_Handle *handle, TL_E_CMD command, void* arg)
+{
+	TL_E_MODE mode;
+
+	if ((handle == NULL) || (arg == NULL)) {
+		return TL_E_ERR_PARAM;
+	}
+	if (command != TL_CMD_MODE) {
+		return TL_E_ERR_NOT_SUPPORT;
+	}
+
+	mode = *static_cast<TL_E_MODE *>(arg);
+	if ((mode >= TL_E_MODE_NUM) || (MODE_INFO[mode].enable != TL_E_TRUE)) {
+		return TL_E_ERR_PARAM;
+	}
+	handle->mode = mode;
+
+	return TL_E_SUCCESS;
+}
+
+//******************************************************************************
+//! \brief        capture image, blocks until next image of mode frame rate.
+//******************************************************************************
+TL_E_RESULT TL_capture(TL_Handle *handle, uint32_t *notify, TL_Image *image)
+{
+	if ((handle == NULL) || (notify == NULL) || (image == NULL)) {
+		return TL_E_ERR_PARAM;
+	}
+
+	std::unique_lock<std::mutex> lock(handle->mtx);
+
+	*notify = 0U;
+	if (!handle->started) {
+		return TL_E_ERR_STATE;
+	}
+
+	handle->cv.wait_until(lock, handle->next, [handle] { return handle->canceled || !handle->started; });
+	if (handle->canceled) {
+		handle->canceled = false;
+		return TL_E_ERR_CANCELED;
+	}
+	if (!handle->started) {
+		*notify = TL_NOTIFY_STOPPED;
+		return TL_E_SUCCESS;
+	}
+
+	// Keep Frame Rate, But Do Not Burst After Late Capture
+	handle->next += std::chrono::microseconds(1000000 / MODE_INFO[handle->mode].fps);
+	handle->next = std::max(handle->next, std::chrono::steady_clock::now());
+	stub_make_image(handle, image);
+	*notify = TL_NOTIFY_IMAGE;
+
+	return TL_E_SUCCESS;
+}
+
+//******************************************************************************
+//! \brief        cancel capture
+//******************************************************************************
+TL_E_RESULT TL_cancel(TL_Handle *handle)
+{
+	if (handle == NULL) {
+		return TL_E_ERR_PARAM;
+	}
+
+	std::lock_guard<std::mutex> lock(handle->mtx);
+	handle->canceled = true;
+	handle->cv.notify_all();
+
+	return TL_E_SUCCESS;
+}
@@ -17,13 +17,18 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <errno.h>
 
 #include <cstring>
 #include <chrono>
 #include <thread>
 #include <forward_list>
+#include <deque>
+#include <condition_variable>
 #include <mutex>
+#include <atomic>
 #include <ctime>
+#include <cmath>
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui/highgui.hpp>
@@ -31,6 +36,31 @@
 
 #include "tl.h"
 #include "tl_log.h"
+#include "apl_cfg.h"
+#include "apl_thread.h"
+#include "apl_pool.h"
+#include "apl_kernel.h"
+#include "apl_telemetry.h"
+#include "apl_stats.h"
+#include "apl_roi.h"
+#include "apl_metrics.h"
+#include "apl_arena.h"
+#include "apl_lens.h"
+#include "apl_scan.h"
+#include "apl_bg.h"
+#include "apl_plane.h"
+#include "apl_jbu.h"
+#include "apl_fly.h"
+#include "apl_fill.h"
+#include "apl_nrm.h"
+#include "apl_rect.h"
+#include "apl_mesh.h"
+#include "apl_rec.h"
+#include "apl_trig.h"
+#include "apl_ctl.h"
+#include "apl_stamp.h"
+#include "apl_take.h"
+#include "apl_dev.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -54,11 +84,16 @@ extern "C"
 #define OPENCV_WINDOW_NAME_BG								"BG image"
 #define OPENCV_WINDOW_NAME_CONFDATA							"CONFDATA image"
 #define OPENCV_WINDOW_NAME_IRNRREF							"IRNRREF image"
+#define OPENCV_WINDOW_NAME_NORMAL							"Normal image"
 #define OPENCV_TRACKBAR_NAME_GAMMA_CORR_IR					"IR Gamma Correction (slider/10)"
 #define OPENCV_TRACKBAR_NAME_GAMMA_CORR_BG					"BG Gamma Correction (slider/10)"
 
 #define OPENCV_TRACKBAR_NAME_TOGGLE_CONFDAT					"Conf Data View :                \t\t\t"
 #define OPENCV_TRACKBAR_NAME_TOGGLE_IRNRREF					"IRNRREF View :                  \t\t\t"
+#define OPENCV_TRACKBAR_NAME_TOGGLE_AUTORANGE				"Depth Auto Range :              \t\t\t"
+#define OPENCV_TRACKBAR_NAME_TOGGLE_NORMAL					"Normal View :                   \t\t\t"
+
+#define AUTO_RANGE_STEP_DIV						(64)	// auto range is quantized to (range / 64), limits color table rebuild
 
 // Image Size
 typedef struct {
@@ -68,41 +103,117 @@ typedef struct {
 	size_t	irnrref;	// irnrref image
 } apl_img_size;
 
-// Application Paramters
+// Application Paramters, Shared By Devices
 typedef struct {
-	TL_Handle			*handle;		// camera handle
-	TL_ModeInfoGroup	mode_info_grp;	// Each ranging mode info
-	TL_DeviceInfo		device_info;	// Device info
-	TL_Fov				fov;			// FOV info
-	TL_LensPrm			lens_info;		// Lens info
-	TL_E_MODE			mode;			// User's selected ranging mode
+	TL_E_MODE			mode;			// User's selected ranging mode (cam<n>.mode overrides it)
 	TL_E_IMAGE_KIND		image_kind;		// User's selected image kind, type of output image
-	TL_Resolution		resolution;		// resolution of images
-	apl_img_size		img_size;		// image size
+	uint8_t				dev_num;		// devices driven by this process
 	bool				view_confdat_on;	// ConfData view on/off
 	bool				view_irnrref_on;	// IrNrRef view on/off
+	bool				view_auto_range_on;	// Depth color range from statistics on/off
+	bool				view_normal_on;		// Normal view on/off
 	bool				view_bef_enh_on;	// Image before Enhance feature on/off
 } __attribute__((aligned(8))) apl_prm;
 
-static const uint16_t	RAW12_INVALID_DEPTH = 0x0FFFU;	/*!< invalid depth in RAW12 format */
-static const uint16_t	INVALID_DEPTH = 0xFFFFU;		/*!< invalid depth */
-
-static apl_prm gPrm;			// application parameters
-static bool bExit = false;		// false = Run Program, true = Exit Program.
-
-static uint8_t							FRM_BUF_CNT = 1U;	// maximum of frame buffer
-static std::mutex						sBufMtx;			// mutex for buffer, queue
-static std::forward_list<TL_Image *>	sFreeBuf;			// free buffer list
-static std::mutex mutexUserInput;							// mutex
-static std::string userInput;								// user input
-
-static unsigned int start = 0;
-static unsigned int end = 0;
-static unsigned int fps = 0;
-static unsigned int calcfps = 0;
-
-pthread_t threadusrinp;		// View Thread (Handle User Input)
-pthread_t threadview;		// View Thread (Handle Depth View, IR View)
+// Device Context, One Per Sensor : Handle, Frame Pool, Pipeline Stages, Capture Thread And Statistics
+typedef struct {
+	uint8_t				idx;			// device index, telemetry and timestamps of device
+	TL_Handle			*handle;		// camera handle
+	TL_ModeInfoGroup	mode_info_grp;	// Each ranging mode info
+	TL_DeviceInfo		device_info;	// Device info
+	TL_Fov				fov;			// FOV info
+	TL_LensPrm			lens_info;		// Lens info
+	TL_E_MODE			mode;			// ranging mode of device, capture thread only once started (frames carry it)
+	TL_Resolution		resolution;		// resolution of images (depth is after upsampling)
+	TL_ImageFormat		dp_raw;			// depth format from library, before upsampling
+	apl_img_size		img_size;		// image size
+	apl_dp_cnv			dp_cnv;			// depth conversion (unit, temperature correction)
+
+	// Stages Of Capture Thread
+	apl_fly				fly;			// flying pixel filter of depth as captured
+	apl_lens			fly_lens;		// lens model of depth as captured (3D test of fly)
+	bool				fly_on;			// flying pixel filter on/off
+	apl_stats			stats;			// depth statistics
+	apl_fill			fill;			// hole filling of depth guided by ir
+	bool				fill_on;		// hole filling on/off
+	apl_nrm				nrm;			// surface normals of depth
+	bool				nrm_on;			// surface normals on/off
+	apl_rect			rect;			// rectification of depth (and of ir of depth size)
+	apl_rect			rect_ir;		// rectification of ir of other size
+	apl_rect_coef		rect_coef;		// distortion of lens
+	bool				rect_on;		// rectification on/off
+	bool				rect_ir_own;	// ir has own table (size differs from depth)
+	bool				rect_view;		// rectified planes are shown
+	bool				rect_save;		// rectified planes are saved (and kept by pre-trigger ring)
+	bool				rect_cloud;		// rectified planes feed 3D stages (normal, plane, scan, mesh)
+	uint8_t				*rect_fill;		// rectified mask of filled depth, skipped by roi of rectified view
+	apl_roi				roi;			// depth summed-area tables
+	apl_jbu				jbu;			// depth upsampling guided by ir
+	void				*jbu_out;		// upsampled depth, swapped with depth plane of frame
+	bool				jbu_on;			// depth upsampling on/off
+	apl_lens			lens;			// lens model of depth image
+	apl_scan			scan;			// depth to laser scan
+	bool				scan_on;		// laser scan on/off
+	apl_bg				bg;				// depth background model
+	bool				bg_on;			// background model on/off
+	apl_plane			plane;			// floor plane
+	bool				plane_on;		// floor plane on/off
+
+	// Pre-Trigger Ring, Fed By View Thread
+	apl_trig			trig;
+	bool				trig_on;		// pre-trigger ring on/off
+	bool				trig_on_blob;	// trigger on first foreground blob
+	size_t				blob_prev;		// blobs of previous frame
+
+	// Mesh Export, Fed By View Thread
+	apl_mesh_out		mesh;
+	bool				mesh_on;		// mesh export on/off
+
+	// Frame Pool, Capture Thread -> View Thread
+	std::mutex						buf_mtx;	// mutex for buffer, queue
+	std::forward_list<TL_Image *>	free_buf;	// free buffer list
+	std::deque<TL_Image *>			rdy_buf;	// captured buffer queue
+	apl_ctl_queue					cap_ctl;	// commands to capture thread (start, stop, mode)
+	std::atomic<bool>				cap_stop;	// capture is stopped by command
+	pthread_t						thr_cap;	// capture thread (TL_capture, depth conversion, stages)
+
+	// Frame Rate, Counted By Capture Thread
+	unsigned int		fps_start;
+	unsigned int		fps_cnt;
+	unsigned int		calcfps;
+
+	// Saving, View Thread Only
+	uint16_t			save_req;		// frames to save, requested by command
+	uint16_t			save_idx;		// next frame of take
+	uint16_t			save_cnt;		// frames of take, 0 = not saving
+	char				save_time[32];	// time of take
+	TL_E_MODE			save_mode;		// ranging mode of take
+	bool				save_take;		// take is one file of records (crc32c, index) instead of raw files
+	uint32_t			save_sync;		// frames between fdatasync of take, 0 = closed take only
+	apl_take_writer		take;			// take being saved (save_take)
+
+	// Windows, View Thread Only
+	TL_E_MODE			view_mode;		// ranging mode of last frame shown
+	apl_color_lut		color_lut;		// depth color table
+	int32_t				gamma_corr_ir;	// IR gamma x10 (OpenCV TrackBar)
+	std::chrono::steady_clock::time_point	tick_fps;	// previous frame shown
+	cv::Mat				mat_ir;			// gamma corrected images, frame is kept as captured
+	cv::Mat				mat_confdata;
+	cv::Mat				mat_irnrref;
+	cv::Mat				mat_normal;		// color of normals
+} apl_dev;
+
+static apl_prm gPrm;					// application parameters
+static apl_dev *sDev[APL_DEV_MAX];		// device contexts, gPrm.dev_num are used
+static bool bExit = false;				// false = Run Program, true = Exit Program.
+
+static const uint8_t					FRM_BUF_CNT = 3U;	// maximum of frame buffer, per device
+static std::mutex						sRdyMtx;			// mutex for sRdyNum
+static std::condition_variable			sRdyCv;				// signal captured buffer of any device
+static uint32_t							sRdyNum = 0;		// buffers queued since view thread woke
+static apl_ctl_queue					sViewCtl;			// commands to view thread (save, view)
+
+pthread_t threadview;		// View Thread (Handle Depth View, IR View Of All Devices)
 
 #if USE_OPEN_CV_COLOR_MAP
 #else
@@ -114,19 +225,19 @@ class fwc::ColorTable* color_tbl;
 //******************************************************************************
 static void apl_print_error(TL_E_RESULT ret, char *function, unsigned int line);	// TODO remove
 
-void apl_cnv_dp(TL_Resolution reso, TL_Image *stData, uint16_t unit);
-void apl_show_img(TL_E_MODE mode, TL_E_IMAGE_KIND img_kind, TL_Resolution reso, TL_Image *stData);
-void *user_input_thread(void *);
+void apl_show_img(apl_dev *dev, TL_Image *stData);
+void *capture_thread(void *);
 void *view_thread(void *);
 
 
 //******************************************************************************
 //! \brief	allocate list of frame buffer
+//! \param	[in]	dev			device
 //! \param	[in]	buf_num		number of frame buffer
 //******************************************************************************
-void apl_frmbuf_alloc(uint8_t buf_num, TL_Resolution reso)
+void apl_frmbuf_alloc(apl_dev *dev, uint8_t buf_num, TL_Resolution reso)
 {
-	uint8_t i, n;
+	uint8_t i;
 	uint32_t siz_dp;	// depth
 	uint32_t siz_ir;	// ir
 	uint32_t siz_cf;	// confdata
@@ -138,41 +249,73 @@ void apl_frmbuf_alloc(uint8_t buf_num, TL_Resolution reso)
 	siz_rf = reso.irnrref.width * reso.irnrref.height;
 
 	for (i = 0; i < buf_num; i++) {
-		TL_Image* buf = new TL_Image;
+		TL_Image* buf = &(new apl_frm())->img;	// Timestamps Follow The Buffer
+
+		// Planes From Arena, Aligned And Zero Filled
+		buf->depth    = apl_arena_alloc(siz_dp * sizeof(uint16_t));
+		buf->ir       = apl_arena_alloc(siz_ir * sizeof(uint16_t));
+		buf->confdata = apl_arena_alloc(siz_cf * sizeof(uint16_t));
+		buf->irnrref  = apl_arena_alloc(siz_rf * sizeof(uint16_t));
+
+		// Mask Of Filled Depth, Only When Holes Are Filled
+		if (dev->fill_on) {
+			apl_frm_of(buf)->fill = static_cast<uint8_t *>(apl_arena_alloc(siz_dp * sizeof(uint8_t)));
+		}
 
-		buf->depth    = new uint16_t[siz_dp];
-		std::fill_n(static_cast<uint16_t *>(buf->depth),    siz_dp, 0);
+		// Packed Normals, Only When Normals Are Computed
+		if (dev->nrm_on) {
+			apl_frm_of(buf)->nrm = static_cast<uint32_t *>(apl_arena_alloc(siz_dp * sizeof(uint32_t)));
+		}
 
-		buf->ir       = new uint16_t[siz_ir];
-		std::fill_n(static_cast<uint16_t *>(buf->ir),       siz_ir, 0);
+		// Foreground Mask, Only When Background Is Modeled
+		if (dev->bg_on) {
+			apl_frm_of(buf)->fg = static_cast<uint8_t *>(apl_arena_alloc(siz_dp * sizeof(uint8_t)));
+		}
 
-		buf->confdata = new uint16_t[siz_cf];
-		std::fill_n(static_cast<uint16_t *>(buf->confdata), siz_cf, 0);
+		// Inlier Mask Of Floor Plane, Only When Plane Is Fitted
+		if (dev->plane_on) {
+			apl_frm_of(buf)->plane = static_cast<uint8_t *>(apl_arena_alloc(siz_dp * sizeof(uint8_t)));
+		}
 
-		buf->irnrref  = new uint16_t[siz_rf];
-		std::fill_n(static_cast<uint16_t *>(buf->irnrref),  siz_rf, 0);
+		// Rectified Depth And IR, Only When Rectified
+		if (dev->rect_on) {
+			apl_frm_of(buf)->rect_dp = static_cast<uint16_t *>(apl_arena_alloc(siz_dp * sizeof(uint16_t)));
+			apl_frm_of(buf)->rect_ir = static_cast<uint16_t *>(apl_arena_alloc(siz_ir * sizeof(uint16_t)));
+		}
 
-		sFreeBuf.push_front(buf);
+		dev->free_buf.push_front(buf);
 	}
 }
 
 
 //******************************************************************************
 //! \brief	free list of frame buffer
+//! \param	[in]	dev			device
 //******************************************************************************
-void apl_frmbuf_free(void)
+void apl_frmbuf_free(apl_dev *dev)
 {
-	std::lock_guard<std::mutex> lock(sBufMtx);
+	std::lock_guard<std::mutex> lock(dev->buf_mtx);
 
-	while (!sFreeBuf.empty()) {
-		TL_Image* buf = sFreeBuf.front();
-		sFreeBuf.pop_front();
+	while (!dev->rdy_buf.empty()) {
+		dev->free_buf.push_front(dev->rdy_buf.front());
+		dev->rdy_buf.pop_front();
+	}
 
-		delete[] static_cast<uint16_t *>(buf->depth);
-		delete[] static_cast<uint16_t *>(buf->ir);
-		delete[] static_cast<uint16_t *>(buf->confdata);
-		delete[] static_cast<uint16_t *>(buf->irnrref);
-		delete buf;
+	while (!dev->free_buf.empty()) {
+		TL_Image* buf = dev->free_buf.front();
+		dev->free_buf.pop_front();
+
+		apl_arena_free(buf->depth);
+		apl_arena_free(buf->ir);
+		apl_arena_free(buf->confdata);
+		apl_arena_free(buf->irnrref);
+		apl_arena_free(apl_frm_of(buf)->fill);
+		apl_arena_free(apl_frm_of(buf)->nrm);
+		apl_arena_free(apl_frm_of(buf)->plane);
+		apl_arena_free(apl_frm_of(buf)->fg);
+		apl_arena_free(apl_frm_of(buf)->rect_dp);
+		apl_arena_free(apl_frm_of(buf)->rect_ir);
+		delete apl_frm_of(buf);
 		buf = nullptr;
 	}
 }
@@ -180,18 +323,26 @@ void apl_frmbuf_free(void)
 
 //******************************************************************************
 //! \brief	get frame buffer
+//! \param	[in]	dev		device
 //! \param	[out]	buf		frame buffer pointer
 //******************************************************************************
-int apl_frmbuf_get(TL_Image** buf)
+int apl_frmbuf_get(apl_dev *dev, TL_Image** buf)
 {
-	std::lock_guard<std::mutex> lock(sBufMtx);
+	std::lock_guard<std::mutex> lock(dev->buf_mtx);
 
-	if (sFreeBuf.empty()) {
-		return -1;
+	if (dev->free_buf.empty()) {
+		// View Is Behind, Drop The Oldest Captured Frame
+		if (dev->rdy_buf.empty()) {
+			return -1;
+		}
+		*buf = dev->rdy_buf.front();
+		dev->rdy_buf.pop_front();
+		apl_tlm_pipeline_drop(dev->idx);
+		return 0;
 	}
 
-	*buf = sFreeBuf.front();
-	sFreeBuf.pop_front();
+	*buf = dev->free_buf.front();
+	dev->free_buf.pop_front();
 
 	return 0;
 }
@@ -199,176 +350,273 @@ int apl_frmbuf_get(TL_Image** buf)
 
 //******************************************************************************
 //! \brief	release frame buffer
+//! \param	[in]		dev		device
 //! \param	[in,out]	buf		frame buffer pointer
 //******************************************************************************
-void apl_frmbuf_rel(TL_Image** buf)
+void apl_frmbuf_rel(apl_dev *dev, TL_Image** buf)
 {
-	std::lock_guard<std::mutex> lock(sBufMtx);
+	std::lock_guard<std::mutex> lock(dev->buf_mtx);
 
-	sFreeBuf.push_front(*buf);
+	dev->free_buf.push_front(*buf);
 	*buf = nullptr;
 }
 
 
 //******************************************************************************
-//! \brief  Get User Input From Keyboard
-//! \param  [in]    None
-//! \param  [out]   User Input String
+//! \brief	queue captured frame buffer to view thread
+//! \param	[in]		dev		device
+//! \param	[in,out]	buf		frame buffer pointer
+//******************************************************************************
+void apl_frmbuf_put_rdy(apl_dev *dev, TL_Image** buf)
+{
+	{
+		std::lock_guard<std::mutex> lock(dev->buf_mtx);
+		dev->rdy_buf.push_back(*buf);
+		*buf = nullptr;
+	}
+
+	// One View Thread For All Devices, Wake It Whichever Device Captured
+	{
+		std::lock_guard<std::mutex> lock(sRdyMtx);
+		sRdyNum++;
+	}
+	sRdyCv.notify_one();
+}
+
+
+//******************************************************************************
+//! \brief	wait captured frame buffer of any device
+//! \param	[in]	ms		timeout [ms]
+//! \return	0		success
+//! \return	-1		timeout
 //******************************************************************************
-std::string apl_get_usr_inp(void)
+int apl_frmbuf_wait_rdy(unsigned int ms)
 {
-	std::string retInput = "";
-	std::lock_guard<std::mutex> lock(mutexUserInput);
+	std::unique_lock<std::mutex> lock(sRdyMtx);
+
+	if (!sRdyCv.wait_for(lock, std::chrono::milliseconds(ms), [] { return sRdyNum != 0; })) {
+		return -1;
+	}
+	sRdyNum = 0;
+
+	return 0;
+}
+
 
-	if (!userInput.empty()) {
-		// Copy The Shared Variable To Return
-		retInput = userInput;
+//******************************************************************************
+//! \brief	get captured frame buffer
+//! \param	[in]	dev		device
+//! \param	[out]	buf		frame buffer pointer
+//! \return	0		success
+//! \return	-1		no captured frame buffer
+//******************************************************************************
+int apl_frmbuf_get_rdy(apl_dev *dev, TL_Image** buf)
+{
+	std::lock_guard<std::mutex> lock(dev->buf_mtx);
 
-		// Clear The Input
-		userInput.clear();
+	if (dev->rdy_buf.empty()) {
+		return -1;
 	}
 
-	return retInput;
+	*buf = dev->rdy_buf.front();
+	dev->rdy_buf.pop_front();
+
+	return 0;
+}
+
+
+//******************************************************************************
+//! brief       File name prefix of take, mode#_<time> (cam#_mode#_<time> when several devices)
+//! param[in]   dev                device
+//! param[out]  pfx                prefix
+//! param[in]   siz                size of prefix
+//! return none
+//******************************************************************************
+static void apl_save_prefix(const apl_dev *dev, char *pfx, size_t siz)
+{
+	if (gPrm.dev_num > 1) {
+		snprintf(pfx, siz, "cam%u_mode%d_%s", dev->idx, dev->save_mode+1, dev->save_time);	// Mode+1 For Index From 1 (Although Code Is Index From 0)
+	}
+	else {
+		snprintf(pfx, siz, "mode%d_%s", dev->save_mode+1, dev->save_time);
+	}
 }
 
 
 //******************************************************************************
-//! \brief  Release User Input String Buffer
-//! \param  [in,out]    None
+//! brief       Save frame as record of take, planes and timestamps in one write with crc32c
+//! param[in]   dev                device
+//! param[in]   stData             image data
+//! param[in]   plane_dp           depth plane to save
+//! param[in]   plane_ir           ir plane to save
+//! return      0                  success
+//! return      -1                 write failed
 //******************************************************************************
-void apl_rel_usr_inp(void)
+static int apl_save_take(apl_dev *dev, TL_Image *stData, const void *plane_dp, const void *plane_ir)
 {
-	std::lock_guard<std::mutex> lock(mutexUserInput);
-	userInput.clear();  // Clear the input
+	const TL_Resolution &reso = dev->resolution;
+	const apl_frm *frm = apl_frm_of(stData);
+	apl_take_frame tf;
+
+	apl_take_frame_init(&tf, dev->save_idx, frm->seq, frm->mono_ns, frm->real_ns);
+	apl_take_frame_add(&tf, "dp", 2, reso.depth.width, reso.depth.height, plane_dp);
+	apl_take_frame_add(&tf, "ir", 2, reso.ir.width, reso.ir.height, plane_ir);
+	apl_take_frame_add(&tf, "cf", 2, reso.confdata.width, reso.confdata.height, stData->confdata);
+	apl_take_frame_add(&tf, "rf", 2, reso.irnrref.width, reso.irnrref.height, stData->irnrref);
+	apl_take_frame_add(&tf, "fm", 1, reso.depth.width, reso.depth.height, frm->fill);
+	apl_take_frame_add(&tf, "nm", 4, reso.depth.width, reso.depth.height, frm->nrm);
+	apl_take_frame_add(&tf, "pm", 1, reso.depth.width, reso.depth.height, frm->plane);
+	apl_take_frame_add(&tf, "bm", 1, reso.depth.width, reso.depth.height, frm->fg);
+
+	return apl_take_write(&dev->take, &tf);
 }
 
 
 //******************************************************************************
 //! brief       Save File
-//! param[in]   mode               camera mode
+//! param[in]   dev                device
 //! param[in]   data               image data
-//! param[in]   size               image size
 //! return none
 //******************************************************************************
-static void apl_save_file(TL_E_MODE mode, TL_Resolution reso, TL_Image *stData)
+static void apl_save_file(apl_dev *dev, TL_Image *stData)
 {
-	std::string tmpStr = "";
-	static uint16_t idx = 0;
-	static uint16_t fileSaveCnt = 0;
+	const TL_Resolution &reso = dev->resolution;
+	void *plane_dp = dev->rect_save ? apl_frm_of(stData)->rect_dp : stData->depth;	// rectified or as captured
+	void *plane_ir = dev->rect_save ? apl_frm_of(stData)->rect_ir : stData->ir;
 	std::time_t timeRaw;
 	std::tm* timeInfo;
-	static char strTime[256];
+	char pfx[64];
 	char fn[256];
-	FILE  *fp;
-	size_t  ret;
-	size_t  data_size;
-	uint8_t *p_data;
 
 	if (stData == NULL) {
 		printf("image data is null\n");
 		return;
 	}
 
-	if (fileSaveCnt == 0) {
-		tmpStr = apl_get_usr_inp();
-		if (tmpStr != "") {
-			fileSaveCnt = std::stoi(tmpStr);
+	if (dev->save_cnt == 0) {
+		if (dev->save_req != 0) {
+			dev->save_cnt = dev->save_req;
+			dev->save_req = 0;
 
 			std::time(&timeRaw);
 			timeInfo = std::localtime(&timeRaw);
-			std::strftime(strTime, sizeof(strTime), "%Y%m%d_%H%M%S", timeInfo);
+			std::strftime(dev->save_time, sizeof(dev->save_time), "%Y%m%d_%H%M%S", timeInfo);
+			dev->save_mode = apl_frm_of(stData)->mode;
+
+			// Lens Of Take, Point Clouds Are Made Offline From It (viewer_convert)
+			apl_save_prefix(dev, pfx, sizeof(pfx));
+			snprintf(fn, sizeof(fn), "%s_lens.conf", pfx);
+			(void)apl_lens_save(fn, &dev->lens_info, &dev->fov);
+			(void)apl_rect_save(fn, &dev->rect_coef, dev->rect_save);
+
+			// Take File, Index Is <pfx>.take.idx (viewer_take)
+			if (dev->save_take) {
+				snprintf(fn, sizeof(fn), "%s.take", pfx);
+				if (apl_take_open(&dev->take, fn, dev->save_sync) < 0) {
+					dev->save_cnt = 0;
+				}
+			}
 		}
+		return;
 	}
-	else {
-		data_size = reso.depth.height * reso.depth.width * 2;
-		p_data = (uint8_t *)stData->depth;
-		snprintf(fn, sizeof(fn), "mode%d_%s_dp%04d.raw", mode+1, strTime, idx);	// Mode+1 For Index From 1 (Although Code Is Index From 0)
 
-		fp = fopen(fn, "wb");
-		if (fp == NULL) {
-			printf("fopen (%s) failed\n", fn);
+	apl_save_prefix(dev, pfx, sizeof(pfx));
+
+	if (dev->save_take) {
+		if (apl_save_take(dev, stData, plane_dp, plane_ir) < 0) {
+			// Take Is Valid Up To Last Frame Written, Not Retried With Next Frame
+			apl_take_close(&dev->take);
+			std::cout << "Take " << pfx << ".take cut short, " << dev->save_idx << " of " << dev->save_cnt << " frames saved." << std::endl;
+			dev->save_idx = 0;
+			dev->save_cnt = 0;
+			memset(dev->save_time, 0, sizeof(dev->save_time));
 			return;
 		}
-
-		ret = fwrite((const void*)p_data, data_size, 1, fp);
-		if ((ret != (size_t)1) &&
-			(ferror(fp) != 0) &&
-			(feof(fp) != 0)) {
-			printf("fwrite (%s) failed(%d/%d)\n", fn, (int)ret, ferror(fp));
-			clearerr(fp);
+		dev->save_idx++;
+		if (dev->save_idx >= dev->save_cnt) {
+			apl_take_close(&dev->take);
+			std::cout << "Total of " << dev->save_cnt << " frames " << pfx << ".take (+.idx) being saved." << std::endl;
+			// Clean Up
+			dev->save_idx = 0;
+			dev->save_cnt = 0;
+			memset(dev->save_time, 0, sizeof(dev->save_time));
 		}
+		return;
+	}
 
-		(void)fclose(fp);
-
-		data_size = reso.ir.height * reso.ir.width * 2;
-		p_data = (uint8_t *)stData->ir;
-		snprintf(fn, sizeof(fn), "mode%d_%s_ir%04d.raw", mode+1, strTime, idx);
-
-		fp = fopen(fn, "wb");
-		if (fp == NULL) {
-			printf("fopen (%s) failed\n", fn);
-			return;
-		}
+	snprintf(fn, sizeof(fn), "%s_dp%04d.raw", pfx, dev->save_idx);
+	if (apl_save_plane(fn, plane_dp, reso.depth.height * reso.depth.width * 2) < 0) {
+		return;
+	}
 
-		ret = fwrite((const void*)p_data, data_size, 1, fp);
-		if ((ret != (size_t)1) &&
-			(ferror(fp) != 0) &&
-			(feof(fp) != 0)) {
-			printf("fwrite (%s) failed(%d/%d)\n", fn, (int)ret, ferror(fp));
-			clearerr(fp);
-		}
+	snprintf(fn, sizeof(fn), "%s_ir%04d.raw", pfx, dev->save_idx);
+	if (apl_save_plane(fn, plane_ir, reso.ir.height * reso.ir.width * 2) < 0) {
+		return;
+	}
 
-		(void)fclose(fp);
+	snprintf(fn, sizeof(fn), "%s_cf%04d.raw", pfx, dev->save_idx);
+	if (apl_save_plane(fn, stData->confdata, reso.confdata.height * reso.confdata.width * 2) < 0) {
+		return;
+	}
 
-		data_size = reso.confdata.height * reso.confdata.width * 2;
-		p_data = (uint8_t *)stData->confdata;
-		snprintf(fn, sizeof(fn), "mode%d_%s_cf%04d.raw", mode+1, strTime, idx);
+	snprintf(fn, sizeof(fn), "%s_rf%04d.raw", pfx, dev->save_idx);
+	if (apl_save_plane(fn, stData->irnrref, reso.irnrref.height * reso.irnrref.width * 2) < 0) {
+		return;
+	}
 
-		fp = fopen(fn, "wb");
-		if (fp == NULL) {
-			printf("fopen (%s) failed\n", fn);
+	// Mask Of Filled Depth, 1 Byte Per Pixel Of Depth
+	if (apl_frm_of(stData)->fill != NULL) {
+		snprintf(fn, sizeof(fn), "%s_fm%04d.raw", pfx, dev->save_idx);
+		if (apl_save_plane(fn, apl_frm_of(stData)->fill, reso.depth.height * reso.depth.width) < 0) {
 			return;
 		}
+	}
 
-		ret = fwrite((const void*)p_data, data_size, 1, fp);
-		if ((ret != (size_t)1) &&
-			(ferror(fp) != 0) &&
-			(feof(fp) != 0)) {
-			printf("fwrite (%s) failed(%d/%d)\n", fn, (int)ret, ferror(fp));
-			clearerr(fp);
+	// Packed Normals, 4 Bytes Per Pixel Of Depth
+	if (apl_frm_of(stData)->nrm != NULL) {
+		snprintf(fn, sizeof(fn), "%s_nm%04d.raw", pfx, dev->save_idx);
+		if (apl_save_plane(fn, apl_frm_of(stData)->nrm, reso.depth.height * reso.depth.width * 4) < 0) {
+			return;
 		}
+	}
 
-		(void)fclose(fp);
-
-		data_size = reso.irnrref.height * reso.irnrref.width * 2;
-		p_data = (uint8_t *)stData->irnrref;
-		snprintf(fn, sizeof(fn), "mode%d_%s_rf%04d.raw", mode+1, strTime, idx);
-
-		fp = fopen(fn, "wb");
-		if (fp == NULL) {
-			printf("fopen (%s) failed\n", fn);
+	// Inlier Mask Of Floor Plane, 1 Byte Per Pixel Of Depth
+	if (apl_frm_of(stData)->plane != NULL) {
+		snprintf(fn, sizeof(fn), "%s_pm%04d.raw", pfx, dev->save_idx);
+		if (apl_save_plane(fn, apl_frm_of(stData)->plane, reso.depth.height * reso.depth.width) < 0) {
 			return;
 		}
+	}
 
-		ret = fwrite((const void*)p_data, data_size, 1, fp);
-		if ((ret != (size_t)1) &&
-			(ferror(fp) != 0) &&
-			(feof(fp) != 0)) {
-			printf("fwrite (%s) failed(%d/%d)\n", fn, (int)ret, ferror(fp));
-			clearerr(fp);
+	// Foreground Mask, 1 Byte Per Pixel Of Depth
+	if (apl_frm_of(stData)->fg != NULL) {
+		snprintf(fn, sizeof(fn), "%s_bm%04d.raw", pfx, dev->save_idx);
+		if (apl_save_plane(fn, apl_frm_of(stData)->fg, reso.depth.height * reso.depth.width) < 0) {
+			return;
 		}
+	}
 
-		(void)fclose(fp);
-
-		idx++;
-		if (idx >= fileSaveCnt) {
-			std::cout << "Total of " << fileSaveCnt << " files mode#_" << strTime << "_{dp|ir|cf|rf}####.raw being saved." << std::endl;
-			// Clean Up
-			idx = 0;
-			fileSaveCnt = 0;
-			memset(&strTime, 0, sizeof(strTime));
-			apl_rel_usr_inp();
-		}
+	// Capture Timestamps, One Line Per Frame
+	snprintf(fn, sizeof(fn), "%s_ts.csv", pfx);
+	FILE *fp = fopen(fn, (dev->save_idx == 0) ? "w" : "a");
+	if (fp == NULL) {
+		printf("fopen (%s) failed\n", fn);
+		return;
+	}
+	if (dev->save_idx == 0) {
+		fprintf(fp, "idx,seq,mono_ns,real_ns\n");
+	}
+	fprintf(fp, "%u,%llu,%llu,%llu\n", dev->save_idx, (unsigned long long)apl_frm_of(stData)->seq,
+		(unsigned long long)apl_frm_of(stData)->mono_ns, (unsigned long long)apl_frm_of(stData)->real_ns);
+	fclose(fp);
+
+	dev->save_idx++;
+	if (dev->save_idx >= dev->save_cnt) {
+		std::cout << "Total of " << dev->save_cnt << " files " << pfx << "_{dp|ir|cf|rf}####.raw (+_ts.csv) being saved." << std::endl;
+		// Clean Up
+		dev->save_idx = 0;
+		dev->save_cnt = 0;
+		memset(dev->save_time, 0, sizeof(dev->save_time));
 	}
 }
 
@@ -376,13 +624,13 @@ static void apl_save_file(TL_E_MODE mode, TL_Resolution reso, TL_Image *stData)
 //******************************************************************************
 //! \brief        Initialization of libccdtof.so Library
 //! \details
-//! \param[in]    None
+//! \param[in]    dev           device
 //! \param[out]   None
 //! \return       0         success
 //! \return       -1        failed
 //! \date         2021-02-16, Tue, 02:33 PM
 //******************************************************************************
-static int apl_init(TL_E_MODE mode, TL_E_IMAGE_KIND image_kind)
+static int apl_init(apl_dev *dev)
 {
 	TL_E_RESULT ret;
 	TL_Param    tlprm;
@@ -395,22 +643,22 @@ static int apl_init(TL_E_MODE mode, TL_E_IMAGE_KIND image_kind)
 	tlprm.image_kind = gPrm.image_kind;
 
 	// Initialize libccdtof.so Library
-	gPrm.handle = NULL;
-	ret = TL_init(&gPrm.handle, &tlprm);
+	dev->handle = NULL;
+	ret = TL_init(&dev->handle, &tlprm);
 	if (ret != TL_E_SUCCESS) {
 		apl_print_error(ret, (char *)"TL_init", __LINE__);
 		return -1;
 	}
 
 	// Set Depth Mode (Ranging Mode)
-	ret = TL_setProperty(gPrm.handle, TL_CMD_MODE, (void*)&gPrm.mode);
+	ret = TL_setProperty(dev->handle, TL_CMD_MODE, (void*)&dev->mode);
 	if (ret != TL_E_SUCCESS) {
 		apl_print_error(ret, (char *)"TL_setProperty TL_CMD_MODE", __LINE__);
 		return -1;
 	}
 
 	// Get Resolution Of Output Images
-	ret = TL_getProperty(gPrm.handle, TL_CMD_RESOLUTION, (void*)&gPrm.resolution);
+	ret = TL_getProperty(dev->handle, TL_CMD_RESOLUTION, (void*)&dev->resolution);
 	if (ret != TL_E_SUCCESS) {
 		apl_print_error(ret, (char *)"TL_getProperty TL_CMD_RESOLUTION", __LINE__);
 		return -1;
@@ -418,33 +666,33 @@ static int apl_init(TL_E_MODE mode, TL_E_IMAGE_KIND image_kind)
 #if DEBUG	// debug log
 	else {
 		printf("\n");
-		printf("Resolution of output images:\n");
+		printf("Device %u, resolution of output images:\n", dev->idx);
 		printf("depth    : width=%d, height=%d, stride=%d, bit_per_pixel=%d \n",
-			gPrm.resolution.depth.width,
-			gPrm.resolution.depth.height,
-			gPrm.resolution.depth.stride,
-			gPrm.resolution.depth.bit_per_pixel);
+			dev->resolution.depth.width,
+			dev->resolution.depth.height,
+			dev->resolution.depth.stride,
+			dev->resolution.depth.bit_per_pixel);
 		printf("ir       : width=%d, height=%d, stride=%d, bit_per_pixel=%d \n",
-			gPrm.resolution.ir.width,
-			gPrm.resolution.ir.height,
-			gPrm.resolution.ir.stride,
-			gPrm.resolution.ir.bit_per_pixel);
+			dev->resolution.ir.width,
+			dev->resolution.ir.height,
+			dev->resolution.ir.stride,
+			dev->resolution.ir.bit_per_pixel);
 		printf("confdata : width=%d, height=%d, stride=%d, bit_per_pixel=%d \n",
-			gPrm.resolution.confdata.width,
-			gPrm.resolution.confdata.height,
-			gPrm.resolution.confdata.stride,
-			gPrm.resolution.confdata.bit_per_pixel);
+			dev->resolution.confdata.width,
+			dev->resolution.confdata.height,
+			dev->resolution.confdata.stride,
+			dev->resolution.confdata.bit_per_pixel);
 		printf("irnrref  : width=%d, height=%d, stride=%d, bit_per_pixel=%d \n",
-			gPrm.resolution.irnrref.width,
-			gPrm.resolution.irnrref.height,
-			gPrm.resolution.irnrref.stride,
-			gPrm.resolution.irnrref.bit_per_pixel);
+			dev->resolution.irnrref.width,
+			dev->resolution.irnrref.height,
+			dev->resolution.irnrref.stride,
+			dev->resolution.irnrref.bit_per_pixel);
 		printf("\n");
 	}
 #endif
 
 	// Get Mode Information
-	ret = TL_getProperty(gPrm.handle, TL_CMD_MODE_INFO, (void*)&gPrm.mode_info_grp);
+	ret = TL_getProperty(dev->handle, TL_CMD_MODE_INFO, (void*)&dev->mode_info_grp);
 	if (ret != TL_E_SUCCESS) {
 		apl_print_error(ret, (char *)"TL_getProperty TL_CMD_MODE_INFO", __LINE__);
 		return -1;
@@ -453,47 +701,47 @@ static int apl_init(TL_E_MODE mode, TL_E_IMAGE_KIND image_kind)
 	else {
 		printf("Mode Info:\n");
 		printf("mode0 : enable=%d, range_near=%d, range_far=%d, depth_unit=%d, fps=%d\n",
-				gPrm.mode_info_grp.mode[0].enable,
-				gPrm.mode_info_grp.mode[0].range_near,
-				gPrm.mode_info_grp.mode[0].range_far,
-				gPrm.mode_info_grp.mode[0].depth_unit,
-				gPrm.mode_info_grp.mode[0].fps);
+				dev->mode_info_grp.mode[0].enable,
+				dev->mode_info_grp.mode[0].range_near,
+				dev->mode_info_grp.mode[0].range_far,
+				dev->mode_info_grp.mode[0].depth_unit,
+				dev->mode_info_grp.mode[0].fps);
 		printf("mode1 : enable=%d, range_near=%d, range_far=%d, depth_unit=%d, fps=%d\n",
-				gPrm.mode_info_grp.mode[1].enable,
-				gPrm.mode_info_grp.mode[1].range_near,
-				gPrm.mode_info_grp.mode[1].range_far,
-				gPrm.mode_info_grp.mode[1].depth_unit,
-				gPrm.mode_info_grp.mode[1].fps);
+				dev->mode_info_grp.mode[1].enable,
+				dev->mode_info_grp.mode[1].range_near,
+				dev->mode_info_grp.mode[1].range_far,
+				dev->mode_info_grp.mode[1].depth_unit,
+				dev->mode_info_grp.mode[1].fps);
 		printf("mode2 : enable=%d, range_near=%d, range_far=%d, depth_unit=%d, fps=%d\n",
-				gPrm.mode_info_grp.mode[2].enable,
-				gPrm.mode_info_grp.mode[2].range_near,
-				gPrm.mode_info_grp.mode[2].range_far,
-				gPrm.mode_info_grp.mode[2].depth_unit,
-				gPrm.mode_info_grp.mode[2].fps);
+				dev->mode_info_grp.mode[2].enable,
+				dev->mode_info_grp.mode[2].range_near,
+				dev->mode_info_grp.mode[2].range_far,
+				dev->mode_info_grp.mode[2].depth_unit,
+				dev->mode_info_grp.mode[2].fps);
 		printf("mode3 : enable=%d, range_near=%d, range_far=%d, depth_unit=%d, fps=%d\n",
-				gPrm.mode_info_grp.mode[3].enable,
-				gPrm.mode_info_grp.mode[3].range_near,
-				gPrm.mode_info_grp.mode[3].range_far,
-				gPrm.mode_info_grp.mode[3].depth_unit,
-				gPrm.mode_info_grp.mode[3].fps);
+				dev->mode_info_grp.mode[3].enable,
+				dev->mode_info_grp.mode[3].range_near,
+				dev->mode_info_grp.mode[3].range_far,
+				dev->mode_info_grp.mode[3].depth_unit,
+				dev->mode_info_grp.mode[3].fps);
 		printf("mode4 : enable=%d, range_near=%d, range_far=%d, depth_unit=%d, fps=%d\n",
-				gPrm.mode_info_grp.mode[4].enable,
-				gPrm.mode_info_grp.mode[4].range_near,
-				gPrm.mode_info_grp.mode[4].range_far,
-				gPrm.mode_info_grp.mode[4].depth_unit,
-				gPrm.mode_info_grp.mode[4].fps);
+				dev->mode_info_grp.mode[4].enable,
+				dev->mode_info_grp.mode[4].range_near,
+				dev->mode_info_grp.mode[4].range_far,
+				dev->mode_info_grp.mode[4].depth_unit,
+				dev->mode_info_grp.mode[4].fps);
 		printf("mode5 : enable=%d, range_near=%d, range_far=%d, depth_unit=%d, fps=%d\n",
-				gPrm.mode_info_grp.mode[5].enable,
-				gPrm.mode_info_grp.mode[5].range_near,
-				gPrm.mode_info_grp.mode[5].range_far,
-				gPrm.mode_info_grp.mode[5].depth_unit,
-				gPrm.mode_info_grp.mode[5].fps);
+				dev->mode_info_grp.mode[5].enable,
+				dev->mode_info_grp.mode[5].range_near,
+				dev->mode_info_grp.mode[5].range_far,
+				dev->mode_info_grp.mode[5].depth_unit,
+				dev->mode_info_grp.mode[5].fps);
 		printf("\n");
 	}
 #endif
 
 	// Get Fov Information
-	ret = TL_getProperty(gPrm.handle, TL_CMD_FOV, (void*)&gPrm.fov);
+	ret = TL_getProperty(dev->handle, TL_CMD_FOV, (void*)&dev->fov);
 	if(ret != TL_E_SUCCESS){
 		apl_print_error(ret, (char *)"TL_getProperty TL_CMD_FOV", __LINE__);
 		return -1;
@@ -502,15 +750,15 @@ static int apl_init(TL_E_MODE mode, TL_E_IMAGE_KIND image_kind)
 	else {
 		printf("Fov Info:\n");
 		printf("focal_length=%d, angle_h=%d, angle_v=%d\n",
-				gPrm.fov.focal_length,
-				gPrm.fov.angle_h,
-				gPrm.fov.angle_v);
+				dev->fov.focal_length,
+				dev->fov.angle_h,
+				dev->fov.angle_v);
 		printf("\n");
 	}
 #endif
 
 	// Get Mode Information
-	ret = TL_getProperty(gPrm.handle, TL_CMD_DEVICE_INFO, (void*)&gPrm.device_info);
+	ret = TL_getProperty(dev->handle, TL_CMD_DEVICE_INFO, (void*)&dev->device_info);
 	if (ret != TL_E_SUCCESS) {
 		apl_print_error(ret, (char *)"TL_getProperty TL_CMD_DEVICE_INFO", __LINE__);
 		return -1;
@@ -519,24 +767,24 @@ static int apl_init(TL_E_MODE mode, TL_E_IMAGE_KIND image_kind)
 	else {
 		printf("Hardware Info:\n");
 		printf("%s; %s; %s; \n",
-			gPrm.device_info.mod_name,
-			gPrm.device_info.sns_name,
-			gPrm.device_info.lns_name);
+			dev->device_info.mod_name,
+			dev->device_info.sns_name,
+			dev->device_info.lns_name);
 		printf("module_type:0x%x(%d hw version) 0x%x(%dnm light source wavelength) sno_l:0x%x\n",
-			gPrm.device_info.mod_type1, gPrm.device_info.mod_type1,
-			gPrm.device_info.mod_type2, gPrm.device_info.mod_type2,
-			gPrm.device_info.sno_l);
+			dev->device_info.mod_type1, dev->device_info.mod_type1,
+			dev->device_info.mod_type2, dev->device_info.mod_type2,
+			dev->device_info.sno_l);
 		printf("eep_map_ver:0x%x sno_u:0x%x ajust_date:0x%x [20%d-%02d-%02d,T%d] ajust_no:0x%x\n",
-			gPrm.device_info.map_ver,
-			gPrm.device_info.sno_u,
-			gPrm.device_info.ajust_date, (gPrm.device_info.ajust_date&0xFC00)>>10, (gPrm.device_info.ajust_date&0x03C0)>>6, (gPrm.device_info.ajust_date&0x003E)>>1, (gPrm.device_info.ajust_date&0x0001),
-			gPrm.device_info.ajust_no);
+			dev->device_info.map_ver,
+			dev->device_info.sno_u,
+			dev->device_info.ajust_date, (dev->device_info.ajust_date&0xFC00)>>10, (dev->device_info.ajust_date&0x03C0)>>6, (dev->device_info.ajust_date&0x003E)>>1, (dev->device_info.ajust_date&0x0001),
+			dev->device_info.ajust_no);
 		printf("\n");
 	}
 #endif
 
 	// Get device information, Execute TL_getProperty (TL_CMD_LENS_INFO)
-	ret = TL_getProperty(gPrm.handle, TL_CMD_LENS_INFO, (void*)&gPrm.lens_info);
+	ret = TL_getProperty(dev->handle, TL_CMD_LENS_INFO, (void*)&dev->lens_info);
 	if (ret != TL_E_SUCCESS) {
 		apl_print_error(ret, (char *)"TL_getProperty TL_CMD_LENS_INFO", __LINE__);
 		return -1;
@@ -545,20 +793,20 @@ static int apl_init(TL_E_MODE mode, TL_E_IMAGE_KIND image_kind)
 	else {
 		printf("Lens Info:\n");
 		printf("sns_h=%d, sns_v=%d, center_h=%d, center_v=%d pixel_pitch=%d\n",
-			gPrm.lens_info.sns_h,
-			gPrm.lens_info.sns_v,
-			gPrm.lens_info.center_h,
-			gPrm.lens_info.center_v,
-			gPrm.lens_info.pixel_pitch);
+			dev->lens_info.sns_h,
+			dev->lens_info.sns_v,
+			dev->lens_info.center_h,
+			dev->lens_info.center_v,
+			dev->lens_info.pixel_pitch);
 		printf("planer_prm: ");
 		for (int i = 0; i < 4; i++) {
-			printf("%ld ", gPrm.lens_info.planer_prm[i]);
+			printf("%ld ", dev->lens_info.planer_prm[i]);
 		}
 		printf("\n");
 
 		printf("distortion_prm: ");
 		for (int i = 0; i < 4; i++) {
-			printf("%ld ", gPrm.lens_info.distortion_prm[i]);
+			printf("%ld ", dev->lens_info.distortion_prm[i]);
 		}
 		printf("\n");
 	}
@@ -567,10 +815,12 @@ static int apl_init(TL_E_MODE mode, TL_E_IMAGE_KIND image_kind)
 #if USE_OPEN_CV_COLOR_MAP
 #else
 	fwc::stRange range = {
-		 static_cast<uint16_t>(static_cast<float>(gPrm.mode_info_grp.mode[mode].range_near) * 0.9F)	// 10% more of whole range
-		,static_cast<uint16_t>(static_cast<float>(gPrm.mode_info_grp.mode[mode].range_far)  * 1.1F)	// 10% more of whole range
+		 static_cast<uint16_t>(static_cast<float>(dev->mode_info_grp.mode[dev->mode].range_near) * 0.9F)	// 10% more of whole range
+		,static_cast<uint16_t>(static_cast<float>(dev->mode_info_grp.mode[dev->mode].range_far)  * 1.1F)	// 10% more of whole range
 	};
-	color_tbl = new fwc::ColorTable();
+	if (color_tbl == nullptr) {	// Shared By Devices
+		color_tbl = new fwc::ColorTable();
+	}
 	color_tbl->setRange(range);
 #endif
 
@@ -580,19 +830,19 @@ static int apl_init(TL_E_MODE mode, TL_E_IMAGE_KIND image_kind)
 //******************************************************************************
 //! \brief        Termination of libccdtof/libcistof Library
 //! \details
-//! \param[in]    None
+//! \param[in]    dev           device
 //! \param[out]   None
 //! \return       0         success
 //! \return       -1        failed
 //! \date         2021-02-16, Tue, 02:33 PM
 //******************************************************************************
-static int apl_term(void)
+static int apl_term(apl_dev *dev)
 {
 	TL_E_RESULT ret;
 
 	TL_LGI("%s", __FUNCTION__);
 
-	ret = TL_term(&gPrm.handle);
+	ret = TL_term(&dev->handle);
 	if (ret != TL_E_SUCCESS) {
 		apl_print_error(ret, (char *)"TL_term", __LINE__);
 		return -1;
@@ -606,19 +856,19 @@ static int apl_term(void)
 //******************************************************************************
 //! \brief        Start Transferring
 //! \details
-//! \param[in]    None
+//! \param[in]    dev           device
 //! \param[out]   None
 //! \return       0         success
 //! \return       -1        failed
 //! \date         2021-02-16, Tue, 02:33 PM
 //******************************************************************************
-static int apl_start(void)
+static int apl_start(apl_dev *dev)
 {
 	TL_E_RESULT ret;
 
 	TL_LGI("%s", __FUNCTION__);
 
-	ret = TL_start(gPrm.handle);
+	ret = TL_start(dev->handle);
 	if (ret != TL_E_SUCCESS) {
 		apl_print_error(ret, (char *)"TL_start", __LINE__);
 		return -1;
@@ -631,44 +881,142 @@ static int apl_start(void)
 //******************************************************************************
 //! \brief        Capturing Of Images
 //! \details
-//! \param[in]    None
+//! \param[in]    dev           device
 //! \param[out]   None
 //! \return       0         success
 //! \return       -1        failed
 //! \date         2021-02-16, Tue, 02:33 PM
 //******************************************************************************
-static int apl_capture(void)
+static int apl_capture(apl_dev *dev)
 {
 	TL_E_RESULT ret;
 	uint32_t notify = 0U;
 	TL_Image *data = nullptr;
-	uint16_t unit;
+	uint64_t tick;
 
 	TL_LGI("%s", __FUNCTION__);
 
-	apl_frmbuf_get(&data);
+	if (apl_frmbuf_get(dev, &data) < 0) {
+		printf("no frame buffer\n");
+		return TL_E_ERR_EMPTY;
+	}
+
+	tick = apl_mtr_tick();
+	ret = TL_capture(dev->handle, &notify, data);
+	if ((ret == TL_E_SUCCESS) && ((notify & (uint32_t)TL_NOTIFY_IMAGE) != 0U)) {
+		apl_stamp_frame(dev->idx, data);		// Before Anything Else, Time Of Arrival Of Image
+		apl_frm_of(data)->mode = dev->mode;		// View Thread Reads Mode Of Frame, Not Of Device
+	}
+	apl_mtr_observe(APL_MTR_STAGE_CAPTURE, tick);
 
-	ret = TL_capture(gPrm.handle, &notify, data);
+	// Count Notify Flags, Results, frm_index Gaps And Temperature
+	apl_tlm_capture(dev->idx, ret, notify, data);
 
 	if (ret == TL_E_SUCCESS) {
 		// recieved image data
 		if ((notify & (uint32_t)TL_NOTIFY_IMAGE) != 0U) {
-			// Convert Depth Unit, Exclude Saturated Depth Data
-			unit = gPrm.mode_info_grp.mode[gPrm.mode].depth_unit;
-			apl_cnv_dp(gPrm.resolution, data, unit);
+			// Convert Depth Unit With Temperature Correction, Exclude Saturated Depth Data
+			tick = apl_mtr_tick();
+			TL_Resolution reso_raw = dev->resolution;
+			reso_raw.depth = dev->dp_raw;
+			apl_dp_cnv_update(&dev->dp_cnv, &data->frm_info.mp_temp_crct);
+			apl_cnv_dp(reso_raw, data, &dev->dp_cnv);
+			apl_mtr_observe(APL_MTR_STAGE_CNV_DP, tick);
+
+			// Flying Pixels At Depth Edges, Removed Before Upsampling Spreads Them
+			if (dev->fly_on) {
+				tick = apl_mtr_tick();
+				const bool conf = (dev->resolution.confdata.width == dev->dp_raw.width) && (dev->resolution.confdata.height == dev->dp_raw.height);
+				(void)apl_fly_run(&dev->fly, static_cast<uint16_t *>(data->depth), conf ? static_cast<uint16_t *>(data->confdata) : nullptr);
+				apl_mtr_observe(APL_MTR_STAGE_FLY, tick);
+			}
+
+			// QVGA Depth To VGA Guided By VGA IR, Following Stages See VGA Depth
+			if (dev->jbu_on) {
+				tick = apl_mtr_tick();
+				apl_jbu_run(&dev->jbu, static_cast<uint16_t *>(data->depth), static_cast<uint16_t *>(data->ir), static_cast<uint16_t *>(dev->jbu_out));
+				std::swap(data->depth, dev->jbu_out);
+				apl_mtr_observe(APL_MTR_STAGE_UPSAMPLE, tick);
+			}
+
+			// Depth Statistics, Shared With View And Other Consumers
+			tick = apl_mtr_tick();
+			apl_stats_calc(&dev->stats, static_cast<uint16_t *>(data->depth), dev->resolution.depth.width, dev->resolution.depth.height);
+			apl_mtr_observe(APL_MTR_STAGE_STATS, tick);
+
+			// Holes Filled After Statistics, They Count Measured Depth Only
+			if (dev->fill_on) {
+				tick = apl_mtr_tick();
+				(void)apl_fill_run(&dev->fill, static_cast<uint16_t *>(data->depth), static_cast<uint16_t *>(data->ir), apl_frm_of(data)->fill);
+				apl_mtr_observe(APL_MTR_STAGE_FILL, tick);
+			}
+
+			// Rectified Copies Of Depth And IR, Pinhole Lens Holds For Them
+			if (dev->rect_on) {
+				tick = apl_mtr_tick();
+				if (dev->rect_ir_own) {
+					apl_rect_run(&dev->rect, static_cast<uint16_t *>(data->depth), nullptr, apl_frm_of(data)->rect_dp, nullptr);
+					apl_rect_run(&dev->rect_ir, nullptr, static_cast<uint16_t *>(data->ir), nullptr, apl_frm_of(data)->rect_ir);
+				}
+				else {
+					apl_rect_run(&dev->rect, static_cast<uint16_t *>(data->depth), static_cast<uint16_t *>(data->ir), apl_frm_of(data)->rect_dp, apl_frm_of(data)->rect_ir);
+				}
+				apl_mtr_observe(APL_MTR_STAGE_RECT, tick);
+			}
+			const uint16_t *cloud = dev->rect_cloud ? apl_frm_of(data)->rect_dp : static_cast<uint16_t *>(data->depth);
+
+			// Surface Normals On Depth Grid By Ray Table Of Lens
+			if (dev->nrm_on) {
+				tick = apl_mtr_tick();
+				(void)apl_nrm_run(&dev->nrm, cloud, apl_frm_of(data)->nrm);
+				apl_mtr_observe(APL_MTR_STAGE_NORMAL, tick);
+			}
+
+			// Summed-Area Tables On Plane Of Depth Window, Measured Depth Only (Filled Pixels Are Skipped)
+			tick = apl_mtr_tick();
+			if (dev->rect_view) {
+				if (dev->rect_fill != nullptr) {
+					apl_rect_mask(&dev->rect, apl_frm_of(data)->fill, dev->rect_fill);
+				}
+				apl_roi_build(&dev->roi, apl_frm_of(data)->rect_dp, dev->rect_fill);
+			}
+			else {
+				apl_roi_build(&dev->roi, static_cast<uint16_t *>(data->depth), apl_frm_of(data)->fill);
+			}
+			apl_mtr_observe(APL_MTR_STAGE_ROI, tick);
+
+			// Background Model, Foreground Mask And Blobs
+			if (dev->bg_on) {
+				tick = apl_mtr_tick();
+				apl_bg_update(&dev->bg, static_cast<uint16_t *>(data->depth), apl_frm_of(data)->fg);
+				apl_mtr_observe(APL_MTR_STAGE_BG, tick);
+			}
 
-			// Show the image
-			apl_show_img(gPrm.mode, gPrm.image_kind, gPrm.resolution, data);
+			// Floor Plane, Height Above Ground
+			if (dev->plane_on) {
+				tick = apl_mtr_tick();
+				apl_plane_fit(&dev->plane, cloud, apl_frm_of(data)->plane);
+				apl_mtr_observe(APL_MTR_STAGE_PLANE, tick);
+			}
+
+			// Laser Scan Of Band Of Rows, Published At Frame Rate
+			if (dev->scan_on) {
+				tick = apl_mtr_tick();
+				(void)apl_scan_calc(&dev->scan, cloud, apl_frm_of(data)->mono_ns);
+				apl_mtr_observe(APL_MTR_STAGE_SCAN, tick);
+			}
 
-			// Save the image if request by user
-			apl_save_file(gPrm.mode, gPrm.resolution, data);
+			// Pass To View Thread, It Shows And Saves The Image
+			apl_frmbuf_put_rdy(dev, &data);
 		}
 	}
 	else {
 		apl_print_error(ret, (char *)"TL_capture", __LINE__);
 	}
 
-	apl_frmbuf_rel(&data);
+	if (data != nullptr) {
+		apl_frmbuf_rel(dev, &data);
+	}
 
 	return ret;
 }
@@ -677,19 +1025,19 @@ static int apl_capture(void)
 //******************************************************************************
 //! \brief        Cancelation Of Capture
 //! \details
-//! \param[in]    None
+//! \param[in]    dev           device
 //! \param[out]   None
 //! \return       0         success
 //! \return       -1        failed
 //! \date         2021-02-16, Tue, 02:33 PM
 //******************************************************************************
-static int apl_cancel(void)
+static int apl_cancel(apl_dev *dev)
 {
 	TL_E_RESULT ret;
 
 	TL_LGI("%s", __FUNCTION__);
 
-	ret = TL_cancel(gPrm.handle);
+	ret = TL_cancel(dev->handle);
 	if (ret == TL_E_SUCCESS) {
 		printf("TL_cancel success\n");
 	}
@@ -704,19 +1052,19 @@ static int apl_cancel(void)
 //******************************************************************************
 //! \brief        Stop Transferring
 //! \details
-//! \param[in]    None
+//! \param[in]    dev           device
 //! \param[out]   None
 //! \return       0         success
 //! \return       -1        failed
 //! \date         2021-02-16, Tue, 02:33 PM
 //******************************************************************************
-static int apl_stop(void)
+static int apl_stop(apl_dev *dev)
 {
 	TL_E_RESULT ret;
 
 	TL_LGI("%s", __FUNCTION__);
 
-	ret = TL_stop(gPrm.handle);
+	ret = TL_stop(dev->handle);
 	if (ret != TL_E_SUCCESS) {
 		apl_print_error(ret, (char *)"TL_stop", __LINE__);
 		return -1;
@@ -790,19 +1138,20 @@ static void apl_calc_img_size(TL_ImageFormat *format, size_t *size)
 //******************************************************************************
 //! \brief        Calculate Images Size
 //! \details
-//! \param[in]    None
+//! \param[in]    dev           device
 //! \param[out]   None
 //! \return       None
 //! \date         2021-02-16, Tue, 02:33 PM
 //******************************************************************************
-static void apl_images_size(void)
+static void apl_images_size(apl_dev *dev)
 {
 	switch (gPrm.image_kind) {
 		case TL_E_IMAGE_KIND_VGA_DEPTH_IR:
-			apl_calc_img_size(&gPrm.resolution.depth,    &gPrm.img_size.depth);
-			apl_calc_img_size(&gPrm.resolution.ir,       &gPrm.img_size.ir);
-			apl_calc_img_size(&gPrm.resolution.confdata, &gPrm.img_size.confdata);
-			apl_calc_img_size(&gPrm.resolution.irnrref,  &gPrm.img_size.irnrref);
+		case TL_E_IMAGE_KIND_VGA_IR_QVGA_DEPTH:
+			apl_calc_img_size(&dev->resolution.depth,    &dev->img_size.depth);
+			apl_calc_img_size(&dev->resolution.ir,       &dev->img_size.ir);
+			apl_calc_img_size(&dev->resolution.confdata, &dev->img_size.confdata);
+			apl_calc_img_size(&dev->resolution.irnrref,  &dev->img_size.irnrref);
 			break;
 		default:
 			break;
@@ -811,246 +1160,546 @@ static void apl_images_size(void)
 
 
 //******************************************************************************
-//! \brief        Signal Handler Function
-//! \details
-//! \param[in]    signal    signal number
+//! \brief        Load Regions Of Interest From Configuration, "roi.<n> = x y w h"
+//! \details      "cam<d>.roi.<n>" overrides it for device d.
+//! \param[in]    dev           device
 //! \param[out]   None
 //! \return       None
-//! \date         2021-02-16, Tue, 02:33 PM
 //******************************************************************************
-static void apl_signal_handler(int signal)
+static void apl_load_roi(apl_dev *dev)
 {
-	printf("Killed (signal:%d)\n", signal);
-	bExit = true;
+	char key[16];
+	apl_roi_rect rect;
+	int n;
+
+	for (n = 0; n < APL_ROI_MAX; n++) {
+		std::snprintf(key, sizeof(key), "roi.%d", n);
+		const char *val = apl_cfg_get_dev_str(dev->idx, key, nullptr);
+		if (val == nullptr) {
+			continue;
+		}
+		if ((std::sscanf(val, "%d %d %d %d", &rect.x, &rect.y, &rect.w, &rect.h) != 4) || (rect.w <= 0) || (rect.h <= 0)) {
+			printf("%s : invalid rectangle \"%s\"\n", key, val);
+			continue;
+		}
+		(void)apl_roi_add(&dev->roi, &rect);
+		printf("ROI %d : x=%d y=%d w=%d h=%d\n", n, rect.x, rect.y, rect.w, rect.h);
+	}
 }
 
-
 //******************************************************************************
-//! \brief        Utilities Function To Calculate FPS
-//! \details
-//! \param[in]    tick              Elapsed Time Tick.
-//! \param[out]   tickforCalcFps	Start Time Tick.
-//! \param[out]   fps               Frame Per Second.
-//! \return       None.
-//! \date         2022-06-16, Tue, 02:00 PM
+//! \brief        Load Laser Scan From Configuration, Enabled By "scan.output"
+//! \details      Each device needs its own output, e.g. "cam1.scan.output".
+//! \param[in]    dev           device
+//! \param[out]   None
+//! \return       None
 //******************************************************************************
-static void apl_get_calc_fps(const std::chrono::system_clock::time_point & tick, std::chrono::system_clock::time_point & tickforCalcFps, float & fps)
+static void apl_load_scan(apl_dev *dev)
 {
-	const float elapsed = static_cast<float>(std::chrono::duration_cast<std::chrono::microseconds>(tick - tickforCalcFps).count());
+	const char *output = apl_cfg_get_dev_str(dev->idx, "scan.output", nullptr);
+	uint16_t h = dev->resolution.depth.height;
+	int row_begin;
+	int row_end;
 
-	fps = 1000 * 1000 / elapsed;
-	tickforCalcFps = tick;
-}
+	if (output == nullptr) {
+		return;
+	}
 
+	// Default Band Is Center 1/16 Of Rows
+	row_begin = apl_cfg_get_dev_int(dev->idx, "scan.row_begin", (h / 2) - (h / 32));
+	row_end   = apl_cfg_get_dev_int(dev->idx, "scan.row_end",   (h / 2) + (h / 32));
+	if ((row_begin < 0) || (row_end > h)) {
+		printf("scan : rows %d-%d out of image\n", row_begin, row_end);
+		return;
+	}
 
-//******************************************************************************
-//! \brief        Utilities Function To Wait Until A Defined Interval
-//! \details
-//! \param[in]    targetFps     A Defined Interval, In Term Of Fps.
-//! \param[in]    tickforFixFps	Current Time Tick.
-//! \param[out]   None.
-//! \return       None.
-//! \date         2022-06-16, Tue, 02:00 PM
-//******************************************************************************
-static void apl_fix_fps(const float & targetFps, const std::chrono::system_clock::time_point & tickforFixFps)
-{
-	const int64_t duration_ms = static_cast<int64_t>(1000 / targetFps);
-	const std::chrono::system_clock::time_point until = tickforFixFps + std::chrono::milliseconds(duration_ms);
+	if (apl_scan_init(&dev->scan, &dev->lens, (uint16_t)row_begin, (uint16_t)row_end,
+					  (uint16_t)apl_cfg_get_dev_int(dev->idx, "scan.bins", 0),
+					  dev->mode_info_grp.mode[dev->mode].range_near,
+					  dev->mode_info_grp.mode[dev->mode].range_far) < 0) {
+		return;
+	}
+	if (apl_scan_open(&dev->scan, output) < 0) {
+		apl_scan_close(&dev->scan);
+		return;
+	}
 
-	std::this_thread::sleep_until(until);
+	dev->scan_on = true;
+	printf("Scan %u : rows %d-%d, %s\n", dev->idx, row_begin, row_end, output);
 }
 
-
 //******************************************************************************
-//! \brief        Utilities Function To Get Current Time Tick.
-//! \details
-//! \param[in]    None.
-//! \param[out]   None.
-//! \return       Time Tick In Miliseconds
-//! \date         2022-06-16, Tue, 02:00 PM
+//! \brief        Load Floor Plane From Configuration, Enabled By "plane.on"
+//! \details      Sensors are mounted apart, "cam<d>.plane.up" etc. override it for device d.
+//! \param[in]    dev           device
+//! \param[out]   None
+//! \return       None
 //******************************************************************************
-unsigned int apl_get_tick_cnt(void)
+static void apl_load_plane(apl_dev *dev)
 {
-	struct timeval tv;
+	float up[3] = { 0.0F, -1.0F, 0.0F };	// Camera y Is Down
 
-	if (gettimeofday(&tv, NULL) != 0) {
-		return 0;
+	if (apl_cfg_get_dev_int(dev->idx, "plane.on", 0) == 0) {
+		return;
 	}
 
-	return (tv.tv_sec * 1000) + (tv.tv_usec / 1000);
-}
+	const char *val = apl_cfg_get_dev_str(dev->idx, "plane.up", nullptr);
+	if ((val != nullptr) && (std::sscanf(val, "%f %f %f", &up[0], &up[1], &up[2]) != 3)) {
+		printf("plane.up : invalid vector \"%s\"\n", val);
+	}
 
+	apl_plane_init(&dev->plane, &dev->lens,
+				   (uint16_t)apl_cfg_get_dev_int(dev->idx, "plane.stride", 4),
+				   (uint32_t)apl_cfg_get_dev_int(dev->idx, "plane.iter", 200),
+				   apl_cfg_get_dev_float(dev->idx, "plane.thresh_mm", 30.0F),
+				   up,
+				   apl_cfg_get_dev_float(dev->idx, "plane.max_tilt", 60.0F));
+
+	dev->plane_on = true;
+	printf("Floor plane %u : stride=%u iter=%u thresh=%.0f mm\n", dev->idx, dev->plane.stride, dev->plane.iter_max, dev->plane.thresh);
+}
 
 //******************************************************************************
-//! \brief        Utilities Function To Convert Depth Image To Color Map, By Using OpenCV API.
-//! \n
-//! \param[in]    img       Depth Image.
-//! \param[in]    min_val   Minimum Depth Value.
-//! \param[in]    max_val   Depth Value.
-//! \param[out]   None.
-//! \return       cv::Mat of Type CV_8UC3 (8Bits 3 Channels).
-//! \date         2021-02-16, Tue, 02:33 PM
+//! \brief        Load Flying Pixel Filter From Configuration, Enabled By "fly.on"
+//! \details      Filter runs on depth as captured (before upsampling), "fly.angle" selects 3D test by lens.
+//! \param[in]    dev           device
+//! \param[out]   None
+//! \return       None
 //******************************************************************************
-cv::Mat apl_dpth_to_color_by_opencv(cv::Mat img, uint32_t min_val, uint32_t max_val)
+static void apl_load_fly(apl_dev *dev)
 {
-	size_t i;
-	size_t j;
-	size_t w = img.cols;
-	size_t h = img.rows;
-	double d_min_val = min_val;
-	double d_max_val = max_val;
-	cv::Mat mat_8bit(h, w, CV_8UC1);
-	cv::Mat mat_32bit = cv::Mat::zeros(h, w, CV_32F);
-
-	//! \remark 1. Normalise To 32Bits Float.
-	img.convertTo(mat_32bit, CV_32FC1, 1/(d_max_val - d_min_val), -d_min_val/(d_max_val - d_min_val));
-
-	//! \remark 2. Convert To 8Bits, As applyColorMap() Only Accept CV_8U.
-	mat_32bit.convertTo(mat_8bit, CV_8UC1, -255, 255);
-
-	//! \remark 3. Convert To Rainbow Color.
-	cv::applyColorMap(mat_8bit, mat_8bit, cv::COLORMAP_JET);
-
-	//! \remark 4. Mask Off Upper And Lower Range.
-	for (i = 0 ; i < h; i++) {
-		for (j = 0 ; j < w; j++) {
-			float y = mat_32bit.at<float>(i,j);
-			if (y > 1) {
-				mat_8bit.at<cv::Vec3b>(i,j) = 0;	// Change To Black, i.e. 0 if (img > 1).
-			}
-			else
-			if (y < 0) {
-				mat_8bit.at<cv::Vec3b>(i,j) = 255;	// Change To White, i.e. 255 if (img < 0).
-			}
-		}
+	const apl_lens *lens = nullptr;
+	float angle = apl_cfg_get_dev_float(dev->idx, "fly.angle", 0.0F);
+
+	if (apl_cfg_get_dev_int(dev->idx, "fly.on", 0) == 0) {
+		return;
 	}
 
-	return mat_8bit;
-}
+	if ((angle > 0) && (apl_lens_init(&dev->fly_lens, &dev->lens_info, &dev->fov, dev->dp_raw.width, dev->dp_raw.height) == 0)) {
+		lens = &dev->fly_lens;
+	}
 
+	apl_fly_init(&dev->fly, dev->dp_raw.width, dev->dp_raw.height, lens, angle,
+				 apl_cfg_get_dev_float(dev->idx, "fly.abs_mm", 50.0F),
+				 apl_cfg_get_dev_float(dev->idx, "fly.rel", 0.03F),
+				 (uint32_t)apl_cfg_get_dev_int(dev->idx, "fly.lines", 1),
+				 (uint16_t)apl_cfg_get_dev_int(dev->idx, "fly.conf_min", 0));
+
+	dev->fly_on = true;
+	if (lens != nullptr) {
+		printf("Flying pixel %u : 3D, angle=%.1f deg abs=%.0f mm lines=%u conf_min=%u\n", dev->idx, angle, dev->fly.abs, dev->fly.jump_min, dev->fly.conf_min);
+	}
+	else {
+		printf("Flying pixel %u : abs=%.0f mm rel=%.3f lines=%u conf_min=%u\n", dev->idx, dev->fly.abs, dev->fly.rel, dev->fly.jump_min, dev->fly.conf_min);
+	}
+}
 
 //******************************************************************************
-//! \brief        Opencv Trackbar Callback Function.
-//! \n
-//! \param[in]    trk_bar_pos   Current Trackbar Position.
-//! \param[in]    usr_dat       Custom User Data.
-//! \param[out]   None.
+//! \brief        Load Surface Normals From Configuration, Enabled By "normal.on"
+//! \details      Normals are computed on depth of frame after hole filling, by lens of depth image.
+//! \param[in]    dev           device
+//! \param[out]   None
 //! \return       None
-//! \date         2022-08-17, Tue, 02:00 PM
 //******************************************************************************
-static void on_trkbar_toggle(int trk_bar_pos, void* usr_dat)
+static void apl_load_nrm(apl_dev *dev)
 {
-	bool *pBool = (bool *) usr_dat;
-
-	if (*pBool != trk_bar_pos) {
-		*pBool = (bool) trk_bar_pos;
+	if (apl_cfg_get_dev_int(dev->idx, "normal.on", 0) == 0) {
+		return;
 	}
+
+	apl_nrm_init(&dev->nrm, &dev->lens,
+				 (uint32_t)apl_cfg_get_dev_int(dev->idx, "normal.step", 2),
+				 apl_cfg_get_dev_float(dev->idx, "normal.jump", 0.05F));
+
+	dev->nrm_on = true;
+	printf("Surface normals %u : step=%u jump=%.3f\n", dev->idx, dev->nrm.step, dev->nrm.jump);
 }
 
 //******************************************************************************
-//! \brief        Display Opencv Trackbar As GUI Panel
-//! \n
-//! \param[in]    None.
-//! \param[out]   None.
-//! \return       None.
-//! \date         2022-08-17, Tue, 02:00 PM
-//  https://www.opencv-srf.com/2011/11/track-bars.html
+//! \brief        Load Hole Filling From Configuration, Enabled By "fill.on"
+//! \details      Holes are filled guided by ir, so that ir must have the size of depth (after upsampling).
+//! \param[in]    dev           device
+//! \param[out]   None
+//! \return       None
 //******************************************************************************
-void apl_show_pnl(void)
+static void apl_load_fill(apl_dev *dev)
 {
-	//! \remark Create GUI For Control Panel
-	cv::Mat mat_footer(25, 350, CV_8UC3, cv::Scalar(220, 220, 220));
-	cv::putText(mat_footer,								// Target Image
-				"Nuvoton Technology Corporation Japan",	// Text
-				cv::Point(60, 15),						// Origin
-				cv::FONT_HERSHEY_SIMPLEX,				// Font Face
-				0.4,									// Font Scale
-				CV_RGB(128, 128, 128),					// Font Color
-				1,										// Thickness
-				cv::LINE_8,								// Line Type
-				false);									// Bottom Left Origin
-	cv::imshow(OPENCV_WINDOW_NAME_PANEL_VIEWER, mat_footer);
-	//cv::namedWindow(OPENCV_WINDOW_NAME_PANEL_VIEWER, CV_WINDOW_NORMAL);
-	//cv::moveWindow(OPENCV_WINDOW_NAME_PANEL_VIEWER, 650, 10);
-	//cv::resizeWindow(OPENCV_WINDOW_NAME_PANEL_VIEWER, 160, 80);
-	//cv::waitKey(1);  // Draw The Screen And Wait For 1 Millisecond.
+	float sigma_r = apl_cfg_get_dev_float(dev->idx, "fill.sigma_r", 32.0F);
 
-	cv::createTrackbar(OPENCV_TRACKBAR_NAME_TOGGLE_CONFDAT,              OPENCV_WINDOW_NAME_PANEL_VIEWER, nullptr, 1, on_trkbar_toggle, (void *)&gPrm.view_confdat_on);
-	cv::createTrackbar(OPENCV_TRACKBAR_NAME_TOGGLE_IRNRREF,              OPENCV_WINDOW_NAME_PANEL_VIEWER, nullptr, 1, on_trkbar_toggle, (void *)&gPrm.view_irnrref_on);
+	if (apl_cfg_get_dev_int(dev->idx, "fill.on", 0) == 0) {
+		return;
+	}
 
-	cv::imshow(OPENCV_WINDOW_NAME_PANEL_VIEWER, mat_footer);
-	//cv::namedWindow(OPENCV_WINDOW_NAME_PANEL_VIEWER, CV_WINDOW_NORMAL);
-	cv::moveWindow(OPENCV_WINDOW_NAME_PANEL_VIEWER, 1400, 100);
-	cv::resizeWindow(OPENCV_WINDOW_NAME_PANEL_VIEWER, 340, 80);
-	cv::waitKey(1);  // Draw The Screen And Wait For 1 Millisecond.
+	if ((dev->resolution.ir.width != dev->resolution.depth.width) || (dev->resolution.ir.height != dev->resolution.depth.height)) {
+		printf("Hole filling %u : ir is not of depth size, disabled\n", dev->idx);
+		return;
+	}
+
+	apl_fill_init(&dev->fill, dev->resolution.depth.width, dev->resolution.depth.height,
+				  (uint32_t)apl_cfg_get_dev_int(dev->idx, "fill.max_hole", 16),
+				  sigma_r);
 
+	dev->fill_on = true;
+	printf("Hole filling %u : max_hole=%u sigma_r=%.0f\n", dev->idx, 1U << dev->fill.level_num, sigma_r);
 }
 
 //******************************************************************************
-//! \brief        Preprocess depth data, convert using depth_unit, exclude saturated depth data.
-//! \n
-//! \param[in]    reso          Depth Image Format.
-//! \param[in]    stData        Image data.
-//! \param[in]    uint16_t      depth_unit [mm/digit].
-//! \param[out]   None.
+//! \brief        Load Rectification From Configuration, Enabled By "rect.on"
+//! \details      Remap tables are built once from distortion_prm of lens ("rect.k1" .. "rect.p2" override it),
+//!               rectified planes are used by view, saving and 3D stages as selected by "rect.view", "rect.save", "rect.cloud".
+//! \param[in]    dev           device
+//! \param[out]   None
 //! \return       None
 //******************************************************************************
-void apl_cnv_dp(TL_Resolution reso, TL_Image *stData, uint16_t unit)
+static void apl_load_rect(apl_dev *dev)
 {
-	size_t w;
-	size_t h;
-	uint16_t* src;
-	uint16_t* end;
+	apl_rect_coef *coef = &dev->rect_coef;
+	apl_lens lens_ir;
+
+	// Distortion Is Kept Even If Not Rectified, Saved Takes Can Be Rectified Offline
+	(void)apl_rect_coef_of(&dev->lens_info, (uint32_t)apl_cfg_get_dev_int(dev->idx, "rect.prm_frac", APL_RECT_PRM_FRAC), coef);
+	coef->k1 = apl_cfg_get_dev_float(dev->idx, "rect.k1", (float)coef->k1);
+	coef->k2 = apl_cfg_get_dev_float(dev->idx, "rect.k2", (float)coef->k2);
+	coef->p1 = apl_cfg_get_dev_float(dev->idx, "rect.p1", (float)coef->p1);
+	coef->p2 = apl_cfg_get_dev_float(dev->idx, "rect.p2", (float)coef->p2);
+
+	if (apl_cfg_get_dev_int(dev->idx, "rect.on", 0) == 0) {
+		return;
+	}
+	if ((coef->k1 == 0) && (coef->k2 == 0) && (coef->p1 == 0) && (coef->p2 == 0)) {
+		printf("Rectification %u : lens has no distortion, disabled\n", dev->idx);
+		return;
+	}
 
-	h = reso.depth.height;
-	w = reso.depth.width;
-	src = static_cast<uint16_t*>(stData->depth);
-	end = src + (w * h);
+	if (apl_rect_init(&dev->rect, &dev->lens, coef) < 0) {
+		printf("apl_rect_init failed, images are not rectified\n");
+		return;
+	}
 
-	while (src < end) {
-		if (*src == RAW12_INVALID_DEPTH) {
-			*src = 0;	//INVALID_DEPTH;
+	// IR Of Other Size (QVGA Depth Not Upsampled) Has Table Of Its Own, Rays Are Needed While Building Only
+	dev->rect_ir_own = (dev->resolution.ir.width != dev->resolution.depth.width) || (dev->resolution.ir.height != dev->resolution.depth.height);
+	if (dev->rect_ir_own) {
+		if ((apl_lens_init(&lens_ir, &dev->lens_info, &dev->fov, dev->resolution.ir.width, dev->resolution.ir.height) < 0) ||
+			(apl_rect_init(&dev->rect_ir, &lens_ir, coef) < 0)) {
+			printf("apl_rect_init failed, images are not rectified\n");
+			apl_rect_term(&dev->rect);
+			return;
 		}
-		else {
-			*src *= unit;
+		apl_arena_free(lens_ir.rx);
+		apl_arena_free(lens_ir.ry);
+	}
+
+	dev->rect_on = true;
+	dev->rect_view = (apl_cfg_get_dev_int(dev->idx, "rect.view", 1) != 0);
+	dev->rect_save = (apl_cfg_get_dev_int(dev->idx, "rect.save", 1) != 0);
+	dev->rect_cloud = (apl_cfg_get_dev_int(dev->idx, "rect.cloud", 1) != 0);
+	if (dev->fill_on && dev->rect_view) {
+		dev->rect_fill = static_cast<uint8_t *>(apl_arena_alloc((size_t)dev->resolution.depth.width * dev->resolution.depth.height));
+	}
+	printf("Rectification %u : k1=%g k2=%g p1=%g p2=%g outside=%u view=%d save=%d cloud=%d\n", dev->idx,
+		   coef->k1, coef->k2, coef->p1, coef->p2, dev->rect.outside, dev->rect_view, dev->rect_save, dev->rect_cloud);
+}
+
+//******************************************************************************
+//! \brief        Load Mesh Export From Configuration, Enabled By "mesh.on"
+//! \details      Meshes are written to "<mesh.dir>/[cam<d>_]mode#_<time>_mesh<seq>.ply" (or .obj).
+//! \param[in]    dev           device
+//! \param[out]   None
+//! \return       None
+//******************************************************************************
+static void apl_load_mesh(apl_dev *dev)
+{
+	APL_MESH_FMT fmt = APL_MESH_FMT_PLY;
+	char stamp[32];
+	char pfx[384];
+	std::time_t now;
+
+	if (apl_cfg_get_dev_int(dev->idx, "mesh.on", 0) == 0) {
+		return;
+	}
+
+	const char *fmt_name = apl_cfg_get_dev_str(dev->idx, "mesh.format", "ply");
+	if (apl_mesh_fmt_of(fmt_name, &fmt) < 0) {
+		printf("mesh.format : unknown \"%s\", use ply\n", fmt_name);
+	}
+
+	std::time(&now);
+	std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", std::localtime(&now));
+	if (gPrm.dev_num > 1) {
+		snprintf(pfx, sizeof(pfx), "%s/cam%u_mode%d_%s", apl_cfg_get_dev_str(dev->idx, "mesh.dir", "."), dev->idx, dev->mode + 1, stamp);
+	}
+	else {
+		snprintf(pfx, sizeof(pfx), "%s/mode%d_%s", apl_cfg_get_dev_str(dev->idx, "mesh.dir", "."), dev->mode + 1, stamp);
+	}
+
+	if (apl_mesh_out_init(&dev->mesh, &dev->lens,
+						  apl_cfg_get_dev_float(dev->idx, "mesh.jump", 0.05F),
+						  (uint16_t)apl_cfg_get_dev_int(dev->idx, "mesh.ir_max", 1023),
+						  dev->resolution.ir.width, dev->resolution.ir.height, pfx, fmt,
+						  (uint32_t)apl_cfg_get_dev_int(dev->idx, "mesh.decimate", 10),
+						  (uint32_t)apl_cfg_get_dev_int(dev->idx, "mesh.queue", APL_MESH_QUEUE_DEF)) < 0) {
+		printf("apl_mesh_out_init failed, mesh is not exported\n");
+		return;
+	}
+
+	dev->mesh_on = true;
+	printf("Mesh %u : %s_mesh<seq>%s, 1 of %u frames\n", dev->idx, pfx, apl_mesh_ext(fmt), dev->mesh.que.decimate);
+}
+
+//******************************************************************************
+//! \brief        Load Pre-Trigger Ring From Configuration, Enabled By "trigger.on"
+//! \details      Ring is sized by frame rate of fastest enabled mode and resolution of frame buffers.
+//!               Several devices dump to "<trigger.dir>/cam<d>".
+//! \param[in]    dev           device
+//! \param[out]   None
+//! \return       None
+//******************************************************************************
+static void apl_load_trig(apl_dev *dev)
+{
+	uint32_t fps_max = 0;
+	char dir[256];
+	int m;
+
+	if (apl_cfg_get_dev_int(dev->idx, "trigger.on", 0) == 0) {
+		return;
+	}
+
+	std::snprintf(dir, sizeof(dir), "%s", apl_cfg_get_dev_str(dev->idx, "trigger.dir", "."));
+	if (gPrm.dev_num > 1) {
+		std::snprintf(dir + strlen(dir), sizeof(dir) - strlen(dir), "/cam%u", dev->idx);
+		if ((mkdir(dir, 0755) < 0) && (errno != EEXIST)) {
+			printf("mkdir (%s) failed\n", dir);
+		}
+	}
+
+	// Ring Is Allocated For Fastest Mode, Mode Switch Resizes It Within
+	for (m = 0; m < TL_E_MODE_NUM; m++) {
+		if (dev->mode_info_grp.mode[m].enable == TL_E_TRUE) {
+			fps_max = std::max<uint32_t>(fps_max, dev->mode_info_grp.mode[m].fps);
+		}
+	}
+
+	if (apl_trig_init(&dev->trig, dev->resolution, dev->mode_info_grp.mode[dev->mode].fps, fps_max,
+					  apl_cfg_get_dev_float(dev->idx, "trigger.pre_sec", 5.0F),
+					  apl_cfg_get_dev_float(dev->idx, "trigger.post_sec", 2.0F),
+					  dir, strcmp(apl_cfg_get_dev_str(dev->idx, "trigger.format", dev->save_take ? "take" : "raw"), "take") == 0) < 0) {
+		printf("apl_trig_init failed, trigger is disabled\n");
+		return;
+	}
+
+	dev->trig_on_blob = dev->bg_on && (apl_cfg_get_dev_int(dev->idx, "trigger.on_blob", 0) != 0);
+	dev->trig_on = true;
+	printf("Trigger %u : %u frames (post %u), %.1f MB, kill -USR1 %d or \"t\"%s\n", dev->idx,
+		dev->trig.num, dev->trig.post, (double)dev->trig.bytes / (1024 * 1024), (int)getpid(), dev->trig_on_blob ? " or blob" : "");
+}
+
+//******************************************************************************
+//! \brief        Signal Handler Function Of Trigger (SIGUSR1), Fires Rings Of All Devices
+//! \param[in]    signal    signal number
+//! \return       None
+//******************************************************************************
+static void apl_trig_signal_handler(int signal)
+{
+	uint8_t d;
+
+	(void)signal;
+
+	for (d = 0; d < gPrm.dev_num; d++) {
+		if ((sDev[d] != nullptr) && sDev[d]->trig_on) {
+			apl_trig_fire(&sDev[d]->trig);
 		}
-		src++;
 	}
 }
 
+//******************************************************************************
+//! \brief        Signal Handler Function
+//! \details
+//! \param[in]    signal    signal number
+//! \param[out]   None
+//! \return       None
+//! \date         2021-02-16, Tue, 02:33 PM
+//******************************************************************************
+static void apl_signal_handler(int signal)
+{
+	printf("Killed (signal:%d)\n", signal);
+	bExit = true;
+}
+
+
+//******************************************************************************
+//! \brief        Utilities Function To Calculate FPS
+//! \details
+//! \param[in]    tick              Elapsed Time Tick.
+//! \param[out]   tickforCalcFps	Start Time Tick.
+//! \param[out]   fps               Frame Per Second.
+//! \return       None.
+//! \date         2022-06-16, Tue, 02:00 PM
+//******************************************************************************
+static void apl_get_calc_fps(const std::chrono::steady_clock::time_point & tick, std::chrono::steady_clock::time_point & tickforCalcFps, float & fps)
+{
+	const float elapsed = static_cast<float>(std::chrono::duration_cast<std::chrono::microseconds>(tick - tickforCalcFps).count());
+
+	fps = 1000 * 1000 / elapsed;
+	tickforCalcFps = tick;
+}
+
+
+//******************************************************************************
+//! \brief        Utilities Function To Wait Until A Defined Interval
+//! \details
+//! \param[in]    targetFps     A Defined Interval, In Term Of Fps.
+//! \param[in]    tickforFixFps	Current Time Tick.
+//! \param[out]   None.
+//! \return       None.
+//! \date         2022-06-16, Tue, 02:00 PM
+//******************************************************************************
+static void apl_fix_fps(const float & targetFps, const std::chrono::steady_clock::time_point & tickforFixFps)
+{
+	const int64_t duration_ms = static_cast<int64_t>(1000 / targetFps);
+	const std::chrono::steady_clock::time_point until = tickforFixFps + std::chrono::milliseconds(duration_ms);
+
+	std::this_thread::sleep_until(until);
+}
+
+
+//******************************************************************************
+//! \brief        Utilities Function To Get Current Time Tick.
+//! \details
+//! \param[in]    None.
+//! \param[out]   None.
+//! \return       Time Tick In Miliseconds
+//! \date         2022-06-16, Tue, 02:00 PM
+//******************************************************************************
+unsigned int apl_get_tick_cnt(void)
+{
+	return (unsigned int)(apl_stamp_mono() / 1000000U);
+}
+
+
+//******************************************************************************
+//! \brief        Opencv Trackbar Callback Function.
+//! \n
+//! \param[in]    trk_bar_pos   Current Trackbar Position.
+//! \param[in]    usr_dat       Custom User Data.
+//! \param[out]   None.
+//! \return       None
+//! \date         2022-08-17, Tue, 02:00 PM
+//******************************************************************************
+static void on_trkbar_toggle(int trk_bar_pos, void* usr_dat)
+{
+	bool *pBool = (bool *) usr_dat;
+
+	if (*pBool != trk_bar_pos) {
+		*pBool = (bool) trk_bar_pos;
+	}
+}
+
+//******************************************************************************
+//! \brief        Display Opencv Trackbar As GUI Panel
+//! \n
+//! \param[in]    None.
+//! \param[out]   None.
+//! \return       None.
+//! \date         2022-08-17, Tue, 02:00 PM
+//  https://www.opencv-srf.com/2011/11/track-bars.html
+//******************************************************************************
+void apl_show_pnl(void)
+{
+	//! \remark Create GUI For Control Panel
+	cv::Mat mat_footer(25, 350, CV_8UC3, cv::Scalar(220, 220, 220));
+	cv::putText(mat_footer,								// Target Image
+				"Nuvoton Technology Corporation Japan",	// Text
+				cv::Point(60, 15),						// Origin
+				cv::FONT_HERSHEY_SIMPLEX,				// Font Face
+				0.4,									// Font Scale
+				CV_RGB(128, 128, 128),					// Font Color
+				1,										// Thickness
+				cv::LINE_8,								// Line Type
+				false);									// Bottom Left Origin
+	cv::imshow(OPENCV_WINDOW_NAME_PANEL_VIEWER, mat_footer);
+	//cv::namedWindow(OPENCV_WINDOW_NAME_PANEL_VIEWER, CV_WINDOW_NORMAL);
+	//cv::moveWindow(OPENCV_WINDOW_NAME_PANEL_VIEWER, 650, 10);
+	//cv::resizeWindow(OPENCV_WINDOW_NAME_PANEL_VIEWER, 160, 80);
+	//cv::waitKey(1);  // Draw The Screen And Wait For 1 Millisecond.
+
+	cv::createTrackbar(OPENCV_TRACKBAR_NAME_TOGGLE_CONFDAT,              OPENCV_WINDOW_NAME_PANEL_VIEWER, nullptr, 1, on_trkbar_toggle, (void *)&gPrm.view_confdat_on);
+	cv::createTrackbar(OPENCV_TRACKBAR_NAME_TOGGLE_IRNRREF,              OPENCV_WINDOW_NAME_PANEL_VIEWER, nullptr, 1, on_trkbar_toggle, (void *)&gPrm.view_irnrref_on);
+	cv::createTrackbar(OPENCV_TRACKBAR_NAME_TOGGLE_AUTORANGE,            OPENCV_WINDOW_NAME_PANEL_VIEWER, nullptr, 1, on_trkbar_toggle, (void *)&gPrm.view_auto_range_on);
+	cv::setTrackbarPos(OPENCV_TRACKBAR_NAME_TOGGLE_AUTORANGE,            OPENCV_WINDOW_NAME_PANEL_VIEWER, gPrm.view_auto_range_on ? 1 : 0);
+	cv::createTrackbar(OPENCV_TRACKBAR_NAME_TOGGLE_NORMAL,               OPENCV_WINDOW_NAME_PANEL_VIEWER, nullptr, 1, on_trkbar_toggle, (void *)&gPrm.view_normal_on);
+	cv::setTrackbarPos(OPENCV_TRACKBAR_NAME_TOGGLE_NORMAL,               OPENCV_WINDOW_NAME_PANEL_VIEWER, gPrm.view_normal_on ? 1 : 0);
+
+	cv::imshow(OPENCV_WINDOW_NAME_PANEL_VIEWER, mat_footer);
+	//cv::namedWindow(OPENCV_WINDOW_NAME_PANEL_VIEWER, CV_WINDOW_NORMAL);
+	cv::moveWindow(OPENCV_WINDOW_NAME_PANEL_VIEWER, 1400, 100);
+	cv::resizeWindow(OPENCV_WINDOW_NAME_PANEL_VIEWER, 340, 80);
+	cv::waitKey(1);  // Draw The Screen And Wait For 1 Millisecond.
+
+}
+
+//******************************************************************************
+//! \brief        Window Name Of Device, Suffixed By Device When Several Devices
+//! \param[in]    dev           Device.
+//! \param[in]    base          Window name.
+//! \return       Window name.
+//******************************************************************************
+static std::string apl_win_name(const apl_dev *dev, const char *base)
+{
+	char name[128];
+
+	if (gPrm.dev_num <= 1) {
+		return base;
+	}
+	std::snprintf(name, sizeof(name), "%s - cam%u", base, dev->idx);
+
+	return name;
+}
+
 //******************************************************************************
 //! \brief        Display Image In Opencv Windows
 //! \n
-//! \param[in]    img_kind      Image data.
-//! \param[in]    reso          Depth Image Format.
+//! \param[in]    dev           Device.
 //! \param[in]    stData        Image data.
-//! \param[in]    temperature   Temperature.
 //! \param[out]   None.
 //! \return       None
 //! \date         2021-11-30, Tue, 02:33 PM
 //******************************************************************************
-void apl_show_img(TL_E_MODE mode, TL_E_IMAGE_KIND img_kind, TL_Resolution reso, TL_Image *stData)
+void apl_show_img(apl_dev *dev, TL_Image *stData)
 {
+	const TL_Resolution &reso = dev->resolution;
 	bool show_depth = false;
 	bool show_ir = false;
 	bool show_bg = false;
 	bool show_confdat = gPrm.view_confdat_on;
 	bool show_irnrref = gPrm.view_irnrref_on;
+	bool show_normal = gPrm.view_normal_on && (apl_frm_of(stData)->nrm != NULL);
+	void *plane_dp = dev->rect_view ? apl_frm_of(stData)->rect_dp : stData->depth;	// rectified or as captured
+	void *plane_ir = dev->rect_view ? apl_frm_of(stData)->rect_ir : stData->ir;
 	size_t w;
 	size_t h;
 	uint8_t *p_data;
 	uint16_t range_min;
 	uint16_t range_max;
-	static int32_t gamma_corr_ir = 22;  //!< Default Gamma Value Is 2.2 (For OpenCV TrackBar Used).
+	uint16_t range_step;
+	apl_dp_stats dp_stats;
 	static int32_t gamma_corr_bg = 22;  //!< Default Gamma Value Is 2.2 (For OpenCV TrackBar Used).
 	int32_t temperature;
-	std::chrono::system_clock::time_point tick = (std::chrono::system_clock::time_point::min)();
-	static std::chrono::system_clock::time_point tickforCalcFps = (std::chrono::system_clock::time_point::min)();
+	std::chrono::steady_clock::time_point tick = (std::chrono::steady_clock::time_point::min)();
 	float calcFPS;
 	char str[256];
-
-	tick = std::chrono::system_clock::now();
-	apl_get_calc_fps(tick, tickforCalcFps, calcFPS);
+	const int win_x = 20 + (660 * dev->idx);		// Windows Of Devices Side By Side
+	const int win_x_sub = 20 + (660 * (gPrm.dev_num + dev->idx));
+	const int win_x_nrm = 20 + (660 * ((2 * gPrm.dev_num) + dev->idx));
+	const std::string win_depth    = apl_win_name(dev, OPENCV_WINDOW_NAME_DPTH);
+	const std::string win_ir       = apl_win_name(dev, OPENCV_WINDOW_NAME_IR);
+	const std::string win_confdata = apl_win_name(dev, OPENCV_WINDOW_NAME_CONFDATA);
+	const std::string win_irnrref  = apl_win_name(dev, OPENCV_WINDOW_NAME_IRNRREF);
+	const std::string win_normal   = apl_win_name(dev, OPENCV_WINDOW_NAME_NORMAL);
+	cv::Mat rec_depth;	// shares images of windows, copied by apl_rec_push()
+	cv::Mat rec_ir;
+
+	tick = std::chrono::steady_clock::now();
+	apl_get_calc_fps(tick, dev->tick_fps, calcFPS);
 
 	show_depth = true;
 	show_ir = true;
@@ -1061,7 +1710,7 @@ void apl_show_img(TL_E_MODE mode, TL_E_IMAGE_KIND img_kind, TL_Resolution reso,
 		//! \remark - Obtain Height, Width, Pointer To Data From Toflib-Output Message.
 		h = reso.depth.height;
 		w = reso.depth.width;
-		p_data = (uint8_t *)stData->depth;
+		p_data = (uint8_t *)plane_dp;
 
 
 		cv::Mat mat_depth_color;
@@ -1071,18 +1720,28 @@ void apl_show_img(TL_E_MODE mode, TL_E_IMAGE_KIND img_kind, TL_Resolution reso,
 		cv::Mat mat_depth_raw(h, w, CV_16UC1, p_data);
 
 		//! \remark - Decide The Range For Depth Base On Range Mode.
-		range_min = gPrm.mode_info_grp.mode[gPrm.mode].range_near;
-		range_max = gPrm.mode_info_grp.mode[gPrm.mode].range_far;
+		range_min = dev->mode_info_grp.mode[dev->view_mode].range_near;
+		range_max = dev->mode_info_grp.mode[dev->view_mode].range_far;
+
+		//! \remark - Or Base On Statistics Of Scene, Quantized To Limit Color Table Rebuild.
+		apl_stats_get(&dev->stats, &dp_stats);
+		if (gPrm.view_auto_range_on && (dp_stats.range_far > dp_stats.range_near)) {
+			range_step = (uint16_t)((dp_stats.range_far - dp_stats.range_near) / AUTO_RANGE_STEP_DIV);
+			range_step = (range_step != 0) ? range_step : 1;
+			range_min = (uint16_t)((dp_stats.range_near / range_step) * range_step);
+			range_max = (uint16_t)std::min<uint32_t>(((dp_stats.range_far + range_step - 1U) / range_step) * range_step, 0xFFFEU);
+		}
 
-		//! \remark - Depth To Color Conversion, Using OpenCV API.
-		mat_depth_color = apl_dpth_to_color_by_opencv(mat_depth_raw, range_min, range_max);
+		//! \remark - Depth To Color Conversion, Using Color Table Of OpenCV COLORMAP_JET.
+		(void)apl_color_lut_build(&dev->color_lut, range_min, range_max);
+		mat_depth_color = apl_dpth_to_color_by_lut(mat_depth_raw, &dev->color_lut);
 #else
 		const fwc::stRGB* tbl = color_tbl->getTbl();
 		mat_depth_color = cv::Mat::zeros(static_cast<int>(h), static_cast<int>(w), CV_8UC3);
 		fwc::stRGB* dst = reinterpret_cast<fwc::stRGB*>(mat_depth_color.data);
 
 		//! \remark - Convert uint16 To RGB
-		uint16_t* src = static_cast<uint16_t*>(stData->depth);
+		uint16_t* src = static_cast<uint16_t*>(plane_dp);
 		uint16_t* end = src + (w * h);
 
 		for (; src < end; src++, dst++) {
@@ -1091,7 +1750,7 @@ void apl_show_img(TL_E_MODE mode, TL_E_IMAGE_KIND img_kind, TL_Resolution reso,
 #endif
 
 		//! \remark - Add Fps Text.
-		std::snprintf(str, sizeof(str), "fps=%d [instant fps=%.1f]", calcfps, calcFPS);
+		std::snprintf(str, sizeof(str), "fps=%d [instant fps=%.1f]", dev->calcfps, calcFPS);
 		cv::putText(mat_depth_color, std::string(str), cv::Point(10, 20), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.6, cv::Scalar(255, 255, 255), 1, cv::LINE_AA);
 
 		//! \remark - Add Temperature Text.
@@ -1099,9 +1758,59 @@ void apl_show_img(TL_E_MODE mode, TL_E_IMAGE_KIND img_kind, TL_Resolution reso,
 		std::snprintf(str, sizeof(str), "temperature=%d.%d C", temperature/100, temperature%100);
 		cv::putText(mat_depth_color, std::string(str), cv::Point(10, 40), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.6, cv::Scalar(255, 255, 255), 1, cv::LINE_AA);
 
+		//! \remark - Add Frame Loss Text.
+		apl_tlm_snapshot tlm;
+		apl_tlm_get(dev->idx, &tlm);
+		std::snprintf(str, sizeof(str), "lost=%llu drop=%llu error=%llu", (unsigned long long)tlm.lost, (unsigned long long)tlm.pipeline_drop, (unsigned long long)tlm.frame_error);
+		cv::putText(mat_depth_color, std::string(str), cv::Point(10, 60), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.6, cv::Scalar(255, 255, 255), 1, cv::LINE_AA);
+
+		//! \remark - Add Color Range Text.
+		std::snprintf(str, sizeof(str), "range=%u-%u mm%s valid=%.0f%%", range_min, range_max, gPrm.view_auto_range_on ? " (auto)" : "", dp_stats.valid_ratio * 100);
+		cv::putText(mat_depth_color, std::string(str), cv::Point(10, 80), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.6, cv::Scalar(255, 255, 255), 1, cv::LINE_AA);
+
+		//! \remark - Add Distance Of Regions Of Interest.
+		apl_roi_rect roi_rect[APL_ROI_MAX];
+		apl_roi_res roi_res[APL_ROI_MAX];
+		size_t roi_num = apl_roi_get(&dev->roi, roi_rect, roi_res);
+		for (size_t i = 0; i < roi_num; i++) {
+			cv::Rect rect(roi_rect[i].x, roi_rect[i].y, roi_rect[i].w, roi_rect[i].h);
+			cv::rectangle(mat_depth_color, rect, cv::Scalar(255, 255, 255), 1);
+			std::snprintf(str, sizeof(str), "%.0f+-%.0f mm %.0f%%", roi_res[i].mean, std::sqrt(roi_res[i].var), roi_res[i].coverage * 100);
+			cv::putText(mat_depth_color, std::string(str), cv::Point(rect.x + 2, rect.y + 12), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.6, cv::Scalar(255, 255, 255), 1, cv::LINE_AA);
+		}
+
+		//! \remark - Add Foreground Blobs.
+		if (dev->bg_on) {
+			apl_bg_blob blob[APL_BG_BLOB_MAX];
+			float fg_ratio;
+			size_t blob_num = apl_bg_get(&dev->bg, blob, &fg_ratio);
+			for (size_t i = 0; i < blob_num; i++) {
+				cv::Rect rect(blob[i].x, blob[i].y, blob[i].w, blob[i].h);
+				cv::rectangle(mat_depth_color, rect, cv::Scalar(0, 255, 0), 1);
+				std::snprintf(str, sizeof(str), "%.0f mm", blob[i].mean);
+				cv::putText(mat_depth_color, std::string(str), cv::Point(rect.x + 2, rect.y + rect.height - 4), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.6, cv::Scalar(0, 255, 0), 1, cv::LINE_AA);
+			}
+			std::snprintf(str, sizeof(str), "blobs=%zu foreground=%.1f%%", blob_num, fg_ratio * 100);
+			cv::putText(mat_depth_color, std::string(str), cv::Point(10, 100), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.6, cv::Scalar(255, 255, 255), 1, cv::LINE_AA);
+		}
+
+		//! \remark - Add Floor Plane.
+		if (dev->plane_on) {
+			apl_plane_res plane;
+			apl_plane_get(&dev->plane, &plane);
+			if (plane.valid) {
+				std::snprintf(str, sizeof(str), "floor: height=%.0f mm tilt=%.1f inliers=%.0f%%", plane.d, plane.tilt, plane.inlier_ratio * 100);
+			}
+			else {
+				std::snprintf(str, sizeof(str), "floor: not found");
+			}
+			cv::putText(mat_depth_color, std::string(str), cv::Point(10, 120), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.6, cv::Scalar(255, 255, 255), 1, cv::LINE_AA);
+		}
+
 		//! \remark - Display It.
-		cv::imshow(OPENCV_WINDOW_NAME_DPTH, mat_depth_color);
-		cv::moveWindow(OPENCV_WINDOW_NAME_DPTH, 20, 20);
+		rec_depth = mat_depth_color;
+		cv::imshow(win_depth, mat_depth_color);
+		cv::moveWindow(win_depth, win_x, 20);
 		cv::waitKey(1);	// Draw The Screen And Wait For 1 Millisecond.
 	}
 
@@ -1111,24 +1820,18 @@ void apl_show_img(TL_E_MODE mode, TL_E_IMAGE_KIND img_kind, TL_Resolution reso,
 		//! \remark - Obtain Height, Width, Pointer To Data From Toflib-Output Message.
 		h = reso.ir.height;
 		w = reso.ir.width;
-		p_data = (uint8_t *)stData->ir;
+		p_data = (uint8_t *)plane_ir;
 
 		//! \remark - Create Cv Matrix, 16 Bits.
-		cv::Mat mat_ir(h, w, CV_16UC1, p_data);
-
-		//! \remark - Convert To Double For "pow()".
-		cv::Mat mat_ir_64f;
-		mat_ir.convertTo(mat_ir_64f, CV_64F);
+		cv::Mat mat_ir_raw(h, w, CV_16UC1, p_data);
 
-		//! \remark - Apply Gamma Correction.
-		cv::Mat mat_ir_pow;
-		cv::pow(mat_ir_64f, (float) gamma_corr_ir/10, mat_ir_pow);
-
-		//! \remark - Convert Back To 16Bits.
-		mat_ir_pow.convertTo(mat_ir, CV_16UC1);
+		//! \remark - Apply Gamma Correction, Frame Is Kept As Captured (Saved Or Held By Trigger Ring).
+		cv::Mat &mat_ir = dev->mat_ir;
+		mat_ir.create(h, w, CV_16UC1);
+		apl_gamma_by_opencv(mat_ir_raw, mat_ir, (float) dev->gamma_corr_ir/10);
 
 		//! \remark - Add Fps Text.
-		std::snprintf(str, sizeof(str), "fps=%d [instant fps=%.1f]", calcfps, calcFPS);
+		std::snprintf(str, sizeof(str), "fps=%d [instant fps=%.1f]", dev->calcfps, calcFPS);
 		cv::putText(mat_ir, std::string(str), cv::Point(10, 20), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.6, cv::Scalar(255, 255, 255), 1, cv::LINE_AA);
 
 		//! \remark - Add Temperature Text.
@@ -1137,12 +1840,18 @@ void apl_show_img(TL_E_MODE mode, TL_E_IMAGE_KIND img_kind, TL_Resolution reso,
 		cv::putText(mat_ir, std::string(str), cv::Point(10, 40), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.6, cv::Scalar(255, 255, 255), 1, cv::LINE_AA);
 
 		//! \remark - Display It.
-		cv::createTrackbar(OPENCV_TRACKBAR_NAME_GAMMA_CORR_IR, OPENCV_WINDOW_NAME_IR, &gamma_corr_ir, 30);
-		cv::imshow(OPENCV_WINDOW_NAME_IR, mat_ir);
-		cv::moveWindow(OPENCV_WINDOW_NAME_IR, 20, 520);
+		cv::createTrackbar(OPENCV_TRACKBAR_NAME_GAMMA_CORR_IR, win_ir, &dev->gamma_corr_ir, 30);
+		rec_ir = mat_ir;
+		cv::imshow(win_ir, mat_ir);
+		cv::moveWindow(win_ir, win_x, 520);
 		cv::waitKey(1);	// Draw The Screen And Wait For 1 Millisecond.
 	}
 
+	//! \remark - Queue Windows With Overlay For Video Export, Dropped When Encoder Is Behind. First Device Only.
+	if (dev->idx == 0) {
+		apl_rec_push(rec_depth, rec_ir);
+	}
+
 	if (show_confdat) {
 		// --------------------------------------------------
 		//! \remark - Proecess CONFDATA Image
@@ -1152,28 +1861,22 @@ void apl_show_img(TL_E_MODE mode, TL_E_IMAGE_KIND img_kind, TL_Resolution reso,
 		p_data = (uint8_t *)stData->confdata;
 
 		//! \remark - Create Cv Matrix, 16 Bits.
-		cv::Mat mat_confdata(h, w, CV_16UC1, p_data);
-
-		//! \remark - Convert To Double For "pow()".
-		cv::Mat mat_confdata_64f;
-		mat_confdata.convertTo(mat_confdata_64f, CV_64F);
-
-		//! \remark - Apply Gamma Correction.
-		cv::Mat mat_confdata_pow;
-		cv::pow(mat_confdata_64f, (float) 3.0, mat_confdata_pow);
+		cv::Mat mat_confdata_raw(h, w, CV_16UC1, p_data);
 
-		//! \remark - Convert Back To 16Bits.
-		mat_confdata_pow.convertTo(mat_confdata, CV_16UC1);
+		//! \remark - Apply Gamma Correction, Out Of Place.
+		cv::Mat &mat_confdata = dev->mat_confdata;
+		mat_confdata.create(h, w, CV_16UC1);
+		apl_gamma_by_opencv(mat_confdata_raw, mat_confdata, (float) 3.0);
 
 		//! \remark - Display It.
-		cv::imshow(OPENCV_WINDOW_NAME_CONFDATA, mat_confdata);
-		cv::moveWindow(OPENCV_WINDOW_NAME_CONFDATA, 680, 20);
+		cv::imshow(win_confdata, mat_confdata);
+		cv::moveWindow(win_confdata, win_x_sub, 20);
 		cv::waitKey(1);	// Draw The Screen And Wait For 1 Millisecond.
 	}
 	else {
 		//! \remark - Destroy It.
-		if (cv::getWindowProperty(OPENCV_WINDOW_NAME_CONFDATA, cv::WND_PROP_AUTOSIZE) != -1) {
-			cv::destroyWindow(OPENCV_WINDOW_NAME_CONFDATA);
+		if (cv::getWindowProperty(win_confdata, cv::WND_PROP_AUTOSIZE) != -1) {
+			cv::destroyWindow(win_confdata);
 		}
 	}
 
@@ -1186,62 +1889,358 @@ void apl_show_img(TL_E_MODE mode, TL_E_IMAGE_KIND img_kind, TL_Resolution reso,
 		p_data = (uint8_t *)stData->irnrref;
 
 		//! \remark - Create Cv Matrix, 16 Bits.
-		cv::Mat mat_irnrref(h, w, CV_16UC1, p_data);
+		cv::Mat mat_irnrref_raw(h, w, CV_16UC1, p_data);
 
-		//! \remark - Convert To Double For "pow()".
-		cv::Mat mat_irnrref_64f;
-		mat_irnrref.convertTo(mat_irnrref_64f, CV_64F);
+		//! \remark - Apply Gamma Correction, Out Of Place.
+		cv::Mat &mat_irnrref = dev->mat_irnrref;
+		mat_irnrref.create(h, w, CV_16UC1);
+		apl_gamma_by_opencv(mat_irnrref_raw, mat_irnrref, (float) 6.2);
+
+		//! \remark - Display It.
+		cv::imshow(win_irnrref, mat_irnrref);
+		cv::moveWindow(win_irnrref, win_x_sub, 520);
+		cv::waitKey(1);	// Draw The Screen And Wait For 1 Millisecond.
+	}
+	else {
+		//! \remark - Destroy It.
+		if (cv::getWindowProperty(win_irnrref, cv::WND_PROP_AUTOSIZE) != -1) {
+			cv::destroyWindow(win_irnrref);
+		}
+	}
 
-		//! \remark - Apply Gamma Correction.
-		cv::Mat mat_irnrref_pow;
-		cv::pow(mat_irnrref_64f, (float) 6.2, mat_irnrref_pow);
+	if (show_normal) {
+		// --------------------------------------------------
+		//! \remark - Process Normals Of Depth
+		h = reso.depth.height;
+		w = reso.depth.width;
 
-		//! \remark - Convert Back To 16Bits.
-		mat_irnrref_pow.convertTo(mat_irnrref, CV_16UC1);
+		//! \remark - Normal To Color (r = x, g = y, b = -z), Invalid Is Black.
+		cv::Mat &mat_normal = dev->mat_normal;
+		mat_normal.create(h, w, CV_8UC3);
+		apl_nrm_color(apl_frm_of(stData)->nrm, w * h, mat_normal.data);
 
 		//! \remark - Display It.
-		cv::imshow(OPENCV_WINDOW_NAME_IRNRREF, mat_irnrref);
-		cv::moveWindow(OPENCV_WINDOW_NAME_IRNRREF, 680, 520);
+		cv::imshow(win_normal, mat_normal);
+		cv::moveWindow(win_normal, win_x_nrm, 20);
 		cv::waitKey(1);	// Draw The Screen And Wait For 1 Millisecond.
 	}
 	else {
 		//! \remark - Destroy It.
-		if (cv::getWindowProperty(OPENCV_WINDOW_NAME_IRNRREF, cv::WND_PROP_AUTOSIZE) != -1) {
-			cv::destroyWindow(OPENCV_WINDOW_NAME_IRNRREF);
+		if (cv::getWindowProperty(win_normal, cv::WND_PROP_AUTOSIZE) != -1) {
+			cv::destroyWindow(win_normal);
+		}
+	}
+}
+
+
+//******************************************************************************
+//! \brief        Route Command Of Control Channel, Called On Channel Thread
+//! \details      Commands of capture and view are queued and executed between their frames,
+//!               others are answered here. Commands apply to all devices.
+//! \param[in]    cmd          Command.
+//! \param[out]   reply        Reply, empty = "ok".
+//! \return       None
+//******************************************************************************
+static void apl_ctl_dispatch(const apl_ctl_cmd *cmd, std::string *reply)
+{
+	bool trig_on = false;
+	uint8_t d;
+
+	switch (cmd->cmd) {
+		case APL_CTL_CMD_SAVE:
+		case APL_CTL_CMD_VIEW:
+			if (!apl_ctl_push(&sViewCtl, cmd)) {
+				*reply = "error: busy\n";
+			}
+			break;
+		case APL_CTL_CMD_MODE:
+		case APL_CTL_CMD_START:
+		case APL_CTL_CMD_STOP:
+			if (cmd->cmd == APL_CTL_CMD_MODE) {
+				for (d = 0; d < gPrm.dev_num; d++) {
+					if ((cmd->arg >= TL_E_MODE_NUM) || (sDev[d]->mode_info_grp.mode[cmd->arg].enable != TL_E_TRUE)) {
+						*reply = "error: mode is not available\n";
+						return;
+					}
+				}
+			}
+			for (d = 0; d < gPrm.dev_num; d++) {
+				if (!apl_ctl_push(&sDev[d]->cap_ctl, cmd)) {
+					*reply = "error: busy\n";
+				}
+			}
+			break;
+		case APL_CTL_CMD_STATS:
+			apl_mtr_format(reply);
+			break;
+		case APL_CTL_CMD_TRIGGER:
+			for (d = 0; d < gPrm.dev_num; d++) {
+				if (sDev[d]->trig_on) {
+					apl_trig_fire(&sDev[d]->trig);
+					trig_on = true;
+				}
+			}
+			if (!trig_on) {
+				*reply = "error: trigger is off\n";
+			}
+			break;
+		case APL_CTL_CMD_QUIT:
+			bExit = true;
+			break;
+		default:
+			break;
+	}
+}
+
+//******************************************************************************
+//! \brief        Switch Ranging Mode, Capture Is Stopped While Switched
+//! \param[in]    dev          Device.
+//! \param[in]    mode         Ranging Mode.
+//! \return       None
+//******************************************************************************
+static void apl_set_mode(apl_dev *dev, TL_E_MODE mode)
+{
+	const TL_ModeInfo &info = dev->mode_info_grp.mode[mode];
+	TL_Resolution reso;
+	TL_E_RESULT ret;
+
+	if ((!dev->cap_stop) && (apl_stop(dev) < 0)) {
+		return;
+	}
+
+	ret = TL_setProperty(dev->handle, TL_CMD_MODE, (void*)&mode);
+	if (ret != TL_E_SUCCESS) {
+		apl_print_error(ret, (char *)"TL_setProperty TL_CMD_MODE", __LINE__);
+	}
+	else
+	if ((TL_getProperty(dev->handle, TL_CMD_RESOLUTION, (void*)&reso) != TL_E_SUCCESS) ||
+		(reso.ir.width != dev->resolution.ir.width) || (reso.ir.height != dev->resolution.ir.height) ||
+		(reso.depth.width != dev->dp_raw.width) || (reso.depth.height != dev->dp_raw.height)) {
+		// Frame Buffers, Lens And Stages Are Sized By Resolution, Mode Of Other Size Needs Restart
+		printf("Mode %d : resolution differs from mode %d, not selected (device %u)\n", mode + 1, dev->mode + 1, dev->idx);
+		(void)TL_setProperty(dev->handle, TL_CMD_MODE, (void*)&dev->mode);
+	}
+	else {
+		//! \remark Stages Of Capture Thread Are Not Running, Every Per-Mode State Is Set Again.
+		dev->mode = mode;
+		apl_dp_cnv_init(&dev->dp_cnv, info.depth_unit, dev->dp_cnv.tcc_on, dev->dp_cnv.slope_one);
+		apl_stamp_init(dev->idx, info.fps, (apl_cfg_get_int("time.realtime", 1) != 0));
+		apl_tlm_mode(dev->idx, info.fps);
+		apl_stats_range(&dev->stats, (uint16_t)std::min<uint32_t>((uint32_t)RAW12_INVALID_DEPTH * dev->dp_cnv.unit, 0xFFFFU));
+		if (dev->scan_on) {
+			apl_scan_range(&dev->scan, info.range_near, info.range_far);
+		}
+		printf("Mode selected : %d (device %u)\n", dev->mode + 1, dev->idx);
+	}
+
+	if ((!dev->cap_stop) && (apl_start(dev) < 0)) {
+		dev->cap_stop = true;
+	}
+}
+
+//******************************************************************************
+//! \brief        Execute Commands Of Capture Thread, Between Frames
+//! \param[in]    dev          Device.
+//! \return       None
+//******************************************************************************
+static void apl_cap_ctl(apl_dev *dev)
+{
+	apl_ctl_cmd cmd;
+
+	while (apl_ctl_pop(&dev->cap_ctl, &cmd)) {
+		switch (cmd.cmd) {
+			case APL_CTL_CMD_START:
+				if (dev->cap_stop && (apl_start(dev) == 0)) {
+					apl_stamp_resume(dev->idx);
+					dev->cap_stop = false;
+					printf("Capture : started (device %u)\n", dev->idx);
+				}
+				break;
+			case APL_CTL_CMD_STOP:
+				if ((!dev->cap_stop) && (apl_stop(dev) == 0)) {
+					dev->cap_stop = true;
+					printf("Capture : stopped (device %u)\n", dev->idx);
+				}
+				break;
+			case APL_CTL_CMD_MODE:
+				apl_set_mode(dev, (TL_E_MODE)cmd.arg);
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+//******************************************************************************
+//! \brief        Execute Commands Of View Thread, Between Frames
+//! \return       None
+//******************************************************************************
+static void apl_view_ctl(void)
+{
+	static const char *TRKBAR[APL_CTL_VIEW_NUM] = {
+		OPENCV_TRACKBAR_NAME_TOGGLE_CONFDAT, OPENCV_TRACKBAR_NAME_TOGGLE_IRNRREF, OPENCV_TRACKBAR_NAME_TOGGLE_AUTORANGE,
+		OPENCV_TRACKBAR_NAME_TOGGLE_NORMAL
+	};
+	bool *view[APL_CTL_VIEW_NUM] = { &gPrm.view_confdat_on, &gPrm.view_irnrref_on, &gPrm.view_auto_range_on, &gPrm.view_normal_on };
+	apl_ctl_cmd cmd;
+	uint8_t d;
+
+	while (apl_ctl_pop(&sViewCtl, &cmd)) {
+		switch (cmd.cmd) {
+			case APL_CTL_CMD_SAVE:
+				for (d = 0; d < gPrm.dev_num; d++) {
+					sDev[d]->save_req = (uint16_t)cmd.arg;		// Starts After Saving In Progress
+				}
+				break;
+			case APL_CTL_CMD_VIEW:
+				*view[cmd.arg] = (cmd.arg2 < 0) ? !*view[cmd.arg] : (cmd.arg2 != 0);
+				cv::setTrackbarPos(TRKBAR[cmd.arg], OPENCV_WINDOW_NAME_PANEL_VIEWER, *view[cmd.arg] ? 1 : 0);
+				break;
+			default:
+				break;
 		}
 	}
 }
 
 
 //******************************************************************************
-//! \brief        Thread to handle image capture and view
+//! \brief        Thread to handle image capture of one device
 //! \n
-//! \param[in]    data         Data.
+//! \param[in]    data         Device.
 //! \return       void pointer
 //! \date         2021-11-30, Tue, 02:33 PM
 //******************************************************************************
-void *user_input_thread(void *data)
+void *capture_thread(void *data)
 {
-	std::string tempInput;
+	apl_dev *dev = static_cast<apl_dev *>(data);
+	std::chrono::steady_clock::time_point tickforFixFps = (std::chrono::steady_clock::time_point::min)();
+	unsigned int end;
 
-	while (true) {
-		if (userInput.empty()) {
-			std::cout << std::endl;
-			std::cout << "Enter number of files to save: ";
-			std::getline(std::cin, tempInput);
+	dev->fps_start = apl_get_tick_cnt();
+
+	while (!bExit) {
+		tickforFixFps = std::chrono::steady_clock::now();
 
-			// Lock The Mutex Before Accessing Shared Data
-			std::lock_guard<std::mutex> lock(mutexUserInput);
-			userInput = tempInput;   // Copy The Input To The Shared Variable
+		// Commands Between Frames, Idle While Stopped
+		apl_cap_ctl(dev);
+		if (dev->cap_stop) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			continue;
 		}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(500));
+		apl_capture(dev);
+
+		int fps_now = dev->mode_info_grp.mode[dev->mode].fps;
+		apl_fix_fps(fps_now, tickforFixFps); //!< Put here to adjust the capture interval
+
+		dev->fps_cnt++;
+		end = apl_get_tick_cnt();
+		if ((end - dev->fps_start) >= 1000) {
+			dev->calcfps = dev->fps_cnt;
+			dev->fps_cnt = 0;
+			dev->fps_start = end;
+		}
 	}
+
+	return nullptr;
 }
 
 
 //******************************************************************************
-//! \brief        Thread to handle image capture and view
+//! \brief        Follow Ranging Mode Of Frames, Per-Mode State Of View Thread Is Set Again
+//! \param[in]    dev          Device.
+//! \param[in]    mode         Ranging mode of frame.
+//! \return       None
+//******************************************************************************
+static void apl_view_mode(apl_dev *dev, TL_E_MODE mode)
+{
+	const TL_ModeInfo &info = dev->mode_info_grp.mode[mode];
+
+	dev->view_mode = mode;
+
+#if USE_OPEN_CV_COLOR_MAP
+#else
+	fwc::stRange range = {
+		 static_cast<uint16_t>(static_cast<float>(info.range_near) * 0.9F)	// 10% more of whole range
+		,static_cast<uint16_t>(static_cast<float>(info.range_far)  * 1.1F)	// 10% more of whole range
+	};
+	color_tbl->setRange(range);
+#endif
+
+	// Pre-Trigger Length Is In Seconds, Frames Of Ring Follow Frame Rate
+	if (dev->trig_on) {
+		apl_trig_fps(&dev->trig, info.fps);
+	}
+}
+
+//******************************************************************************
+//! \brief        Show, save and keep one captured frame of device
+//! \param[in]    dev          Device.
+//! \param[in]    frm          Frame, released.
+//! \return       None
+//******************************************************************************
+static void apl_view_frame(apl_dev *dev, TL_Image *frm)
+{
+	uint64_t tick;
+
+	// Mode Switched By Capture Thread Arrives With Its First Frame
+	if (apl_frm_of(frm)->mode != dev->view_mode) {
+		apl_view_mode(dev, apl_frm_of(frm)->mode);
+	}
+
+	// Show the image
+	tick = apl_mtr_tick();
+	apl_show_img(dev, frm);
+	apl_mtr_observe(APL_MTR_STAGE_SHOW, tick);
+
+	// End To End, From Capture Timestamp
+	apl_stamp_latency(dev->idx, frm);
+	apl_mtr_observe(APL_MTR_STAGE_LATENCY, apl_frm_of(frm)->mono_ns);
+
+	// Save the image if request by user
+	tick = apl_mtr_tick();
+	apl_save_file(dev, frm);
+	apl_mtr_observe(APL_MTR_STAGE_SAVE, tick);
+
+	// Mesh of the image, built and written by writer thread from copy
+	if (dev->mesh_on) {
+		if (dev->rect_cloud) {
+			apl_mesh_out_push(&dev->mesh, apl_frm_of(frm)->rect_dp, apl_frm_of(frm)->rect_ir, apl_frm_of(frm)->seq);
+		}
+		else {
+			apl_mesh_out_push(&dev->mesh, static_cast<uint16_t *>(frm->depth), static_cast<uint16_t *>(frm->ir), apl_frm_of(frm)->seq);
+		}
+	}
+
+	// Keep the image in pre-trigger ring, its oldest buffer is released instead
+	if (dev->trig_on) {
+		// Ring keeps planes that are saved, rectified ones are swapped in (same size, frame is not used after this)
+		if (dev->rect_save) {
+			uint16_t *dp = apl_frm_of(frm)->rect_dp;
+			uint16_t *ir = apl_frm_of(frm)->rect_ir;
+			apl_frm_of(frm)->rect_dp = static_cast<uint16_t *>(frm->depth);
+			apl_frm_of(frm)->rect_ir = static_cast<uint16_t *>(frm->ir);
+			frm->depth = dp;
+			frm->ir = ir;
+		}
+		if (dev->trig_on_blob) {
+			apl_bg_blob blob[APL_BG_BLOB_MAX];
+			float fg_ratio;
+			size_t blob_num = apl_bg_get(&dev->bg, blob, &fg_ratio);
+			if ((blob_num > 0) && (dev->blob_prev == 0)) {
+				apl_trig_fire(&dev->trig);
+			}
+			dev->blob_prev = blob_num;
+		}
+		apl_trig_put(&dev->trig, &frm);
+	}
+
+	apl_frmbuf_rel(dev, &frm);
+}
+
+
+//******************************************************************************
+//! \brief        Thread to handle image view of all devices (HighGUI is single threaded)
 //! \n
 //! \param[in]    data         Data.
 //! \return       void pointer
@@ -1249,31 +2248,135 @@ void *user_input_thread(void *data)
 //******************************************************************************
 void *view_thread(void *data)
 {
-	std::chrono::system_clock::time_point tickforFixFps = (std::chrono::system_clock::time_point::min)();
+	TL_Image *frm = nullptr;
+	bool shown;
+	uint8_t d;
 
 	apl_show_pnl();
 
-	start = apl_get_tick_cnt();
-
 	while (!bExit) {
-		tickforFixFps = std::chrono::system_clock::now();
+		// Commands Between Frames
+		apl_view_ctl();
 
-		apl_capture();
+		if (apl_frmbuf_wait_rdy(100) < 0) {
+			continue;
+		}
 
-		int fps_now = gPrm.mode_info_grp.mode[gPrm.mode].fps;
-		apl_fix_fps(fps_now, tickforFixFps); //!< Put here to adjust the capture interval
+		// Oldest Frame Of Each Device In Turn, Slow Device Does Not Starve Others
+		do {
+			shown = false;
+			for (d = 0; d < gPrm.dev_num; d++) {
+				if (apl_frmbuf_get_rdy(sDev[d], &frm) == 0) {
+					apl_view_frame(sDev[d], frm);
+					shown = true;
+				}
+			}
+		} while (shown && !bExit);
+	}
 
-		fps++;
-		end = apl_get_tick_cnt();
-		if ((end - start) >= 1000) {
-			calcfps = fps;
-			//std::cout << "fps = " << fps << std::endl;
-			fps = 0;
-			start = end;
+	return nullptr;
+}
+
+
+//******************************************************************************
+//! \brief        Initialize Device, Library Handle, Stages And Frame Buffers
+//! \details      Configuration keys of stages are read per device, "cam<d>.<key>" overrides "<key>".
+//! \param[in]    dev          Device, idx is set.
+//! \return       0            success
+//! \return       -1           failed
+//******************************************************************************
+static int apl_dev_init(apl_dev *dev)
+{
+	const uint8_t d = dev->idx;
+	int m;
+
+	// Ranging Mode Of Argument, Or Of Device
+	dev->mode = gPrm.mode;
+	m = apl_cfg_get_dev_int(d, "mode", 0);
+	if ((m > 0) && (m <= TL_E_MODE_NUM)) {
+		dev->mode = (TL_E_MODE)(m - 1);
+	}
+	dev->view_mode = dev->mode;
+	dev->gamma_corr_ir = 22;	//!< Default Gamma Value Is 2.2 (For OpenCV TrackBar Used).
+	dev->tick_fps = (std::chrono::steady_clock::time_point::min)();
+
+	if (apl_init(dev) < 0) {
+		printf ("apl_init failed\n");
+		return -1;
+	}
+
+	apl_images_size(dev);
+
+	apl_tlm_init(d, dev->mode_info_grp.mode[dev->mode].fps);
+	apl_stamp_init(d, dev->mode_info_grp.mode[dev->mode].fps, (apl_cfg_get_int("time.realtime", 1) != 0));
+
+	apl_dp_cnv_init(&dev->dp_cnv,
+					dev->mode_info_grp.mode[dev->mode].depth_unit,
+					(apl_cfg_get_dev_int(d, "depth.tcc", 0) != 0),
+					(uint16_t)apl_cfg_get_dev_int(d, "depth.tcc_slope_one", APL_DP_TCC_SLOPE_ONE));
+	printf("Temperature correction : %s\n", dev->dp_cnv.tcc_on ? "on" : "off");
+
+	// Flying Pixel Filter Of Depth As Captured
+	dev->dp_raw = dev->resolution.depth;
+	apl_load_fly(dev);
+
+	// Depth Upsampling, Stages After It Work On Depth Of IR Resolution
+	if (gPrm.image_kind == TL_E_IMAGE_KIND_VGA_IR_QVGA_DEPTH) {
+		if ((dev->resolution.ir.width == (dev->dp_raw.width * 2)) && (dev->resolution.ir.height == (dev->dp_raw.height * 2))) {
+			apl_jbu_init(&dev->jbu, dev->dp_raw.width, dev->dp_raw.height,
+						 apl_cfg_get_dev_float(d, "upsample.sigma_s", 0.8F),
+						 apl_cfg_get_dev_float(d, "upsample.sigma_r", 32.0F));
+			dev->resolution.depth = dev->resolution.ir;
+			dev->jbu_out = apl_arena_alloc((size_t)dev->resolution.depth.width * dev->resolution.depth.height * sizeof(uint16_t));
+			dev->jbu_on = true;
+			printf("Depth upsampling : %ux%u -> %ux%u\n", dev->dp_raw.width, dev->dp_raw.height, dev->resolution.depth.width, dev->resolution.depth.height);
+		}
+		else {
+			printf("Depth upsampling : ir is not twice of depth, depth stays %ux%u\n", dev->dp_raw.width, dev->dp_raw.height);
 		}
 	}
 
-	return nullptr;
+	apl_stats_init(&dev->stats,
+				   (uint16_t)std::min<uint32_t>((uint32_t)RAW12_INVALID_DEPTH * dev->dp_cnv.unit, 0xFFFFU),
+				   (uint16_t)apl_cfg_get_dev_int(d, "stats.stride", 2),
+				   apl_cfg_get_dev_float(d, "stats.alpha", 0.1F));
+
+	apl_load_fill(dev);
+
+	apl_roi_init(&dev->roi, dev->resolution.depth.width, dev->resolution.depth.height);
+	apl_load_roi(dev);
+
+	dev->bg_on = (apl_cfg_get_dev_int(d, "bg.on", 0) != 0);
+	if (dev->bg_on) {
+		apl_bg_init(&dev->bg, dev->resolution.depth.width, dev->resolution.depth.height,
+					apl_cfg_get_dev_float(d, "bg.alpha", 0.02F),
+					apl_cfg_get_dev_float(d, "bg.alpha_fg", 0.002F),
+					apl_cfg_get_dev_float(d, "bg.k", 3.0F),
+					(uint16_t)apl_cfg_get_dev_int(d, "bg.noise_mm", 20),
+					(uint32_t)apl_cfg_get_dev_int(d, "bg.min_area", 100));
+		printf("Background model : alpha=%.3f alpha_fg=%.4f k=%.1f\n", dev->bg.alpha, dev->bg.alpha_fg, std::sqrt(dev->bg.k2));
+	}
+
+	if (apl_lens_init(&dev->lens, &dev->lens_info, &dev->fov, dev->resolution.depth.width, dev->resolution.depth.height) < 0) {
+		printf("apl_lens_init failed, 3D stages are disabled\n");
+	}
+	else {
+		printf("Lens : fx=%.1f fy=%.1f cx=%.1f cy=%.1f\n", dev->lens.fx, dev->lens.fy, dev->lens.cx, dev->lens.cy);
+		apl_load_rect(dev);
+		apl_load_scan(dev);
+		apl_load_plane(dev);
+		apl_load_nrm(dev);
+		apl_load_mesh(dev);
+	}
+
+	apl_frmbuf_alloc(dev, FRM_BUF_CNT, dev->resolution);
+
+	// Takes Are Raw Files Of Planes, Or One File Of Records With crc32c And Index ("take")
+	dev->save_take = (strcmp(apl_cfg_get_dev_str(dev->idx, "save.format", "raw"), "take") == 0);
+	dev->save_sync = (uint32_t)apl_cfg_get_dev_int(dev->idx, "save.sync", 0);
+	apl_load_trig(dev);
+
+	return 0;
 }
 
 
@@ -1301,13 +2404,31 @@ int main(int argc, char *argv[])
 	if (SIG_ERR == signal(SIGQUIT, apl_signal_handler)) { printf("SIGQUIT error(%d)\n", errno); };
 	if (SIG_ERR == signal(SIGTERM, apl_signal_handler)) { printf("SIGTERM error(%d)\n", errno); };
 	if (SIG_ERR == signal(SIGINT,  apl_signal_handler)) { printf("SIGINT error(%d)\n",  errno); };
+	if (SIG_ERR == signal(SIGUSR1, SIG_IGN)) { printf("SIGUSR1 error(%d)\n", errno); };	// Trigger Until Devices Are Up
 
 	memset(&gPrm, 0, sizeof(gPrm));
 
+	// Load Configuration, Thread Scheduling Per Role
+	const char *conf = getenv(APL_CFG_ENV_FILE);
+	if (apl_cfg_load((conf != NULL) ? conf : APL_CFG_DEF_FILE) == 0) {
+		printf("Configuration : %s\n", (conf != NULL) ? conf : APL_CFG_DEF_FILE);
+	}
+	apl_thr_load_cfg();
+
 	// Default Setting
 	gPrm.mode = TL_E_MODE_0;
 	gPrm.image_kind = TL_E_IMAGE_KIND_VGA_DEPTH_IR;
 
+	// Image Kind From Configuration
+	const char *image_kind = apl_cfg_get_str("image.kind", "vga_depth_ir");
+	if (strcmp(image_kind, "vga_ir_qvga_depth") == 0) {
+		gPrm.image_kind = TL_E_IMAGE_KIND_VGA_IR_QVGA_DEPTH;
+	}
+	else
+	if (strcmp(image_kind, "vga_depth_ir") != 0) {
+		printf("image.kind : unsupported \"%s\", use vga_depth_ir\n", image_kind);
+	}
+
 	// Get User Mode From Argument
 	if (argc > 1) {
 		m = static_cast<uint8_t>(atoi(argv[1]));
@@ -1321,51 +2442,150 @@ int main(int argc, char *argv[])
 	}
 	printf("Mode selected : %d\n", gPrm.mode + 1);	// Cis Mode Index From 1 to 6 From User Input Perpective (But In Code, Always Index From 0)
 
+	// Devices Of This Process, Each Drives One Sensor
+	int dev_num = apl_cfg_get_int("camera.num", 1);
+	if ((dev_num < 1) || (dev_num > APL_DEV_MAX)) {
+		printf("camera.num : %d out of 1-%d, use 1\n", dev_num, APL_DEV_MAX);
+		dev_num = 1;
+	}
+	gPrm.dev_num = (uint8_t)dev_num;
+	gPrm.view_auto_range_on = (apl_cfg_get_int("color.auto_range", 0) != 0);
+	gPrm.view_normal_on = (apl_cfg_get_int("normal.view", 0) != 0);
+
+	// Arena Of Frame Buffers And Stage Workspaces, Shared By Devices
+	const char *arena_pages = apl_cfg_get_str("arena.pages", "thp");
+	APL_ARENA_PAGE arena_page = APL_ARENA_PAGE_THP;
+	if (strcmp(arena_pages, "4k") == 0) {
+		arena_page = APL_ARENA_PAGE_4K;
+	}
+	else
+	if (strcmp(arena_pages, "hugetlb") == 0) {
+		arena_page = APL_ARENA_PAGE_HUGETLB;
+	}
+	if (apl_arena_init((size_t)apl_cfg_get_int("arena.size_mb", 32 * gPrm.dev_num) * 1024 * 1024, arena_page) < 0) {
+		printf("apl_arena_init failed, buffers are allocated from heap\n");
+	}
+
 	// User Have On Camera Streaming, Proceed.
-	if ((ret = apl_init(gPrm.mode, gPrm.image_kind)) < 0) {
-		printf ("apl_init failed\n");
-		exit(-1);
+	for (uint8_t d = 0; d < gPrm.dev_num; d++) {
+		sDev[d] = new apl_dev();
+		sDev[d]->idx = d;
+		if ((ret = apl_dev_init(sDev[d])) < 0) {
+			printf ("apl_dev_init failed (device %u)\n", d);
+			exit(-1);
+		}
 	}
 
-	apl_images_size();
+	// Trigger Handler Reads Devices, Installed Once All Of Them Are Up
+	if (SIG_ERR == signal(SIGUSR1, apl_trig_signal_handler)) { printf("SIGUSR1 error(%d)\n", errno); };
 
-	apl_frmbuf_alloc(FRM_BUF_CNT, gPrm.resolution);
+	if (apl_cfg_get_int("arena.mlock", 0) != 0) {
+		(void)apl_arena_lock();
+	}
+	apl_arena_report(stdout);
 
-	if (apl_start() < 0) {
-		printf ("apl_start failed\n");
-		(void) apl_term();
-		exit(-1);
+	// Start Worker Pool For Per-Frame Kernels, On Big Cores, Shared By Capture Threads Of Devices
+	if (apl_pool_init(0, APL_POOL_CLUSTER_BIG) < 0) {
+		printf("apl_pool_init failed, kernels may run with less threads\n");
 	}
+	printf("Worker pool : %d threads\n", apl_pool_thread_num());
 
-	// Create Threads
-	if (pthread_create(&threadusrinp, NULL, user_input_thread, NULL) != 0) {
-		printf("pthread_create failed\n");
-		exit(-1);
+	for (uint8_t d = 0; d < gPrm.dev_num; d++) {
+		if (apl_start(sDev[d]) < 0) {
+			printf ("apl_start failed (device %u)\n", d);
+			for (uint8_t t = 0; t < gPrm.dev_num; t++) {
+				(void) apl_term(sDev[t]);
+			}
+			exit(-1);
+		}
+	}
+
+	// Control Channel, Commands From Stdin And Optional Unix Socket
+	const char *ctl_listen = apl_cfg_get_str("control.listen", nullptr);
+	bool ctl_stdin = (apl_cfg_get_int("control.stdin", 1) != 0);
+	if (apl_ctl_start(ctl_listen, ctl_stdin, apl_ctl_dispatch) < 0) {
+		printf("apl_ctl_start failed, no commands are accepted\n");
+	}
+	else {
+		printf("Control : %s %s, \"help\" lists commands\n", ctl_stdin ? "stdin" : "", (ctl_listen != nullptr) ? ctl_listen : "");
+	}
+
+	// Video Export Of Depth And IR Windows Of First Device, Encoder Is Started Before View Thread
+	const char *rec_output = apl_cfg_get_str("video.output", nullptr);
+	if (rec_output != nullptr) {
+		if (apl_rec_start(rec_output, sDev[0]->mode_info_grp.mode[sDev[0]->mode].fps,
+						  (uint32_t)apl_cfg_get_int("video.decimate", 1),
+						  (uint32_t)apl_cfg_get_int("video.queue", APL_REC_QUEUE_DEF)) < 0) {
+			printf("apl_rec_start failed, video is not recorded\n");
+		}
+		else {
+			printf("Video : %s_depth.avi, %s_ir.avi\n", rec_output, rec_output);
+		}
 	}
 
 	// Create Threads
-	if (pthread_create(&threadview, NULL, view_thread, NULL) != 0) {
+	if (apl_thr_create(&threadview, APL_THR_ROLE_DISPLAY, "tof_view", view_thread, NULL) != 0) {
 		printf("pthread_create failed\n");
 		exit(-1);
 	}
 
+	// Create Threads, One Capture Thread Per Device
+	for (uint8_t d = 0; d < gPrm.dev_num; d++) {
+		char name[16];
+		if (d == 0) {
+			std::snprintf(name, sizeof(name), "tof_capture");
+		}
+		else {
+			std::snprintf(name, sizeof(name), "tof_capture%u", d);
+		}
+		if (apl_thr_create(&sDev[d]->thr_cap, APL_THR_ROLE_CAPTURE, name, capture_thread, sDev[d]) != 0) {
+			printf("pthread_create failed\n");
+			exit(-1);
+		}
+	}
+
+	// Metrics Endpoint, e.g. "curl http://127.0.0.1:9100/metrics"
+	const char *mtr_listen = apl_cfg_get_str("metrics.listen", nullptr);
+	if (mtr_listen != nullptr) {
+		if (apl_mtr_start(mtr_listen) < 0) {
+			printf("apl_mtr_start failed, metrics are not served\n");
+		}
+		else {
+			printf("Metrics : %s\n", mtr_listen);
+		}
+	}
+
+	apl_thr_report();
+
 	// Spin Here
 	while (!bExit) {
 		sleep(1);
 	}
 
+	// No Trigger While Devices Are Torn Down
+	(void)signal(SIGUSR1, SIG_IGN);
+
 	// Abort Here
-	apl_cancel();
+	for (uint8_t d = 0; d < gPrm.dev_num; d++) {
+		apl_cancel(sDev[d]);
+	}
 
-	if (apl_stop() < 0) {
-		printf("app exit abnormal\n");
-		(void) apl_term();
-		exit(-1);
+	for (uint8_t d = 0; d < gPrm.dev_num; d++) {
+		if ((!sDev[d]->cap_stop) && (apl_stop(sDev[d]) < 0)) {
+			printf("app exit abnormal\n");
+			(void) apl_term(sDev[d]);
+			exit(-1);
+		}
 	}
 
+	// Wake Control Channel From poll()
+	apl_ctl_stop();
+
 	// Wait Threads Terminate
-	if (threadusrinp) {
-		pthread_join(threadusrinp, NULL);
+	for (uint8_t d = 0; d < gPrm.dev_num; d++) {
+		if (sDev[d]->thr_cap) {
+			pthread_join(sDev[d]->thr_cap, NULL);
+		}
 	}
 
 	// Wait Threads Terminate
@@ -1373,12 +2593,64 @@ int main(int argc, char *argv[])
 		pthread_join(threadview, NULL);
 	}
 
-	if (apl_term() < 0) {
-		printf("apl_term abnormal\n");
-		exit(-1);
+	// Encode Queued Frames And Close Videos
+	apl_rec_stop();
+
+	for (uint8_t d = 0; d < gPrm.dev_num; d++) {
+		apl_dev *dev = sDev[d];
+
+		// Finish Dump In Progress, Ring Buffers Are Freed Before Arena
+		if (dev->trig_on) {
+			dev->trig_on = false;
+			apl_trig_term(&dev->trig);
+		}
+
+		// Take Cut Short By Quit Is Valid Up To Its Last Frame
+		if (dev->take.fp != NULL) {
+			apl_take_close(&dev->take);
+		}
+
+		// Write Queued Meshes
+		if (dev->mesh_on) {
+			dev->mesh_on = false;
+			apl_mesh_out_term(&dev->mesh);
+		}
+
+		if (apl_term(dev) < 0) {
+			printf("apl_term abnormal\n");
+			exit(-1);
+		}
+	}
+
+	apl_mtr_stop();
+
+	for (uint8_t d = 0; d < gPrm.dev_num; d++) {
+		apl_dev *dev = sDev[d];
+
+		if (dev->scan_on) {
+			dev->scan_on = false;
+			apl_scan_close(&dev->scan);
+		}
+
+		apl_tlm_report(d, stdout);
+		apl_stamp_report(d, stdout);
+	}
+
+	apl_pool_term();
+
+	for (uint8_t d = 0; d < gPrm.dev_num; d++) {
+		apl_frmbuf_free(sDev[d]);
+
+		apl_arena_free(sDev[d]->jbu_out);
+		sDev[d]->jbu_out = NULL;
+		apl_arena_free(sDev[d]->rect_fill);
+		sDev[d]->rect_fill = NULL;
+
+		delete sDev[d];
+		sDev[d] = nullptr;
 	}
 
-	apl_frmbuf_free();
+	apl_arena_term();
 
 	return 0;
 }
@@ -0,0 +1,634 @@
+//******************************************************************************
+//! \file         viewer_bench.cpp
+//! \brief        benchmark of per-frame kernels, single thread vs worker pool.
+//! \details      Each kernel runs on synthetic VGA and QVGA frames of several scenes.
+//!               Results are printed as table, or as JSON (-j) for comparison across commits.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "tl.h"
+#include "apl_pool.h"
+#include "apl_kernel.h"
+#include "apl_stats.h"
+#include "apl_roi.h"
+#include "apl_lens.h"
+#include "apl_scan.h"
+#include "apl_bg.h"
+#include "apl_plane.h"
+#include "apl_jbu.h"
+#include "apl_fly.h"
+#include "apl_fill.h"
+#include "apl_rect.h"
+#include "apl_take.h"
+#include "apl_nrm.h"
+#include "apl_mesh.h"
+#include "apl_arena.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define BENCH_DEF_ITERATION		(100)	// default iterations per stage
+#define BENCH_DEF_SAVE_DIR		"/tmp"	// default directory of save stage
+#define BENCH_DEPTH_UNIT		(1)		// depth_unit [mm/digit]
+#define BENCH_RANGE_NEAR		(150)	// colormap range [mm]
+#define BENCH_RANGE_FAR			(4000)	// colormap range [mm]
+#define BENCH_IR_GAMMA			(2.2F)	// default gamma of viewer
+
+// Stage Under Measurement
+typedef enum {
+	 BENCH_STAGE_CNV_DP = 0	// apl_cnv_dp
+	,BENCH_STAGE_UPSAMPLE	// apl_jbu_run (half resolution depth to frame)
+	,BENCH_STAGE_FLY		// apl_fly_run (depth test)
+	,BENCH_STAGE_COLOR		// apl_dpth_to_color_by_opencv
+	,BENCH_STAGE_COLOR_LUT	// apl_dpth_to_color_by_lut
+	,BENCH_STAGE_GAMMA		// apl_gamma_by_opencv
+	,BENCH_STAGE_STATS		// apl_stats_calc
+	,BENCH_STAGE_FILL		// apl_fill_run (holes up to 16 pixels)
+	,BENCH_STAGE_RECT		// apl_rect_run (depth and ir, barrel distortion)
+	,BENCH_STAGE_NORMAL		// apl_nrm_run (step 2)
+	,BENCH_STAGE_MESH		// apl_mesh_build (not written)
+	,BENCH_STAGE_ROI		// apl_roi_build
+	,BENCH_STAGE_SCAN		// apl_scan_calc (center 1/16 rows, not published)
+	,BENCH_STAGE_BG			// apl_bg_update
+	,BENCH_STAGE_PLANE		// apl_plane_fit (stride 4, warm started)
+	,BENCH_STAGE_CRC		// apl_crc32c x 4 planes (as apl_save_take)
+	,BENCH_STAGE_SAVE		// apl_save_plane x 4 planes (as apl_save_file)
+	,BENCH_STAGE_NUM
+} BENCH_STAGE;
+
+static const char *STAGE_NAME[BENCH_STAGE_NUM] = { "cnv_dp", "upsample", "flying", "colorize", "color_lut", "gamma", "stats", "fill", "rect", "normal", "mesh", "roi", "scan", "bg", "plane", "crc32c", "save" };
+
+// Bytes Read And Written Per Pixel Of Each Stage
+static const double STAGE_BYTES[BENCH_STAGE_NUM] = {
+	 2 + 2			// cnv_dp    : depth in place
+	,2 + 2 + 0.5	// upsample  : ir, 1/4 depth -> depth
+	,2 + 2 + 2		// flying    : depth -> row ring -> depth
+	,2 + 3			// colorize  : depth -> BGR
+	,2 + 3			// color_lut : depth -> BGR
+	,2 + 2			// gamma     : ir in place
+	,2				// stats     : depth (upper bound, rows are strided)
+	,2 + 2 + 1		// fill      : depth, ir -> mask (pyramid is 1/3, holes only are written)
+	,2 + 2 + 4 + 2 + 2	// rect      : depth, ir, remap table -> depth, ir
+	,2 + 4			// normal    : depth -> packed normals
+	,2 + 2 + 15 + 4 + 26	// mesh      : depth, ir -> vertex, index of pixel, 2 triangles
+	,2 + 8 + 8 + 4	// roi       : depth -> sum, sum of squares, count
+	,2.0 / 16		// scan      : depth of band
+	,2 + 8 + 8 + 1	// bg        : depth, mean and variance -> mean, variance, mask
+	,2 + 1			// plane     : depth -> inlier mask (cloud is 1/16)
+	,2 * 4			// crc32c    : depth, ir, confdata, irnrref
+	,2 * 4			// save      : depth, ir, confdata, irnrref
+};
+
+// Frame Size
+typedef enum {
+	 BENCH_RESO_VGA = 0
+	,BENCH_RESO_QVGA
+	,BENCH_RESO_NUM
+} BENCH_RESO;
+
+static const char *RESO_NAME[BENCH_RESO_NUM] = { "VGA", "QVGA" };
+static const uint16_t RESO_W[BENCH_RESO_NUM] = { 640, 320 };
+static const uint16_t RESO_H[BENCH_RESO_NUM] = { 480, 240 };
+
+// Synthetic Scene
+typedef enum {
+	 BENCH_SCENE_RAMP = 0	// horizontal ramp, uniform invalid pixels
+	,BENCH_SCENE_ROOM		// floor, wall and boxes, noise grows with distance, invalid at edges
+	,BENCH_SCENE_SPARSE		// far scene, large invalid (saturated / out of range) regions
+	,BENCH_SCENE_NUM
+} BENCH_SCENE;
+
+static const char *SCENE_NAME[BENCH_SCENE_NUM] = { "ramp", "room", "sparse" };
+
+// Synthetic Frame
+typedef struct {
+	TL_Resolution			reso;		// resolution
+	float					invalid;	// ratio of invalid depth
+	std::vector<uint16_t>	dp_raw;		// raw depth (before apl_cnv_dp)
+	uint16_t				*dp;		// working depth (arena)
+	std::vector<uint16_t>	ir_raw;		// raw ir (before gamma)
+	uint16_t				*ir;		// working ir (arena)
+	TL_Image				img;		// image points working buffers
+	apl_color_lut			lut;		// depth color table
+	apl_stats				stats;		// depth statistics
+	apl_roi					roi;		// depth summed-area tables
+	apl_lens				lens;		// lens model
+	apl_scan				scan;		// laser scan
+	apl_bg					bg;			// background model
+	uint8_t					*bg_mask;	// foreground mask (arena)
+	apl_plane				plane;		// floor plane
+	uint8_t					*plane_mask;	// inlier mask of floor plane (arena)
+	uint16_t				*dp_lo;		// half resolution depth (arena)
+	apl_jbu					jbu;		// depth upsampling
+	apl_fly					fly;		// flying pixel filter
+	apl_fill				fill;		// hole filling
+	uint8_t					*fill_mask;	// mask of filled depth (arena)
+	apl_rect				rect;		// rectification
+	uint16_t				*rect_dp;	// rectified depth (arena)
+	uint16_t				*rect_ir;	// rectified ir (arena)
+	apl_nrm					nrm;		// surface normals
+	uint32_t				*nrm_map;	// packed normals (arena)
+	apl_mesh				mesh;		// mesh
+} bench_frame;
+
+// Result Of One Stage
+typedef struct {
+	double		single_ms;	// single thread [ms/frame]
+	double		pool_ms;	// worker pool [ms/frame]
+} bench_res;
+
+//******************************************************************************
+//! \brief        Uniform random number in [0, 1).
+//******************************************************************************
+static double bench_rand(void)
+{
+	return (double)rand() / ((double)RAND_MAX + 1.0);
+}
+
+//******************************************************************************
+//! \brief        Depth of scene at pixel [mm], 0 = invalid.
+//! \param[in]    scene         scene.
+//! \param[in]    u             horizontal position (0 .. 1).
+//! \param[in]    v             vertical position (0 .. 1).
+//******************************************************************************
+static double bench_scene_depth(BENCH_SCENE scene, double u, double v)
+{
+	double d;
+
+	switch (scene) {
+		case BENCH_SCENE_ROOM:
+			// Wall At 3 m, Floor Comes Closer Toward Bottom, Two Boxes
+			d = 3000;
+			if (v > 0.55) {
+				d = 600 / (v - 0.35);
+			}
+			if ((u > 0.15) && (u < 0.40) && (v > 0.40) && (v < 0.85)) {
+				d = 900;
+			}
+			if ((u > 0.60) && (u < 0.75) && (v > 0.30) && (v < 0.70)) {
+				d = 1500;
+			}
+			// Noise Grows With Square Of Distance, Saturated Near Box Edges
+			d += d * d * 2e-6 * ((bench_rand() + bench_rand() + bench_rand() + bench_rand()) - 2.0);
+			if ((fabs(u - 0.15) < 0.004) || (fabs(u - 0.40) < 0.004) || (bench_rand() < 0.01)) {
+				d = 0;
+			}
+			break;
+		case BENCH_SCENE_SPARSE:
+			// Far Field, Regions Without Return
+			d = 2000 + (2000 * v);
+			if (((int)(u * 12) + (int)(v * 9)) % 3 == 0) {
+				d = 0;
+			}
+			else
+			if (bench_rand() < 0.05) {
+				d = 0;
+			}
+			break;
+		case BENCH_SCENE_RAMP:
+		default:
+			d = BENCH_RANGE_NEAR + ((1100 - BENCH_RANGE_NEAR) * u);
+			if ((rand() % 16) == 0) {
+				d = 0;
+			}
+			break;
+	}
+
+	return d;
+}
+
+//******************************************************************************
+//! \brief        Create synthetic frame.
+//! \param[out]   frm           synthetic frame.
+//! \param[in]    reso          frame size.
+//! \param[in]    scene         scene.
+//******************************************************************************
+static void bench_make_frame(bench_frame *frm, BENCH_RESO reso, BENCH_SCENE scene)
+{
+	size_t x;
+	size_t y;
+	size_t w = RESO_W[reso];
+	size_t h = RESO_H[reso];
+	size_t invalid = 0;
+
+	memset(&frm->reso, 0, sizeof(frm->reso));
+	memset(&frm->img, 0, sizeof(frm->img));
+	frm->reso.depth.width  = (uint16_t)w;
+	frm->reso.depth.height = (uint16_t)h;
+	frm->reso.depth.stride = (uint16_t)(w * sizeof(uint16_t));
+	frm->reso.depth.bit_per_pixel = 16;
+	frm->reso.ir = frm->reso.depth;
+	frm->reso.confdata = frm->reso.depth;
+	frm->reso.irnrref = frm->reso.depth;
+
+	frm->dp_raw.resize(w * h);
+	frm->ir_raw.resize(w * h);
+	srand(1);
+	for (y = 0; y < h; y++) {
+		for (x = 0; x < w; x++) {
+			double d = bench_scene_depth(scene, (double)x / w, (double)y / h);
+
+			if ((d <= 0) || (d >= RAW12_INVALID_DEPTH)) {
+				frm->dp_raw[y * w + x] = RAW12_INVALID_DEPTH;
+				frm->ir_raw[y * w + x] = 0x3FF;
+				invalid++;
+			}
+			else {
+				frm->dp_raw[y * w + x] = (uint16_t)(d / BENCH_DEPTH_UNIT);
+				frm->ir_raw[y * w + x] = (uint16_t)std::min(4.0e7 / (d * d), 1023.0);
+			}
+		}
+	}
+	frm->invalid = (float)invalid / (float)(w * h);
+
+	frm->dp = static_cast<uint16_t *>(apl_arena_alloc(w * h * sizeof(uint16_t)));
+	frm->ir = static_cast<uint16_t *>(apl_arena_alloc(w * h * sizeof(uint16_t)));
+	frm->img.depth = frm->dp;
+	frm->img.ir = frm->ir;
+	frm->img.confdata = frm->dp_raw.data();
+	frm->img.irnrref = frm->ir_raw.data();
+
+	(void)apl_color_lut_build(&frm->lut, BENCH_RANGE_NEAR, BENCH_RANGE_FAR);
+	apl_stats_init(&frm->stats, RAW12_INVALID_DEPTH, 2, 0.1F);
+	apl_roi_init(&frm->roi, w, h);
+
+	// Lens Of Viewer Camera (Focal Length 2.00mm, Pixel Pitch 5.00um At VGA)
+	TL_LensPrm lens_prm = {};
+	TL_Fov fov = {};
+	lens_prm.sns_h = 640;
+	lens_prm.sns_v = 480;
+	lens_prm.pixel_pitch = 500;
+	fov.focal_length = 200;
+	(void)apl_lens_init(&frm->lens, &lens_prm, &fov, w, h);
+	(void)apl_scan_init(&frm->scan, &frm->lens, (uint16_t)((h / 2) - (h / 32)), (uint16_t)((h / 2) + (h / 32)),
+						0, BENCH_RANGE_NEAR, BENCH_RANGE_FAR);
+	apl_bg_init(&frm->bg, w, h, 0.02F, 0.002F, 3.0F, 20, 100);
+	frm->bg_mask = static_cast<uint8_t *>(apl_arena_alloc(w * h * sizeof(uint8_t)));
+	const float up[3] = { 0.0F, -1.0F, 0.0F };
+	apl_plane_init(&frm->plane, &frm->lens, 4, 200, 30.0F, up, 60.0F);
+	frm->plane_mask = static_cast<uint8_t *>(apl_arena_alloc(w * h * sizeof(uint8_t)));
+
+	// Half Resolution Depth, As VGA_IR_QVGA_DEPTH
+	frm->dp_lo = static_cast<uint16_t *>(apl_arena_alloc((w / 2) * (h / 2) * sizeof(uint16_t)));
+	for (y = 0; y < h / 2; y++) {
+		for (x = 0; x < w / 2; x++) {
+			frm->dp_lo[(y * (w / 2)) + x] = frm->dp_raw[(2 * y * w) + (2 * x)];
+		}
+	}
+	apl_jbu_init(&frm->jbu, w / 2, h / 2, 0.8F, 32.0F);
+	apl_fly_init(&frm->fly, w, h, NULL, 0.0F, 50.0F, 0.03F, 1, 0);
+	apl_fill_init(&frm->fill, w, h, 16, 32.0F);
+	frm->fill_mask = static_cast<uint8_t *>(apl_arena_alloc(w * h * sizeof(uint8_t)));
+	const apl_rect_coef coef = { -0.2, 0.05, 0.0, 0.0 };
+	(void)apl_rect_init(&frm->rect, &frm->lens, &coef);
+	frm->rect_dp = static_cast<uint16_t *>(apl_arena_alloc(w * h * sizeof(uint16_t)));
+	frm->rect_ir = static_cast<uint16_t *>(apl_arena_alloc(w * h * sizeof(uint16_t)));
+	apl_nrm_init(&frm->nrm, &frm->lens, 2, 0.05F);
+	frm->nrm_map = static_cast<uint32_t *>(apl_arena_alloc(w * h * sizeof(uint32_t)));
+	apl_mesh_init(&frm->mesh, &frm->lens, 0.05F, 1023);
+}
+
+//******************************************************************************
+//! \brief        Write planes of frame as apl_save_file does.
+//******************************************************************************
+static void bench_save(bench_frame *frm, const char *dir)
+{
+	static const char *PLANE_NAME[4] = { "dp", "ir", "cf", "rf" };
+	const void *plane[4] = { frm->img.depth, frm->img.ir, frm->img.confdata, frm->img.irnrref };
+	size_t size = (size_t)frm->reso.depth.width * frm->reso.depth.height * sizeof(uint16_t);
+	char fn[512];
+	int p;
+
+	for (p = 0; p < 4; p++) {
+		snprintf(fn, sizeof(fn), "%s/viewer_bench_%s.raw", dir, PLANE_NAME[p]);
+		(void)apl_save_plane(fn, plane[p], size);
+	}
+}
+
+//******************************************************************************
+//! \brief        Remove files of bench_save().
+//******************************************************************************
+static void bench_save_clean(const char *dir)
+{
+	static const char *PLANE_NAME[4] = { "dp", "ir", "cf", "rf" };
+	char fn[512];
+	int p;
+
+	for (p = 0; p < 4; p++) {
+		snprintf(fn, sizeof(fn), "%s/viewer_bench_%s.raw", dir, PLANE_NAME[p]);
+		(void)unlink(fn);
+	}
+}
+
+//******************************************************************************
+//! \brief        Run one stage for iterations, return average time [ms].
+//! \param[in]    stage         stage to run.
+//! \param[in]    frm           synthetic frame.
+//! \param[in]    cnv           depth conversion.
+//! \param[in]    iter          iterations.
+//! \param[in]    dir           directory of save stage.
+//******************************************************************************
+static double bench_run_stage(BENCH_STAGE stage, bench_frame *frm, const apl_dp_cnv *cnv, int iter, const char *dir)
+{
+	std::chrono::steady_clock::duration total = std::chrono::steady_clock::duration::zero();
+	std::chrono::steady_clock::time_point tick;
+	const int w = frm->reso.depth.width;
+	const int h = frm->reso.depth.height;
+	uint32_t crc = 0;
+	int i;
+
+	for (i = 0; i < iter; i++) {
+		// Restore Input, Kernels Work In Place
+		std::copy(frm->dp_raw.begin(), frm->dp_raw.end(), frm->dp);
+		std::copy(frm->ir_raw.begin(), frm->ir_raw.end(), frm->ir);
+		cv::Mat mat_dp(h, w, CV_16UC1, frm->dp);
+		cv::Mat mat_ir(h, w, CV_16UC1, frm->ir);
+		if ((stage == BENCH_STAGE_FILL) || (stage == BENCH_STAGE_NORMAL) || (stage == BENCH_STAGE_MESH)) {
+			apl_cnv_dp(frm->reso, &frm->img, cnv);	// Holes Are 0 As In Viewer
+		}
+
+		tick = std::chrono::steady_clock::now();
+		switch (stage) {
+			case BENCH_STAGE_CNV_DP:
+				apl_cnv_dp(frm->reso, &frm->img, cnv);
+				break;
+			case BENCH_STAGE_UPSAMPLE:
+				apl_jbu_run(&frm->jbu, frm->dp_lo, frm->ir, frm->dp);
+				break;
+			case BENCH_STAGE_FLY:
+				(void)apl_fly_run(&frm->fly, frm->dp, NULL);
+				break;
+			case BENCH_STAGE_COLOR:
+				(void)apl_dpth_to_color_by_opencv(mat_dp, BENCH_RANGE_NEAR, BENCH_RANGE_FAR);
+				break;
+			case BENCH_STAGE_COLOR_LUT:
+				(void)apl_dpth_to_color_by_lut(mat_dp, &frm->lut);
+				break;
+			case BENCH_STAGE_GAMMA:
+				apl_gamma_by_opencv(mat_ir, mat_ir, BENCH_IR_GAMMA);
+				break;
+			case BENCH_STAGE_STATS:
+				apl_stats_calc(&frm->stats, frm->dp, w, h);
+				break;
+			case BENCH_STAGE_FILL:
+				(void)apl_fill_run(&frm->fill, frm->dp, frm->ir, frm->fill_mask);
+				break;
+			case BENCH_STAGE_RECT:
+				apl_rect_run(&frm->rect, frm->dp, frm->ir, frm->rect_dp, frm->rect_ir);
+				break;
+			case BENCH_STAGE_NORMAL:
+				(void)apl_nrm_run(&frm->nrm, frm->dp, frm->nrm_map);
+				break;
+			case BENCH_STAGE_MESH:
+				(void)apl_mesh_build(&frm->mesh, frm->dp, frm->ir, (uint16_t)w, (uint16_t)h);
+				break;
+			case BENCH_STAGE_ROI:
+				apl_roi_build(&frm->roi, frm->dp, NULL);
+				break;
+			case BENCH_STAGE_SCAN:
+				(void)apl_scan_calc(&frm->scan, frm->dp, 0);
+				break;
+			case BENCH_STAGE_BG:
+				apl_bg_update(&frm->bg, frm->dp, frm->bg_mask);
+				break;
+			case BENCH_STAGE_PLANE:
+				apl_plane_fit(&frm->plane, frm->dp, frm->plane_mask);
+				break;
+			case BENCH_STAGE_CRC:
+				crc = apl_crc32c(0, frm->img.depth, w * h * sizeof(uint16_t));
+				crc = apl_crc32c(crc, frm->img.ir, w * h * sizeof(uint16_t));
+				crc = apl_crc32c(crc, frm->img.confdata, w * h * sizeof(uint16_t));
+				crc = apl_crc32c(crc, frm->img.irnrref, w * h * sizeof(uint16_t));
+				break;
+			case BENCH_STAGE_SAVE:
+				bench_save(frm, dir);
+				break;
+			default:
+				break;
+		}
+		total += std::chrono::steady_clock::now() - tick;
+	}
+	(void)crc;
+
+	return std::chrono::duration<double, std::milli>(total).count() / iter;
+}
+
+//******************************************************************************
+//! \brief        Check hole filling on flat depth: small hole is filled, over-size hole stays invalid.
+//! \param[in]    frm           synthetic frame, only fill workspace is used.
+//! \return       true          hole of max_hole is filled, every pixel of hole wider than max_hole is 0 and not in mask
+//******************************************************************************
+static bool bench_check_fill(bench_frame *frm)
+{
+	size_t w = frm->reso.depth.width;
+	size_t h = frm->reso.depth.height;
+	size_t big = 4 * frm->fill.max_hole;
+	size_t x;
+	size_t y;
+	size_t bad = 0;
+	std::vector<uint16_t> dp(w * h, 1000);
+	std::vector<uint16_t> ir(w * h, 500);
+
+	// Hole Of max_hole At Top Left, Hole Of 4 x max_hole At Bottom Right
+	for (y = 0; y < frm->fill.max_hole; y++) {
+		for (x = 0; x < frm->fill.max_hole; x++) {
+			dp[((8 + y) * w) + 8 + x] = 0;
+		}
+	}
+	for (y = 0; y < big; y++) {
+		for (x = 0; x < big; x++) {
+			dp[((h - 8 - big + y) * w) + w - 8 - big + x] = 0;
+		}
+	}
+	(void)apl_fill_run(&frm->fill, dp.data(), ir.data(), frm->fill_mask);
+
+	for (y = 0; y < frm->fill.max_hole; y++) {
+		for (x = 0; x < frm->fill.max_hole; x++) {
+			bad += (dp[((8 + y) * w) + 8 + x] == 0) ? 1 : 0;
+		}
+	}
+	for (y = 0; y < big; y++) {
+		for (x = 0; x < big; x++) {
+			size_t i = ((h - 8 - big + y) * w) + w - 8 - big + x;
+			bad += ((dp[i] != 0) || (frm->fill_mask[i] != 0)) ? 1 : 0;
+		}
+	}
+	if (bad > 0) {
+		printf("fill check failed : %zu pixels (max_hole %u)\n", bad, frm->fill.max_hole);
+	}
+
+	return (bad == 0);
+}
+
+//******************************************************************************
+//! \brief        Print usage.
+//******************************************************************************
+static void bench_usage(const char *prog)
+{
+	printf("usage: %s [-n iterations] [-w workers] [-a pages] [-d dir] [-t tag] [-j]\n", prog);
+	printf("  -n  iterations per stage (default %d)\n", BENCH_DEF_ITERATION);
+	printf("  -w  pool workers, 0 = automatic (default 0)\n");
+	printf("  -a  buffers from arena of 4k, thp or hugetlb pages (default heap)\n");
+	printf("  -d  directory of save stage (default %s)\n", BENCH_DEF_SAVE_DIR);
+	printf("  -t  tag written to JSON, e.g. commit id\n");
+	printf("  -j  print JSON instead of table\n");
+}
+
+//******************************************************************************
+//! \brief        main function
+//! \n
+//! \param[in]    argc         number of arguments.
+//! \param[in]    argv         arguments, see bench_usage().
+//! \return       0            success
+//! \return       -1           bad argument, or fill check failed
+//******************************************************************************
+int main(int argc, char *argv[])
+{
+	static bench_frame frm[BENCH_RESO_NUM][BENCH_SCENE_NUM];
+	static bench_res res[BENCH_RESO_NUM][BENCH_SCENE_NUM][BENCH_STAGE_NUM];
+	apl_dp_cnv cnv;
+	int iter = BENCH_DEF_ITERATION;
+	int workers = 0;
+	bool json = false;
+	const char *dir = BENCH_DEF_SAVE_DIR;
+	const char *tag = "";
+	const char *pages = NULL;
+	bool first = true;
+	int opt;
+	int r;
+	int c;
+	int s;
+
+	while ((opt = getopt(argc, argv, "n:w:a:d:t:jh")) != -1) {
+		switch (opt) {
+			case 'n':
+				iter = atoi(optarg);
+				iter = (iter > 0) ? iter : BENCH_DEF_ITERATION;
+				break;
+			case 'w':
+				workers = atoi(optarg);
+				break;
+			case 'a':
+				pages = optarg;
+				break;
+			case 'd':
+				dir = optarg;
+				break;
+			case 't':
+				tag = optarg;
+				break;
+			case 'j':
+				json = true;
+				break;
+			default:
+				bench_usage(argv[0]);
+				return -1;
+		}
+	}
+
+	// Workspaces Of Stages From Arena, As Viewer Does
+	if (pages != NULL) {
+		APL_ARENA_PAGE page = (strcmp(pages, "hugetlb") == 0) ? APL_ARENA_PAGE_HUGETLB :
+							  (strcmp(pages, "thp") == 0) ? APL_ARENA_PAGE_THP : APL_ARENA_PAGE_4K;
+		(void)apl_arena_init((size_t)160 * 1024 * 1024, page);
+	}
+
+	apl_dp_cnv_init(&cnv, BENCH_DEPTH_UNIT, false, APL_DP_TCC_SLOPE_ONE);
+	for (r = 0; r < BENCH_RESO_NUM; r++) {
+		for (c = 0; c < BENCH_SCENE_NUM; c++) {
+			bench_make_frame(&frm[r][c], (BENCH_RESO)r, (BENCH_SCENE)c);
+		}
+	}
+	if (!bench_check_fill(&frm[BENCH_RESO_VGA][0])) {
+		return -1;
+	}
+
+	// Single Thread, Pool Without Worker Runs Inline
+	apl_pool_term();
+	for (r = 0; r < BENCH_RESO_NUM; r++) {
+		for (c = 0; c < BENCH_SCENE_NUM; c++) {
+			for (s = 0; s < BENCH_STAGE_NUM; s++) {
+				res[r][c][s].single_ms = bench_run_stage((BENCH_STAGE)s, &frm[r][c], &cnv, iter, dir);
+			}
+		}
+	}
+
+	// Worker Pool On Big Cores
+	if (apl_pool_init(workers, APL_POOL_CLUSTER_BIG) < 0) {
+		printf("apl_pool_init failed\n");
+	}
+	for (r = 0; r < BENCH_RESO_NUM; r++) {
+		for (c = 0; c < BENCH_SCENE_NUM; c++) {
+			for (s = 0; s < BENCH_STAGE_NUM; s++) {
+				res[r][c][s].pool_ms = bench_run_stage((BENCH_STAGE)s, &frm[r][c], &cnv, iter, dir);
+			}
+		}
+	}
+	bench_save_clean(dir);
+
+	if (json) {
+		printf("{\n  \"tag\": \"%s\",\n  \"iterations\": %d,\n  \"threads\": %d,\n  \"results\": [\n", tag, iter, apl_pool_thread_num());
+	}
+	else {
+		printf("%d iterations, %d threads\n", iter, apl_pool_thread_num());
+		apl_arena_report(stdout);
+	}
+
+	for (r = 0; r < BENCH_RESO_NUM; r++) {
+		for (c = 0; c < BENCH_SCENE_NUM; c++) {
+			const double pixels = (double)RESO_W[r] * RESO_H[r];
+
+			if (!json) {
+				printf("\n%s %dx%d, scene=%s, invalid=%.1f%%\n", RESO_NAME[r], RESO_W[r], RESO_H[r], SCENE_NAME[c], frm[r][c].invalid * 100);
+				printf("%-10s %11s %11s %8s %9s %9s %10s\n", "stage", "single[ms]", "pool[ms]", "speedup", "fps", "ns/pixel", "MB/s");
+			}
+
+			for (s = 0; s < BENCH_STAGE_NUM; s++) {
+				const bench_res *p = &res[r][c][s];
+				double fps = 1000.0 / p->pool_ms;
+				double ns_px = (p->pool_ms * 1e6) / pixels;
+				double bps = (STAGE_BYTES[s] * pixels * 1000.0) / p->pool_ms;
+
+				if (json) {
+					printf("%s    { \"reso\": \"%s\", \"width\": %d, \"height\": %d, \"scene\": \"%s\", \"invalid_ratio\": %.4f, "
+						   "\"stage\": \"%s\", \"single_ms\": %.4f, \"pool_ms\": %.4f, \"speedup\": %.3f, "
+						   "\"fps\": %.1f, \"ns_per_pixel\": %.3f, \"bytes_per_sec\": %.0f }",
+						first ? "" : ",\n",
+						RESO_NAME[r], RESO_W[r], RESO_H[r], SCENE_NAME[c], frm[r][c].invalid,
+						STAGE_NAME[s], p->single_ms, p->pool_ms, p->single_ms / p->pool_ms,
+						fps, ns_px, bps);
+					first = false;
+				}
+				else {
+					printf("%-10s %11.3f %11.3f %7.2fx %9.1f %9.3f %10.1f\n",
+						STAGE_NAME[s], p->single_ms, p->pool_ms, p->single_ms / p->pool_ms, fps, ns_px, bps / 1e6);
+				}
+			}
+		}
+	}
+
+	if (json) {
+		printf("\n  ]\n}\n");
+	}
+
+	apl_pool_term();
+
+	return 0;
+}
@@ -0,0 +1,687 @@
+//******************************************************************************
+//! \file         viewer_convert.cpp
+//! \brief        offline converter of saved raw frames to point clouds (binary PLY / PCD) or meshes (PLY / OBJ).
+//! \details      Frames mode#_<time>_dp####.raw (and ir####.raw) saved by viewer are converted by
+//!               lens of take (mode#_<time>_lens.conf), files are processed in parallel by worker pool.
+//!               Each worker owns one set of frame buffers, memory does not grow with number of files.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "tl.h"
+#include "apl_cfg.h"
+#include "apl_pool.h"
+#include "apl_lens.h"
+#include "apl_mesh.h"
+#include "apl_rect.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define CONV_DP_TAG			"_dp"			// depth file : <prefix>dp####.raw
+#define CONV_RAW_EXT		".raw"
+#define CONV_LENS_SUFFIX	"lens.conf"		// lens of take : <prefix>lens.conf
+#define CONV_MM_TO_M		(0.001F)		// points are written in meters
+#define CONV_MESH_JUMP		(0.05F)			// spread of triangle that is a discontinuity
+#define CONV_MESH_IR_MAX	(1023)			// ir that is white
+
+// Output Format
+typedef enum {
+	 CONV_FMT_PLY = 0	// binary_little_endian PLY
+	,CONV_FMT_PCD		// binary PCD v0.7
+	,CONV_FMT_NUM
+} CONV_FMT;
+
+static const char *FMT_EXT[CONV_FMT_NUM] = { ".ply", ".pcd" };
+
+// Frame Sizes Known From File Size (Depth And IR Are 16 Bit)
+static const uint16_t KNOWN_W[] = { 640, 320 };
+static const uint16_t KNOWN_H[] = { 480, 240 };
+
+// Take, Frames Saved At Once Share Lens
+typedef struct {
+	std::string		prefix;		// path up to "dp", e.g. dir/mode1_20240101_120000_
+	uint16_t		w;			// depth width
+	uint16_t		h;			// depth height
+	apl_lens		lens;		// lens model of depth image
+	apl_rect		rect;		// rectification of take, built once (-r)
+	bool			rect_on;	// frames of take are rectified before conversion
+} conv_take;
+
+// Frame To Convert
+typedef struct {
+	size_t			take;		// index of take
+	std::string		dp;			// depth file
+	std::string		ir;			// ir file, empty = no intensity
+	std::string		out;		// output file
+} conv_job;
+
+// Conversion Shared By Workers
+typedef struct {
+	std::vector<conv_take>	takes;
+	std::vector<conv_job>	jobs;
+	CONV_FMT				fmt;
+	bool					intensity;	// write ir as intensity
+	bool					rect;		// rectify takes saved as captured
+	bool					mesh;		// write mesh instead of point cloud
+	APL_MESH_FMT			mesh_fmt;
+	std::atomic<size_t>		next;		// next job
+	std::atomic<uint64_t>	frames;		// converted frames
+	std::atomic<uint64_t>	failed;		// frames failed
+	std::atomic<uint64_t>	points;		// written points
+	std::atomic<uint64_t>	triangles;	// written triangles
+	std::atomic<uint64_t>	bytes_in;	// read bytes
+	std::atomic<uint64_t>	bytes_out;	// written bytes
+} conv_ctx;
+
+// Buffers Of One Worker, Reused For Every Frame
+typedef struct {
+	std::vector<uint16_t>	dp;
+	std::vector<uint16_t>	ir;
+	std::vector<uint16_t>	rect_dp;	// rectified depth, swapped with dp
+	std::vector<uint16_t>	rect_ir;	// rectified ir, swapped with ir
+	std::vector<float>		pts;		// x, y, z (, intensity) of valid pixels
+	std::vector<char>		io;			// stdio buffer of output
+	apl_mesh				mesh;		// mesh of take, rebuilt for every frame
+	size_t					mesh_take;	// take of mesh, SIZE_MAX = none
+} conv_buf;
+
+//******************************************************************************
+//! \brief        Size of file, 0 if not found.
+//******************************************************************************
+static size_t conv_file_size(const std::string &fn)
+{
+	struct stat st;
+
+	if (stat(fn.c_str(), &st) != 0) {
+		return 0;
+	}
+
+	return (size_t)st.st_size;
+}
+
+//******************************************************************************
+//! \brief        Frame size of 16 bit raw file.
+//! \return       0             success
+//! \return       -1            unknown size
+//******************************************************************************
+static int conv_frame_size(size_t size, uint16_t *w, uint16_t *h)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(KNOWN_W) / sizeof(KNOWN_W[0]); i++) {
+		if (size == (size_t)KNOWN_W[i] * KNOWN_H[i] * sizeof(uint16_t)) {
+			*w = KNOWN_W[i];
+			*h = KNOWN_H[i];
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+//******************************************************************************
+//! \brief        Split depth file name into prefix and index, e.g. dir/mode1_<time>_dp0003.raw.
+//! \return       true          depth file
+//******************************************************************************
+static bool conv_split_name(const std::string &fn, std::string *prefix, std::string *idx)
+{
+	const size_t ext = fn.size() - strlen(CONV_RAW_EXT);
+	size_t pos;
+
+	if ((fn.size() <= strlen(CONV_RAW_EXT)) || (fn.compare(ext, std::string::npos, CONV_RAW_EXT) != 0)) {
+		return false;
+	}
+	pos = fn.rfind(CONV_DP_TAG);
+	if ((pos == std::string::npos) || (pos + strlen(CONV_DP_TAG) >= ext) || (fn.find('/', pos) != std::string::npos)) {
+		return false;
+	}
+
+	*prefix = fn.substr(0, pos + 1);
+	*idx = fn.substr(pos + strlen(CONV_DP_TAG), ext - (pos + strlen(CONV_DP_TAG)));
+
+	return std::all_of(idx->begin(), idx->end(), [](char c) { return (c >= '0') && (c <= '9'); });
+}
+
+//******************************************************************************
+//! \brief        Depth files of argument, directory is scanned (not recursively).
+//******************************************************************************
+static void conv_collect(const char *arg, std::vector<std::string> *files)
+{
+	struct stat st;
+	struct dirent *ent;
+	std::string prefix;
+	std::string idx;
+	DIR *dir;
+
+	if ((stat(arg, &st) == 0) && S_ISDIR(st.st_mode)) {
+		dir = opendir(arg);
+		if (dir == NULL) {
+			printf("opendir (%s) failed\n", arg);
+			return;
+		}
+		while ((ent = readdir(dir)) != NULL) {
+			std::string fn = std::string(arg) + "/" + ent->d_name;
+
+			if (conv_split_name(fn, &prefix, &idx)) {
+				files->push_back(fn);
+			}
+		}
+		(void)closedir(dir);
+	}
+	else
+	if (conv_split_name(arg, &prefix, &idx)) {
+		files->push_back(arg);
+	}
+	else {
+		printf("%s : not a depth file (<prefix>dp####.raw) nor directory\n", arg);
+	}
+}
+
+//******************************************************************************
+//! \brief        Lens of take from <prefix>lens.conf, or from file given by -l.
+//! \return       0             success
+//! \return       -1            no lens
+//******************************************************************************
+static int conv_take_lens(conv_take *take, const char *lens_fn)
+{
+	std::string fn = take->prefix + CONV_LENS_SUFFIX;
+	TL_LensPrm prm = {};
+	TL_Fov fov = {};
+
+	// Sidecar Of Take Overrides Keys Of -l, Keys Of Previous Take Are Not Kept
+	apl_cfg_clear();
+	if ((lens_fn != NULL) && (apl_cfg_load(lens_fn) < 0)) {
+		printf("%s : not found\n", lens_fn);
+		return -1;
+	}
+	if ((apl_cfg_load(fn.c_str()) < 0) && (lens_fn == NULL)) {
+		printf("%s : not found, give lens file by -l\n", fn.c_str());
+		return -1;
+	}
+
+	prm.sns_h        = (uint16_t)apl_cfg_get_int("lens.sns_h", 0);
+	prm.sns_v        = (uint16_t)apl_cfg_get_int("lens.sns_v", 0);
+	prm.center_h     = (uint16_t)apl_cfg_get_int("lens.center_h", 0);
+	prm.center_v     = (uint16_t)apl_cfg_get_int("lens.center_v", 0);
+	prm.pixel_pitch  = (uint16_t)apl_cfg_get_int("lens.pixel_pitch", 0);
+	fov.focal_length = (uint16_t)apl_cfg_get_int("fov.focal_length", 0);
+	fov.angle_h      = (uint16_t)apl_cfg_get_int("fov.angle_h", 0);
+	fov.angle_v      = (uint16_t)apl_cfg_get_int("fov.angle_v", 0);
+
+	return apl_lens_init(&take->lens, &prm, &fov, take->w, take->h);
+}
+
+//******************************************************************************
+//! \brief        Rectification of take by distortion in <prefix>lens.conf, unless frames are rectified already.
+//******************************************************************************
+static void conv_take_rect(conv_take *take)
+{
+	apl_rect_coef coef;
+
+	take->rect_on = false;
+	coef.k1 = apl_cfg_get_float("rect.k1", 0.0F);
+	coef.k2 = apl_cfg_get_float("rect.k2", 0.0F);
+	coef.p1 = apl_cfg_get_float("rect.p1", 0.0F);
+	coef.p2 = apl_cfg_get_float("rect.p2", 0.0F);
+
+	if (apl_cfg_get_int("rect.saved", 0) != 0) {
+		printf("%s* : rectified already\n", take->prefix.c_str());
+		return;
+	}
+	if ((coef.k1 == 0) && (coef.k2 == 0) && (coef.p1 == 0) && (coef.p2 == 0)) {
+		printf("%s* : no distortion, not rectified\n", take->prefix.c_str());
+		return;
+	}
+	if (apl_rect_init(&take->rect, &take->lens, &coef) < 0) {
+		printf("%s* : not rectified\n", take->prefix.c_str());
+		return;
+	}
+	take->rect_on = true;
+}
+
+//******************************************************************************
+//! \brief        Group depth files into takes and make jobs.
+//! \return       0             success
+//! \return       -1            no frame to convert
+//******************************************************************************
+static int conv_plan(conv_ctx *ctx, std::vector<std::string> *files, const char *out_dir, const char *lens_fn)
+{
+	std::string prefix;
+	std::string idx;
+	size_t i;
+
+	std::sort(files->begin(), files->end());
+	files->erase(std::unique(files->begin(), files->end()), files->end());
+
+	for (i = 0; i < files->size(); i++) {
+		const std::string &fn = (*files)[i];
+		conv_job job;
+		uint16_t w;
+		uint16_t h;
+
+		(void)conv_split_name(fn, &prefix, &idx);
+		if (conv_frame_size(conv_file_size(fn), &w, &h) < 0) {
+			printf("%s : unknown frame size, skipped\n", fn.c_str());
+			continue;
+		}
+
+		//! \remark 1. New Take (Files Are Sorted, Frames Of Take Are Adjacent).
+		if (ctx->takes.empty() || (ctx->takes.back().prefix != prefix) ||
+			(ctx->takes.back().w != w) || (ctx->takes.back().h != h)) {
+			conv_take take;
+
+			take.prefix = prefix;
+			take.w = w;
+			take.h = h;
+			take.rect_on = false;
+			if (conv_take_lens(&take, lens_fn) < 0) {
+				printf("%s* : no lens, skipped\n", prefix.c_str());
+				take.lens.rx = NULL;
+			}
+			else
+			if (ctx->rect) {
+				conv_take_rect(&take);
+			}
+			ctx->takes.push_back(take);
+		}
+		if (ctx->takes.back().lens.rx == NULL) {
+			continue;
+		}
+
+		//! \remark 2. Job, Output Is <prefix>pc####.<ext> (Mesh <prefix>ms####.<ext>) In Output Directory.
+		job.take = ctx->takes.size() - 1;
+		job.dp = fn;
+		job.ir = (ctx->intensity || ctx->mesh) ? (prefix + "ir" + idx + CONV_RAW_EXT) : "";
+		if (ctx->mesh) {
+			job.out = prefix + "ms" + idx + apl_mesh_ext(ctx->mesh_fmt);
+		}
+		else {
+			job.out = prefix + "pc" + idx + FMT_EXT[ctx->fmt];
+		}
+		if (out_dir != NULL) {
+			size_t slash = job.out.rfind('/');
+
+			job.out = std::string(out_dir) + "/" + ((slash != std::string::npos) ? job.out.substr(slash + 1) : job.out);
+		}
+		ctx->jobs.push_back(job);
+	}
+
+	return ctx->jobs.empty() ? -1 : 0;
+}
+
+//******************************************************************************
+//! \brief        Read 16 bit raw file.
+//! \return       0             success
+//! \return       -1            failed
+//******************************************************************************
+static int conv_read(const std::string &fn, std::vector<uint16_t> *buf, size_t num)
+{
+	FILE *fp;
+	size_t n;
+
+	fp = fopen(fn.c_str(), "rb");
+	if (fp == NULL) {
+		printf("fopen (%s) failed\n", fn.c_str());
+		return -1;
+	}
+	buf->resize(num);
+	n = fread(buf->data(), sizeof(uint16_t), num, fp);
+	(void)fclose(fp);
+
+	if (n != num) {
+		printf("%s : short read\n", fn.c_str());
+		return -1;
+	}
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Header of point cloud file.
+//******************************************************************************
+static std::string conv_header(CONV_FMT fmt, bool intensity, size_t num)
+{
+	char hdr[512];
+
+	if (fmt == CONV_FMT_PCD) {
+		snprintf(hdr, sizeof(hdr),
+			"# .PCD v0.7 - Point Cloud Data file format\n"
+			"VERSION 0.7\n"
+			"FIELDS x y z%s\n"
+			"SIZE 4 4 4%s\n"
+			"TYPE F F F%s\n"
+			"COUNT 1 1 1%s\n"
+			"WIDTH %zu\n"
+			"HEIGHT 1\n"
+			"VIEWPOINT 0 0 0 1 0 0 0\n"
+			"POINTS %zu\n"
+			"DATA binary\n",
+			intensity ? " intensity" : "", intensity ? " 4" : "", intensity ? " F" : "", intensity ? " 1" : "",
+			num, num);
+	}
+	else {
+		snprintf(hdr, sizeof(hdr),
+			"ply\n"
+			"format binary_little_endian 1.0\n"
+			"comment camera coordinate [m], x right, y down, z forward\n"
+			"element vertex %zu\n"
+			"property float x\n"
+			"property float y\n"
+			"property float z\n"
+			"%s"
+			"end_header\n",
+			num, intensity ? "property float intensity\n" : "");
+	}
+
+	return hdr;
+}
+
+//******************************************************************************
+//! \brief        Mesh of frame read into buffers, textured by ir.
+//! \return       0             success
+//! \return       -1            failed
+//******************************************************************************
+static int conv_frame_mesh(conv_ctx *ctx, const conv_job *job, conv_buf *buf, bool use_ir, uint16_t ir_w, uint16_t ir_h)
+{
+	size_t bytes;
+
+	//! \remark 1. Buffers Of Worker Follow Take, Reallocated Only When Take Changes.
+	if (buf->mesh_take != job->take) {
+		if (buf->mesh_take != SIZE_MAX) {
+			apl_mesh_term(&buf->mesh);
+		}
+		apl_mesh_init(&buf->mesh, &ctx->takes[job->take].lens, CONV_MESH_JUMP, CONV_MESH_IR_MAX);
+		buf->mesh_take = job->take;
+	}
+
+	//! \remark 2. Build And Write.
+	(void)apl_mesh_build(&buf->mesh, buf->dp.data(), use_ir ? buf->ir.data() : NULL, ir_w, ir_h);
+	bytes = apl_mesh_write(&buf->mesh, job->out.c_str(), ctx->mesh_fmt, buf->io.data(), buf->io.size());
+	if (bytes == 0) {
+		return -1;
+	}
+
+	ctx->points += buf->mesh.vtx_num;
+	ctx->triangles += buf->mesh.face_num;
+	ctx->bytes_out += bytes;
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Convert one frame.
+//! \return       0             success
+//! \return       -1            failed
+//******************************************************************************
+static int conv_frame(conv_ctx *ctx, const conv_job *job, conv_buf *buf)
+{
+	const conv_take *take = &ctx->takes[job->take];
+	const apl_lens *lens = &take->lens;
+	const size_t w = take->w;
+	const size_t h = take->h;
+	const size_t stride = ctx->intensity ? 4 : 3;
+	uint16_t ir_w = 0;
+	uint16_t ir_h = 0;
+	bool use_ir = false;
+	std::string hdr;
+	size_t num = 0;
+	size_t u;
+	size_t v;
+	FILE *fp;
+
+	//! \remark 1. Read Depth [mm] (And IR, Sampled At Depth Pixel If Size Differs).
+	if (conv_read(job->dp, &buf->dp, w * h) < 0) {
+		return -1;
+	}
+	if (!job->ir.empty()) {
+		use_ir = (conv_frame_size(conv_file_size(job->ir), &ir_w, &ir_h) == 0) &&
+				 (conv_read(job->ir, &buf->ir, (size_t)ir_w * ir_h) == 0);
+		if (!use_ir) {
+			printf("%s : no ir, intensity is 0\n", job->ir.c_str());
+		}
+	}
+	ctx->bytes_in += (w * h + (use_ir ? (size_t)ir_w * ir_h : 0)) * sizeof(uint16_t);
+
+	//! \remark 2. Rectified By Table Of Take (IR Only If Of Depth Size), Lens Is Pinhole For Them.
+	if (take->rect_on) {
+		const bool rect_ir = use_ir && (ir_w == w) && (ir_h == h);
+
+		buf->rect_dp.resize(w * h);
+		buf->rect_ir.resize(rect_ir ? (w * h) : 0);
+		apl_rect_run(&take->rect, buf->dp.data(), rect_ir ? buf->ir.data() : NULL, buf->rect_dp.data(), rect_ir ? buf->rect_ir.data() : NULL);
+		buf->dp.swap(buf->rect_dp);
+		if (rect_ir) {
+			buf->ir.swap(buf->rect_ir);
+		}
+	}
+
+	if (ctx->mesh) {
+		return conv_frame_mesh(ctx, job, buf, use_ir, ir_w, ir_h);
+	}
+
+	//! \remark 3. Valid Pixels To Points.
+	buf->pts.resize(w * h * stride);
+	for (v = 0; v < h; v++) {
+		const uint16_t *dp = &buf->dp[v * w];
+		const uint16_t *ir = use_ir ? &buf->ir[((v * ir_h) / h) * ir_w] : NULL;
+
+		for (u = 0; u < w; u++) {
+			float *pt = &buf->pts[num * stride];
+			float z = (float)dp[u] * CONV_MM_TO_M;
+
+			if (dp[u] == 0) {
+				continue;
+			}
+			apl_lens_point(lens, u, v, z, &pt[0], &pt[1]);
+			pt[2] = z;
+			if (ctx->intensity) {
+				pt[3] = (ir != NULL) ? (float)ir[(u * ir_w) / w] : 0.0F;
+			}
+			num++;
+		}
+	}
+
+	//! \remark 4. Header And Points, One Buffered Write.
+	fp = fopen(job->out.c_str(), "wb");
+	if (fp == NULL) {
+		printf("fopen (%s) failed\n", job->out.c_str());
+		return -1;
+	}
+	(void)setvbuf(fp, buf->io.data(), _IOFBF, buf->io.size());
+	hdr = conv_header(ctx->fmt, ctx->intensity, num);
+	if ((fwrite(hdr.data(), 1, hdr.size(), fp) != hdr.size()) ||
+		(fwrite(buf->pts.data(), sizeof(float) * stride, num, fp) != num)) {
+		printf("fwrite (%s) failed\n", job->out.c_str());
+		(void)fclose(fp);
+		return -1;
+	}
+	if (fclose(fp) != 0) {
+		printf("fclose (%s) failed\n", job->out.c_str());
+		return -1;
+	}
+
+	ctx->points += num;
+	ctx->bytes_out += hdr.size() + (num * stride * sizeof(float));
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Worker, takes next job until all are done.
+//******************************************************************************
+static void conv_worker(conv_ctx *ctx)
+{
+	conv_buf buf;
+	size_t j;
+
+	buf.io.resize(256 * 1024);
+	buf.mesh_take = SIZE_MAX;
+
+	for (;;) {
+		j = ctx->next.fetch_add(1);
+		if (j >= ctx->jobs.size()) {
+			break;
+		}
+		if (conv_frame(ctx, &ctx->jobs[j], &buf) == 0) {
+			ctx->frames++;
+		}
+		else {
+			ctx->failed++;
+		}
+	}
+
+	if (buf.mesh_take != SIZE_MAX) {
+		apl_mesh_term(&buf.mesh);
+	}
+}
+
+//******************************************************************************
+//! \brief        Print usage.
+//******************************************************************************
+static void conv_usage(const char *prog)
+{
+	printf("usage: %s [-m] [-f ply|pcd|obj] [-i] [-r] [-o dir] [-l lens.conf] [-w workers] <dp file|dir> ...\n", prog);
+	printf("  -m  write mesh (<prefix>ms####) textured by ir of same index, instead of point cloud\n");
+	printf("  -f  output format, binary PLY or PCD, mesh binary PLY or OBJ (default ply)\n");
+	printf("  -i  write ir of same index (<prefix>ir####.raw) as intensity\n");
+	printf("  -r  rectify takes saved as captured by distortion of lens file (rect.k1 .. rect.p2)\n");
+	printf("  -o  output directory (default directory of input)\n");
+	printf("  -l  lens file for takes without <prefix>lens.conf\n");
+	printf("  -w  pool workers, 0 = automatic (default 0)\n");
+}
+
+//******************************************************************************
+//! \brief        main function
+//! \n
+//! \param[in]    argc         number of arguments.
+//! \param[in]    argv         arguments, see conv_usage().
+//! \return       0            success
+//! \return       -1           bad argument or frame failed
+//******************************************************************************
+int main(int argc, char *argv[])
+{
+	static conv_ctx ctx;
+	std::vector<std::string> files;
+	std::vector<apl_pool_task_fn> tasks;
+	std::chrono::steady_clock::time_point tick;
+	const char *out_dir = NULL;
+	const char *lens_fn = NULL;
+	const char *fmt_name = "ply";
+	int workers = 0;
+	double sec;
+	int opt;
+	int i;
+
+	ctx.fmt = CONV_FMT_PLY;
+	ctx.intensity = false;
+	ctx.rect = false;
+	ctx.mesh = false;
+	ctx.mesh_fmt = APL_MESH_FMT_PLY;
+
+	while ((opt = getopt(argc, argv, "mf:iro:l:w:h")) != -1) {
+		switch (opt) {
+			case 'm':
+				ctx.mesh = true;
+				break;
+			case 'f':
+				fmt_name = optarg;
+				break;
+			case 'i':
+				ctx.intensity = true;
+				break;
+			case 'r':
+				ctx.rect = true;
+				break;
+			case 'o':
+				out_dir = optarg;
+				break;
+			case 'l':
+				lens_fn = optarg;
+				break;
+			case 'w':
+				workers = atoi(optarg);
+				break;
+			default:
+				conv_usage(argv[0]);
+				return -1;
+		}
+	}
+	if (optind >= argc) {
+		conv_usage(argv[0]);
+		return -1;
+	}
+
+	// Point Cloud Or Mesh Format
+	if (ctx.mesh) {
+		if (apl_mesh_fmt_of(fmt_name, &ctx.mesh_fmt) < 0) {
+			conv_usage(argv[0]);
+			return -1;
+		}
+	}
+	else
+	if (strcmp(fmt_name, "pcd") == 0) {
+		ctx.fmt = CONV_FMT_PCD;
+	}
+	else
+	if (strcmp(fmt_name, "ply") != 0) {
+		conv_usage(argv[0]);
+		return -1;
+	}
+
+	for (i = optind; i < argc; i++) {
+		conv_collect(argv[i], &files);
+	}
+	if (conv_plan(&ctx, &files, out_dir, lens_fn) < 0) {
+		printf("no frame to convert\n");
+		return -1;
+	}
+
+	// Offline, Any Core Is Used
+	if (apl_pool_init(workers, APL_POOL_CLUSTER_ALL) < 0) {
+		printf("apl_pool_init failed, single thread\n");
+	}
+	tasks.assign(std::min((size_t)apl_pool_thread_num(), ctx.jobs.size()), [] { conv_worker(&ctx); });
+	printf("%zu frames of %zu takes, %zu threads\n", ctx.jobs.size(), ctx.takes.size(), tasks.size());
+
+	tick = std::chrono::steady_clock::now();
+	apl_pool_invoke(tasks.data(), tasks.size());
+	sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - tick).count();
+
+	apl_pool_term();
+
+	for (i = 0; i < (int)ctx.takes.size(); i++) {
+		if (ctx.takes[i].rect_on) {
+			apl_rect_term(&ctx.takes[i].rect);
+		}
+	}
+
+	printf("converted=%llu failed=%llu points=%llu\n", (unsigned long long)ctx.frames.load(),
+		(unsigned long long)ctx.failed.load(), (unsigned long long)ctx.points.load());
+	if (ctx.mesh) {
+		printf("triangles=%llu, %.2f M triangles/s\n", (unsigned long long)ctx.triangles.load(),
+			(double)ctx.triangles.load() / std::max(sec, 1e-9) / 1e6);
+	}
+	printf("%.3f s, %.1f frames/s, read %.1f MB/s, written %.1f MB/s\n", sec,
+		(double)ctx.frames.load() / std::max(sec, 1e-9),
+		(double)ctx.bytes_in.load() / std::max(sec, 1e-9) / 1e6,
+		(double)ctx.bytes_out.load() / std::max(sec, 1e-9) / 1e6);
+
+	return (ctx.failed.load() == 0) ? 0 : -1;
+}
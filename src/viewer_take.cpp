@@ -0,0 +1,306 @@
+//******************************************************************************
+//! \file         viewer_take.cpp
+//! \brief        verifier and extractor of takes (<name>.take) saved by viewer.
+//! \details      Every record of take is read in one sequential pass, its header and payload crc32c are checked,
+//!               sequence gaps (lost frames), corrupt bytes and truncated tail are reported, and index is checked
+//!               against records as written, it is rebuilt by scan of record headers only by -r.
+//!               Frames are found by index (completed by scan in memory) and extracted as raw planes for viewer_convert.
+//! \copyright    Nuvoton Technology Corporation Japan
+//******************************************************************************
+
+//******************************************************************************
+// Include Headers
+//******************************************************************************
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "apl_take.h"
+
+//******************************************************************************
+// Definitions
+//******************************************************************************
+#define TAKE_EXT			".take"
+
+// Result Of Verification
+typedef struct {
+	uint64_t	frames;			// records found
+	uint64_t	bad;			// records of payload crc mismatch
+	uint64_t	lost;			// frames missing by sequence of capture
+	uint64_t	skipped;		// bytes not in any record
+	uint64_t	idx_bad;		// records not in index as found, and entries of no record
+	uint64_t	bytes;			// bytes read
+	double		crc_sec;		// time of crc32c of payloads
+} take_result;
+
+//******************************************************************************
+//! \brief        Path of take without extension, prefix of raw files.
+//******************************************************************************
+static std::string take_base(const char *fn, const char *out_dir)
+{
+	std::string base(fn);
+	size_t pos;
+
+	if ((base.size() > strlen(TAKE_EXT)) && (base.compare(base.size() - strlen(TAKE_EXT), std::string::npos, TAKE_EXT) == 0)) {
+		base.resize(base.size() - strlen(TAKE_EXT));
+	}
+	if (out_dir != NULL) {
+		pos = base.rfind('/');
+		base = std::string(out_dir) + "/" + ((pos == std::string::npos) ? base : base.substr(pos + 1));
+	}
+
+	return base;
+}
+
+//******************************************************************************
+//! \brief        Verify every record of take in one sequential pass.
+//! \param[in]    fn            take.
+//! \param[in]    rd            reader of take (index).
+//! \param[out]   res           result.
+//! \return       0             read to end
+//! \return       -1            not a take
+//******************************************************************************
+static int take_verify(const char *fn, const apl_take_reader *rd, take_result *res)
+{
+	std::vector<uint8_t> buf;
+	apl_take_frame frm;
+	uint64_t size;
+	uint64_t off = sizeof(apl_take_file_hdr);
+	uint64_t seq = 0;
+	size_t matched = 0;
+	size_t n = 0;
+	FILE *fp;
+
+	memset(res, 0, sizeof(*res));
+
+	fp = fopen(fn, "rb");
+	if (fp == NULL) {
+		printf("fopen (%s) failed\n", fn);
+		return -1;
+	}
+	if (apl_take_check(fp, &size) != 0) {
+		(void)fclose(fp);
+		return -1;
+	}
+
+	//! \remark 1. Sequential Read, Kernel Read Ahead Overlaps crc Of Previous Frame.
+	(void)posix_fadvise(fileno(fp), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	while (apl_take_next(fp, size, &off, &frm, &res->skipped) == 0) {
+		std::chrono::steady_clock::time_point tick;
+
+		buf.resize(frm.hdr.payload);
+		if (fread(buf.data(), 1, frm.hdr.payload, fp) != frm.hdr.payload) {
+			break;
+		}
+
+		//! \remark 2. Payload crc32c.
+		tick = std::chrono::steady_clock::now();
+		if (apl_crc32c(0, buf.data(), frm.hdr.payload) != frm.hdr.payload_crc) {
+			printf("frame %u (seq %llu) at %llu : crc mismatch\n", frm.hdr.idx,
+				(unsigned long long)frm.hdr.seq, (unsigned long long)off);
+			res->bad++;
+		}
+		res->crc_sec += std::chrono::duration<double>(std::chrono::steady_clock::now() - tick).count();
+
+		//! \remark 3. Sequence Of Capture, Gap Is Lost Frames.
+		if ((res->frames > 0) && (frm.hdr.seq > (seq + 1))) {
+			printf("frame %u : %llu frames lost before seq %llu\n", frm.hdr.idx,
+				(unsigned long long)(frm.hdr.seq - seq - 1), (unsigned long long)frm.hdr.seq);
+			res->lost += frm.hdr.seq - seq - 1;
+		}
+		seq = frm.hdr.seq;
+
+		//! \remark 4. Index Entry Of Record.
+		while ((n < rd->idx.size()) && (rd->idx[n].off < off)) {
+			n++;
+		}
+		if ((n >= rd->idx.size()) || (rd->idx[n].off != off) || (rd->idx[n].idx != frm.hdr.idx)) {
+			res->idx_bad++;
+		}
+		else {
+			matched++;
+		}
+
+		res->frames++;
+		res->bytes += apl_take_rec_bytes(&frm);
+		off += apl_take_rec_bytes(&frm);
+	}
+	res->bytes += res->skipped;
+	res->idx_bad += rd->idx.size() - matched;
+
+	(void)fclose(fp);
+
+	return 0;
+}
+
+//******************************************************************************
+//! \brief        Extract frames as raw planes <base>_<tag>####.raw.
+//! \return       frames extracted
+//******************************************************************************
+static uint32_t take_extract(apl_take_reader *rd, const std::string &base, uint32_t first, uint32_t count)
+{
+	apl_take_frame frm;
+	uint32_t done = 0;
+	uint32_t k;
+	uint16_t i;
+
+	for (k = first; (k - first) < count; k++) {
+		const size_t n = apl_take_find(rd, k);
+
+		if (n == SIZE_MAX) {
+			printf("frame %u is not in take\n", k);
+			continue;
+		}
+		if (apl_take_read(rd, n, &frm) != 0) {
+			continue;
+		}
+
+		//! \remark 1. One File Per Plane, Names Of Raw Save Of Viewer.
+		for (i = 0; i < frm.hdr.plane_num; i++) {
+			const size_t bytes = (size_t)frm.plane[i].w * frm.plane[i].h * frm.plane[i].bpp;
+			char fn[512];
+			FILE *fp;
+
+			snprintf(fn, sizeof(fn), "%s_%c%c%04u.raw", base.c_str(), frm.plane[i].tag[0], frm.plane[i].tag[1], k);
+			fp = fopen(fn, "wb");
+			if (fp == NULL) {
+				printf("fopen (%s) failed\n", fn);
+				continue;
+			}
+			(void)fwrite(frm.data[i], 1, bytes, fp);
+			(void)fclose(fp);
+		}
+		printf("frame %u (seq %llu) : %u planes\n", k, (unsigned long long)frm.hdr.seq, frm.hdr.plane_num);
+		done++;
+	}
+
+	return done;
+}
+
+//******************************************************************************
+//! \brief        Print usage.
+//******************************************************************************
+static void take_usage(const char *prog)
+{
+	printf("usage: %s [-r] [-l] [-x first[:count]] [-o dir] <take>\n", prog);
+	printf("  (none) verify crc32c of every frame, sequence gaps and index at disk speed, index is not written\n");
+	printf("  -r  rebuild index by scan of take and write it\n");
+	printf("  -l  list index (frame, seq, time, offset)\n");
+	printf("  -x  extract frames by index as <name>_dp####.raw etc. (for viewer_convert)\n");
+	printf("  -o  output directory of -x (default directory of take)\n");
+}
+
+//******************************************************************************
+//! \brief        main function
+//! \n
+//! \param[in]    argc         number of arguments.
+//! \param[in]    argv         arguments, see take_usage().
+//! \return       0            success
+//! \return       -1           bad argument, take is damaged, or frame failed
+//******************************************************************************
+int main(int argc, char *argv[])
+{
+	static apl_take_reader rd;
+	std::chrono::steady_clock::time_point tick;
+	take_result res;
+	const char *out_dir = NULL;
+	const char *fn;
+	APL_TAKE_IDX_MODE mode;
+	bool rebuild = false;
+	bool list = false;
+	bool extract = false;
+	uint32_t first = 0;
+	uint32_t count = 1;
+	double sec;
+	int opt;
+	size_t i;
+
+	while ((opt = getopt(argc, argv, "rlx:o:h")) != -1) {
+		switch (opt) {
+			case 'r':
+				rebuild = true;
+				break;
+			case 'l':
+				list = true;
+				break;
+			case 'x':
+				extract = true;
+				if (sscanf(optarg, "%u:%u", &first, &count) < 1) {
+					take_usage(argv[0]);
+					return -1;
+				}
+				break;
+			case 'o':
+				out_dir = optarg;
+				break;
+			default:
+				take_usage(argv[0]);
+				return -1;
+		}
+	}
+	if (optind != (argc - 1)) {
+		take_usage(argv[0]);
+		return -1;
+	}
+	fn = argv[optind];
+
+	//! \remark 1. Index, As Written For Verification, Completed By Scan For Access, Written Again Only By -r.
+	mode = rebuild ? APL_TAKE_IDX_REBUILD : ((list || extract) ? APL_TAKE_IDX_SCAN : APL_TAKE_IDX_READ);
+	tick = std::chrono::steady_clock::now();
+	if (apl_take_ropen(&rd, fn, mode) != 0) {
+		return -1;
+	}
+	sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - tick).count();
+	printf("%s : %llu bytes, %zu frames in index%s (%.3f s)\n", fn, (unsigned long long)rd.size, rd.idx.size(),
+		rd.rebuilt ? ", rebuilt" : (rd.idx_ok ? "" : ((mode == APL_TAKE_IDX_SCAN) ? ", completed by scan" : ", missing or broken")), sec);
+
+	if (list) {
+		for (i = 0; i < rd.idx.size(); i++) {
+			printf("%6u seq=%-10llu mono=%.6f off=%llu bytes=%u\n", rd.idx[i].idx, (unsigned long long)rd.idx[i].seq,
+				(double)rd.idx[i].mono_ns / 1e9, (unsigned long long)rd.idx[i].off, rd.idx[i].bytes);
+		}
+	}
+
+	//! \remark 2. Random Access By Index.
+	if (extract) {
+		const uint32_t done = take_extract(&rd, take_base(fn, out_dir), first, count);
+
+		apl_take_rclose(&rd);
+		return (done == count) ? 0 : -1;
+	}
+	if (list) {
+		apl_take_rclose(&rd);
+		return 0;
+	}
+
+	//! \remark 3. Every Record.
+	tick = std::chrono::steady_clock::now();
+	if (take_verify(fn, &rd, &res) != 0) {
+		apl_take_rclose(&rd);
+		return -1;
+	}
+	sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - tick).count();
+
+	printf("frames=%llu crc_bad=%llu lost=%llu skipped=%llu bytes, index_mismatch=%llu\n",
+		(unsigned long long)res.frames, (unsigned long long)res.bad, (unsigned long long)res.lost,
+		(unsigned long long)res.skipped, (unsigned long long)res.idx_bad);
+	printf("%.3f s, read %.1f MB/s, crc32c (%s) %.1f MB/s\n", sec, (double)res.bytes / std::max(sec, 1e-9) / 1e6,
+		apl_crc32c_impl(), (double)res.bytes / std::max(res.crc_sec, 1e-9) / 1e6);
+
+	if ((res.idx_bad > 0) || !rd.idx_ok) {
+		printf("index does not match take, rebuild by -r\n");
+	}
+
+	apl_take_rclose(&rd);
+
+	return ((res.bad == 0) && (res.skipped == 0) && (res.idx_bad == 0) && rd.idx_ok) ? 0 : -1;
+}